@@ -33,9 +33,15 @@ void add_agraph_class(py::module &parent) {
     .def("evaluate_equation_at",
          &bingo::Equation::EvaluateEquationAt,
          py::arg("x"))
+    .def("evaluate_equation_at_rows",
+         &bingo::Equation::EvaluateEquationAtRows,
+         py::arg("x"), py::arg("rows"))
     .def("evaluate_equation_with_x_gradient_at",
          &bingo::Equation::EvaluateEquationWithXGradientAt,
          py::arg("x"))
+    .def("evaluate_equation_with_x_directional_derivative_at",
+         &bingo::Equation::EvaluateEquationWithXDirectionalDerivativeAt,
+         py::arg("x"), py::arg("direction"))
     .def("evaluate_equation_with_local_opt_gradient_at",
          &bingo::Equation::EvaluateEquationWithLocalOptGradientAt,
          py::arg("x"))
@@ -72,13 +78,23 @@ void add_agraph_class(py::module &parent) {
         &AGraph::GetNumberLocalOptimizationParams)
     .def("get_local_optimization_params",
         &AGraph::GetLocalOptimizationParams)
+    .def("get_linear_local_optimization_params",
+        &AGraph::GetLinearLocalOptimizationParams)
     .def("set_local_optimization_params", py::overload_cast<Eigen::Ref<Eigen::ArrayXXd>>(&AGraph::SetLocalOptimizationParams), py::arg("params"))
     .def("set_local_optimization_params", py::overload_cast<Eigen::VectorXd>(&AGraph::SetLocalOptimizationParamsV), py::arg("params"))
     .def("set_local_optimization_params", py::overload_cast<Eigen::ArrayXXd>(&AGraph::SetLocalOptimizationParamsA), py::arg("params"))
     .def("evaluate_equation_at", &AGraph::EvaluateEquationAt, py::arg("x"))
+    .def("evaluate_equation_at_rows", &AGraph::EvaluateEquationAtRows,
+        py::arg("x"), py::arg("rows"))
     .def("evaluate_equation_with_x_gradient_at",
         &AGraph::EvaluateEquationWithXGradientAt,
         py::arg("x"))
+    .def("evaluate_equation_with_gradients_at",
+        &AGraph::EvaluateEquationWithGradientsAt,
+        py::arg("x"))
+    .def("evaluate_equation_with_x_directional_derivative_at",
+        &AGraph::EvaluateEquationWithXDirectionalDerivativeAt,
+        py::arg("x"), py::arg("direction"))
     .def("evaluate_equation_with_local_opt_gradient_at",
         &AGraph::EvaluateEquationWithLocalOptGradientAt,
         py::arg("x"))
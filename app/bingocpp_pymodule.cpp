@@ -45,11 +45,14 @@
 
 #include <Eigen/Dense>
 
+#include "bingocpp/thread_pool.h"
+
 #include "evaluation_backend_pymodule.cpp"
 #include "simplification_backend_pymodule.cpp"
 #include "agraph_pymodule.cpp"
 #include "fitness_function_pymodule.cpp"
 #include "symbolic_regression_pymodule.cpp"
+#include "local_optimizer_pymodule.cpp"
 
 namespace py = pybind11;
 using namespace bingo;
@@ -61,4 +64,11 @@ PYBIND11_MODULE(bingocpp, m) {
     add_simplification_backend_submodule(m);
     add_fitness_classes(m);
     add_regressor_classes(m);
+    add_local_optimizer_classes(m);
+    m.def("set_num_threads", &SetNumThreads,
+          "Set the number of threads used for parallel evaluation; evaluations "
+          "already running finish with the previous threads",
+          py::arg("num_threads"));
+    m.def("get_num_threads", &GetNumThreads,
+          "Get the number of threads used for parallel evaluation");
 }
\ No newline at end of file
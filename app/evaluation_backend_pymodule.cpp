@@ -21,6 +21,7 @@
 #include <Eigen/Dense>
 
 #include "bingocpp/agraph/evaluation_backend/evaluation_backend.h"
+#include "bingocpp/agraph/evaluation_backend/simd_math.h"
 
 namespace py = pybind11;
 using namespace bingo;
@@ -30,15 +31,86 @@ void add_evaluation_backend_submodule(py::module &parent)
       py::module m = parent.def_submodule("evaluation_backend",
                                           "The evaluation backend for Agraphs");
       m.attr("ENGINE") = "c++";
-      m.def("evaluate", &evaluation_backend::Evaluate, "Evaluate an equation",
+      m.def("evaluate",
+            py::overload_cast<const Eigen::Ref<const Eigen::ArrayX3i> &,
+                              const Eigen::Ref<const Eigen::ArrayXXd> &,
+                              const Eigen::Ref<const Eigen::ArrayXXd> &>(
+                &evaluation_backend::Evaluate),
+            "Evaluate an equation",
             py::arg("stack"),
             py::arg("x"),
             py::arg("constants"));
       m.def("evaluate_with_derivative",
-            &evaluation_backend::EvaluateWithDerivative,
+            py::overload_cast<const Eigen::Ref<const Eigen::ArrayX3i> &,
+                              const Eigen::Ref<const Eigen::ArrayXXd> &,
+                              const Eigen::Ref<const Eigen::ArrayXXd> &,
+                              const bool>(
+                &evaluation_backend::EvaluateWithDerivative),
             "Evaluate equation and take derivative",
             py::arg("stack"),
             py::arg("x"),
             py::arg("constants"),
             py::arg("wrt_param_x_or_c"));
+      m.def("evaluate_with_derivative",
+            [](const Eigen::Ref<const Eigen::ArrayX3i> &stack,
+               const Eigen::Ref<const Eigen::ArrayXXd> &x,
+               const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+               const bool wrt_param_x_or_c,
+               const std::size_t memory_budget) {
+              evaluation_backend::EvaluationOptions options;
+              options.memory_budget = memory_budget;
+              return evaluation_backend::EvaluateWithDerivative(
+                  evaluation_backend::EvaluationPlan(stack), x, constants,
+                  wrt_param_x_or_c, options);
+            },
+            "Evaluate equation and take derivative within a memory budget "
+            "in bytes",
+            py::arg("stack"),
+            py::arg("x"),
+            py::arg("constants"),
+            py::arg("wrt_param_x_or_c"),
+            py::arg("memory_budget"));
+      m.def("evaluate_with_gradients",
+            py::overload_cast<const Eigen::Ref<const Eigen::ArrayX3i> &,
+                              const Eigen::Ref<const Eigen::ArrayXXd> &,
+                              const Eigen::Ref<const Eigen::ArrayXXd> &>(
+                &evaluation_backend::EvaluateWithGradients),
+            "Evaluate equation and take derivatives with respect to x and "
+            "the constants",
+            py::arg("stack"),
+            py::arg("x"),
+            py::arg("constants"));
+      m.def("evaluate_with_directional_derivative",
+            py::overload_cast<const Eigen::Ref<const Eigen::ArrayX3i> &,
+                              const Eigen::Ref<const Eigen::ArrayXXd> &,
+                              const Eigen::Ref<const Eigen::ArrayXXd> &,
+                              const Eigen::Ref<const Eigen::ArrayXXd> &>(
+                &evaluation_backend::EvaluateWithDirectionalDerivative),
+            "Evaluate equation and take derivative along a direction in x",
+            py::arg("stack"),
+            py::arg("x"),
+            py::arg("constants"),
+            py::arg("direction"));
+      m.def("evaluate_population",
+            &evaluation_backend::EvaluatePopulation,
+            "Evaluate a population of equations in parallel",
+            py::arg("individuals"),
+            py::arg("x"),
+            py::call_guard<py::gil_scoped_release>());
+      py::enum_<evaluation_backend::InstructionSet>(m, "InstructionSet")
+          .value("GENERIC", evaluation_backend::kGenericInstructions)
+          .value("SSE2", evaluation_backend::kSse2Instructions)
+          .value("AVX2", evaluation_backend::kAvx2Instructions)
+          .value("AVX512", evaluation_backend::kAvx512Instructions);
+      m.def("get_instruction_set",
+            &evaluation_backend::GetInstructionSet,
+            "Get the instruction set of the vectorized operators");
+      m.def("set_instruction_set",
+            &evaluation_backend::SetInstructionSet,
+            "Select the instruction set of the vectorized operators",
+            py::arg("instruction_set"));
+      m.def("is_instruction_set_supported",
+            &evaluation_backend::IsInstructionSetSupported,
+            "Check whether the processor supports an instruction set",
+            py::arg("instruction_set"));
 }
\ No newline at end of file
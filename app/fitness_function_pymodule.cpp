@@ -26,10 +26,36 @@ void add_fitness_classes(py::module &parent) {
          py::arg("items"))
     .def("__len__", &TrainingData::Size);
 
+  py::class_<BoundedFitness>(parent, "BoundedFitness")
+    .def_readonly("fitness", &BoundedFitness::fitness)
+    .def_readonly("is_lower_bound", &BoundedFitness::is_lower_bound);
+
+  py::enum_<MinibatchSampling>(parent, "MinibatchSampling")
+    .value("ROTATING", kRotatingMinibatch)
+    .value("STRATIFIED", kStratifiedMinibatch);
+
   py::class_<VectorBasedFunction, FitnessFunction, PyVectorBasedFunction /* trampoline */>(parent, "VectorBasedFunction")
     .def(py::init<TrainingData *, std::string>(),
          py::arg("training_data") = py::none(),
          py::arg("metric") = "mae")
     .def("__call__", &VectorBasedFunction::EvaluateIndividualFitness)
-    .def("evaluate_fitness_vector", &VectorBasedFunction::EvaluateFitnessVector);
+    .def("evaluate_full_fitness", &VectorBasedFunction::EvaluateFullFitness,
+         py::arg("individual"))
+    .def("evaluate_fitness_within", &VectorBasedFunction::EvaluateIndividualFitnessWithin,
+         py::arg("individual"), py::arg("bound"))
+    .def("evaluate_fitness_vector", &VectorBasedFunction::EvaluateFitnessVector)
+    .def("evaluate_fitness_vector_at_rows", &VectorBasedFunction::EvaluateFitnessVectorAtRows,
+         py::arg("individual"), py::arg("rows"))
+    .def("evaluate_population_fitness", &VectorBasedFunction::EvaluatePopulationFitness,
+         py::arg("individuals"),
+         py::call_guard<py::gil_scoped_release>())
+    .def("set_minibatch", &VectorBasedFunction::SetMinibatch,
+         py::arg("size"),
+         py::arg("sampling") = kRotatingMinibatch,
+         py::arg("seed") = 0)
+    .def("next_minibatch", &VectorBasedFunction::NextMinibatch)
+    .def_property("minibatch_index", &VectorBasedFunction::GetMinibatchIndex,
+                  &VectorBasedFunction::SetMinibatchIndex)
+    .def_property_readonly("minibatch_size", &VectorBasedFunction::GetMinibatchSize)
+    .def_property_readonly("minibatch_rows", &VectorBasedFunction::GetMinibatchRows);
 }
\ No newline at end of file
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2018 United States Government as represented by the Administrator
+ * of the National Aeronautics and Space Administration. No copyright is claimed
+ * in the United States under Title 17, U.S. Code. All Other Rights Reserved.
+ *
+ * The Bingo Mini-app platform is licensed under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+*/
+#include <pybind11/pybind11.h>
+#include <pybind11/eigen.h>
+#include <pybind11/stl.h>
+
+#include <Eigen/Dense>
+
+#include "bingocpp/agraph/agraph.h"
+#include "bingocpp/continuous_local_optimizer.h"
+#include "bingocpp/gradient_mixin.h"
+
+namespace py = pybind11;
+using namespace bingo;
+
+void add_local_optimizer_classes(py::module &parent) {
+  py::class_<LocalOptimizationOptions>(parent, "LocalOptimizationOptions")
+    .def(py::init<>())
+    .def_readwrite("max_iterations", &LocalOptimizationOptions::max_iterations)
+    .def_readwrite("function_tolerance", &LocalOptimizationOptions::function_tolerance)
+    .def_readwrite("parameter_tolerance", &LocalOptimizationOptions::parameter_tolerance)
+    .def_readwrite("gradient_tolerance", &LocalOptimizationOptions::gradient_tolerance)
+    .def_readwrite("lbfgs_memory", &LocalOptimizationOptions::lbfgs_memory)
+    .def_readwrite("num_starts", &LocalOptimizationOptions::num_starts)
+    .def_readwrite("variable_projection", &LocalOptimizationOptions::variable_projection);
+
+  py::class_<LocalOptimizationResult>(parent, "LocalOptimizationResult")
+    .def_readonly("params", &LocalOptimizationResult::params)
+    .def_readonly("cost", &LocalOptimizationResult::cost)
+    .def_readonly("num_evaluations", &LocalOptimizationResult::num_evaluations)
+    .def_readonly("converged", &LocalOptimizationResult::converged);
+
+  py::class_<ContinuousLocalOptimizer>(parent, "ContinuousLocalOptimizer")
+    .def(py::init<const VectorGradientMixin *, const std::string &, double,
+                  double, const LocalOptimizationOptions &, unsigned int>(),
+         py::arg("fitness_function"),
+         py::arg("algorithm") = "lm",
+         py::arg("param_init_min") = -10.0,
+         py::arg("param_init_max") = 10.0,
+         py::arg("options") = LocalOptimizationOptions(),
+         py::arg("seed") = std::mt19937::default_seed,
+         py::keep_alive<1, 2>())
+    .def_property("options",
+                  &ContinuousLocalOptimizer::GetOptions,
+                  &ContinuousLocalOptimizer::SetOptions)
+    .def("__call__", &ContinuousLocalOptimizer::EvaluateIndividualFitness,
+         py::arg("individual"))
+    .def("evaluate_population_fitness",
+         &ContinuousLocalOptimizer::EvaluatePopulationFitness,
+         py::arg("individuals"),
+         py::call_guard<py::gil_scoped_release>())
+    .def("optimize_params", &ContinuousLocalOptimizer::OptimizeParams,
+         py::arg("individual"), py::arg("initial_params"))
+    .def("optimize_params_multi_start",
+         &ContinuousLocalOptimizer::OptimizeParamsMultiStart,
+         py::arg("individual"), py::arg("initial_params"));
+}
@@ -2,22 +2,26 @@
 
 #include <benchmarking/benchmark_data.h>
 #include <benchmarking/benchmark_logging.h>
+#include <bingocpp/agraph/evaluation_backend/evaluation_backend.h>
 
 #define EVALUATE "pure c++: evaluate"
 #define X_DERIVATIVE "pure c++: x derivative"
 #define C_DERIVATIVE "pure c++: c derivative"
+#define POPULATION_EVALUATE "pure c++: population eval"
 
 void DoBenchmarking();
 Eigen::ArrayXd TimeBenchmark(
-  void (*benchmark)(const std::vector<AGraph>&, const Eigen::ArrayXXd&), 
-  const BenchmarkTestData &test_data, int number=100, int repeat=10);
-void RunBenchmarks(const BenchmarkTestData &benchmark_test_data);
-void BenchmarkEvaluate(const std::vector<AGraph> &indv_list,
+  void (*benchmark)(std::vector<AGraph>&, const Eigen::ArrayXXd&), 
+  BenchmarkTestData &test_data, int number=100, int repeat=10);
+void RunBenchmarks(BenchmarkTestData &benchmark_test_data);
+void BenchmarkEvaluate(std::vector<AGraph> &indv_list,
                        const Eigen::ArrayXXd &x_vals);
-void BenchmarkEvaluateAndXDerivative(const std::vector<AGraph> &indv_list,
+void BenchmarkEvaluateAndXDerivative(std::vector<AGraph> &indv_list,
                                      const Eigen::ArrayXXd &x_vals);
-void BenchmarkEvaluateAndCDerivative(const std::vector<AGraph> &indv_list,
+void BenchmarkEvaluateAndCDerivative(std::vector<AGraph> &indv_list,
                                      const Eigen::ArrayXXd &x_vals);
+void BenchmarkEvaluatePopulation(std::vector<AGraph> &indv_list,
+                                 const Eigen::ArrayXXd &x_vals);
 
 int main() {
   DoBenchmarking();
@@ -30,19 +34,21 @@ void DoBenchmarking() {
   RunBenchmarks(benchmark_test_data);
 }
 
-void RunBenchmarks(const BenchmarkTestData &benchmark_test_data) {
+void RunBenchmarks(BenchmarkTestData &benchmark_test_data) {
   Eigen::ArrayXd evaluate_times = TimeBenchmark(BenchmarkEvaluate, benchmark_test_data);
   Eigen::ArrayXd x_derivative_times = TimeBenchmark(BenchmarkEvaluateAndXDerivative, benchmark_test_data);
   Eigen::ArrayXd c_derivative_times = TimeBenchmark(BenchmarkEvaluateAndCDerivative, benchmark_test_data);
+  Eigen::ArrayXd population_times = TimeBenchmark(BenchmarkEvaluatePopulation, benchmark_test_data);
   PrintHeader();
   PrintResults(evaluate_times, EVALUATE);
   PrintResults(x_derivative_times, X_DERIVATIVE);
   PrintResults(c_derivative_times, C_DERIVATIVE);
+  PrintResults(population_times, POPULATION_EVALUATE);
 }
 
 Eigen::ArrayXd TimeBenchmark(
-  void (*benchmark)(const std::vector<AGraph>&, const Eigen::ArrayXXd&), 
-  const BenchmarkTestData &test_data, int number, int repeat) {
+  void (*benchmark)(std::vector<AGraph>&, const Eigen::ArrayXXd&), 
+  BenchmarkTestData &test_data, int number, int repeat) {
   Eigen::ArrayXd times = Eigen::ArrayXd(repeat);
   for (int run=0; run<repeat; run++) {
     auto start = std::chrono::high_resolution_clock::now();
@@ -56,29 +62,35 @@ Eigen::ArrayXd TimeBenchmark(
   return times; 
 }
 
-void BenchmarkEvaluate(const std::vector<AGraph> &indv_list,
+void BenchmarkEvaluate(std::vector<AGraph> &indv_list,
                        const Eigen::ArrayXXd &x_vals) {
-  std::vector<AGraph>::const_iterator indv;
+  std::vector<AGraph>::iterator indv;
   for(indv=indv_list.begin(); indv!=indv_list.end(); indv++) {
-    evaluation_backend::Evaluate(
-      indv->GetCommandArray(), x_vals, indv->GetLocalOptimizationParams());
+    indv->EvaluateEquationAt(x_vals);
   } 
 }
 
-void BenchmarkEvaluateAndXDerivative(const std::vector<AGraph> &indv_list,
+void BenchmarkEvaluateAndXDerivative(std::vector<AGraph> &indv_list,
                                      const Eigen::ArrayXXd &x_vals) {
-  std::vector<AGraph>::const_iterator indv;
+  std::vector<AGraph>::iterator indv;
   for(indv=indv_list.begin(); indv!=indv_list.end(); indv++) {
-    evaluation_backend::EvaluateWithDerivative(
-      indv->GetCommandArray(), x_vals, indv->GetLocalOptimizationParams(), true);
+    indv->EvaluateEquationWithXGradientAt(x_vals);
   }
 }
 
-void BenchmarkEvaluateAndCDerivative(const std::vector<AGraph> &indv_list,
+void BenchmarkEvaluateAndCDerivative(std::vector<AGraph> &indv_list,
                                      const Eigen::ArrayXXd &x_vals) {
-  std::vector<AGraph>::const_iterator indv;
+  std::vector<AGraph>::iterator indv;
   for(indv=indv_list.begin(); indv!=indv_list.end(); indv++) {
-    evaluation_backend::EvaluateWithDerivative(
-      indv->GetCommandArray(), x_vals, indv->GetLocalOptimizationParams(), false);
+    indv->EvaluateEquationWithLocalOptGradientAt(x_vals);
   }
-}
\ No newline at end of file
+}
+
+void BenchmarkEvaluatePopulation(std::vector<AGraph> &indv_list,
+                                 const Eigen::ArrayXXd &x_vals) {
+  std::vector<AGraph *> population;
+  for (AGraph &indv : indv_list) {
+    population.push_back(&indv);
+  }
+  bingo::evaluation_backend::EvaluatePopulation(population, x_vals);
+}
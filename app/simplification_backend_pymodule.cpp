@@ -32,10 +32,24 @@ void add_simplification_backend_submodule(py::module &parent) {
   m.def("get_utilized_commands", &simplification_backend::GetUtilizedCommands,
         "Find which commands are utilized",
         py::arg("stack"));
+  m.def("find_linear_constants",
+        &simplification_backend::FindLinearConstants,
+        "Find which constants enter a stack linearly",
+        py::arg("stack"));
   m.def("simplify_stack", &simplification_backend::PythonSimplifyStack,
         "Simplifies a stack based on computational algebra",
         py::arg("stack"));
   m.def("reduce_stack", &simplification_backend::SimplifyStack, "Reduces a stack",
         py::arg("stack"));
+  m.def("native_simplify_stack", &simplification_backend::CppSimplifyStack,
+        "Simplifies a stack natively, renumbering its constants",
+        py::arg("stack"));
+  m.def("set_use_native_simplification",
+        &simplification_backend::SetUseNativeSimplification,
+        "Choose whether AGraphs simplify natively instead of in Python",
+        py::arg("use_native"));
+  m.def("get_use_native_simplification",
+        &simplification_backend::GetUseNativeSimplification,
+        "Check whether AGraphs simplify natively");
 
 }
\ No newline at end of file
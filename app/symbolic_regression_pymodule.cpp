@@ -21,9 +21,11 @@
 #include <Eigen/Dense> 
 
 #include <python/py_gradient_mixin.h>
+#include <python/py_training_data.h>
 #include "bingocpp/gradient_mixin.h"
 #include "bingocpp/explicit_regression.h"
 #include "bingocpp/implicit_regression.h"
+#include "bingocpp/npy_file.h"
 #include "bingocpp/fitness_function.h"
 #include "bingocpp/training_data.h"
 
@@ -42,11 +44,17 @@ void add_regressor_classes(py::module &parent) {
     .def("get_fitness_and_gradient", &VectorGradientMixin::GetIndividualFitnessAndGradient,
          py::arg("individual"))
     .def("get_fitness_vector_and_jacobian", &VectorGradientMixin::GetFitnessVectorAndJacobian,
+         py::arg("individual"))
+    .def("get_fitness_vectors_and_jacobians", &VectorGradientMixin::GetFitnessVectorsAndJacobians,
          py::arg("individual"));
 
   py::class_<ImplicitTrainingData, TrainingData>(parent, "ImplicitTrainingData")
     .def(py::init<Eigen::ArrayXXd &>(), py::arg("x"))
-    .def(py::init<Eigen::ArrayXXd &, Eigen::ArrayXXd &>(),
+    .def(py::init([](const NumpyTrainingArray &x,
+                     const NumpyTrainingArray &dx_dt) {
+           return new ImplicitTrainingData(ViewOfNumpy(x), ViewOfNumpy(dx_dt),
+                                           NumpyOwner(x, dx_dt));
+         }),
          py::arg("x"),
          py::arg("dx_dt"))
     .def_readonly("x", &ImplicitTrainingData::x)
@@ -59,13 +67,35 @@ void add_regressor_classes(py::module &parent) {
          (ImplicitTrainingData *(ImplicitTrainingData::*)(const std::vector<int>&))
          &ImplicitTrainingData::GetItem,
          py::arg("items"), py::return_value_policy::reference)
+    .def_static("load_npy", &LoadImplicitTrainingData,
+                py::arg("x_path"), py::arg("dx_dt_path"))
+    .def("get_range", &ImplicitTrainingData::GetRange,
+         py::arg("begin"), py::arg("end"))
+    .def("view", [](const ImplicitTrainingData &td,
+                    const std::vector<int> &items) {
+           return new ImplicitTrainingDataView(td, items);
+         },
+         py::arg("items"))
     .def("__len__", &ImplicitTrainingData::Size)
     .def("__getstate__", &ImplicitTrainingData::DumpState)
     .def("__setstate__", [](ImplicitTrainingData &td, const ImplicitTrainingDataState &state) {
             new (&td) ImplicitTrainingData(state); });
 
+  py::class_<ImplicitTrainingDataView, TrainingData>(parent, "ImplicitTrainingDataView")
+    .def_readonly("data", &ImplicitTrainingDataView::data)
+    .def("__getitem__",
+         (ImplicitTrainingDataView *(ImplicitTrainingDataView::*)(const std::vector<int>&))
+         &ImplicitTrainingDataView::GetItem,
+         py::arg("items"))
+    .def("gather", &ImplicitTrainingDataView::Gather)
+    .def("__len__", &ImplicitTrainingDataView::Size);
+
   py::class_<ExplicitTrainingData, TrainingData>(parent, "ExplicitTrainingData")
-    .def(py::init<Eigen::ArrayXXd &, Eigen::ArrayXXd&>(), py::arg("x"), py::arg("y"))
+    .def(py::init([](const NumpyTrainingArray &x, const NumpyTrainingArray &y) {
+           return new ExplicitTrainingData(ViewOfNumpy(x), ViewOfNumpy(y),
+                                           NumpyOwner(x, y));
+         }),
+         py::arg("x"), py::arg("y"))
     .def_readonly("x", &ExplicitTrainingData::x)
     .def_readonly("y", &ExplicitTrainingData::y)
     .def("__getitem__", 
@@ -76,23 +106,48 @@ void add_regressor_classes(py::module &parent) {
          (ExplicitTrainingData *(ExplicitTrainingData::*)(const std::vector<int>&))
          &ExplicitTrainingData::GetItem,
          py::arg("items"), py::return_value_policy::reference)
+    .def_static("load_npy", &LoadExplicitTrainingData,
+                py::arg("x_path"), py::arg("y_path"))
+    .def("get_range", &ExplicitTrainingData::GetRange,
+         py::arg("begin"), py::arg("end"))
+    .def("view", [](const ExplicitTrainingData &td,
+                    const std::vector<int> &items) {
+           return new ExplicitTrainingDataView(td, items);
+         },
+         py::arg("items"))
     .def("__len__", &ExplicitTrainingData::Size)
     .def("__getstate__", &ExplicitTrainingData::DumpState)
     .def("__setstate__", [](ExplicitTrainingData &td, const ExplicitTrainingDataState &state) {
             new (&td) ExplicitTrainingData(state); });
 
+  py::class_<ExplicitTrainingDataView, TrainingData>(parent, "ExplicitTrainingDataView")
+    .def_readonly("data", &ExplicitTrainingDataView::data)
+    .def("__getitem__",
+         (ExplicitTrainingDataView *(ExplicitTrainingDataView::*)(const std::vector<int>&))
+         &ExplicitTrainingDataView::GetItem,
+         py::arg("items"))
+    .def("gather", &ExplicitTrainingDataView::Gather)
+    .def("__len__", &ExplicitTrainingDataView::Size);
+
   py::class_<ExplicitRegression, VectorGradientMixin, VectorBasedFunction>(parent, "ExplicitRegression")
     .def(py::init<ExplicitTrainingData *, std::string &, bool &>(),
         py::arg("training_data"),
         py::arg("metric")="mae",
         py::arg("relative")=false)
+    .def(py::init<ExplicitTrainingDataView *, std::string &, bool &>(),
+        py::arg("training_data"),
+        py::arg("metric")="mae",
+        py::arg("relative")=false)
     .def_property("eval_count",
                   &ExplicitRegression::GetEvalCount,
                   &ExplicitRegression::SetEvalCount)
     .def("__call__", &ExplicitRegression::EvaluateIndividualFitness, py::arg("individual"))
     .def("evaluate_fitness_vector", &ExplicitRegression::EvaluateFitnessVector, py::arg("individual"))
+    .def("evaluate_population_fitness", &ExplicitRegression::EvaluatePopulationFitness, py::arg("individuals"),
+         py::call_guard<py::gil_scoped_release>())
     .def("get_fitness_and_gradient", &ExplicitRegression::GetIndividualFitnessAndGradient, py::arg("individual"))
     .def("get_fitness_vector_and_jacobian", &ExplicitRegression::GetFitnessVectorAndJacobian, py::arg("individual"))
+    .def("get_fitness_vectors_and_jacobians", &ExplicitRegression::GetFitnessVectorsAndJacobians, py::arg("individual"))
     .def("__getstate__", &ExplicitRegression::DumpState)
     .def("__setstate__", [](ExplicitRegression &r, const ExplicitRegressionState &state) {
             new (&r) ExplicitRegression(state); });
@@ -102,11 +157,17 @@ void add_regressor_classes(py::module &parent) {
          py::arg("training_data"),
          py::arg("required_params") = -1,
          py::arg("metric") = "mae")
+    .def(py::init<ImplicitTrainingDataView *, int &, std::string &>(),
+         py::arg("training_data"),
+         py::arg("required_params") = -1,
+         py::arg("metric") = "mae")
     .def_property("eval_count",
                   &ImplicitRegression::GetEvalCount,
                   &ImplicitRegression::SetEvalCount)
     .def("__call__", &ImplicitRegression::EvaluateIndividualFitness, py::arg("individual"))
     .def("evaluate_fitness_vector", &ImplicitRegression::EvaluateFitnessVector, py::arg("individual"))
+    .def("evaluate_population_fitness", &ImplicitRegression::EvaluatePopulationFitness, py::arg("individuals"),
+         py::call_guard<py::gil_scoped_release>())
     .def("__getstate__", &ImplicitRegression::DumpState)
     .def("__setstate__", [](ImplicitRegression &r, const ImplicitRegressionState &state) {
             new (&r) ImplicitRegression(state); });
@@ -28,6 +28,9 @@
 #include <Eigen/Core>
 
 #include <bingocpp/equation.h>
+#include <bingocpp/agraph/evaluation_backend/evaluation_cache.h>
+#include <bingocpp/agraph/evaluation_backend/evaluation_options.h>
+#include <bingocpp/agraph/evaluation_backend/evaluation_plan.h>
 
 typedef std::pair<Eigen::ArrayXXd, Eigen::ArrayXXd> EvalAndDerivative;
 typedef std::tuple<Eigen::ArrayX3i, Eigen::ArrayX3i, Eigen::ArrayXXd,
@@ -174,6 +177,16 @@ namespace bingo
      */
     const Eigen::ArrayXXd &GetLocalOptimizationParams() const;
 
+    /**
+     * @brief Find which constants enter the AGraph linearly
+     *
+     * The simplified equation is affine in the constants flagged, taken
+     * together, so they can be fit by linear least squares.
+     *
+     * @return std::vector<bool> The mask, indexed like the constants.
+     */
+    std::vector<bool> GetLinearLocalOptimizationParams();
+
     /**
      * @brief Evaluate the AGraph equatoin
      *
@@ -185,7 +198,24 @@ namespace bingo
      * @return Eigen::ArrayXXd The evaluation of function at points x.
      */
     Eigen::ArrayXXd
-    EvaluateEquationAt(const Eigen::ArrayXXd &x);
+    EvaluateEquationAt(const Eigen::Ref<const Eigen::ArrayXXd> &x);
+
+    /**
+     * @brief Evaluate the AGraph equation at some rows of x
+     *
+     * The rows are gathered a tile at a time as the AGraph is evaluated,
+     * so they are never copied all at once.
+     *
+     * @param x Values from which points are taken. x is MxD where D is the
+     * number of dimensions in x and M is the number of data points in x.
+     *
+     * @param rows N indices of the points of x at which to evaluate.
+     *
+     * @return Eigen::ArrayXXd The evaluation of function at the N points.
+     */
+    Eigen::ArrayXXd
+    EvaluateEquationAtRows(const Eigen::Ref<const Eigen::ArrayXXd> &x,
+                           const Eigen::Ref<const Eigen::ArrayXi> &rows);
 
     /**
      * @brief Evaluate the AGraph and get its derivatives
@@ -200,7 +230,40 @@ namespace bingo
      * along the points x and the derivative of the equation with respect to x.
      */
     EvalAndDerivative
-    EvaluateEquationWithXGradientAt(const Eigen::ArrayXXd &x);
+    EvaluateEquationWithXGradientAt(const Eigen::Ref<const Eigen::ArrayXXd> &x);
+
+    /**
+     * @brief Evaluate the AGraph and get its derivatives with respect to
+     * both x and the constants.
+     *
+     * Both derivatives come from a single evaluation of the equation.
+     *
+     * @param x Values at which to evaluate the equations. x is MxD where D is the
+     * number of dimensions in x and M is the number of data points in x.
+     *
+     * @return EvalAndGradients The evaluation of the function of this AGraph
+     * along the points x, its derivative with respect to x and its
+     * derivative with respect to the constants.
+     */
+    EvalAndGradients EvaluateEquationWithGradientsAt(const Eigen::Ref<const Eigen::ArrayXXd> &x);
+
+    /**
+     * @brief Evaluate the AGraph and get its derivative along a direction.
+     *
+     * The derivative is carried along with the evaluation in forward mode,
+     * so the gradient with respect to each dimension of x is not formed.
+     *
+     * @param x Values at which to evaluate the equations. x is MxD where D is the
+     * number of dimensions in x and M is the number of data points in x.
+     *
+     * @param direction MxD direction of the derivative at each point of x.
+     *
+     * @return EvalAndDerivative The evaluation of the function of this AGraph
+     * along the points x and its directional derivative at each point.
+     */
+    EvalAndDerivative
+    EvaluateEquationWithXDirectionalDerivativeAt(const Eigen::Ref<const Eigen::ArrayXXd> &x,
+                                                 const Eigen::Ref<const Eigen::ArrayXXd> &direction);
 
     /**
      * @brief Evluate the AGraph and get its derivatives.
@@ -216,7 +279,29 @@ namespace bingo
      * the constants of the equation.
      */
     EvalAndDerivative
-    EvaluateEquationWithLocalOptGradientAt(const Eigen::ArrayXXd &x);
+    EvaluateEquationWithLocalOptGradientAt(const Eigen::Ref<const Eigen::ArrayXXd> &x);
+
+    /**
+     * @brief Get the normal equations of fitting the constants to y.
+     *
+     * JᵀJ and Jᵀr of the residual (f(x) - y) * weights are accumulated
+     * while the AGraph is evaluated, without forming its jacobian with
+     * respect to the constants.
+     *
+     * @param x Values at which to evaluate the equations. x is MxD where D is the
+     * number of dimensions in x and M is the number of data points in x.
+     *
+     * @param y M values to fit.
+     *
+     * @param weights M weights of the residuals, or none for unit weights.
+     *
+     * @return std::vector<NormalEquations> The normal equations of each set
+     * of constants.  They are NaN if the evaluation failed.
+     */
+    std::vector<NormalEquations>
+    EvaluateNormalEquationsAt(const Eigen::Ref<const Eigen::ArrayXXd> &x,
+                              const Eigen::Ref<const Eigen::ArrayXd> &y,
+                              const Eigen::Ref<const Eigen::ArrayXd> &weights = Eigen::ArrayXd());
 
     /**
      * @brief Output a string description of the the AGraph in a given format.
@@ -245,6 +330,12 @@ namespace bingo
     Eigen::ArrayX3i command_array_;
     Eigen::ArrayX3i simplified_command_array_;
     Eigen::ArrayXXd simplified_constants_;
+    // simplified_command_array_ compiled for evaluation; rebuilt in update()
+    evaluation_backend::EvaluationPlan evaluation_plan_;
+    // values of the constant-free parts of evaluation_plan_, kept while
+    // caching evaluations
+    evaluation_backend::EvaluationCache evaluation_cache_;
+    bool cache_evaluations_;
     bool needs_opt_;
     double fitness_;
     bool fit_set_;
@@ -254,10 +345,29 @@ namespace bingo
 
     // To string operator when passed into stream
     friend std::ostream &operator<<(std::ostream &, AGraph &);
+    // the only user of evaluation caching, while x is fixed
+    friend class ContinuousLocalOptimizer;
+
+    /**
+     * @brief Keep the values of constant-free subexpressions between
+     * evaluations
+     *
+     * While enabled, evaluations and derivatives with respect to the
+     * constants at an x evaluated before, the same array unmodified, only
+     * compute the parts of the equation that depend on the constants, as
+     * suits local optimization.  The cache recognizes x by its address, so
+     * x must not be modified in place or freed while enabled.  The kept
+     * values are dropped when disabled and when the command array changes.
+     *
+     * @param enabled Whether to keep the values.
+     */
+    void SetEvaluationCaching(bool enabled);
 
     // helper functions
     void notify_agraph_modification();
     void update();
+    std::vector<NormalEquations> nan_normal_equations() const;
+    evaluation_backend::EvaluationOptions evaluation_options();
   };
 } // namespace bingo
 #endif // BINGOCPP_INCLUDE_BINGOCPP_AGRAPH_H_
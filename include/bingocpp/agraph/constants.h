@@ -17,6 +17,8 @@
 #ifndef BINGOCPP_INCLUDE_BINGOCPP_CONSTANTS_H_
 #define BINGOCPP_INCLUDE_BINGOCPP_CONSTANTS_H_
 
+#include <limits>
+
 namespace bingo {
 
 const double kNaN = std::numeric_limits<double>::quiet_NaN();
@@ -17,6 +17,7 @@
 #ifndef INCLUDE_BINGOCPP_EVALUATION_BACKEND_H_
 #define INCLUDE_BINGOCPP_EVALUATION_BACKEND_H_
 
+#include <cstddef>
 #include <set>
 #include <utility>
 #include <vector>
@@ -25,6 +26,11 @@
 #include <Eigen/Core>
 
 #include <bingocpp/agraph/agraph.h>
+#include <bingocpp/agraph/evaluation_backend/evaluation_cache.h>
+#include <bingocpp/agraph/evaluation_backend/evaluation_options.h>
+#include <bingocpp/agraph/evaluation_backend/evaluation_plan.h>
+#include <bingocpp/agraph/evaluation_backend/evaluation_workspace.h>
+#include <bingocpp/normal_equations.h>
 
 using RowArrayXXd = Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
 using Stack3i = Eigen::Array<int, Eigen::Dynamic, 3, Eigen::RowMajor>;
@@ -63,6 +69,11 @@ namespace bingo
          * Evaluate the derivatives of the equation associated with an Agraph,
          * at the values x.
          *
+         * Each column of constants is a separate set of constants, evaluated
+         * in the same pass.  With K sets, the evaluation has K columns and
+         * the derivative has K blocks of columns, the derivative with
+         * respect to feature j for set k being column k * num_features + j.
+         *
          * @param stack Nx3 array. The command stack associated with an equation.
          * N is the number of commands in the stack.
          *
@@ -81,6 +92,251 @@ namespace bingo
             const Eigen::Ref<const Eigen::ArrayXXd> &constants,
             const bool param_x_or_c = true);
 
+        /**
+         * @brief Evaluate equation and take derivatives with respect to both
+         * x and the constants.
+         *
+         * Both derivatives are accumulated by one reverse pass over one
+         * forward evaluation.  Their columns are laid out as by
+         * EvaluateWithDerivative.
+         *
+         * @param stack Nx3 array. The command stack associated with an equation.
+         * N is the number of commands in the stack.
+         *
+         * @param x MxD Array. Values at which to evaluate the equations. D is the
+         * dimension in x and M is the number of data points in x.
+         *
+         * @param constants Vector of doubles. Constants that are used in the equation.
+         *
+         * @return EvalAndGradients The evaluation, the derivative with
+         * respect to x and the derivative with respect to the constants.
+         */
+        EvalAndGradients EvaluateWithGradients(
+            const Eigen::Ref<const Eigen::ArrayX3i> &stack,
+            const Eigen::Ref<const Eigen::ArrayXXd> &x,
+            const Eigen::Ref<const Eigen::ArrayXXd> &constants);
+
+        /**
+         * @brief Evaluate equation and its derivative along a direction in x.
+         *
+         * The derivative with respect to x, dotted with the direction at
+         * each point of x, is carried along with the evaluation in forward
+         * mode, so there is no reverse pass and no gradient with respect to
+         * each dimension of x.
+         *
+         * @param stack Nx3 array. The command stack associated with an equation.
+         * N is the number of commands in the stack.
+         *
+         * @param x MxD Array. Values at which to evaluate the equations. D is the
+         * dimension in x and M is the number of data points in x.
+         *
+         * @param constants Vector of doubles. Constants that are used in the equation.
+         *
+         * @param direction MxD Array. Direction of the derivative at each point of x.
+         *
+         * @return EvalAndDerivative The evaluation and the directional
+         * derivative, each with one column per set of constants.
+         */
+        EvalAndDerivative EvaluateWithDirectionalDerivative(
+            const Eigen::Ref<const Eigen::ArrayX3i> &stack,
+            const Eigen::Ref<const Eigen::ArrayXXd> &x,
+            const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+            const Eigen::Ref<const Eigen::ArrayXXd> &direction);
+
+        /**
+         * @brief Evaluate a compiled equation.
+         *
+         * Same as Evaluate, but the command stack has already been compiled
+         * into an EvaluationPlan, so it is not decoded again.
+         *
+         * With a cache, the values of the instructions that depend on x
+         * only are kept by the first evaluation at x and reused by later
+         * evaluations at the same x, so repeated evaluations with other
+         * constants only evaluate the parts of the plan that depend on the
+         * constants.  With rows, only those rows of x are evaluated; they
+         * are gathered one tile at a time as the tiles are evaluated rather
+         * than copied out of x all at once, and the cache is not used.
+         *
+         * @param plan The compiled command stack of an equation.
+         *
+         * @param x MxD Array. Values at which to evaluate the equations.
+         *
+         * @param constants Vector of doubles. Constants that are used in the equation.
+         *
+         * @param options The workspace, cache and rows to use.
+         *
+         * @return Eigen::ArrayXXd The evaluation of the graph with x as the
+         * input data, with one row per row evaluated.
+         */
+        Eigen::ArrayXXd Evaluate(const EvaluationPlan &plan,
+                                 const Eigen::Ref<const Eigen::ArrayXXd> &x,
+                                 const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+                                 const EvaluationOptions &options = EvaluationOptions());
+
+        /**
+         * @brief Evaluate a compiled equation and take derivative.
+         *
+         * The evaluation and derivative are also left in
+         * workspace.evaluation and workspace.derivative.  The cache is only
+         * used for derivatives with respect to the constants, which the
+         * constant-free parts do not contribute to.
+         *
+         * Within a memory budget, when the buffers of the reverse pass
+         * would exceed it, only the values crossing the boundaries of
+         * segments of about sqrt(N) instructions are kept as checkpoints;
+         * the reverse sweep recomputes each segment from them before going
+         * through it, and buffers are released as soon as they are dead.
+         * If even that does not fit, the tiles are made smaller.  The
+         * result is the same as without a budget, but the cache is not
+         * used.
+         *
+         * @param plan The compiled command stack of an equation.
+         *
+         * @param x MxD Array. Values at which to evaluate the equations.
+         *
+         * @param constants Vector of doubles. Constants that are used in the equation.
+         *
+         * @param param_x_or_c true: x derivative, false: c derivative
+         *
+         * @param options The workspace, cache and memory budget to use.
+         *
+         * @return EvalAndDerivative Derivatives of all dimensions of x/constants at location x.
+         */
+        EvalAndDerivative EvaluateWithDerivative(
+            const EvaluationPlan &plan,
+            const Eigen::Ref<const Eigen::ArrayXXd> &x,
+            const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+            const bool param_x_or_c = true,
+            const EvaluationOptions &options = EvaluationOptions());
+
+        /**
+         * @brief Evaluate a compiled equation and take derivatives with
+         * respect to both x and the constants.
+         *
+         * The evaluation is also left in workspace.evaluation, the
+         * derivative with respect to x in workspace.derivative and the
+         * derivative with respect to the constants in
+         * workspace.constant_derivative.
+         *
+         * @param plan The compiled command stack of an equation.
+         *
+         * @param x MxD Array. Values at which to evaluate the equations.
+         *
+         * @param constants Vector of doubles. Constants that are used in the equation.
+         *
+         * @param options The workspace and memory budget to use.
+         *
+         * @return EvalAndGradients The evaluation, the derivative with
+         * respect to x and the derivative with respect to the constants.
+         */
+        EvalAndGradients EvaluateWithGradients(
+            const EvaluationPlan &plan,
+            const Eigen::Ref<const Eigen::ArrayXXd> &x,
+            const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+            const EvaluationOptions &options = EvaluationOptions());
+
+        /**
+         * @brief Evaluate a compiled equation and its derivative along a
+         * direction in x.
+         *
+         * The evaluation and directional derivative are also left in
+         * workspace.evaluation and workspace.derivative.
+         *
+         * @param plan The compiled command stack of an equation.
+         *
+         * @param x MxD Array. Values at which to evaluate the equations.
+         *
+         * @param constants Vector of doubles. Constants that are used in the equation.
+         *
+         * @param direction MxD Array. Direction of the derivative at each point of x.
+         *
+         * @param options The workspace to use.
+         *
+         * @return EvalAndDerivative The evaluation and the directional
+         * derivative, each with one column per set of constants.
+         */
+        EvalAndDerivative EvaluateWithDirectionalDerivative(
+            const EvaluationPlan &plan,
+            const Eigen::Ref<const Eigen::ArrayXXd> &x,
+            const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+            const Eigen::Ref<const Eigen::ArrayXXd> &direction,
+            const EvaluationOptions &options = EvaluationOptions());
+
+        /**
+         * @brief Accumulate the normal equations of the constants of a
+         * compiled equation.
+         *
+         * The residual of each point of x is (f - y) * weight, and the
+         * jacobian is its derivative with respect to the constants.  JᵀJ
+         * and Jᵀr are accumulated tile by tile of rows as the derivatives
+         * are evaluated, so neither the residual nor the jacobian of all
+         * the rows is ever held in memory.
+         *
+         * @param plan The compiled command stack of an equation.
+         *
+         * @param x MxD Array. Values at which to evaluate the equations.
+         *
+         * @param constants Vector of doubles. Constants that are used in the equation.
+         *
+         * @param y M values subtracted from the evaluation.
+         *
+         * @param weights M weights of the residuals, or none for unit weights.
+         *
+         * @param options The cache to use.
+         *
+         * @return std::vector<NormalEquations> The normal equations of each
+         * set of constants.
+         */
+        std::vector<NormalEquations> EvaluateNormalEquations(
+            const EvaluationPlan &plan,
+            const Eigen::Ref<const Eigen::ArrayXXd> &x,
+            const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+            const Eigen::Ref<const Eigen::ArrayXd> &y,
+            const Eigen::Ref<const Eigen::ArrayXd> &weights,
+            const EvaluationOptions &options = EvaluationOptions());
+
+        /**
+         * @brief Evaluate a population of equations in parallel.
+         *
+         * The individuals are spread over the threads of the shared thread
+         * pool (see SetNumThreads).  Individuals are simplified on the
+         * calling thread first.
+         *
+         * @param individuals The equations to evaluate.
+         *
+         * @param x MxD Array. Values at which to evaluate the equations.
+         *
+         * @return std::vector<Eigen::ArrayXXd> The evaluation of each individual.
+         */
+        std::vector<Eigen::ArrayXXd> EvaluatePopulation(
+            const std::vector<AGraph *> &individuals,
+            const Eigen::Ref<const Eigen::ArrayXXd> &x);
+
+        /**
+         * @brief Choose the tile size of a workspace by timing evaluations.
+         *
+         * The plan is evaluated with tiles of 256, 512, ... rows up to the
+         * whole data set, and the fastest tile size is stored in
+         * workspace.tile_rows.
+         *
+         * @param plan The compiled command stack of an equation.
+         *
+         * @param x MxD Array. Representative values of x.
+         *
+         * @param constants Vector of doubles. Constants that are used in the equation.
+         *
+         * @param with_derivative Whether to time derivative evaluations.
+         *
+         * @param workspace Buffers for the evaluation, receiving the tile size.
+         *
+         * @return int The chosen number of rows per tile.
+         */
+        int TuneTileRows(const EvaluationPlan &plan,
+                         const Eigen::Ref<const Eigen::ArrayXXd> &x,
+                         const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+                         const bool with_derivative,
+                         EvaluationWorkspace &workspace);
+
     } // namespace evaluation_backend
 } // namespace bingo
 #endif
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2018 United States Government as represented by the Administrator
+ * of the National Aeronautics and Space Administration. No copyright is claimed
+ * in the United States under Title 17, U.S. Code. All Other Rights Reserved.
+ *
+ * The Bingo Mini-app platform is licensed under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#ifndef INCLUDE_BINGOCPP_EVALUATION_CACHE_H_
+#define INCLUDE_BINGOCPP_EVALUATION_CACHE_H_
+
+#include <vector>
+
+#include <Eigen/Dense>
+
+namespace bingo
+{
+    namespace evaluation_backend
+    {
+        /**
+         * @brief Values of the constant-free parts of an equation at some x.
+         *
+         * Instructions whose shape is kColumnShape depend on x but not on
+         * the constants.  Those read by instructions that depend on the
+         * constants have their values kept here by the first evaluation at
+         * an x, so that later evaluations at the same x, with other
+         * constants, skip the constant-free instructions and only evaluate
+         * the constant-dependent part of the plan.
+         *
+         * The cache recognizes x by its address and size, so x must not be
+         * modified in place while the cache is in use, and the cache must be
+         * cleared whenever the plan it was filled for is recompiled.
+         */
+        struct EvaluationCache
+        {
+            // The x the values were computed for
+            const double *x_data = nullptr;
+            Eigen::Index x_rows = 0;
+            Eigen::Index x_cols = 0;
+            // Whether an evaluation has completed filling the values
+            bool filled = false;
+            // One value per instruction of the plan, empty for instructions
+            // that are not cached
+            std::vector<Eigen::ArrayXXd> values;
+
+            /**
+             * @brief Check whether the values were computed for x.
+             *
+             * @param x Values at which the equation is evaluated.
+             *
+             * @return true if the cached values can be used.
+             */
+            bool IsFilledFor(const Eigen::Ref<const Eigen::ArrayXXd> &x) const
+            {
+                return filled && x.data() == x_data && x.rows() == x_rows &&
+                       x.cols() == x_cols;
+            }
+
+            /**
+             * @brief Drop the values, releasing their memory.
+             */
+            void Clear()
+            {
+                x_data = nullptr;
+                x_rows = 0;
+                x_cols = 0;
+                filled = false;
+                values.clear();
+                values.shrink_to_fit();
+            }
+        };
+    } // namespace evaluation_backend
+} // namespace bingo
+#endif
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2018 United States Government as represented by the Administrator
+ * of the National Aeronautics and Space Administration. No copyright is claimed
+ * in the United States under Title 17, U.S. Code. All Other Rights Reserved.
+ *
+ * The Bingo Mini-app platform is licensed under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#ifndef INCLUDE_BINGOCPP_EVALUATION_OPTIONS_H_
+#define INCLUDE_BINGOCPP_EVALUATION_OPTIONS_H_
+
+#include <cstddef>
+
+#include <Eigen/Dense>
+
+#include <bingocpp/agraph/evaluation_backend/evaluation_cache.h>
+#include <bingocpp/agraph/evaluation_backend/evaluation_workspace.h>
+
+namespace bingo
+{
+    namespace evaluation_backend
+    {
+        /**
+         * @brief Optional inputs of the evaluation of a compiled equation.
+         *
+         * Every option is off by default.  Each evaluation function lists
+         * the options it uses.
+         */
+        struct EvaluationOptions
+        {
+            // Buffers for the evaluation, reused between calls, in which
+            // the results are also left; a thread-local workspace if null
+            EvaluationWorkspace *workspace = nullptr;
+            // Values of the constant-free parts of the plan, filled by the
+            // first evaluation at an x and reused by later ones at that x
+            EvaluationCache *cache = nullptr;
+            // Indices of the rows of x at which to evaluate, all rows if null
+            const Eigen::Ref<const Eigen::ArrayXi> *rows = nullptr;
+            // Bytes for the intermediate buffers of the reverse pass of the
+            // tiles evaluated by each thread, 0 for no budget
+            std::size_t memory_budget = 0;
+        };
+    } // namespace evaluation_backend
+} // namespace bingo
+#endif
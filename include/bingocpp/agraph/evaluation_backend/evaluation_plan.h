@@ -0,0 +1,174 @@
+/*
+ * Copyright 2018 United States Government as represented by the Administrator
+ * of the National Aeronautics and Space Administration. No copyright is claimed
+ * in the United States under Title 17, U.S. Code. All Other Rights Reserved.
+ *
+ * The Bingo Mini-app platform is licensed under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#ifndef INCLUDE_BINGOCPP_EVALUATION_PLAN_H_
+#define INCLUDE_BINGOCPP_EVALUATION_PLAN_H_
+
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include <bingocpp/agraph/evaluation_backend/operator_eval.h>
+
+namespace bingo
+{
+    namespace evaluation_backend
+    {
+        /**
+         * @brief A decoded command of an EvaluationPlan.
+         */
+        struct Instruction
+        {
+            // Operator of the command
+            int node;
+            // Kernels of the operator; the reverse kernel is specialized
+            // for the shape of the operands
+            ForwardKernel forward;
+            ReverseKernel reverse;
+            TangentKernel tangent;
+            // Shape of the result
+            ValueShape shape;
+            // Terminal parameters, or the buffer slots of the operands
+            int param1;
+            int param2;
+            // Buffer slot receiving the result
+            int result;
+            // Instructions that produced the operands, used for adjoints
+            int adjoint1;
+            int adjoint2;
+            // Whether the value is kept by an EvaluationCache: it depends
+            // on x only and is read by an instruction depending on the
+            // constants
+            bool cached;
+        };
+
+        /**
+         * @brief A command stack compiled for repeated evaluation.
+         *
+         * Commands that the last command does not depend on are dropped, and
+         * a liveness analysis assigns the remaining intermediate values to a
+         * small set of buffer slots that are reused once a value is dead.
+         * Two assignments are kept: one for evaluation only, and one for
+         * derivatives, in which the values read by the reverse pass keep
+         * their slots until the end of the evaluation.
+         *
+         * Each instruction carries the kernels of its operator, so the
+         * interpreters walk the instructions without dispatching on the
+         * operator again.  An activity analysis restricts the reverse pass
+         * to the instructions that depend on the targets of
+         * differentiation.
+         */
+        class EvaluationPlan
+        {
+        public:
+            EvaluationPlan() = default;
+
+            /**
+             * @brief Compile a command stack.
+             *
+             * @param stack Nx3 array. The command stack associated with an equation.
+             */
+            explicit EvaluationPlan(const Eigen::Ref<const Eigen::ArrayX3i> &stack);
+
+            /**
+             * @brief Recompile the plan for a new command stack.
+             *
+             * The storage of the plan is reused.
+             *
+             * @param stack Nx3 array. The command stack associated with an equation.
+             */
+            void Compile(const Eigen::Ref<const Eigen::ArrayX3i> &stack);
+
+            /**
+             * @brief Get the decoded instructions in evaluation order.
+             *
+             * @param with_derivative Whether the slot assignment must keep
+             * the values needed by the reverse pass.
+             *
+             * @return const std::vector<Instruction>& The instructions.
+             */
+            const std::vector<Instruction> &GetInstructions(
+                bool with_derivative) const;
+
+            /**
+             * @brief Get the number of buffer slots used by the instructions.
+             *
+             * @param with_derivative Whether the slot assignment must keep
+             * the values needed by the reverse pass.
+             *
+             * @return int The number of slots.
+             */
+            int GetNumSlots(bool with_derivative) const;
+
+            /**
+             * @brief Get the adjoint buffer of each instruction in the
+             * reverse pass.
+             *
+             * Only the instructions whose values vary with the targets of
+             * differentiation, as given by their shapes, are active: they
+             * are on a path from a target to the result.  Active
+             * instructions are numbered from 0, and all inactive ones share
+             * the number GetNumAdjoints, a buffer into which the kernels of
+             * active instructions discard the adjoints of their inactive
+             * operands.
+             *
+             * @param targets The targets of differentiation: kColumnShape
+             * for x, kRowShape for the constants, kFullShape for both.
+             *
+             * @return const std::vector<int>& The adjoint of each instruction.
+             */
+            const std::vector<int> &GetAdjoints(ValueShape targets) const;
+
+            /**
+             * @brief Get the number of active instructions in the reverse
+             * pass.
+             *
+             * @param targets The targets of differentiation, as for
+             * GetAdjoints.
+             *
+             * @return int The number of adjoint buffers, excluding the
+             * discarded one.
+             */
+            int GetNumAdjoints(ValueShape targets) const;
+
+            /**
+             * @brief Get the number of instructions whose values are kept by
+             * an EvaluationCache.
+             *
+             * @return int The number of cached instructions.
+             */
+            int GetNumCachedValues() const;
+
+            /**
+             * @brief Check whether there is anything to evaluate.
+             *
+             * @return true if the compiled stack was empty.
+             */
+            bool IsEmpty() const;
+
+        private:
+            std::vector<Instruction> forward_instructions_;
+            std::vector<Instruction> derivative_instructions_;
+            int num_forward_slots_ = 0;
+            int num_derivative_slots_ = 0;
+            int num_cached_values_ = 0;
+            // indexed by the targets of differentiation
+            std::vector<int> adjoints_[kFullShape + 1];
+            int num_adjoints_[kFullShape + 1] = {};
+        };
+    } // namespace evaluation_backend
+} // namespace bingo
+#endif
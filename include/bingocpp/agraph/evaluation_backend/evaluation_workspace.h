@@ -0,0 +1,97 @@
+/*
+ * Copyright 2018 United States Government as represented by the Administrator
+ * of the National Aeronautics and Space Administration. No copyright is claimed
+ * in the United States under Title 17, U.S. Code. All Other Rights Reserved.
+ *
+ * The Bingo Mini-app platform is licensed under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#ifndef INCLUDE_BINGOCPP_EVALUATION_WORKSPACE_H_
+#define INCLUDE_BINGOCPP_EVALUATION_WORKSPACE_H_
+
+#include <vector>
+
+#include <Eigen/Dense>
+
+namespace bingo
+{
+    namespace evaluation_backend
+    {
+        /**
+         * @brief Reusable buffers for the evaluation of command stacks.
+         *
+         * The operator kernels write into these buffers in place, so once a
+         * workspace has seen a stack of a given size and data set, further
+         * evaluations of similar stacks do not touch the heap.  A workspace
+         * may be owned by the caller or the thread-local default may be used
+         * implicitly.  A workspace must not be shared between threads.
+         */
+        struct EvaluationWorkspace
+        {
+            // One buffer per slot of the evaluation plan for the forward pass
+            std::vector<Eigen::ArrayXXd> forward_eval;
+            // One adjoint buffer per active instruction for the reverse pass,
+            // and one for the discarded adjoints of inactive ones
+            std::vector<Eigen::ArrayXXd> reverse_eval;
+            // One tangent buffer per slot for directional derivatives
+            std::vector<Eigen::ArrayXXd> tangent_eval;
+            // Result of the last evaluation
+            Eigen::ArrayXXd evaluation;
+            // Result of the last derivative evaluation; the derivative
+            // with respect to x when both derivatives are taken
+            Eigen::ArrayXXd derivative;
+            // Derivative with respect to the constants when both
+            // derivatives are taken
+            Eigen::ArrayXXd constant_derivative;
+            // Rows of x gathered for the tile being evaluated, when an
+            // evaluation is of rows listed by index
+            Eigen::ArrayXXd gathered_x;
+            // Buffers released by a checkpointed reverse pass, reused before
+            // new ones are allocated
+            std::vector<Eigen::ArrayXXd> spare_buffers;
+            // Number of rows of x evaluated at a time.  The whole plan is
+            // run on one tile of rows before moving to the next, so the
+            // buffers stay in cache for large data sets.  0 selects a tile
+            // size from the size of the plan.
+            int tile_rows = 0;
+
+            /**
+             * @brief Make sure there are enough buffers for an evaluation.
+             *
+             * Buffers are never released, so their memory is reused by
+             * later evaluations.
+             *
+             * @param num_slots Number of forward buffer slots.
+             *
+             * @param num_adjoints Number of adjoint buffers.
+             *
+             * @param num_tangents Number of tangent buffers.
+             */
+            void Reserve(std::size_t num_slots, std::size_t num_adjoints = 0,
+                         std::size_t num_tangents = 0)
+            {
+                if (forward_eval.size() < num_slots)
+                {
+                    forward_eval.resize(num_slots);
+                }
+                if (reverse_eval.size() < num_adjoints)
+                {
+                    reverse_eval.resize(num_adjoints);
+                }
+                if (tangent_eval.size() < num_tangents)
+                {
+                    tangent_eval.resize(num_tangents);
+                }
+            }
+        };
+    } // namespace evaluation_backend
+} // namespace bingo
+#endif
@@ -25,21 +25,87 @@ namespace bingo
 {
     namespace evaluation_backend
     {
+        /*
+         * Shape of a value during evaluation, as bit flags: whether it
+         * varies between sets of constants (columns) and between samples
+         * of x (rows).  The shape of an operator is the union of the shapes
+         * of its operands.
+         */
+        enum ValueShape
+        {
+            kScalarShape = 0,
+            kRowShape = 1,
+            kColumnShape = 2,
+            kFullShape = kRowShape | kColumnShape
+        };
+
+        /*
+         * Signature of the forward evaluation kernel of an operator.
+         */
+        typedef void (*ForwardKernel)(int param1, int param2,
+                                      const Eigen::Ref<const Eigen::ArrayXXd> &x,
+                                      const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+                                      const std::vector<Eigen::ArrayXXd> &forward_eval,
+                                      Eigen::ArrayXXd &result);
+
+        /*
+         * Signature of the reverse evaluation kernel of an operator.
+         */
+        typedef void (*ReverseKernel)(int reverse_index, int param1, int param2,
+                                      const Eigen::ArrayXXd &forward_result,
+                                      const Eigen::ArrayXXd &forward_param1,
+                                      const Eigen::ArrayXXd &forward_param2,
+                                      std::vector<Eigen::ArrayXXd> &reverse_eval);
+
+        /*
+         * Signature of the tangent kernel of an operator, which writes the
+         * derivative of the result along a direction into tangent_index
+         * from the tangents of the operands in param1 and param2.
+         */
+        typedef void (*TangentKernel)(int tangent_index, int param1, int param2,
+                                      const Eigen::ArrayXXd &forward_result,
+                                      const Eigen::ArrayXXd &forward_param1,
+                                      const Eigen::ArrayXXd &forward_param2,
+                                      std::vector<Eigen::ArrayXXd> &tangent_eval);
+
+        /*
+         * Looks up the forward, reverse and tangent kernels of an operation
+         * node, so they can be resolved once rather than on every
+         * evaluation.  The tangents of terminals are set by the caller, so
+         * their tangent kernels do nothing.
+         */
+        ForwardKernel GetForwardKernel(int node);
+        ReverseKernel GetReverseKernel(int node);
+        TangentKernel GetTangentKernel(int node);
+
+        /*
+         * Looks up the reverse kernel of an operation node given the union
+         * of the shapes of its operands.  When the operands do not vary
+         * between samples, a kernel computing the local derivative once is
+         * returned.  Such kernels assume a single set of constants.
+         */
+        ReverseKernel GetReverseKernel(int node, ValueShape operand_shape);
 
         /*
          * Maps param1, param2, x, constants, and forward eval to the correct
-         * forward eval function corresponding to the operation node.
+         * forward eval function corresponding to the operation node.  The
+         * evaluation is written into result, reusing its storage.
          */
-        Eigen::ArrayXXd ForwardEvalFunction(int node, int param1, int param2,
-                                            const Eigen::ArrayXXd &x,
-                                            const Eigen::ArrayXXd &constants,
-                                            std::vector<Eigen::ArrayXXd> &forward_eval);
+        void ForwardEvalFunction(int node, int param1, int param2,
+                                 const Eigen::Ref<const Eigen::ArrayXXd> &x,
+                                 const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+                                 const std::vector<Eigen::ArrayXXd> &forward_eval,
+                                 Eigen::ArrayXXd &result);
         /*
-         * Maps reverse_index, param1, param2, forward evaluation stack and
-         * revese evaluation stack to the corresponding operation node.
+         * Maps reverse_index, param1, param2, the forward evaluations of the
+         * node and its operands, and the reverse evaluation stack to the
+         * corresponding operation node.  reverse_index, param1 and param2
+         * index the reverse evaluation stack.
          */
         void ReverseEvalFunction(int node, int reverse_index, int param1, int param2,
-                                 const std::vector<Eigen::ArrayXXd> &forward_eval,
+                                 const Eigen::ArrayXXd &forward_result,
+                                 const Eigen::ArrayXXd &forward_param1,
+                                 const Eigen::ArrayXXd &forward_param2,
                                  std::vector<Eigen::ArrayXXd> &reverse_eval);
     }
 } // namespace bingo
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2018 United States Government as represented by the Administrator
+ * of the National Aeronautics and Space Administration. No copyright is claimed
+ * in the United States under Title 17, U.S. Code. All Other Rights Reserved.
+ *
+ * The Bingo Mini-app platform is licensed under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#ifndef INCLUDE_BINGOCPP_BACKEND_SIMD_MATH_H_
+#define INCLUDE_BINGOCPP_BACKEND_SIMD_MATH_H_
+
+#include <cstddef>
+
+namespace bingo
+{
+    namespace evaluation_backend
+    {
+        /*
+         * Element-wise functions with vectorized implementations.  kLogAbs
+         * is the logarithm of the absolute value, as used by the log
+         * operator.
+         */
+        enum SimdFunction
+        {
+            kSinFunction,
+            kCosFunction,
+            kExpFunction,
+            kLogAbsFunction,
+            kSinhFunction,
+            kCoshFunction
+        };
+
+        /*
+         * Instruction sets the vectorized functions are compiled for.
+         * kGenericInstructions falls back to Eigen's array functions.
+         */
+        enum InstructionSet
+        {
+            kGenericInstructions,
+            kSse2Instructions,
+            kAvx2Instructions,
+            kAvx512Instructions
+        };
+
+        /**
+         * @brief Evaluate a function over a contiguous array.
+         *
+         * Values the vectorized kernels do not cover (non-finite values,
+         * overflows and very large arguments of sin and cos) are computed
+         * with the standard library, so the results match it to within a
+         * couple of ulps.
+         *
+         * @param function The function to evaluate.
+         *
+         * @param x The n input values.
+         *
+         * @param result The n output values.  May be the same as x.
+         *
+         * @param n Number of values.
+         */
+        void ApplySimdFunction(SimdFunction function, const double *x,
+                               double *result, std::size_t n);
+
+        /**
+         * @brief Accumulate accumulator += scale * adjoint * function(x)
+         * over contiguous arrays.
+         *
+         * @param function The function to evaluate.
+         *
+         * @param x The n input values.
+         *
+         * @param adjoint The n values multiplying the function values.
+         *
+         * @param scale A factor applied to every product.
+         *
+         * @param accumulator The n values accumulated into.
+         *
+         * @param n Number of values.
+         */
+        void AccumulateSimdProduct(SimdFunction function, const double *x,
+                                   const double *adjoint, double scale,
+                                   double *accumulator, std::size_t n);
+
+        /**
+         * @brief Get the instruction set used by the vectorized functions.
+         *
+         * When the library is loaded, the widest instruction set supported
+         * by the processor is selected.
+         *
+         * @return InstructionSet The active instruction set.
+         */
+        InstructionSet GetInstructionSet();
+
+        /**
+         * @brief Check whether the processor supports an instruction set.
+         *
+         * @param instruction_set The instruction set.
+         *
+         * @return bool Whether kernels for it can be run.
+         */
+        bool IsInstructionSetSupported(InstructionSet instruction_set);
+
+        /**
+         * @brief Select the instruction set used by the vectorized functions.
+         *
+         * Must not be called while evaluations are running.
+         *
+         * @param instruction_set The instruction set.
+         *
+         * @throw std::invalid_argument If the processor does not support it.
+         */
+        void SetInstructionSet(InstructionSet instruction_set);
+    } // namespace evaluation_backend
+} // namespace bingo
+
+#endif
@@ -0,0 +1,56 @@
+/*
+ * Copyright 2018 United States Government as represented by the Administrator
+ * of the National Aeronautics and Space Administration. No copyright is claimed
+ * in the United States under Title 17, U.S. Code. All Other Rights Reserved.
+ *
+ * The Bingo Mini-app platform is licensed under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+*/
+#ifndef INCLUDE_BINGOCPP_SIMPLIFICATION_BACKEND_AUTOMATIC_SIMPLIFICATION_H
+#define INCLUDE_BINGOCPP_SIMPLIFICATION_BACKEND_AUTOMATIC_SIMPLIFICATION_H
+
+#include <bingocpp/agraph/simplification_backend/expression.h>
+#include <bingocpp/agraph/simplification_backend/expression_arena.h>
+
+namespace bingo {
+namespace simplification_backend {
+
+/**
+ * @brief Brings an expression to a canonical form.
+ *
+ * Follows the automatic simplification of Cohen, "Computer Algebra and
+ * Symbolic Computation".  Sums and products are flattened and sorted, like
+ * terms are collected, powers of a common base are merged, integer
+ * arithmetic is folded, and identities such as x^0 and x*1 are removed.
+ * Constants take part as numbers whose value is unknown.
+ *
+ * @param expression An expression with sums, products and powers only
+ * (see BuildExpression).
+ *
+ * @param arena The arena making the simplified subexpressions.
+ *
+ * @return The simplified expression.
+ */
+ExpressionPtr AutomaticSimplify(const ExpressionPtr &expression,
+                                ExpressionArena &arena);
+
+/**
+ * @brief The order of operands in simplified sums and products.
+ *
+ * Numbers come first (integers by value, then constants by index), then
+ * variables by index and compound expressions.
+ *
+ * @return bool Whether u is ordered before v.
+ */
+bool ExpressionLess(const ExpressionPtr &u, const ExpressionPtr &v);
+} // namespace simplification_backend
+} // namespace bingo
+#endif
@@ -26,7 +26,7 @@ namespace bingo {
 namespace simplification_backend {
 
 
-std::shared_ptr<const Expression> kOne =
+const std::shared_ptr<const Expression> kOne =
     std::make_shared<const TermExpression>(kInteger, 1);
 
 
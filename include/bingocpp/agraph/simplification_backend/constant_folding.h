@@ -0,0 +1,45 @@
+/*
+ * Copyright 2018 United States Government as represented by the Administrator
+ * of the National Aeronautics and Space Administration. No copyright is claimed
+ * in the United States under Title 17, U.S. Code. All Other Rights Reserved.
+ *
+ * The Bingo Mini-app platform is licensed under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+*/
+#ifndef INCLUDE_BINGOCPP_SIMPLIFICATION_BACKEND_CONSTANT_FOLDING_H
+#define INCLUDE_BINGOCPP_SIMPLIFICATION_BACKEND_CONSTANT_FOLDING_H
+
+#include <bingocpp/agraph/simplification_backend/expression.h>
+#include <bingocpp/agraph/simplification_backend/expression_arena.h>
+
+namespace bingo {
+namespace simplification_backend {
+
+/**
+ * @brief Replaces constant-valued subexpressions with new constants.
+ *
+ * Subexpressions whose value depends on constants but not on variables are
+ * replaced by a single constant, as are the constant-valued operands of sums
+ * and products.  Since constants are optimized, this loses no generality.
+ * New constants are numbered after the largest constant of the expression.
+ * Subexpressions of integers only are left as they are.
+ *
+ * @param expression An automatically simplified expression.
+ *
+ * @param arena The arena making the folded subexpressions.
+ *
+ * @return The expression with folded constants.
+ */
+ExpressionPtr FoldConstants(const ExpressionPtr &expression,
+                            ExpressionArena &arena);
+} // namespace simplification_backend
+} // namespace bingo
+#endif
@@ -17,6 +17,7 @@
 #ifndef INCLUDE_BINGOCPP_SIMPLIFICATION_BACKEND_EXPRESSION_H
 #define INCLUDE_BINGOCPP_SIMPLIFICATION_BACKEND_EXPRESSION_H
 
+#include <cstdint>
 #include <vector>
 #include <iostream>
 #include <typeinfo>
@@ -27,6 +28,9 @@
 namespace bingo {
 namespace simplification_backend {
 
+class Expression;
+typedef std::shared_ptr<const Expression> ExpressionPtr;
+typedef std::vector<ExpressionPtr> ExpressionList;
 
 class Expression: public std::enable_shared_from_this<Expression> {
   public:
@@ -34,6 +38,9 @@ class Expression: public std::enable_shared_from_this<Expression> {
 
     virtual Op GetOperator() const { return operator_; }
 
+    // Structural hash: equal expressions have equal hashes
+    inline std::uint64_t GetHash() const { return hash_; }
+
     virtual bool IsZero() const = 0;
     virtual bool IsOne() const = 0;
     virtual bool IsConstantValued() const = 0;
@@ -45,6 +52,8 @@ class Expression: public std::enable_shared_from_this<Expression> {
 
     bool operator==(const Expression& other) const
     {
+      if (this == &other) return true;
+      if (hash_ != other.hash_) return false;
       if (typeid(*this) != typeid(other) || operator_ != other.operator_) return false;
       return equal(other);
     }
@@ -57,6 +66,7 @@ class Expression: public std::enable_shared_from_this<Expression> {
 
   protected:
     Op operator_;
+    std::uint64_t hash_;
 
     virtual bool equal(const Expression& other) const = 0;
     virtual std::ostream &print(std::ostream &strm) const = 0;
@@ -68,6 +78,8 @@ class TermExpression : public Expression {
     TermExpression(const Op operatr, const int operand);
     virtual ~TermExpression() = default;
 
+    static std::uint64_t Hash(const Op operatr, const int operand);
+
     inline bool IsZero() const {
       return operator_ == kInteger && operand_ == 0;
     }
@@ -78,6 +90,8 @@ class TermExpression : public Expression {
       return operator_ != kVariable; // operator_ == kConstant || operator_ == kInteger;
     }
 
+    inline int GetOperand() const { return operand_; }
+
     //std::vector<std::string> DependsOn() const;
     inline std::shared_ptr<const Expression> GetBase() const { return shared_from_this(); }
     std::shared_ptr<const Expression> GetExponent() const;
@@ -101,9 +115,17 @@ class OpExpression : public Expression {
                  const std::vector<std::shared_ptr<const Expression>> operands);
     virtual ~OpExpression() = default;
 
+    static std::uint64_t Hash(
+        const Op operatr,
+        const std::vector<std::shared_ptr<const Expression>> &operands);
+
     inline bool IsZero() const { return false; }
     inline bool IsOne() const { return false; }
-    bool IsConstantValued() const;
+    inline bool IsConstantValued() const { return is_constant_valued_; }
+
+    inline const std::vector<std::shared_ptr<const Expression>> &GetOperands() const {
+      return operands_;
+    }
 
     //std::vector<std::string> DependsOn() const;
     std::shared_ptr<const Expression> GetBase() const;
@@ -116,6 +138,7 @@ class OpExpression : public Expression {
 
   private:
     std::vector<std::shared_ptr<const Expression>> operands_;
+    bool is_constant_valued_;
 
     bool equal(const Expression& other) const;
     std::ostream &print(std::ostream &strm) const;
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2018 United States Government as represented by the Administrator
+ * of the National Aeronautics and Space Administration. No copyright is claimed
+ * in the United States under Title 17, U.S. Code. All Other Rights Reserved.
+ *
+ * The Bingo Mini-app platform is licensed under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+*/
+#ifndef INCLUDE_BINGOCPP_SIMPLIFICATION_BACKEND_EXPRESSION_ARENA_H
+#define INCLUDE_BINGOCPP_SIMPLIFICATION_BACKEND_EXPRESSION_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <bingocpp/agraph/simplification_backend/expression.h>
+
+namespace bingo {
+namespace simplification_backend {
+
+/**
+ * @brief Creates interned expressions in a memory arena.
+ *
+ * Structurally equal expressions made by an arena are the same node, so
+ * they compare equal by pointer and subexpressions are shared.  Nodes are
+ * allocated from large blocks which are all freed with the arena.
+ * Expressions made by an arena must not outlive it.
+ */
+class ExpressionArena {
+ public:
+  ExpressionArena();
+  ~ExpressionArena();
+  ExpressionArena(const ExpressionArena &) = delete;
+  ExpressionArena &operator=(const ExpressionArena &) = delete;
+
+  /**
+   * @brief Gets the interned integer, variable or constant.
+   */
+  ExpressionPtr MakeTerm(Op operatr, int operand);
+
+  /**
+   * @brief Gets the interned operation on operands.
+   */
+  ExpressionPtr MakeOp(Op operatr, const ExpressionList &operands);
+
+  /**
+   * @brief Gets the interned integer.
+   */
+  ExpressionPtr MakeInteger(int value) { return MakeTerm(kInteger, value); }
+
+  /**
+   * @brief Gets the number of distinct expressions made by the arena.
+   */
+  std::size_t GetNumExpressions() const { return num_expressions_; }
+
+ private:
+  template <typename T>
+  class Allocator;
+
+  std::vector<std::unique_ptr<char[]>> blocks_;
+  std::size_t block_capacity_;
+  std::size_t block_used_;
+  // open addressing table of the expressions by hash
+  std::vector<ExpressionPtr> expressions_;
+  std::size_t num_expressions_;
+
+  void *allocate(std::size_t size, std::size_t alignment);
+  ExpressionPtr insert(std::size_t slot, ExpressionPtr expression);
+};
+} // namespace simplification_backend
+} // namespace bingo
+#endif
@@ -0,0 +1,58 @@
+/*
+ * Copyright 2018 United States Government as represented by the Administrator
+ * of the National Aeronautics and Space Administration. No copyright is claimed
+ * in the United States under Title 17, U.S. Code. All Other Rights Reserved.
+ *
+ * The Bingo Mini-app platform is licensed under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+*/
+#ifndef INCLUDE_BINGOCPP_SIMPLIFICATION_BACKEND_INTERPRETER_H
+#define INCLUDE_BINGOCPP_SIMPLIFICATION_BACKEND_INTERPRETER_H
+
+#include <Eigen/Dense>
+
+#include <bingocpp/agraph/simplification_backend/expression.h>
+#include <bingocpp/agraph/simplification_backend/expression_arena.h>
+
+namespace bingo {
+namespace simplification_backend {
+
+/**
+ * @brief Builds the expression computed by the last command of a stack.
+ *
+ * Subtraction is expressed as a sum with a product by -1 and division as a
+ * product with a power of -1, so that automatic simplification only deals
+ * with sums, products and powers.  Commands used several times become
+ * shared subexpressions.
+ *
+ * @param stack Description of an acyclic graph in stack format.
+ *
+ * @param arena The arena making the expression.
+ *
+ * @return The expression of the last command.
+ */
+ExpressionPtr BuildExpression(const Eigen::ArrayX3i &stack,
+                              ExpressionArena &arena);
+
+/**
+ * @brief Builds a stack computing an expression.
+ *
+ * Sums and products are chained as binary commands, and equal
+ * subexpressions are computed once.
+ *
+ * @param expression The expression.
+ *
+ * @return Description of an acyclic graph in stack format.
+ */
+Eigen::ArrayX3i BuildStack(const ExpressionPtr &expression);
+} // namespace simplification_backend
+} // namespace bingo
+#endif
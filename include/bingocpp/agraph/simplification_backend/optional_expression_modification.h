@@ -0,0 +1,44 @@
+/*
+ * Copyright 2018 United States Government as represented by the Administrator
+ * of the National Aeronautics and Space Administration. No copyright is claimed
+ * in the United States under Title 17, U.S. Code. All Other Rights Reserved.
+ *
+ * The Bingo Mini-app platform is licensed under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+*/
+#ifndef INCLUDE_BINGOCPP_SIMPLIFICATION_BACKEND_OPTIONAL_EXPRESSION_MODIFICATION_H
+#define INCLUDE_BINGOCPP_SIMPLIFICATION_BACKEND_OPTIONAL_EXPRESSION_MODIFICATION_H
+
+#include <bingocpp/agraph/simplification_backend/expression.h>
+#include <bingocpp/agraph/simplification_backend/expression_arena.h>
+
+namespace bingo {
+namespace simplification_backend {
+
+/**
+ * @brief Reintroduces subtraction and division into an expression.
+ *
+ * Terms of a sum with a negative integer coefficient are subtracted from
+ * the remaining terms, and factors of a product with a negative integer
+ * exponent divide the remaining factors.  This reverses the rewriting done
+ * by BuildExpression and yields shorter stacks.
+ *
+ * @param expression An automatically simplified expression.
+ *
+ * @param arena The arena making the modified subexpressions.
+ *
+ * @return The expression with subtractions and divisions.
+ */
+ExpressionPtr InsertSubtractionAndDivision(const ExpressionPtr &expression,
+                                           ExpressionArena &arena);
+} // namespace simplification_backend
+} // namespace bingo
+#endif
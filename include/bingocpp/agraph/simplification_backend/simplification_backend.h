@@ -52,6 +52,52 @@ Eigen::ArrayX3i SimplifyStack(const Eigen::ArrayX3i &stack);
 // TODO documentation and change simplify_stack to reduce stack
 Eigen::ArrayX3i PythonSimplifyStack(const Eigen::ArrayX3i &stack);
 
+/**
+ * @brief Algebraically simplifies a stack.
+ *
+ * The expression of the stack is brought to a canonical form, in which like
+ * terms are collected, powers of a common base are merged and integer
+ * arithmetic is folded.  Constant-valued subexpressions are then replaced
+ * with new constants, and subtraction and division are reintroduced.  The
+ * native counterpart of PythonSimplifyStack.
+ *
+ * @param stack Description of an acyclic graph in stack format.
+ *
+ * @return Simplified stack.  Constants may be renumbered.
+ */
+Eigen::ArrayX3i CppSimplifyStack(const Eigen::ArrayX3i &stack);
+
+/**
+ * @brief Algebraically simplifies a stack with the chosen simplifier.
+ *
+ * This is what AGraph uses when simplification is enabled.  It is
+ * PythonSimplifyStack unless native simplification is enabled, since the
+ * layout and constant numbering of CppSimplifyStack's output have not been
+ * shown to match those of the Python backend.
+ *
+ * @param stack Description of an acyclic graph in stack format.
+ *
+ * @return Simplified stack.
+ */
+Eigen::ArrayX3i AlgebraicSimplifyStack(const Eigen::ArrayX3i &stack);
+
+/**
+ * @brief Choose whether AlgebraicSimplifyStack uses CppSimplifyStack.
+ *
+ * Stacks simplified before the change are not simplified again.
+ *
+ * @param use_native Whether to simplify natively instead of with the
+ * Python backend.  Off by default.
+ */
+void SetUseNativeSimplification(bool use_native);
+
+/**
+ * @brief Check whether AlgebraicSimplifyStack uses CppSimplifyStack.
+ *
+ * @return bool Whether native simplification is enabled.
+ */
+bool GetUseNativeSimplification();
+
 /**
  * @brief Finds which commands are utilized in a stack.
  *
@@ -63,6 +109,23 @@ Eigen::ArrayX3i PythonSimplifyStack(const Eigen::ArrayX3i &stack);
  * @return vector describing which commands in the stack are used.
  */
 std::vector<bool> GetUtilizedCommands(const Eigen::ArrayX3i &stack);
+
+/**
+ * @brief Finds which constants of a stack enter it linearly.
+ *
+ * The last command of the stack is affine in the linear constants taken
+ * together: they are only added, subtracted, multiplied by subexpressions
+ * free of linear constants, or divided by them.  Where a constant enters
+ * nonlinearly, as in c0 * exp(c1 * x0), it is left to the other constants;
+ * of a product of two subexpressions both holding linear constants, the
+ * constants of the one holding fewer are left out.
+ *
+ * @param stack Description of an acyclic graph in stack format, with the
+ * constants numbered by their first parameter.
+ *
+ * @return vector describing which constants are linear, by number.
+ */
+std::vector<bool> FindLinearConstants(const Eigen::ArrayX3i &stack);
 } // namespace simplification_backend
 } // namespace bingo
 #endif
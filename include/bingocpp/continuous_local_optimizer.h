@@ -0,0 +1,208 @@
+/*
+ * Copyright 2018 United States Government as represented by the Administrator
+ * of the National Aeronautics and Space Administration. No copyright is claimed
+ * in the United States under Title 17, U.S. Code. All Other Rights Reserved.
+ *
+ * The Bingo Mini-app platform is licensed under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+*/
+#ifndef BINGOCPP_INCLUDE_BINGOCPP_CONTINUOUS_LOCAL_OPTIMIZER_H_
+#define BINGOCPP_INCLUDE_BINGOCPP_CONTINUOUS_LOCAL_OPTIMIZER_H_
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "bingocpp/agraph/agraph.h"
+#include "bingocpp/fitness_function.h"
+#include "bingocpp/gradient_mixin.h"
+
+namespace bingo {
+
+enum LocalOptimizationAlgorithm {
+  // Levenberg-Marquardt with adaptive damping, "lm"
+  kLevenbergMarquardt,
+  // Trust region with dogleg steps, "dogleg"
+  kDogleg,
+  // Limited memory BFGS on the scalar fitness, "lbfgs"
+  kLbfgs
+};
+
+/**
+ * @brief Convergence options of local optimization.
+ *
+ * Optimization stops when any tolerance is met or after max_iterations
+ * evaluations of the fitness vector and jacobian, or of the fitness and
+ * gradient for L-BFGS.
+ *
+ * With variable_projection, least squares solves for the constants that
+ * enter the individual linearly at every evaluation, so only the other
+ * constants are iterated on; each step then takes two evaluations.  It
+ * requires the fitness vector to be affine in the output of the individual,
+ * as that of ExplicitRegression is, and is ignored by L-BFGS.
+ */
+struct LocalOptimizationOptions {
+  int max_iterations = 100;
+  // relative reduction of the cost
+  double function_tolerance = 1.49012e-8;
+  // relative size of a step in the parameters
+  double parameter_tolerance = 1.49012e-8;
+  // largest component of the gradient of the cost
+  double gradient_tolerance = 0.0;
+  // number of corrections kept by L-BFGS
+  int lbfgs_memory = 10;
+  // sets of random initial constants optimized for each individual, of
+  // which the best is kept
+  int num_starts = 1;
+  // solve for linearly entering constants by linear least squares
+  bool variable_projection = false;
+};
+
+struct LocalOptimizationResult {
+  // the best of the optimized sets of constants, linear ones included
+  Eigen::VectorXd params;
+  // half the sum of squared residuals at params, or the fitness for L-BFGS
+  double cost;
+  int num_evaluations;
+  bool converged;
+};
+
+/**
+ * @brief Optimizes the constants of equations against a fitness vector.
+ *
+ * The constants of an AGraph are fit by nonlinear least squares on the
+ * fitness vector of a VectorGradientMixin, using its jacobian, or by L-BFGS
+ * on its scalar fitness and gradient, which also suits metrics like the
+ * mean absolute error that are not sums of squares.  The native
+ * counterpart of the ContinuousLocalOptimization of bingo; it does not call
+ * into Python, so populations can be optimized concurrently.
+ */
+class ContinuousLocalOptimizer {
+ public:
+  /**
+   * @brief Construct a local optimizer.
+   *
+   * @param fitness_function The fitness function.  It must also be a
+   * FitnessFunction, as ExplicitRegression is.
+   *
+   * @param algorithm "lm", "dogleg" or "lbfgs".
+   *
+   * @param param_init_min Lower bound of the random initial constants.
+   *
+   * @param param_init_max Upper bound of the random initial constants.
+   *
+   * @param options Convergence options.
+   *
+   * @param seed Seed of the random initial constants.
+   *
+   * @throw std::invalid_argument If the algorithm is unknown or the fitness
+   * function is not a FitnessFunction.
+   */
+  ContinuousLocalOptimizer(
+      const VectorGradientMixin *fitness_function,
+      const std::string &algorithm = "lm",
+      double param_init_min = -10.0, double param_init_max = 10.0,
+      const LocalOptimizationOptions &options = LocalOptimizationOptions(),
+      unsigned int seed = std::mt19937::default_seed);
+
+  /**
+   * @brief Optimize the constants of an individual if it needs it, then
+   * evaluate its fitness.
+   *
+   * options.num_starts sets of initial constants are drawn at random and
+   * optimized together, see OptimizeParamsMultiStart.
+   *
+   * @param individual The equation to optimize.
+   *
+   * @return double The fitness of the individual.
+   */
+  double EvaluateIndividualFitness(AGraph &individual);
+
+  /**
+   * @brief Optimize the constants of a population in parallel, then
+   * evaluate their fitness.
+   *
+   * Individuals, or the rows of the training data, are spread over the
+   * shared thread pool as in VectorBasedFunction::EvaluatePopulationFitness.
+   * Initial constants are drawn in the order of the individuals, so results
+   * do not depend on the number of threads.
+   *
+   * @param individuals The equations to optimize.
+   *
+   * @return Eigen::ArrayXd The fitness of each individual.
+   */
+  Eigen::ArrayXd EvaluatePopulationFitness(
+      const std::vector<AGraph *> &individuals);
+
+  /**
+   * @brief Optimize the constants of an individual from initial values.
+   *
+   * The optimized constants are set on the individual.
+   *
+   * @param individual The equation to optimize.
+   *
+   * @param initial_params The initial constants.
+   *
+   * @return LocalOptimizationResult The outcome of the optimization.
+   */
+  LocalOptimizationResult OptimizeParams(
+      AGraph &individual, const Eigen::VectorXd &initial_params) const;
+
+  /**
+   * @brief Optimize several sets of constants of an individual, keeping the
+   * best.
+   *
+   * For least squares the sets are advanced in lockstep: each evaluation of
+   * the fitness vector and jacobian takes a step of every set that has not
+   * converged, all sets being evaluated in one pass as the columns of
+   * multi-column constants.  options.max_iterations bounds the number of
+   * these evaluations.  The sets of L-BFGS are optimized one after another.
+   *
+   * The best constants are set on the individual.  The individual caches
+   * its constant-free parts during the optimization, so the training data
+   * must not be modified concurrently.
+   *
+   * @param individual The equation to optimize.
+   *
+   * @param initial_params The initial constants, one set per column.
+   *
+   * @return LocalOptimizationResult The outcome of the best set.
+   *
+   * @throw std::invalid_argument If there are no initial constants, or the
+   * fitness function cannot evaluate several sets of constants at once.
+   */
+  LocalOptimizationResult OptimizeParamsMultiStart(
+      AGraph &individual, const Eigen::MatrixXd &initial_params) const;
+
+  LocalOptimizationAlgorithm GetAlgorithm() const { return algorithm_; }
+
+  const LocalOptimizationOptions &GetOptions() const { return options_; }
+
+  void SetOptions(const LocalOptimizationOptions &options) {
+    options_ = options;
+  }
+
+ private:
+  class EvaluationCaching;
+
+  const VectorGradientMixin *fitness_function_;
+  const FitnessFunction *evaluation_function_;
+  LocalOptimizationAlgorithm algorithm_;
+  LocalOptimizationOptions options_;
+  std::uniform_real_distribution<double> param_distribution_;
+  std::mt19937 generator_;
+
+  Eigen::MatrixXd draw_initial_params(int num_params);
+};
+} // namespace bingo
+#endif // BINGOCPP_INCLUDE_BINGOCPP_CONTINUOUS_LOCAL_OPTIMIZER_H_
@@ -18,12 +18,20 @@
 #define BINGOCPP_INCLUDE_BINGOCPP_EQUATION_H_
 
 #include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 #include <Eigen/Dense>
 
+#include <bingocpp/normal_equations.h>
+
 namespace bingo {
  
 typedef std::pair<Eigen::ArrayXXd, Eigen::ArrayXXd> EvalAndDerivative;
+// The evaluation and the derivatives with respect to x and the constants
+typedef std::tuple<Eigen::ArrayXXd, Eigen::ArrayXXd, Eigen::ArrayXXd>
+    EvalAndGradients;
 
 class Equation {
  public:
@@ -40,7 +48,28 @@ class Equation {
    * @return Eigen::ArrayXXd The evaluation of function at points x.
    */
   virtual Eigen::ArrayXXd 
-  EvaluateEquationAt(const Eigen::ArrayXXd &x) = 0;
+  EvaluateEquationAt(const Eigen::Ref<const Eigen::ArrayXXd> &x) = 0;
+
+  /**
+   * @brief Evaluate the Equation at some rows of x
+   * 
+   * Evaluation of the Equation at the points of x listed in rows.  The
+   * default copies the rows before evaluating them; equations that can
+   * gather them as they are evaluated override it.
+   * 
+   * @param x Values from which points are taken. x is MxD where D is the 
+   * number of dimensions in x and M is the number of data points in x.
+   * 
+   * @param rows N indices of the points of x at which to evaluate.
+   * 
+   * @return Eigen::ArrayXXd The evaluation of function at the N points.
+   */
+  virtual Eigen::ArrayXXd
+  EvaluateEquationAtRows(const Eigen::Ref<const Eigen::ArrayXXd> &x,
+                         const Eigen::Ref<const Eigen::ArrayXi> &rows) {
+    Eigen::ArrayXXd x_rows = x(rows, Eigen::all);
+    return EvaluateEquationAt(x_rows);
+  }
 
   /**
    * @brief Evaluate the Equation and get its derivatives
@@ -55,7 +84,31 @@ class Equation {
    * along the points x and the derivative of the equation with respect to x.
    */
   virtual EvalAndDerivative
-  EvaluateEquationWithXGradientAt(const Eigen::ArrayXXd &x) = 0;
+  EvaluateEquationWithXGradientAt(const Eigen::Ref<const Eigen::ArrayXXd> &x) = 0;
+
+  /**
+   * @brief Evaluate the Equation and get its derivative along a direction
+   * 
+   * Evaluation of the Equation along points x and the gradient of the
+   * equation with respect to x dotted with the direction at each point.
+   * The default takes the gradient; equations that can propagate the
+   * direction through their evaluation override it.
+   * 
+   * @param x Values at which to evaluate the equations. x is MxD where D is the 
+   * number of dimensions in x and M is the number of data points in x.
+   * 
+   * @param direction MxD direction of the derivative at each point of x.
+   * 
+   * @return EvalAndDerivative The evaluation of the function of this Equation 
+   * along the points x and its directional derivative at each point.
+   */
+  virtual EvalAndDerivative
+  EvaluateEquationWithXDirectionalDerivativeAt(const Eigen::Ref<const Eigen::ArrayXXd> &x,
+                                               const Eigen::Ref<const Eigen::ArrayXXd> &direction) {
+    EvalAndDerivative eval_and_grad = EvaluateEquationWithXGradientAt(x);
+    Eigen::ArrayXXd df_dv = (eval_and_grad.second * direction).rowwise().sum();
+    return std::make_pair(eval_and_grad.first, df_dv);
+  }
 
   /**
    * @brief Evaluate the Equation and get its derivatives.
@@ -71,7 +124,46 @@ class Equation {
    * the constants of the equation.
    */
   virtual EvalAndDerivative
-  EvaluateEquationWithLocalOptGradientAt(const Eigen::ArrayXXd &x) = 0;
+  EvaluateEquationWithLocalOptGradientAt(const Eigen::Ref<const Eigen::ArrayXXd> &x) = 0;
+
+  /**
+   * @brief Get the normal equations of fitting the constants to y.
+   * 
+   * JᵀJ and Jᵀr of the residual (f(x) - y) * weights with respect to the
+   * constants.  The default forms the jacobian of all of x; equations that
+   * can accumulate the products as they are evaluated override it.
+   * 
+   * @param x Values at which to evaluate the equations. x is MxD where D is the 
+   * number of dimensions in x and M is the number of data points in x.
+   * 
+   * @param y M values to fit.
+   * 
+   * @param weights M weights of the residuals, or none for unit weights.
+   * 
+   * @return std::vector<NormalEquations> The normal equations of each set
+   * of constants of this Equation.
+   */
+  virtual std::vector<NormalEquations>
+  EvaluateNormalEquationsAt(const Eigen::Ref<const Eigen::ArrayXXd> &x,
+                            const Eigen::Ref<const Eigen::ArrayXd> &y,
+                            const Eigen::Ref<const Eigen::ArrayXd> &weights = Eigen::ArrayXd()) {
+    EvalAndDerivative df_dc = EvaluateEquationWithLocalOptGradientAt(x);
+    int num_sets = df_dc.first.cols();
+    int num_constants = num_sets > 0 ? df_dc.second.cols() / num_sets : 0;
+    std::vector<NormalEquations> normal_equations;
+    for (int set = 0; set < num_sets; ++set) {
+      Eigen::ArrayXd residual = df_dc.first.col(set) - y;
+      Eigen::ArrayXXd jacobian =
+          df_dc.second.middleCols(set * num_constants, num_constants);
+      if (weights.size() != 0) {
+        residual *= weights;
+        jacobian.colwise() *= weights;
+      }
+      normal_equations.emplace_back(num_constants);
+      normal_equations.back().Accumulate(jacobian.matrix(), residual.matrix());
+    }
+    return normal_equations;
+  }
 
   /**
    * @brief Get the Complexity of this Equation.
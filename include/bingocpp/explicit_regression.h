@@ -17,9 +17,11 @@
 #ifndef BINGOCPP_INCLUDE_BINGOCPP_EXPLICIT_REGRESSION_H_
 #define BINGOCPP_INCLUDE_BINGOCPP_EXPLICIT_REGRESSION_H_
 
+#include <memory>
 #include <string>
 #include <vector>
 #include <tuple>
+#include <utility>
 
 #include <Eigen/Core>
 
@@ -35,25 +37,30 @@ typedef std::tuple<ExplicitTrainingDataState, std::string, int> ExplicitRegressi
 namespace bingo {
 
 struct ExplicitTrainingData : TrainingData {
-  Eigen::ArrayXXd x;
+  TrainingArray x;
 
-  Eigen::ArrayXXd y;
+  TrainingArray y;
 
+  // copies the arrays once, into storage shared by all copies of the data
   ExplicitTrainingData(const Eigen::ArrayXXd &input,
-                       const Eigen::ArrayXXd &output) {
-    x = input;
-    y = output;
+                       const Eigen::ArrayXXd &output)
+      : ExplicitTrainingData(
+            std::make_shared<const ExplicitTrainingDataState>(input, output)) {
   }
 
-  ExplicitTrainingData(const ExplicitTrainingData &other) {
-    x = other.x;
-    y = other.y;
-  }
+  // views arrays kept alive by owner, without copying them
+  ExplicitTrainingData(const TrainingArray &input,
+                       const TrainingArray &output,
+                       std::shared_ptr<const void> owner)
+      : x(input), y(output), owner_(std::move(owner)) { }
 
-  ExplicitTrainingData(const ExplicitTrainingDataState &state) {
-    x = std::get<0>(state);
-    y = std::get<1>(state);
-  }
+  // shares the arrays of other
+  ExplicitTrainingData(const ExplicitTrainingData &other)
+      : x(other.x), y(other.y), owner_(other.owner_) { }
+
+  ExplicitTrainingData(const ExplicitTrainingDataState &state)
+      : ExplicitTrainingData(
+            std::make_shared<const ExplicitTrainingDataState>(state)) { }
 
   ~ExplicitTrainingData() { }
 
@@ -61,6 +68,9 @@ struct ExplicitTrainingData : TrainingData {
 
   ExplicitTrainingData *GetItem(const std::vector<int> &items);
 
+  // rows [begin, end), sharing the arrays of this data
+  ExplicitTrainingData *GetRange(int begin, int end);
+
   ExplicitTrainingDataState DumpState() {
     return ExplicitTrainingDataState(x, y);
   }
@@ -68,18 +78,38 @@ struct ExplicitTrainingData : TrainingData {
   int Size() {
     return x.rows();
   }
+
+ private:
+  std::shared_ptr<const void> owner_;
+
+  explicit ExplicitTrainingData(
+      const std::shared_ptr<const ExplicitTrainingDataState> &storage)
+      : ExplicitTrainingData(ViewOf(std::get<0>(*storage)),
+                             ViewOf(std::get<1>(*storage)), storage) { }
 };
 
+typedef TrainingDataView<ExplicitTrainingData> ExplicitTrainingDataView;
+
 class ExplicitRegression : public VectorGradientMixin, public VectorBasedFunction {
  public:
   ExplicitRegression(ExplicitTrainingData *training_data,
                      std::string metric="mae",
                      bool relative=false) :
-      VectorGradientMixin(new ExplicitTrainingData(*training_data), metric),
+      VectorGradientMixin(training_data, metric),
       VectorBasedFunction(new ExplicitTrainingData(*training_data), metric) {
       relative_ = relative;
   }
 
+  // fits the rows of a view; the error is evaluated without copying them
+  ExplicitRegression(ExplicitTrainingDataView *training_data,
+                     std::string metric="mae",
+                     bool relative=false) :
+      VectorGradientMixin(training_data, metric),
+      VectorBasedFunction(new ExplicitTrainingDataView(*training_data),
+                          metric) {
+      relative_ = relative;
+  }
+
   ExplicitRegression(const ExplicitRegressionState &state):
       VectorBasedFunction(new ExplicitTrainingData(std::get<0>(state)),
                           std::get<1>(state)){
@@ -97,10 +127,38 @@ class ExplicitRegression : public VectorGradientMixin, public VectorBasedFunctio
 
   Eigen::ArrayXd EvaluateFitnessVector(Equation &individual) const;
 
+  // gathers the rows as they are evaluated
+  Eigen::ArrayXd EvaluateFitnessVectorAtRows(Equation &individual,
+                                             const Eigen::ArrayXi &rows) const;
+
+  // evaluates the rows in chunks, in order
+  BoundedFitness EvaluateIndividualFitnessWithin(Equation &individual,
+                                                 double bound) const;
+
   FitnessVectorAndJacobian GetFitnessVectorAndJacobian(Equation &individual) const;
 
+  FitnessVectorsAndJacobians GetFitnessVectorsAndJacobians(Equation &individual) const;
+
+  std::vector<NormalEquations> GetNormalEquations(Equation &individual) const;
+
   private:
    bool relative_;
+
+   Eigen::ArrayXd fitness_vector_of(Equation &individual,
+                                    const TrainingArray &x,
+                                    const TrainingArray &y) const;
+
+   Eigen::ArrayXd fitness_vector_at_rows(
+       Equation &individual, const ExplicitTrainingData &data,
+       const Eigen::Ref<const Eigen::ArrayXi> &rows) const;
+
+   FitnessVectorsAndJacobians fitness_vectors_and_jacobians(
+       Equation &individual, const TrainingArray &x,
+       const TrainingArray &y) const;
+
+   std::vector<NormalEquations> normal_equations(
+       Equation &individual, const TrainingArray &x,
+       const TrainingArray &y) const;
 };
 } // namespace bingo
 #endif // BINGOCPP_INCLUDE_BINGOCPP_EXPLICIT_REGRESSION_H_
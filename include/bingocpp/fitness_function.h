@@ -17,14 +17,18 @@
 #ifndef BINGOCPP_INCLUDE_BINGOCPP_FITNESS_FUNCTION_H_
 #define BINGOCPP_INCLUDE_BINGOCPP_FITNESS_FUNCTION_H_
 
+#include <atomic>
+#include <cmath>
 #include <stdexcept>
 #include <string>
 #include <unordered_set>
 #include <functional>
+#include <vector>
 
 #include <bingocpp/agraph/agraph.h>
 #include <bingocpp/equation.h>
 #include <bingocpp/training_data.h>
+#include <bingocpp/thread_pool.h>
 
 namespace metric_functions {
 
@@ -48,16 +52,40 @@ inline bool metric_found(const std::unordered_set<std::string> &set,
   return set.find(metric) != set.end();
 }
 
-inline double mean_absolute_error(const Eigen::ArrayXd &fitness_vector) {
-  return fitness_vector.abs().mean();
+// Mean of block_sum over blocks of the fitness vector.  Large vectors are
+// summed on the shared thread pool; the partial sums of the blocks are
+// reduced in order, so the result does not depend on the number of threads.
+template <typename BlockSum>
+inline double blockwise_mean(const Eigen::ArrayXd &fitness_vector,
+                             const BlockSum &block_sum) {
+  int size = fitness_vector.size();
+  if (size < 2 * bingo::kMinParallelRows) {
+    return block_sum(fitness_vector.segment(0, size)) / size;
+  }
+  int num_blocks = size / bingo::kMinParallelRows;
+  Eigen::ArrayXd partial_sums(num_blocks);
+  bingo::GetThreadPool()->ParallelFor(num_blocks, [&](int block) {
+    int begin = static_cast<long>(size) * block / num_blocks;
+    int end = static_cast<long>(size) * (block + 1) / num_blocks;
+    partial_sums(block) = block_sum(fitness_vector.segment(begin, end - begin));
+  });
+  return partial_sums.sum() / size;
 }
 
-inline double root_mean_squared_error(const Eigen::ArrayXd &fitness_vector) {
-  return sqrt(fitness_vector.square().mean());
+inline double mean_absolute_error(const Eigen::ArrayXd &fitness_vector) {
+  return blockwise_mean(fitness_vector, [](const auto &block) {
+    return block.abs().sum();
+  });
 }
 
 inline double mean_squared_error(const Eigen::ArrayXd &fitness_vector) {
-  return fitness_vector.square().mean();
+  return blockwise_mean(fitness_vector, [](const auto &block) {
+    return block.square().sum();
+  });
+}
+
+inline double root_mean_squared_error(const Eigen::ArrayXd &fitness_vector) {
+  return sqrt(mean_squared_error(fitness_vector));
 }
 } // namespace metric_functions
 
@@ -68,12 +96,22 @@ class FitnessFunction {
   inline FitnessFunction(TrainingData *training_data = nullptr) :
     eval_count_(0), training_data_(training_data) { }
 
+  FitnessFunction(const FitnessFunction &other) :
+    eval_count_(other.eval_count_.load()),
+    training_data_(other.training_data_) { }
+
+  FitnessFunction &operator=(const FitnessFunction &other) {
+    eval_count_ = other.eval_count_.load();
+    training_data_ = other.training_data_;
+    return *this;
+  }
+
   virtual ~FitnessFunction() { }
 
   virtual double EvaluateIndividualFitness(Equation &individual) const = 0;
 
   int GetEvalCount() const {
-    return eval_count_;
+    return eval_count_.load();
   }
 
   void SetEvalCount(int eval_count) {
@@ -89,22 +127,51 @@ class FitnessFunction {
   }
 
  protected:
-  mutable int eval_count_;
+  // atomic, since individuals may be evaluated concurrently
+  mutable std::atomic<int> eval_count_;
   TrainingData* training_data_;
 };
 
+// The fitness of an individual, or a lower bound of it when its evaluation
+// stopped once the fitness was known to be worse than a bound
+struct BoundedFitness {
+  double fitness;
+  bool is_lower_bound;
+};
+
+enum MinibatchSampling {
+  // consecutive slices of a random permutation of the rows, which is
+  // reshuffled once all of its slices have been used
+  kRotatingMinibatch,
+  // one random row from each of minibatch size equal ranges of rows
+  kStratifiedMinibatch
+};
+
 class VectorBasedFunction : public FitnessFunction {
  public:
-  typedef double (VectorBasedFunction::* MetricFunctionPointer)(const Eigen::ArrayXXd&);
   VectorBasedFunction(TrainingData *training_data = nullptr,
                       std::string metric = "mae") :
       FitnessFunction(training_data), metric_(metric) {
     metric_function_ = GetMetric(metric);
+    absolute_metric_ = metric_functions::metric_found(
+        metric_functions::kMeanAbsoluteError, metric);
+    root_metric_ = metric_functions::metric_found(
+        metric_functions::kRootMeanSquaredError, metric);
   }
 
   virtual ~VectorBasedFunction() { }
 
+  // the fitness on the rows of the minibatch, if one is set
   double EvaluateIndividualFitness(Equation &individual) const {
+    if (minibatch_size_ > 0) {
+      return this->metric_function_(
+          EvaluateFitnessVectorAtRows(individual, minibatch_rows_));
+    }
+    return EvaluateFullFitness(individual);
+  }
+
+  // the fitness on all of the training data, as for re-scoring elites
+  double EvaluateFullFitness(Equation &individual) const {
     Eigen::ArrayXd fitness_vector = EvaluateFitnessVector(individual);
     return this->metric_function_(fitness_vector);
   }
@@ -112,10 +179,146 @@ class VectorBasedFunction : public FitnessFunction {
   virtual Eigen::ArrayXd
   EvaluateFitnessVector(Equation &individual) const = 0;
 
+  /**
+   * @brief Evaluate the fitness of an individual, stopping early once it
+   * is worse than a bound.
+   *
+   * Fitness functions that override this evaluate the rows a chunk at a
+   * time.  The metric of all rows is at least the metric taken as if the
+   * rows not evaluated yet had no error, so once that exceeds bound the
+   * other rows are skipped, and it is returned as a lower bound of the
+   * fitness.  The default evaluates all rows.  Minibatches are respected.
+   *
+   * @param individual The equation to evaluate.
+   *
+   * @param bound The worst acceptable fitness, such as that of a
+   * tournament opponent.
+   *
+   * @return BoundedFitness The fitness, exact unless is_lower_bound.
+   */
+  virtual BoundedFitness
+  EvaluateIndividualFitnessWithin(Equation &individual,
+                                  double /* bound */) const {
+    return BoundedFitness{EvaluateIndividualFitness(individual), false};
+  }
+
+  /**
+   * @brief The fitness vector on some rows of the training data.
+   *
+   * The default evaluates all of the training data and keeps the rows;
+   * fitness functions that can evaluate fewer rows override it.
+   *
+   * @param individual The equation to evaluate.
+   *
+   * @param rows Indices of the rows of the training data to evaluate.
+   *
+   * @return Eigen::ArrayXd The fitness vector of the rows.
+   */
+  virtual Eigen::ArrayXd
+  EvaluateFitnessVectorAtRows(Equation &individual,
+                              const Eigen::ArrayXi &rows) const {
+    return EvaluateFitnessVector(individual)(rows);
+  }
+
+  /**
+   * @brief Score individuals on a random minibatch of the rows.
+   *
+   * Individual fitness is then the metric of the rows of the minibatch,
+   * which stay the same until NextMinibatch, so that the individuals of a
+   * generation are compared on the same rows.  The rows of a minibatch
+   * depend only on the seed, its index and the size of the training data,
+   * so any minibatch can be drawn again with SetMinibatchIndex, which
+   * must also be called after the training data is replaced.  Minibatches
+   * must not be changed while individuals are being evaluated.
+   *
+   * @param size Number of rows of a minibatch, or 0 to score on all rows.
+   *
+   * @param sampling How the rows are drawn.
+   *
+   * @param seed Seed of the random draws.
+   */
+  void SetMinibatch(int size,
+                    MinibatchSampling sampling = kRotatingMinibatch,
+                    unsigned int seed = 0);
+
+  // draws the rows of the minibatch with the given index
+  void SetMinibatchIndex(int index);
+
+  void NextMinibatch() {
+    SetMinibatchIndex(minibatch_index_ + 1);
+  }
+
+  int GetMinibatchSize() const {
+    return minibatch_size_;
+  }
+
+  int GetMinibatchIndex() const {
+    return minibatch_index_;
+  }
+
+  // rows of the current minibatch, in increasing order
+  const Eigen::ArrayXi &GetMinibatchRows() const {
+    return minibatch_rows_;
+  }
+
+  /**
+   * @brief Evaluate the fitness of a population in parallel.
+   *
+   * The individuals, or the rows of the training data of each individual,
+   * are spread over the threads of the shared thread pool (see
+   * SetNumThreads and UseRowParallelism).  Individuals are simplified on
+   * the calling thread first.  The Python bindings release the GIL while
+   * the population is evaluated, so fitness functions and individuals
+   * implemented in Python take it again on each call into Python, which
+   * runs those calls one at a time.
+   *
+   * @param individuals The equations to evaluate.
+   *
+   * @return Eigen::ArrayXd The fitness of each individual.
+   */
+  Eigen::ArrayXd
+  EvaluatePopulationFitness(const std::vector<Equation *> &individuals) const {
+    for (Equation *individual : individuals) {
+      individual->GetComplexity();
+    }
+    Eigen::ArrayXd fitness(individuals.size());
+    auto evaluate_individual = [&](int i) {
+      fitness(i) = EvaluateIndividualFitness(*individuals[i]);
+    };
+    int num_rows = minibatch_size_ > 0 ? minibatch_rows_.size()
+                   : training_data_ != nullptr ? training_data_->Size() : 0;
+    if (UseRowParallelism(individuals.size(), num_rows)) {
+      for (std::size_t i = 0; i < individuals.size(); ++i) {
+        evaluate_individual(i);
+      }
+    } else {
+      GetThreadPool()->ParallelFor(individuals.size(), evaluate_individual);
+    }
+    return fitness;
+  }
+
  protected:
   std::string metric_;
 
-  std::function<double(Eigen::ArrayXd)> GetMetric(std::string metric) {
+  // The sum of the terms of the metric over the rows of a fitness vector:
+  // |f| for mae, f² for mse and rmse
+  double MetricSum(const Eigen::ArrayXd &fitness_vector) const {
+    return absolute_metric_ ? fitness_vector.abs().sum()
+                            : fitness_vector.square().sum();
+  }
+
+  double MetricOf(const Eigen::ArrayXd &fitness_vector) const {
+    return metric_function_(fitness_vector);
+  }
+
+  // The metric of num_rows rows whose terms sum to metric_sum
+  double MetricOfSum(double metric_sum, int num_rows) const {
+    double mean = metric_sum / num_rows;
+    return root_metric_ ? std::sqrt(mean) : mean;
+  }
+
+  std::function<double(const Eigen::ArrayXd &)>
+  GetMetric(std::string metric) {
     if (metric_functions::metric_found(metric_functions::kMeanAbsoluteError, metric)) {
       return metric_functions::mean_absolute_error;
     } else if (metric_functions::metric_found(metric_functions::kMeanSquaredError, metric)) {
@@ -128,7 +331,18 @@ class VectorBasedFunction : public FitnessFunction {
   }
 
  private:
-  std::function<double(Eigen::ArrayXd)> metric_function_;
+  std::function<double(const Eigen::ArrayXd &)> metric_function_;
+  bool absolute_metric_;
+  bool root_metric_;
+  int minibatch_size_ = 0;
+  MinibatchSampling minibatch_sampling_ = kRotatingMinibatch;
+  unsigned int minibatch_seed_ = 0;
+  int minibatch_index_ = 0;
+  Eigen::ArrayXi minibatch_rows_;
+  // the rotating permutation of the rows of the current epoch
+  Eigen::ArrayXi permutation_;
+  int permutation_epoch_ = -1;
+  unsigned int permutation_seed_ = 0;
 };
 } // namespace bingo
 
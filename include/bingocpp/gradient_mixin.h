@@ -4,12 +4,15 @@
 #include <Eigen/Dense>
 #include <bingocpp/equation.h>
 #include <bingocpp/fitness_function.h>
+#include <bingocpp/normal_equations.h>
 
 #include <functional>
 #include <cmath>
+#include <vector>
 
 typedef std::tuple<double, Eigen::ArrayXd> FitnessAndGradient;
 typedef std::tuple<Eigen::ArrayXd, Eigen::ArrayXXd> FitnessVectorAndJacobian;
+typedef std::tuple<Eigen::ArrayXXd, Eigen::ArrayXXd> FitnessVectorsAndJacobians;
 
 namespace bingo {
 
@@ -26,6 +29,18 @@ class VectorGradientMixin : public GradientMixin {
 
   virtual FitnessVectorAndJacobian GetFitnessVectorAndJacobian(Equation &individual) const = 0;
 
+  // The fitness vectors and jacobians of all sets of constants of an
+  // individual (the columns of its constants), with one column of fitness
+  // and one block of jacobian columns per set.  The default only supports a
+  // single set of constants.
+  virtual FitnessVectorsAndJacobians GetFitnessVectorsAndJacobians(Equation &individual) const;
+
+  // The normal equations (JᵀJ, Jᵀr and rᵀr) of the fitness vector of each
+  // set of constants.  The default forms them from
+  // GetFitnessVectorsAndJacobians; fitness functions that can have the
+  // individual accumulate them directly override it.
+  virtual std::vector<NormalEquations> GetNormalEquations(Equation &individual) const;
+
  protected:
   static Eigen::ArrayXd mean_absolute_error_derivative(
       const Eigen::ArrayXd &fitness_vector, const Eigen::ArrayXXd &fitness_partials) {
@@ -44,8 +59,9 @@ class VectorGradientMixin : public GradientMixin {
   }
 
  private:
-  std::function<double(Eigen::ArrayXd)> metric_function_;
-  std::function<Eigen::ArrayXd(Eigen::ArrayXd, Eigen::ArrayXXd)> metric_derivative_;
+  std::function<double(const Eigen::ArrayXd &)> metric_function_;
+  std::function<Eigen::ArrayXd(const Eigen::ArrayXd &,
+                               const Eigen::ArrayXXd &)> metric_derivative_;
 };
 
 } // namespace bingo
@@ -17,8 +17,10 @@
 #ifndef BINGOCPP_INCLUDE_BINGOCPP_IMPLICIT_REGRESSION_H_
 #define BINGOCPP_INCLUDE_BINGOCPP_IMPLICIT_REGRESSION_H_
 
+#include <memory>
 #include <string>
 #include <tuple>
+#include <utility>
 
 #include <Eigen/Dense>
 
@@ -36,36 +38,41 @@ namespace bingo {
 
 struct ImplicitTrainingData : TrainingData {
  public:
-  Eigen::ArrayXXd x;
+  TrainingArray x;
 
-  Eigen::ArrayXXd dx_dt;
+  TrainingArray dx_dt;
 
-  ImplicitTrainingData(const Eigen::ArrayXXd &input) {
-    InputAndDeriviative input_and_deriv = CalculatePartials(input);
-    x = input_and_deriv.first;
-    dx_dt = input_and_deriv.second;
-  }
+  ImplicitTrainingData(const Eigen::ArrayXXd &input)
+      : ImplicitTrainingData(std::make_shared<const ImplicitTrainingDataState>(
+            CalculatePartials(input))) { }
 
+  // copies the arrays once, into storage shared by all copies of the data
   ImplicitTrainingData(const Eigen::ArrayXXd &input,
-                       const Eigen::ArrayXXd &derivative) {
-    x = input; 
-    dx_dt = derivative;
-  }
+                       const Eigen::ArrayXXd &derivative)
+      : ImplicitTrainingData(std::make_shared<const ImplicitTrainingDataState>(
+            input, derivative)) { }
 
-  ImplicitTrainingData(ImplicitTrainingData &other) {
-    x = other.x;
-    dx_dt = other.dx_dt;
-  }
+  // views arrays kept alive by owner, without copying them
+  ImplicitTrainingData(const TrainingArray &input,
+                       const TrainingArray &derivative,
+                       std::shared_ptr<const void> owner)
+      : x(input), dx_dt(derivative), owner_(std::move(owner)) { }
 
-  ImplicitTrainingData(const ImplicitTrainingDataState &state) {
-    x = std::get<0>(state);
-    dx_dt = std::get<1>(state);
-  }
+  // shares the arrays of other
+  ImplicitTrainingData(const ImplicitTrainingData &other)
+      : x(other.x), dx_dt(other.dx_dt), owner_(other.owner_) { }
+
+  ImplicitTrainingData(const ImplicitTrainingDataState &state)
+      : ImplicitTrainingData(
+            std::make_shared<const ImplicitTrainingDataState>(state)) { }
 
   ImplicitTrainingData* GetItem(int item);
 
   ImplicitTrainingData* GetItem(const std::vector<int> &items);
 
+  // rows [begin, end), sharing the arrays of this data
+  ImplicitTrainingData* GetRange(int begin, int end);
+
   ImplicitTrainingDataState DumpState() {
     return ImplicitTrainingDataState(x, dx_dt);
   }
@@ -73,8 +80,18 @@ struct ImplicitTrainingData : TrainingData {
   int Size() { 
     return x.rows();
   }
+
+ private:
+  std::shared_ptr<const void> owner_;
+
+  explicit ImplicitTrainingData(
+      const std::shared_ptr<const ImplicitTrainingDataState> &storage)
+      : ImplicitTrainingData(ViewOf(std::get<0>(*storage)),
+                             ViewOf(std::get<1>(*storage)), storage) { }
 };
 
+typedef TrainingDataView<ImplicitTrainingData> ImplicitTrainingDataView;
+
 class ImplicitRegression : public VectorBasedFunction {
  public:
   ImplicitRegression(ImplicitTrainingData *training_data, 
@@ -84,6 +101,16 @@ class ImplicitRegression : public VectorBasedFunction {
     required_params_ = required_params;
   }
 
+  // fits the rows of a view, which are copied when an individual is
+  // evaluated since its derivatives are taken
+  ImplicitRegression(ImplicitTrainingDataView *training_data,
+                     int required_params = kNoneRequired,
+                     std::string metric="mae") :
+      VectorBasedFunction(new ImplicitTrainingDataView(*training_data),
+                          metric) {
+    required_params_ = required_params;
+  }
+
   ImplicitRegression(const ImplicitRegressionState &state):
       VectorBasedFunction(new ImplicitTrainingData(std::get<0>(state)),
                           std::get<1>(state)){
@@ -102,9 +129,16 @@ class ImplicitRegression : public VectorBasedFunction {
 
   Eigen::ArrayXd EvaluateFitnessVector(Equation &equation) const;
 
+  // evaluates a copy of the rows
+  Eigen::ArrayXd EvaluateFitnessVectorAtRows(Equation &equation,
+                                             const Eigen::ArrayXi &rows) const;
+
  private:
   int required_params_;
   static const int kNoneRequired = -1;
+
+  Eigen::ArrayXd fitness_vector(Equation &equation, const TrainingArray &x,
+                                const TrainingArray &dx_dt) const;
 };
 
 class ImplicitRegressionSchmidt : VectorBasedFunction {
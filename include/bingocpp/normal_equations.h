@@ -0,0 +1,60 @@
+#ifndef BINGOCPP_INCLUDE_BINGOCPP_NORMAL_EQUATIONS_H_
+#define BINGOCPP_INCLUDE_BINGOCPP_NORMAL_EQUATIONS_H_
+
+#include <cmath>
+
+#include <Eigen/Dense>
+
+namespace bingo {
+
+/**
+ * @brief The normal equations of a least squares problem.
+ *
+ * For a residual r with jacobian J, the products JᵀJ and Jᵀr and the sum
+ * of squared residuals are all that Gauss-Newton and Levenberg-Marquardt
+ * need.  They take O(n²) memory for n parameters, whatever the number of
+ * residuals, and are sums over the residuals, so they can be accumulated
+ * a few rows of data at a time.
+ */
+struct NormalEquations {
+  // JᵀJ
+  Eigen::MatrixXd jacobian_squared;
+  // Jᵀr
+  Eigen::VectorXd gradient;
+  // rᵀr
+  double squared_residual = 0.0;
+
+  NormalEquations() = default;
+
+  explicit NormalEquations(int num_params)
+      : jacobian_squared(Eigen::MatrixXd::Zero(num_params, num_params)),
+        gradient(Eigen::VectorXd::Zero(num_params)) {}
+
+  /**
+   * @brief Add the rows of a residual and its jacobian.
+   *
+   * @param jacobian The jacobian of the rows, one column per parameter.
+   *
+   * @param residual The residual of the rows.
+   */
+  template <typename Jacobian, typename Residual>
+  void Accumulate(const Jacobian &jacobian, const Residual &residual) {
+    jacobian_squared.noalias() += jacobian.transpose() * jacobian;
+    gradient.noalias() += jacobian.transpose() * residual;
+    squared_residual += residual.squaredNorm();
+  }
+
+  NormalEquations &operator+=(const NormalEquations &other) {
+    jacobian_squared += other.jacobian_squared;
+    gradient += other.gradient;
+    squared_residual += other.squared_residual;
+    return *this;
+  }
+
+  bool AllFinite() const {
+    return std::isfinite(squared_residual) && gradient.allFinite() &&
+           jacobian_squared.allFinite();
+  }
+};
+} // namespace bingo
+#endif // BINGOCPP_INCLUDE_BINGOCPP_NORMAL_EQUATIONS_H_
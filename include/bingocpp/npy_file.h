@@ -0,0 +1,80 @@
+/*
+ * Copyright 2018 United States Government as represented by the Administrator
+ * of the National Aeronautics and Space Administration. No copyright is claimed
+ * in the United States under Title 17, U.S. Code. All Other Rights Reserved.
+ *
+ * The Bingo Mini-app platform is licensed under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#ifndef BINGOCPP_INCLUDE_BINGOCPP_NPY_FILE_H_
+#define BINGOCPP_INCLUDE_BINGOCPP_NPY_FILE_H_
+
+#include <memory>
+#include <string>
+
+#include "bingocpp/explicit_regression.h"
+#include "bingocpp/implicit_regression.h"
+#include "bingocpp/training_data.h"
+
+namespace bingo {
+
+// An array of training data loaded from a file, and the owner of its
+// memory, which is released once the owner and all its copies are gone
+struct LoadedArray {
+  TrainingArray values;
+  std::shared_ptr<const void> owner;
+};
+
+/**
+ * @brief Map an array of doubles in a .npy file into memory.
+ *
+ * The file is mapped read-only, so its pages are read as they are used,
+ * and are shared by all processes mapping the file.  Arrays in column-major
+ * (Fortran) order, or of a single row or column, are viewed where they are
+ * in the file.  Other row-major arrays are transposed once into memory of
+ * their own, since the columns of training data must be contiguous; save
+ * them with numpy.asfortranarray to avoid the copy.
+ *
+ * @param path A .npy file holding a 1d array, taken as one column, or a 2d
+ * array of little-endian float64 ('<f8').
+ *
+ * @return LoadedArray The array and the owner of the mapping.
+ *
+ * @throw std::runtime_error If the file cannot be opened or mapped.
+ * @throw std::invalid_argument If the file is not such a .npy file.
+ */
+LoadedArray MapNpyFile(const std::string &path);
+
+/**
+ * @brief Explicit training data viewing arrays mapped from .npy files.
+ *
+ * @param x_path .npy file of x, as for MapNpyFile.
+ *
+ * @param y_path .npy file of y, with the rows of x.
+ *
+ * @return ExplicitTrainingData* Training data keeping the files mapped.
+ */
+ExplicitTrainingData *LoadExplicitTrainingData(const std::string &x_path,
+                                               const std::string &y_path);
+
+/**
+ * @brief Implicit training data viewing arrays mapped from .npy files.
+ *
+ * @param x_path .npy file of x, as for MapNpyFile.
+ *
+ * @param dx_dt_path .npy file of the derivatives of x, shaped as x.
+ *
+ * @return ImplicitTrainingData* Training data keeping the files mapped.
+ */
+ImplicitTrainingData *LoadImplicitTrainingData(const std::string &x_path,
+                                               const std::string &dx_dt_path);
+} // namespace bingo
+#endif // BINGOCPP_INCLUDE_BINGOCPP_NPY_FILE_H_
@@ -0,0 +1,164 @@
+/*
+ * Copyright 2018 United States Government as represented by the Administrator
+ * of the National Aeronautics and Space Administration. No copyright is claimed
+ * in the United States under Title 17, U.S. Code. All Other Rights Reserved.
+ *
+ * The Bingo Mini-app platform is licensed under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#ifndef BINGOCPP_INCLUDE_BINGOCPP_THREAD_POOL_H_
+#define BINGOCPP_INCLUDE_BINGOCPP_THREAD_POOL_H_
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace bingo {
+
+// Smallest number of rows of data worth splitting across threads
+const int kMinParallelRows = 16384;
+
+/**
+ * @brief A fixed set of threads running parallel loops.
+ *
+ * The tasks of a loop are split into one contiguous range per thread.  A
+ * thread that runs out of work steals half of the remaining range of
+ * another thread, so loops whose tasks vary widely in cost stay balanced.
+ * The calling thread takes part in the loop.  Loops started from inside a
+ * task run serially on the calling thread.
+ */
+class ThreadPool {
+ public:
+  /**
+   * @brief Start the threads of the pool.
+   *
+   * @param num_threads Number of threads running a loop, including the
+   * calling thread.  0 uses the number of hardware threads.
+   */
+  explicit ThreadPool(int num_threads = 0);
+
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  /**
+   * @brief Get the number of threads running a loop.
+   *
+   * @return int Number of threads, including the calling thread.
+   */
+  int GetNumThreads() const;
+
+  /**
+   * @brief Run task(i) for every i in [0, num_tasks) and wait for them.
+   *
+   * If tasks throw, the first exception is rethrown once all the tasks
+   * have finished.
+   *
+   * @param num_tasks Number of tasks.
+   *
+   * @param task Function called with the index of each task.
+   */
+  void ParallelFor(int num_tasks, const std::function<void(int)> &task);
+
+  /**
+   * @brief Run task(begin, end) over contiguous blocks covering
+   * [0, num_items) and wait for them.
+   *
+   * Every block holds at least block_size items, so fewer than
+   * 2 * block_size items run as a single block on the calling thread.
+   *
+   * @param num_items Number of items.
+   *
+   * @param block_size Smallest number of items in a block.
+   *
+   * @param task Function called with the bounds of each block.
+   */
+  void ParallelForBlocks(int num_items, int block_size,
+                         const std::function<void(int, int)> &task);
+
+ private:
+  struct TaskRange {
+    std::mutex mutex;
+    int begin;
+    int end;
+  };
+
+  std::vector<std::thread> workers_;
+  std::unique_ptr<TaskRange[]> ranges_;
+  const std::function<void(int)> *task_;
+  std::exception_ptr error_;
+
+  std::mutex loop_mutex_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+  unsigned long generation_;
+  int busy_workers_;
+  bool stop_;
+
+  void worker_loop(int id);
+  void run_tasks(int id);
+  bool next_task(int id, int &task);
+};
+
+/**
+ * @brief Get the thread pool shared by the parallel evaluations.
+ *
+ * The pool is created on first use with the number of hardware threads.
+ * A parallel evaluation keeps the returned pointer until its loop is done,
+ * so that the pool outlives the loop if SetNumThreads replaces it.
+ *
+ * @return std::shared_ptr<ThreadPool> The shared pool.
+ */
+std::shared_ptr<ThreadPool> GetThreadPool();
+
+/**
+ * @brief Set the number of threads of the shared pool.
+ *
+ * Replaces the shared pool.  Parallel evaluations already running finish
+ * on the old pool, which is destroyed with its last user; later ones use
+ * the new pool.
+ *
+ * @param num_threads Number of threads, 0 for the number of hardware
+ * threads.
+ */
+void SetNumThreads(int num_threads);
+
+/**
+ * @brief Get the number of threads of the shared pool.
+ *
+ * @return int Number of threads.
+ */
+int GetNumThreads();
+
+/**
+ * @brief Choose how to spread the evaluation of a population over threads.
+ *
+ * Splitting the individuals between threads needs no synchronization
+ * within an evaluation, so it is preferred whenever there are enough
+ * individuals to keep the shared pool busy.  Otherwise, large data sets are
+ * better split by rows, each individual in turn using every thread.
+ *
+ * @param num_individuals Number of individuals to evaluate.
+ *
+ * @param num_rows Number of rows of data of each evaluation.
+ *
+ * @return bool Whether to split the rows of each evaluation, rather than the
+ * individuals, across threads.
+ */
+bool UseRowParallelism(int num_individuals, int num_rows);
+} // namespace bingo
+#endif // BINGOCPP_INCLUDE_BINGOCPP_THREAD_POOL_H_
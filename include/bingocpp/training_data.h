@@ -25,6 +25,8 @@
 #ifndef INCLUDE_BINGOCPP_TRAINING_DATA_H_
 #define INCLUDE_BINGOCPP_TRAINING_DATA_H_
 
+#include <memory>
+#include <utility>
 #include <vector>
 
 #include <Eigen/Dense>
@@ -33,6 +35,50 @@
 
 namespace bingo {
 
+/*! \typedef TrainingArray
+ *
+ *  A read-only view of an array of training data.  Its memory is shared by
+ *  all the copies of the training data holding it, and is either owned by
+ *  them or by the caller, such as a NumPy array wrapped without a copy.
+ */
+typedef Eigen::Map<const Eigen::ArrayXXd, 0, Eigen::OuterStride<>>
+    TrainingArray;
+
+/*! \brief a view of all of an array
+ *
+ *  \param[in] values The array, which must outlive the view.
+ *  \return TrainingArray viewing values
+ */
+inline TrainingArray ViewOf(const Eigen::ArrayXXd &values) {
+  return TrainingArray(values.data(), values.rows(), values.cols(),
+                       Eigen::OuterStride<>(values.outerStride()));
+}
+
+/*! \brief a view of consecutive rows of an array
+ *
+ *  \param[in] values The array, which must outlive the view.
+ *  \param[in] begin The first row of the view.
+ *  \param[in] end One past the last row of the view.
+ *  \return TrainingArray viewing rows [begin, end) of values
+ */
+inline TrainingArray RowsOf(const TrainingArray &values, int begin, int end) {
+  return TrainingArray(values.data() + begin, end - begin, values.cols(),
+                       Eigen::OuterStride<>(values.outerStride()));
+}
+
+/*! \brief whether rows are consecutive and increasing
+ *
+ *  Such rows are a range of an array, so need not be copied.
+ */
+inline bool IsRange(const std::vector<int> &rows) {
+  for (std::size_t i = 1; i < rows.size(); ++i) {
+    if (rows[i] != rows[0] + static_cast<int>(i)) {
+      return false;
+    }
+  }
+  return !rows.empty();
+}
+
 /*! \struct TrainingData
  *
  *  An abstract struct to hold the data for fitness calculations
@@ -61,5 +107,66 @@ struct TrainingData {
   */
   virtual int Size() = 0;
 };
+
+/*! \struct TrainingDataView
+ *
+ *  Rows of a training data, listed by index, that reference the arrays of
+ *  the training data instead of copying them.  Fitness functions gather the
+ *  rows of a view a tile at a time as they evaluate it, so taking many
+ *  subsets of the same data, as fitness predictors do, costs little more
+ *  than their indices.  Consecutive rows need no view: GetRange, and
+ *  GetItem of consecutive rows, give training data sharing the arrays.
+ *
+ *  \note Copies of a view share its indices.
+ *
+ *  \tparam Data The training data viewed, whose copies share its arrays.
+ */
+template <typename Data>
+struct TrainingDataView : TrainingData {
+ public:
+  // the viewed training data, sharing the arrays of its parent
+  Data data;
+
+  // the rows of data in the view
+  std::shared_ptr<const Eigen::ArrayXi> rows;
+
+  TrainingDataView(const Data &parent, const std::vector<int> &items)
+      : TrainingDataView(parent, std::make_shared<const Eigen::ArrayXi>(
+            Eigen::Map<const Eigen::ArrayXi>(items.data(), items.size()))) { }
+
+  TrainingDataView(const Data &parent,
+                   std::shared_ptr<const Eigen::ArrayXi> indices)
+      : data(parent), rows(std::move(indices)) { }
+
+  Data *GetItem(int item) {
+    return data.GetItem((*rows)(item));
+  }
+
+  /*! \brief gets a view of some rows of this view
+  *
+  *  \param[in] items The rows of this view to retrieve.
+  *  \return TrainingDataView* of the same arrays, with the selected rows
+  */
+  TrainingDataView *GetItem(const std::vector<int> &items) {
+    auto selected = std::make_shared<Eigen::ArrayXi>(items.size());
+    for (std::size_t i = 0; i < items.size(); ++i) {
+      (*selected)(i) = (*rows)(items[i]);
+    }
+    return new TrainingDataView(data, std::move(selected));
+  }
+
+  /*! \brief copies the rows of the view into training data of their own
+  *
+  *  \return Data* with the rows of the view
+  */
+  Data *Gather() {
+    return data.GetItem(std::vector<int>(rows->data(),
+                                         rows->data() + rows->size()));
+  }
+
+  int Size() {
+    return rows->size();
+  }
+};
 } // namespace bingo
 #endif
@@ -14,7 +14,7 @@ namespace bingo {
 class PyEquation : public Equation {
  public:
   Eigen::ArrayXXd 
-  EvaluateEquationAt(const Eigen::ArrayXXd &x) {
+  EvaluateEquationAt(const Eigen::Ref<const Eigen::ArrayXXd> &x) {
     PYBIND11_OVERLOAD_PURE_NAME(
       Eigen::ArrayXXd,
       Equation,
@@ -25,7 +25,7 @@ class PyEquation : public Equation {
   }
 
   EvalAndDerivative
-  EvaluateEquationWithXGradientAt(const Eigen::ArrayXXd &x) {
+  EvaluateEquationWithXGradientAt(const Eigen::Ref<const Eigen::ArrayXXd> &x) {
     PYBIND11_OVERLOAD_PURE_NAME(
       EvalAndDerivative,
       Equation,
@@ -35,8 +35,34 @@ class PyEquation : public Equation {
     );
   }
 
+  Eigen::ArrayXXd
+  EvaluateEquationAtRows(const Eigen::Ref<const Eigen::ArrayXXd> &x,
+                         const Eigen::Ref<const Eigen::ArrayXi> &rows) {
+    PYBIND11_OVERLOAD_NAME(
+      Eigen::ArrayXXd,
+      Equation,
+      "evaluate_equation_at_rows",
+      EvaluateEquationAtRows,
+      x,
+      rows
+    );
+  }
+
+  EvalAndDerivative
+  EvaluateEquationWithXDirectionalDerivativeAt(const Eigen::Ref<const Eigen::ArrayXXd> &x,
+                                               const Eigen::Ref<const Eigen::ArrayXXd> &direction) {
+    PYBIND11_OVERLOAD_NAME(
+      EvalAndDerivative,
+      Equation,
+      "evaluate_equation_with_x_directional_derivative_at",
+      EvaluateEquationWithXDirectionalDerivativeAt,
+      x,
+      direction
+    );
+  }
+
   EvalAndDerivative
-  EvaluateEquationWithLocalOptGradientAt(const Eigen::ArrayXXd &x) {
+  EvaluateEquationWithLocalOptGradientAt(const Eigen::Ref<const Eigen::ArrayXXd> &x) {
     PYBIND11_OVERLOAD_PURE_NAME(
       EvalAndDerivative,
       Equation,
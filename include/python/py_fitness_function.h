@@ -78,6 +78,18 @@ namespace bingo {
           individual
       );
     }
+
+    Eigen::ArrayXd EvaluateFitnessVectorAtRows(
+        Equation &individual, const Eigen::ArrayXi &rows) const {
+      PYBIND11_OVERLOAD_NAME(
+          Eigen::ArrayXd,
+          VectorBasedFunction,
+          "evaluate_fitness_vector_at_rows",
+          EvaluateFitnessVectorAtRows,
+          individual,
+          rows
+      );
+    }
   };
 
 } // namespace bingo
@@ -48,6 +48,16 @@ class PyVectorGradientMixin : public VectorGradientMixin {
       individual
     );
   }
+
+  FitnessVectorsAndJacobians GetFitnessVectorsAndJacobians(Equation &individual) const {
+    PYBIND11_OVERLOAD_NAME(
+      FitnessVectorsAndJacobians,
+      VectorGradientMixin,
+      "get_fitness_vectors_and_jacobians",
+      GetFitnessVectorsAndJacobians,
+      individual
+    );
+  }
 };
 } // namespace bingo
 #endif //BINGOCPP_INCLUDE_BINGOCPP_PY_GRADIENT_MIXIN_H
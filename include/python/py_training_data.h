@@ -0,0 +1,47 @@
+#ifndef BINGOCPP_INCLUDE_BINGOCPP_PY_TRAINING_DATA_H_
+#define BINGOCPP_INCLUDE_BINGOCPP_PY_TRAINING_DATA_H_
+
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+
+#include <Eigen/Dense>
+
+#include <bingocpp/training_data.h>
+
+namespace bingo {
+  // Float64 arrays in Fortran order are viewed where they are; others are
+  // converted to one once, when the argument is cast
+  typedef pybind11::array_t<double, pybind11::array::f_style |
+                                    pybind11::array::forcecast>
+      NumpyTrainingArray;
+
+  // A view of a 1d or 2d NumPy array, 1d arrays being a column
+  inline TrainingArray ViewOfNumpy(const NumpyTrainingArray &array) {
+    if (array.ndim() > 2) {
+      throw std::invalid_argument(
+          "Training data must have one or two dimensions");
+    }
+    Eigen::Index rows = array.ndim() > 0 ? array.shape(0) : 1;
+    Eigen::Index cols = array.ndim() > 1 ? array.shape(1) : 1;
+    return TrainingArray(array.data(), rows, cols,
+                         Eigen::OuterStride<>(rows));
+  }
+
+  // Keeps NumPy arrays alive for as long as a view of them is.  The last
+  // view may be dropped by any thread, so the GIL is taken to release them.
+  inline std::shared_ptr<const void> NumpyOwner(
+      const pybind11::object &first, const pybind11::object &second) {
+    typedef std::pair<pybind11::object, pybind11::object> Arrays;
+    return std::shared_ptr<const void>(
+        new Arrays(first, second), [](Arrays *arrays) {
+          pybind11::gil_scoped_acquire gil;
+          delete arrays;
+        });
+  }
+} // namespace bingo
+
+#endif // BINGOCPP_INCLUDE_BINGOCPP_PY_TRAINING_DATA_H_
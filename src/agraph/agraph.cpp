@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <limits>
 #include <sstream>
 #include <stdexcept>
@@ -30,6 +31,7 @@ namespace bingo
     genetic_age_ = 0;
     modified_ = false;
     use_simplification_ = use_simplification;
+    cache_evaluations_ = false;
   }
 
   AGraph::AGraph(const AGraph &agraph)
@@ -37,12 +39,14 @@ namespace bingo
     command_array_ = agraph.command_array_;
     simplified_command_array_ = agraph.simplified_command_array_;
     simplified_constants_ = agraph.simplified_constants_;
+    evaluation_plan_ = agraph.evaluation_plan_;
     needs_opt_ = agraph.needs_opt_;
     fitness_ = agraph.fitness_;
     fit_set_ = agraph.fit_set_;
     genetic_age_ = agraph.genetic_age_;
     modified_ = agraph.modified_;
     use_simplification_ = agraph.use_simplification_;
+    cache_evaluations_ = agraph.cache_evaluations_;
   }
 
   AGraph::AGraph(const AGraphState &state)
@@ -50,12 +54,14 @@ namespace bingo
     command_array_ = std::get<0>(state);
     simplified_command_array_ = std::get<1>(state);
     simplified_constants_ = std::get<2>(state);
+    evaluation_plan_.Compile(simplified_command_array_);
     needs_opt_ = std::get<3>(state);
     fitness_ = std::get<4>(state);
     fit_set_ = std::get<5>(state);
     genetic_age_ = std::get<6>(state);
     modified_ = std::get<7>(state);
     use_simplification_ = std::get<8>(state);
+    cache_evaluations_ = false;
   }
 
   AGraph AGraph::Copy()
@@ -92,6 +98,7 @@ namespace bingo
     fitness_ = kFitnessNotSet;
     fit_set_ = false;
     modified_ = true;
+    evaluation_cache_.Clear();
   }
 
   double AGraph::GetFitness() const
@@ -171,8 +178,27 @@ namespace bingo
     return simplified_constants_;
   }
 
+  std::vector<bool> AGraph::GetLinearLocalOptimizationParams()
+  {
+    if (modified_)
+    {
+      update();
+    }
+    return simplification_backend::FindLinearConstants(
+        simplified_command_array_);
+  }
+
+  void AGraph::SetEvaluationCaching(bool enabled)
+  {
+    cache_evaluations_ = enabled;
+    if (!enabled)
+    {
+      evaluation_cache_.Clear();
+    }
+  }
+
   Eigen::ArrayXXd
-  AGraph::EvaluateEquationAt(const Eigen::ArrayXXd &x)
+  AGraph::EvaluateEquationAt(const Eigen::Ref<const Eigen::ArrayXXd> &x)
   {
     if (modified_)
     {
@@ -181,9 +207,10 @@ namespace bingo
     Eigen::ArrayXXd f_of_x;
     try
     {
-      f_of_x = evaluation_backend::Evaluate(this->simplified_command_array_,
+      f_of_x = evaluation_backend::Evaluate(this->evaluation_plan_,
                                             x,
-                                            this->simplified_constants_);
+                                            this->simplified_constants_,
+                                            evaluation_options());
       return f_of_x;
     }
     catch (const std::underflow_error &ue)
@@ -196,8 +223,36 @@ namespace bingo
     }
   }
 
+  Eigen::ArrayXXd
+  AGraph::EvaluateEquationAtRows(const Eigen::Ref<const Eigen::ArrayXXd> &x,
+                                 const Eigen::Ref<const Eigen::ArrayXi> &rows)
+  {
+    if (modified_)
+    {
+      update();
+    }
+    // the cache holds the values of all of x, so is not used for rows of it
+    evaluation_backend::EvaluationOptions options;
+    options.rows = &rows;
+    try
+    {
+      return evaluation_backend::Evaluate(this->evaluation_plan_,
+                                          x,
+                                          this->simplified_constants_,
+                                          options);
+    }
+    catch (const std::underflow_error &ue)
+    {
+      return Eigen::ArrayXXd::Constant(rows.size(), x.cols(), kNaN);
+    }
+    catch (const std::overflow_error &oe)
+    {
+      return Eigen::ArrayXXd::Constant(rows.size(), x.cols(), kNaN);
+    }
+  }
+
   EvalAndDerivative
-  AGraph::EvaluateEquationWithXGradientAt(const Eigen::ArrayXXd &x)
+  AGraph::EvaluateEquationWithXGradientAt(const Eigen::Ref<const Eigen::ArrayXXd> &x)
   {
     if (modified_)
     {
@@ -206,7 +261,7 @@ namespace bingo
     EvalAndDerivative df_dx;
     try
     {
-      df_dx = evaluation_backend::EvaluateWithDerivative(this->simplified_command_array_,
+      df_dx = evaluation_backend::EvaluateWithDerivative(this->evaluation_plan_,
                                                          x,
                                                          this->simplified_constants_,
                                                          true);
@@ -226,8 +281,66 @@ namespace bingo
     }
   }
 
+  EvalAndGradients
+  AGraph::EvaluateEquationWithGradientsAt(const Eigen::Ref<const Eigen::ArrayXXd> &x)
+  {
+    if (modified_)
+    {
+      update();
+    }
+    EvalAndGradients df_dx_dc;
+    try
+    {
+      df_dx_dc = evaluation_backend::EvaluateWithGradients(this->evaluation_plan_,
+                                                           x,
+                                                           this->simplified_constants_);
+      return df_dx_dc;
+    }
+    catch (const std::underflow_error &ue)
+    {
+      Eigen::ArrayXXd nan_array =
+          Eigen::ArrayXXd::Constant(x.rows(), x.cols(), kNaN);
+      return std::make_tuple(nan_array, nan_array, nan_array);
+    }
+    catch (const std::overflow_error &oe)
+    {
+      Eigen::ArrayXXd nan_array =
+          Eigen::ArrayXXd::Constant(x.rows(), x.cols(), kNaN);
+      return std::make_tuple(nan_array, nan_array, nan_array);
+    }
+  }
+
   EvalAndDerivative
-  AGraph::EvaluateEquationWithLocalOptGradientAt(const Eigen::ArrayXXd &x)
+  AGraph::EvaluateEquationWithXDirectionalDerivativeAt(
+      const Eigen::Ref<const Eigen::ArrayXXd> &x, const Eigen::Ref<const Eigen::ArrayXXd> &direction)
+  {
+    if (modified_)
+    {
+      update();
+    }
+    EvalAndDerivative df_dv;
+    try
+    {
+      df_dv = evaluation_backend::EvaluateWithDirectionalDerivative(
+          this->evaluation_plan_, x, this->simplified_constants_, direction);
+      return df_dv;
+    }
+    catch (const std::underflow_error &ue)
+    {
+      Eigen::ArrayXXd nan_array =
+          Eigen::ArrayXXd::Constant(x.rows(), x.cols(), kNaN);
+      return std::make_pair(nan_array, nan_array);
+    }
+    catch (const std::overflow_error &oe)
+    {
+      Eigen::ArrayXXd nan_array =
+          Eigen::ArrayXXd::Constant(x.rows(), x.cols(), kNaN);
+      return std::make_pair(nan_array, nan_array);
+    }
+  }
+
+  EvalAndDerivative
+  AGraph::EvaluateEquationWithLocalOptGradientAt(const Eigen::Ref<const Eigen::ArrayXXd> &x)
   {
     if (modified_)
     {
@@ -236,10 +349,11 @@ namespace bingo
     EvalAndDerivative df_dc;
     try
     {
-      df_dc = evaluation_backend::EvaluateWithDerivative(this->simplified_command_array_,
+      df_dc = evaluation_backend::EvaluateWithDerivative(this->evaluation_plan_,
                                                          x,
                                                          this->simplified_constants_,
-                                                         false);
+                                                         false,
+                                                         evaluation_options());
       return df_dc;
     }
     catch (const std::underflow_error &ue)
@@ -256,6 +370,53 @@ namespace bingo
     }
   }
 
+  std::vector<NormalEquations>
+  AGraph::EvaluateNormalEquationsAt(const Eigen::Ref<const Eigen::ArrayXXd> &x,
+                                    const Eigen::Ref<const Eigen::ArrayXd> &y,
+                                    const Eigen::Ref<const Eigen::ArrayXd> &weights)
+  {
+    if (modified_)
+    {
+      update();
+    }
+    try
+    {
+      return evaluation_backend::EvaluateNormalEquations(this->evaluation_plan_,
+                                                         x,
+                                                         this->simplified_constants_,
+                                                         y,
+                                                         weights,
+                                                         evaluation_options());
+    }
+    catch (const std::underflow_error &ue)
+    {
+      return nan_normal_equations();
+    }
+    catch (const std::overflow_error &oe)
+    {
+      return nan_normal_equations();
+    }
+  }
+
+  std::vector<NormalEquations> AGraph::nan_normal_equations() const
+  {
+    int num_sets = std::max<int>(simplified_constants_.cols(), 1);
+    NormalEquations nan_equations(simplified_constants_.rows());
+    nan_equations.squared_residual = kNaN;
+    return std::vector<NormalEquations>(num_sets, nan_equations);
+  }
+
+  // the evaluation cache, while caching evaluations
+  evaluation_backend::EvaluationOptions AGraph::evaluation_options()
+  {
+    evaluation_backend::EvaluationOptions options;
+    if (cache_evaluations_)
+    {
+      options.cache = &evaluation_cache_;
+    }
+    return options;
+  }
+
   std::ostream &operator<<(std::ostream &strm, AGraph &graph)
   {
     return strm << graph.GetConsoleString();
@@ -297,8 +458,8 @@ namespace bingo
   {
     if (use_simplification_)
     {
-      simplified_command_array_ = simplification_backend::PythonSimplifyStack(
-          command_array_);
+      simplified_command_array_ =
+          simplification_backend::AlgebraicSimplifyStack(command_array_);
     }
     else
     {
@@ -314,6 +475,7 @@ namespace bingo
         new_const_number++;
       }
     }
+    evaluation_plan_.Compile(simplified_command_array_);
 
     int optimization_aggression = 0;
     if (optimization_aggression == 0 && new_const_number <= simplified_constants_.rows())
@@ -1,6 +1,11 @@
+#include <algorithm>
+#include <chrono>
+#include <limits>
 #include <map>
+#include <mutex>
 #include <numeric>
 #include <iostream>
+#include <stdexcept>
 
 #include <Eigen/Dense>
 
@@ -8,6 +13,7 @@
 #include <bingocpp/agraph/evaluation_backend/operator_eval.h>
 #include <bingocpp/agraph/constants.h>
 #include <bingocpp/agraph/operator_definitions.h>
+#include <bingocpp/thread_pool.h>
 
 namespace bingo
 {
@@ -15,31 +21,172 @@ namespace bingo
   {
     namespace
     {
+      // Cache budget for the buffers of one tile of rows, and the smallest
+      // tile worth the overhead of revisiting every instruction
+      const std::size_t kTileCacheBytes = 256 * 1024;
+      const int kMinTileRows = 256;
 
-      Eigen::ArrayXXd reverse_eval(const std::pair<int, int> &deriv_shape,
-                                   const int deriv_wrt_node,
-                                   const std::vector<Eigen::ArrayXXd> &forward_eval,
-                                   const Eigen::ArrayX3i &stack);
-
-      std::vector<Eigen::ArrayXXd> forward_eval(
-          const Eigen::ArrayX3i &stack,
-          const Eigen::ArrayXXd &x,
-          const Eigen::ArrayXXd &constants);
-
-      EvalAndDerivative evaluate_with_derivative(
-          const Eigen::ArrayX3i &stack,
-          const Eigen::ArrayXXd &x,
-          const Eigen::ArrayXXd &constants,
-          const bool param_x_or_c);
+      // The rows of an EvaluationCache seen by one tile of an evaluation.
+      // An unfilled cache is filled by the evaluation; a filled one
+      // replaces the constant-free instructions
+      struct CachedRows
+      {
+        EvaluationCache *cache;
+        int first_row;
+
+        bool IsFilled() const { return cache != nullptr && cache->filled; }
+      };
+
+      const Eigen::ArrayXXd &evaluate(
+          const EvaluationPlan &plan,
+          const Eigen::Ref<const Eigen::ArrayXXd> &x,
+          const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+          EvaluationCache *cache,
+          EvaluationWorkspace &workspace);
+
+      // The schedule of a checkpointed reverse pass.  The instructions
+      // keep each value in the slot of its own index, so a value lives
+      // exactly as long as the schedule needs it.
+      struct CheckpointSchedule
+      {
+        std::vector<Instruction> instructions;
+        // The last instruction reading each value
+        std::vector<int> last_use;
+        // Whether a value is read past the end of its segment, and so is
+        // kept as a checkpoint until its segment is swept in reverse
+        std::vector<bool> checkpoint;
+        int segment_length;
+        // Largest number of buffers alive at once
+        int peak_buffers;
+      };
+
+      void evaluate_with_derivative(
+          const EvaluationPlan &plan,
+          const Eigen::Ref<const Eigen::ArrayXXd> &x,
+          const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+          const ValueShape targets,
+          const std::size_t memory_budget,
+          EvaluationCache *cache,
+          EvaluationWorkspace &workspace);
+
+      const Eigen::ArrayXXd &evaluate_rows(
+          const EvaluationPlan &plan,
+          const Eigen::Ref<const Eigen::ArrayXXd> &x,
+          const Eigen::Ref<const Eigen::ArrayXi> &rows,
+          const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+          EvaluationWorkspace &workspace);
+
+      CheckpointSchedule checkpoint_schedule(const EvaluationPlan &plan);
+
+      void checkpointed_eval(const ValueShape targets,
+                             const int num_sets,
+                             const EvaluationPlan &plan,
+                             const CheckpointSchedule &schedule,
+                             const Eigen::Ref<const Eigen::ArrayXXd> &x,
+                             const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+                             EvaluationWorkspace &workspace,
+                             Eigen::Ref<Eigen::ArrayXXd> x_derivative,
+                             Eigen::Ref<Eigen::ArrayXXd> constant_derivative);
+
+      void acquire_buffer(Eigen::ArrayXXd &buffer,
+                          EvaluationWorkspace &workspace);
+
+      void release_buffer(Eigen::ArrayXXd &buffer,
+                          EvaluationWorkspace &workspace);
+
+      ValueShape derivative_targets(const bool param_x_or_c);
+
+      std::vector<NormalEquations> evaluate_normal_equations(
+          const EvaluationPlan &plan,
+          const Eigen::Ref<const Eigen::ArrayXXd> &x,
+          const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+          const Eigen::Ref<const Eigen::ArrayXd> &y,
+          const Eigen::Ref<const Eigen::ArrayXd> &weights,
+          EvaluationCache *cache);
+
+      void accumulate_normal_equations(
+          const EvaluationPlan &plan,
+          const Eigen::Ref<const Eigen::ArrayXXd> &x,
+          const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+          const Eigen::Ref<const Eigen::ArrayXd> &y,
+          const Eigen::Ref<const Eigen::ArrayXd> &weights,
+          EvaluationCache *cache,
+          const int begin, const int end, const int tile,
+          std::vector<NormalEquations> &normal_equations);
+
+      EvaluationCache *prepare_cache(const EvaluationPlan &plan,
+                                     const Eigen::Ref<const Eigen::ArrayXXd> &x,
+                                     EvaluationCache &cache);
+
+      void reverse_eval(const ValueShape targets,
+                        const int num_sets,
+                        const EvaluationPlan &plan,
+                        EvaluationWorkspace &workspace,
+                        Eigen::Ref<Eigen::ArrayXXd> x_derivative,
+                        Eigen::Ref<Eigen::ArrayXXd> constant_derivative);
+
+      void reverse_step(const Instruction &instruction,
+                        const int adjoint,
+                        const int num_sets,
+                        const std::vector<int> &adjoints,
+                        const std::vector<Eigen::ArrayXXd> &forward_eval,
+                        std::vector<Eigen::ArrayXXd> &reverse_eval,
+                        Eigen::Ref<Eigen::ArrayXXd> x_derivative,
+                        Eigen::Ref<Eigen::ArrayXXd> constant_derivative);
+
+      void forward_eval(const std::vector<Instruction> &instructions,
+                        int num_slots,
+                        const Eigen::Ref<const Eigen::ArrayXXd> &x,
+                        const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+                        const CachedRows &cached_rows,
+                        EvaluationWorkspace &workspace);
+
+      void forward_tangent_eval(const std::vector<Instruction> &instructions,
+                                int num_slots,
+                                const Eigen::Ref<const Eigen::ArrayXXd> &x,
+                                const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+                                const Eigen::Ref<const Eigen::ArrayXXd> &direction,
+                                EvaluationWorkspace &workspace);
+
+      void store_evaluation(const int result_slot,
+                            const Eigen::Ref<const Eigen::ArrayXXd> &x,
+                            const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+                            EvaluationWorkspace &workspace);
+
+      void store_tile_evaluation(const Eigen::ArrayXXd &result,
+                                 const int first_row, const int num_rows,
+                                 const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+                                 Eigen::ArrayXXd &evaluation);
+
+      int evaluation_columns(const Eigen::Ref<const Eigen::ArrayXXd> &constants);
+
+      template <typename TileFunction>
+      void for_each_tile(const int num_rows, const int tile,
+                         EvaluationWorkspace &workspace,
+                         const TileFunction &evaluate_tile);
+
+      int tile_rows(const EvaluationPlan &plan, const bool with_derivative,
+                    const int num_derivative_columns,
+                    const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+                    const EvaluationWorkspace &workspace);
+
+      void check_plan(const EvaluationPlan &plan);
+
+      void check_all_rows(const EvaluationOptions &options);
+
+      EvaluationWorkspace &options_workspace(const EvaluationOptions &options);
+
+      EvaluationWorkspace &thread_workspace();
+
+      const EvaluationPlan &thread_plan(
+          const Eigen::Ref<const Eigen::ArrayX3i> &stack);
     } // namespace
 
     Eigen::ArrayXXd Evaluate(const Eigen::Ref<const Eigen::ArrayX3i> &stack,
                              const Eigen::Ref<const Eigen::ArrayXXd> &x,
                              const Eigen::Ref<const Eigen::ArrayXXd> &constants)
     {
-      std::vector<Eigen::ArrayXXd> _forward_eval = forward_eval(
-          stack, x, constants);
-      return _forward_eval.back();
+      return Evaluate(thread_plan(stack), x, constants);
     }
 
     std::pair<Eigen::ArrayXXd, Eigen::ArrayXXd> EvaluateWithDerivative(
@@ -48,106 +195,1062 @@ namespace bingo
         const Eigen::Ref<const Eigen::ArrayXXd> &constants,
         const bool param_x_or_c)
     {
-      return evaluate_with_derivative(
-          stack, x, constants, param_x_or_c);
+      return EvaluateWithDerivative(thread_plan(stack), x, constants,
+                                    param_x_or_c);
+    }
+
+    EvalAndGradients EvaluateWithGradients(
+        const Eigen::Ref<const Eigen::ArrayX3i> &stack,
+        const Eigen::Ref<const Eigen::ArrayXXd> &x,
+        const Eigen::Ref<const Eigen::ArrayXXd> &constants)
+    {
+      return EvaluateWithGradients(thread_plan(stack), x, constants);
+    }
+
+    std::pair<Eigen::ArrayXXd, Eigen::ArrayXXd> EvaluateWithDirectionalDerivative(
+        const Eigen::Ref<const Eigen::ArrayX3i> &stack,
+        const Eigen::Ref<const Eigen::ArrayXXd> &x,
+        const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+        const Eigen::Ref<const Eigen::ArrayXXd> &direction)
+    {
+      return EvaluateWithDirectionalDerivative(thread_plan(stack), x, constants,
+                                               direction);
+    }
+
+    Eigen::ArrayXXd Evaluate(const EvaluationPlan &plan,
+                             const Eigen::Ref<const Eigen::ArrayXXd> &x,
+                             const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+                             const EvaluationOptions &options)
+    {
+      EvaluationWorkspace &workspace = options_workspace(options);
+      if (options.rows != nullptr)
+      {
+        return evaluate_rows(plan, x, *options.rows, constants, workspace);
+      }
+      check_plan(plan);
+      EvaluationCache *cache = options.cache == nullptr
+                                   ? nullptr
+                                   : prepare_cache(plan, x, *options.cache);
+      const Eigen::ArrayXXd &evaluation =
+          evaluate(plan, x, constants, cache, workspace);
+      if (cache != nullptr)
+      {
+        cache->filled = true;
+      }
+      return evaluation;
+    }
+
+    std::pair<Eigen::ArrayXXd, Eigen::ArrayXXd> EvaluateWithDerivative(
+        const EvaluationPlan &plan,
+        const Eigen::Ref<const Eigen::ArrayXXd> &x,
+        const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+        const bool param_x_or_c,
+        const EvaluationOptions &options)
+    {
+      check_all_rows(options);
+      check_plan(plan);
+      EvaluationWorkspace &workspace = options_workspace(options);
+      // the reverse pass for x reads the constant-free values, and the
+      // checkpointed pass recomputes them
+      EvaluationCache *cache =
+          (options.cache == nullptr || param_x_or_c ||
+           options.memory_budget > 0)
+              ? nullptr
+              : prepare_cache(plan, x, *options.cache);
+      evaluate_with_derivative(plan, x, constants,
+                               derivative_targets(param_x_or_c),
+                               options.memory_budget, cache, workspace);
+      if (cache != nullptr)
+      {
+        cache->filled = true;
+      }
+      return std::make_pair(workspace.evaluation, workspace.derivative);
+    }
+
+    EvalAndGradients EvaluateWithGradients(
+        const EvaluationPlan &plan,
+        const Eigen::Ref<const Eigen::ArrayXXd> &x,
+        const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+        const EvaluationOptions &options)
+    {
+      check_all_rows(options);
+      EvaluationWorkspace &workspace = options_workspace(options);
+      evaluate_with_derivative(plan, x, constants, kFullShape,
+                               options.memory_budget, nullptr, workspace);
+      return std::make_tuple(workspace.evaluation, workspace.derivative,
+                             workspace.constant_derivative);
+    }
+
+    std::pair<Eigen::ArrayXXd, Eigen::ArrayXXd> EvaluateWithDirectionalDerivative(
+        const EvaluationPlan &plan,
+        const Eigen::Ref<const Eigen::ArrayXXd> &x,
+        const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+        const Eigen::Ref<const Eigen::ArrayXXd> &direction,
+        const EvaluationOptions &options)
+    {
+      check_all_rows(options);
+      check_plan(plan);
+      if (direction.rows() != x.rows() || direction.cols() != x.cols())
+      {
+        throw std::invalid_argument("The direction must have the shape of x");
+      }
+      EvaluationWorkspace &workspace = options_workspace(options);
+      const std::vector<Instruction> &instructions = plan.GetInstructions(false);
+      int num_slots = plan.GetNumSlots(false);
+      int result_slot = instructions.back().result;
+      int num_rows = x.rows();
+      int num_sets = evaluation_columns(constants);
+      // the tangents double the buffers of the forward pass
+      int tile = tile_rows(plan, true, num_sets, constants, workspace);
+      if (num_rows <= tile)
+      {
+        forward_tangent_eval(instructions, num_slots, x, constants, direction,
+                             workspace);
+        store_evaluation(result_slot, x, constants, workspace);
+        workspace.derivative.swap(workspace.tangent_eval[result_slot]);
+        return std::make_pair(workspace.evaluation, workspace.derivative);
+      }
+
+      workspace.evaluation.resize(num_rows, num_sets);
+      workspace.derivative.resize(num_rows, num_sets);
+      for_each_tile(num_rows, tile, workspace,
+                    [&](int first_row, int tile_size,
+                        EvaluationWorkspace &tile_workspace) {
+        forward_tangent_eval(instructions, num_slots,
+                             x.middleRows(first_row, tile_size), constants,
+                             direction.middleRows(first_row, tile_size),
+                             tile_workspace);
+        store_tile_evaluation(tile_workspace.forward_eval[result_slot],
+                              first_row, tile_size, constants,
+                              workspace.evaluation);
+        workspace.derivative.middleRows(first_row, tile_size) =
+            tile_workspace.tangent_eval[result_slot];
+      });
+      return std::make_pair(workspace.evaluation, workspace.derivative);
+    }
+
+    std::vector<NormalEquations> EvaluateNormalEquations(
+        const EvaluationPlan &plan,
+        const Eigen::Ref<const Eigen::ArrayXXd> &x,
+        const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+        const Eigen::Ref<const Eigen::ArrayXd> &y,
+        const Eigen::Ref<const Eigen::ArrayXd> &weights,
+        const EvaluationOptions &options)
+    {
+      check_all_rows(options);
+      check_plan(plan);
+      EvaluationCache *cache = options.cache == nullptr
+                                   ? nullptr
+                                   : prepare_cache(plan, x, *options.cache);
+      std::vector<NormalEquations> normal_equations =
+          evaluate_normal_equations(plan, x, constants, y, weights, cache);
+      if (cache != nullptr)
+      {
+        cache->filled = true;
+      }
+      return normal_equations;
+    }
+
+    std::vector<Eigen::ArrayXXd> EvaluatePopulation(
+        const std::vector<AGraph *> &individuals,
+        const Eigen::Ref<const Eigen::ArrayXXd> &x)
+    {
+      // simplification may call into Python, so it stays on this thread
+      for (AGraph *individual : individuals)
+      {
+        individual->GetComplexity();
+      }
+      std::vector<Eigen::ArrayXXd> evaluations(individuals.size());
+      auto evaluate_individual = [&](int i) {
+        evaluations[i] = individuals[i]->EvaluateEquationAt(x);
+      };
+      if (UseRowParallelism(individuals.size(), x.rows()))
+      {
+        for (std::size_t i = 0; i < individuals.size(); ++i)
+        {
+          evaluate_individual(i);
+        }
+      }
+      else
+      {
+        GetThreadPool()->ParallelFor(individuals.size(), evaluate_individual);
+      }
+      return evaluations;
+    }
+
+    int TuneTileRows(const EvaluationPlan &plan,
+                     const Eigen::Ref<const Eigen::ArrayXXd> &x,
+                     const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+                     const bool with_derivative,
+                     EvaluationWorkspace &workspace)
+    {
+      EvaluationOptions options;
+      options.workspace = &workspace;
+      int best_tile_rows = std::max(static_cast<int>(x.rows()), 1);
+      double best_time = std::numeric_limits<double>::infinity();
+      for (int candidate = kMinTileRows; ; candidate *= 2)
+      {
+        bool whole_data = candidate >= x.rows();
+        workspace.tile_rows = whole_data ? std::max(static_cast<int>(x.rows()), 1)
+                                         : candidate;
+        auto start = std::chrono::steady_clock::now();
+        if (with_derivative)
+        {
+          EvaluateWithDerivative(plan, x, constants, false, options);
+        }
+        else
+        {
+          Evaluate(plan, x, constants, options);
+        }
+        std::chrono::duration<double> time =
+            std::chrono::steady_clock::now() - start;
+        if (time.count() < best_time)
+        {
+          best_time = time.count();
+          best_tile_rows = workspace.tile_rows;
+        }
+        if (whole_data)
+        {
+          break;
+        }
+      }
+      workspace.tile_rows = best_tile_rows;
+      return best_tile_rows;
     }
 
     namespace
     {
 
-      Eigen::ArrayXXd reverse_eval(const std::pair<int, int> &deriv_shape,
-                                   const int deriv_wrt_node,
-                                   const std::vector<Eigen::ArrayXXd> &forward_eval,
-                                   const Eigen::ArrayX3i &stack)
+      const Eigen::ArrayXXd &evaluate(
+          const EvaluationPlan &plan,
+          const Eigen::Ref<const Eigen::ArrayXXd> &x,
+          const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+          EvaluationCache *cache,
+          EvaluationWorkspace &workspace)
       {
-        int num_samples = deriv_shape.first;
-        int num_features = deriv_shape.second;
-        int stack_depth = stack.rows();
+        check_plan(plan);
+        const std::vector<Instruction> &instructions = plan.GetInstructions(false);
+        int num_slots = plan.GetNumSlots(false);
+        int result_slot = instructions.back().result;
+        int num_rows = x.rows();
+        int tile = tile_rows(plan, false, 0, constants, workspace);
+        if (num_rows <= tile)
+        {
+          forward_eval(instructions, num_slots, x, constants,
+                       CachedRows{cache, 0}, workspace);
+          store_evaluation(result_slot, x, constants, workspace);
+          return workspace.evaluation;
+        }
 
-        Eigen::ArrayXXd derivative = Eigen::ArrayXXd::Zero(num_samples, num_features);
-        std::vector<Eigen::ArrayXXd> reverse_eval(stack_depth);
-        for (int row = 0; row < stack_depth; row++)
+        workspace.evaluation.resize(num_rows, evaluation_columns(constants));
+        for_each_tile(num_rows, tile, workspace,
+                      [&](int first_row, int tile_size,
+                          EvaluationWorkspace &tile_workspace) {
+          forward_eval(instructions, num_slots,
+                       x.middleRows(first_row, tile_size), constants,
+                       CachedRows{cache, first_row}, tile_workspace);
+          store_tile_evaluation(tile_workspace.forward_eval[result_slot],
+                                first_row, tile_size, constants,
+                                workspace.evaluation);
+        });
+        return workspace.evaluation;
+      }
+
+      void evaluate_with_derivative(
+          const EvaluationPlan &plan,
+          const Eigen::Ref<const Eigen::ArrayXXd> &x,
+          const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+          const ValueShape targets,
+          const std::size_t memory_budget,
+          EvaluationCache *cache,
+          EvaluationWorkspace &workspace)
+      {
+        check_plan(plan);
+        const std::vector<Instruction> &instructions = plan.GetInstructions(true);
+        int num_slots = plan.GetNumSlots(true);
+        int result_slot = instructions.back().result;
+        int num_sets = evaluation_columns(constants);
+        int num_rows = x.rows();
+
+        // one block of derivative columns per set of constants
+        int num_x_features = (targets & kColumnShape) ? x.cols() * num_sets : 0;
+        int num_constant_features =
+            (targets & kRowShape) ? constants.rows() * num_sets : 0;
+        // a single derivative is stored in workspace.derivative
+        Eigen::ArrayXXd &x_derivative = workspace.derivative;
+        Eigen::ArrayXXd &constant_derivative = (targets == kRowShape)
+                                                   ? workspace.derivative
+                                                   : workspace.constant_derivative;
+        Eigen::ArrayXXd no_derivative(num_rows, 0);
+        if (targets != kRowShape)
+        {
+          x_derivative.resize(num_rows, num_x_features);
+        }
+        if (targets != kColumnShape)
         {
-          reverse_eval[row] = Eigen::ArrayXd::Zero(num_samples);
+          constant_derivative.resize(num_rows, num_constant_features);
         }
+        Eigen::ArrayXXd &x_target = (targets & kColumnShape) ? x_derivative
+                                                             : no_derivative;
+        Eigen::ArrayXXd &constant_target =
+            (targets & kRowShape) ? constant_derivative : no_derivative;
+
+        int tile = tile_rows(plan, true, num_x_features + num_constant_features,
+                             constants, workspace);
+        std::size_t buffer_bytes =
+            sizeof(double) * std::min(tile, std::max(num_rows, 1)) * num_sets;
+        std::size_t taped_buffers = num_slots + plan.GetNumAdjoints(targets) + 1;
+        if (memory_budget > 0 && taped_buffers * buffer_bytes > memory_budget)
+        {
+          CheckpointSchedule schedule = checkpoint_schedule(plan);
+          std::size_t peak_bytes = schedule.peak_buffers * buffer_bytes;
+          if (peak_bytes > memory_budget)
+          {
+            std::size_t row_bytes = sizeof(double) * num_sets *
+                                    schedule.peak_buffers;
+            tile = std::max(static_cast<int>(memory_budget / row_bytes), 1);
+          }
+          int result = schedule.instructions.size() - 1;
+          workspace.evaluation.resize(num_rows, num_sets);
+          for_each_tile(num_rows, tile, workspace,
+                        [&](int first_row, int tile_size,
+                            EvaluationWorkspace &tile_workspace) {
+            checkpointed_eval(targets, num_sets, plan, schedule,
+                              x.middleRows(first_row, tile_size), constants,
+                              tile_workspace,
+                              x_target.middleRows(first_row, tile_size),
+                              constant_target.middleRows(first_row, tile_size));
+            store_tile_evaluation(tile_workspace.forward_eval[result],
+                                  first_row, tile_size, constants,
+                                  workspace.evaluation);
+          });
+          return;
+        }
+
+        if (num_rows <= tile)
+        {
+          forward_eval(instructions, num_slots, x, constants,
+                       CachedRows{cache, 0}, workspace);
+          reverse_eval(targets, num_sets, plan, workspace, x_target,
+                       constant_target);
+          store_evaluation(result_slot, x, constants, workspace);
+          return;
+        }
+
+        workspace.evaluation.resize(num_rows, evaluation_columns(constants));
+        for_each_tile(num_rows, tile, workspace,
+                      [&](int first_row, int tile_size,
+                          EvaluationWorkspace &tile_workspace) {
+          forward_eval(instructions, num_slots,
+                       x.middleRows(first_row, tile_size), constants,
+                       CachedRows{cache, first_row}, tile_workspace);
+          reverse_eval(targets, num_sets, plan, tile_workspace,
+                       x_target.middleRows(first_row, tile_size),
+                       constant_target.middleRows(first_row, tile_size));
+          store_tile_evaluation(tile_workspace.forward_eval[result_slot],
+                                first_row, tile_size, constants,
+                                workspace.evaluation);
+        });
+      }
+
+      // Evaluates the rows of x listed in rows
+      const Eigen::ArrayXXd &evaluate_rows(
+          const EvaluationPlan &plan,
+          const Eigen::Ref<const Eigen::ArrayXXd> &x,
+          const Eigen::Ref<const Eigen::ArrayXi> &rows,
+          const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+          EvaluationWorkspace &workspace)
+      {
+        check_plan(plan);
+        int num_rows = rows.size();
+        if (num_rows > 0 && (rows.minCoeff() < 0 || rows.maxCoeff() >= x.rows()))
+        {
+          throw std::out_of_range("Rows to evaluate must be rows of x");
+        }
+        const std::vector<Instruction> &instructions = plan.GetInstructions(false);
+        int num_slots = plan.GetNumSlots(false);
+        int result_slot = instructions.back().result;
+        int tile = tile_rows(plan, false, 0, constants, workspace);
+
+        // each tile gathers its rows into the workspace evaluating it
+        workspace.evaluation.resize(num_rows, evaluation_columns(constants));
+        for_each_tile(num_rows, tile, workspace,
+                      [&](int first_row, int tile_size,
+                          EvaluationWorkspace &tile_workspace) {
+          tile_workspace.gathered_x =
+              x(rows.segment(first_row, tile_size), Eigen::all);
+          forward_eval(instructions, num_slots, tile_workspace.gathered_x,
+                       constants, CachedRows{nullptr, 0}, tile_workspace);
+          store_tile_evaluation(tile_workspace.forward_eval[result_slot],
+                                first_row, tile_size, constants,
+                                workspace.evaluation);
+        });
+        return workspace.evaluation;
+      }
+
+      std::vector<NormalEquations> evaluate_normal_equations(
+          const EvaluationPlan &plan,
+          const Eigen::Ref<const Eigen::ArrayXXd> &x,
+          const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+          const Eigen::Ref<const Eigen::ArrayXd> &y,
+          const Eigen::Ref<const Eigen::ArrayXd> &weights,
+          EvaluationCache *cache)
+      {
+        check_plan(plan);
+        int num_rows = x.rows();
+        if (y.size() != num_rows ||
+            (weights.size() != 0 && weights.size() != num_rows))
+        {
+          throw std::invalid_argument(
+              "y and the weights must have one value per row of x");
+        }
+        int num_sets = evaluation_columns(constants);
+        int num_constants = constants.rows();
+        int tile = tile_rows(plan, true, num_constants * num_sets, constants,
+                             thread_workspace());
+        std::vector<NormalEquations> normal_equations(
+            num_sets, NormalEquations(num_constants));
+        if (num_rows < kMinParallelRows)
+        {
+          accumulate_normal_equations(plan, x, constants, y, weights, cache,
+                                      0, num_rows, tile, normal_equations);
+          return normal_equations;
+        }
+
+        // each block of rows has its own sums, added in the order of the
+        // blocks so the result does not depend on the scheduling
+        std::map<int, std::vector<NormalEquations>> block_sums;
+        std::mutex block_sums_mutex;
+        GetThreadPool()->ParallelForBlocks(num_rows, kMinParallelRows,
+                                          [&](int begin, int end) {
+          std::vector<NormalEquations> sums(num_sets,
+                                            NormalEquations(num_constants));
+          accumulate_normal_equations(plan, x, constants, y, weights, cache,
+                                      begin, end, tile, sums);
+          std::lock_guard<std::mutex> lock(block_sums_mutex);
+          block_sums[begin] = std::move(sums);
+        });
+        for (const auto &block : block_sums)
+        {
+          for (int set = 0; set < num_sets; ++set)
+          {
+            normal_equations[set] += block.second[set];
+          }
+        }
+        return normal_equations;
+      }
+
+      // Adds the rows [begin, end) to the normal equations, one tile of
+      // rows at a time
+      void accumulate_normal_equations(
+          const EvaluationPlan &plan,
+          const Eigen::Ref<const Eigen::ArrayXXd> &x,
+          const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+          const Eigen::Ref<const Eigen::ArrayXd> &y,
+          const Eigen::Ref<const Eigen::ArrayXd> &weights,
+          EvaluationCache *cache,
+          const int begin, const int end, const int tile,
+          std::vector<NormalEquations> &normal_equations)
+      {
+        EvaluationWorkspace &workspace = thread_workspace();
+        const std::vector<Instruction> &instructions = plan.GetInstructions(true);
+        int num_slots = plan.GetNumSlots(true);
+        int result_slot = instructions.back().result;
+        int num_sets = normal_equations.size();
+        int num_constants = constants.rows();
+        Eigen::VectorXd residual;
+        Eigen::MatrixXd jacobian;
+        for (int first_row = begin; first_row < end; first_row += tile)
+        {
+          int tile_size = std::min(tile, end - first_row);
+          forward_eval(instructions, num_slots,
+                       x.middleRows(first_row, tile_size), constants,
+                       CachedRows{cache, first_row}, workspace);
+          Eigen::ArrayXXd no_derivative(tile_size, 0);
+          workspace.derivative.resize(tile_size, num_constants * num_sets);
+          reverse_eval(kRowShape, num_sets, plan, workspace, no_derivative,
+                       workspace.derivative);
+
+          const Eigen::ArrayXXd &result = workspace.forward_eval[result_slot];
+          for (int set = 0; set < num_sets; ++set)
+          {
+            int col = result.cols() == 1 ? 0 : set;
+            if (result.rows() == 1)
+            {
+              residual.setConstant(tile_size, result(0, col));
+            }
+            else
+            {
+              residual = result.col(col).matrix();
+            }
+            residual -= y.segment(first_row, tile_size).matrix();
+            jacobian = workspace.derivative
+                           .middleCols(set * num_constants, num_constants)
+                           .matrix();
+            if (weights.size() != 0)
+            {
+              auto tile_weights = weights.segment(first_row, tile_size);
+              residual.array() *= tile_weights;
+              jacobian.array().colwise() *= tile_weights;
+            }
+            normal_equations[set].Accumulate(jacobian, residual);
+          }
+        }
+      }
+
+      ValueShape derivative_targets(const bool param_x_or_c)
+      {
+        // true = x, false = c
+        return param_x_or_c ? kColumnShape : kRowShape;
+      }
 
-        reverse_eval[stack_depth - 1] = Eigen::ArrayXd::Ones(num_samples);
-        for (int i = stack_depth - 1; i >= 0; i--)
+      EvaluationCache *prepare_cache(const EvaluationPlan &plan,
+                                     const Eigen::Ref<const Eigen::ArrayXXd> &x,
+                                     EvaluationCache &cache)
+      {
+        if (plan.GetNumCachedValues() == 0)
+        {
+          return nullptr;
+        }
+        if (cache.IsFilledFor(x))
+        {
+          return &cache;
+        }
+        const std::vector<Instruction> &instructions = plan.GetInstructions(false);
+        cache.x_data = x.data();
+        cache.x_rows = x.rows();
+        cache.x_cols = x.cols();
+        cache.filled = false;
+        cache.values.resize(instructions.size());
+        for (std::size_t i = 0; i < instructions.size(); ++i)
         {
-          int node = stack(i, kOpIdx);
-          int param1 = stack(i, kParam1Idx);
-          int param2 = stack(i, kParam2Idx);
-          if (node == deriv_wrt_node)
+          if (instructions[i].cached)
           {
-            derivative.col(param1) += reverse_eval[i];
+            cache.values[i].resize(x.rows(), 1);
           }
           else
           {
-            ReverseEvalFunction(node, i, param1, param2, forward_eval, reverse_eval);
+            cache.values[i].resize(0, 0);
+          }
+        }
+        return &cache;
+      }
+
+      void reverse_eval(const ValueShape targets,
+                        const int num_sets,
+                        const EvaluationPlan &plan,
+                        EvaluationWorkspace &workspace,
+                        Eigen::Ref<Eigen::ArrayXXd> x_derivative,
+                        Eigen::Ref<Eigen::ArrayXXd> constant_derivative)
+      {
+        int num_samples = std::max(x_derivative.rows(),
+                                   constant_derivative.rows());
+        const std::vector<Instruction> &instructions = plan.GetInstructions(true);
+        int num_instructions = instructions.size();
+        const std::vector<int> &adjoints = plan.GetAdjoints(targets);
+        int num_adjoints = plan.GetNumAdjoints(targets);
+        workspace.Reserve(0, num_adjoints + 1);
+        const std::vector<Eigen::ArrayXXd> &forward_eval = workspace.forward_eval;
+        std::vector<Eigen::ArrayXXd> &reverse_eval = workspace.reverse_eval;
+
+        x_derivative.setZero();
+        constant_derivative.setZero();
+        if (adjoints[num_instructions - 1] == num_adjoints)
+        {
+          // the result does not depend on the targets
+          return;
+        }
+        // the last buffer collects the adjoints of inactive operands
+        for (int i = 0; i <= num_adjoints; i++)
+        {
+          reverse_eval[i].setZero(num_samples, num_sets);
+        }
+        reverse_eval[adjoints[num_instructions - 1]].setOnes();
+
+        for (int i = num_instructions - 1; i >= 0; i--)
+        {
+          if (adjoints[i] != num_adjoints)
+          {
+            reverse_step(instructions[i], adjoints[i], num_sets, adjoints,
+                         forward_eval, reverse_eval, x_derivative,
+                         constant_derivative);
           }
         }
-        return derivative;
       }
 
-      std::vector<Eigen::ArrayXXd> forward_eval(
-          const Eigen::ArrayX3i &stack,
-          const Eigen::ArrayXXd &x,
-          const Eigen::ArrayXXd &constants)
+      // Propagates the adjoint of an active instruction to its operands,
+      // or into the derivative if it is a target terminal
+      void reverse_step(const Instruction &instruction,
+                        const int adjoint,
+                        const int num_sets,
+                        const std::vector<int> &adjoints,
+                        const std::vector<Eigen::ArrayXXd> &forward_eval,
+                        std::vector<Eigen::ArrayXXd> &reverse_eval,
+                        Eigen::Ref<Eigen::ArrayXXd> x_derivative,
+                        Eigen::Ref<Eigen::ArrayXXd> constant_derivative)
       {
-        // std::cout << "---Evaluating Equation--\n";
-        // std::cout << "x (" << x.rows() << ", " << x.cols() << ")\n";
-        // std::cout << "consts (" << constants.rows() << ", " << constants.cols() << ")\n";
-        std::vector<Eigen::ArrayXXd> _forward_eval(stack.rows());
+        // the sets of constants are independent, so each has its own
+        // column of adjoints
+        int num_x_features = x_derivative.cols() / num_sets;
+        int num_constant_features = constant_derivative.cols() / num_sets;
+        // terminals are only active when they are targets
+        if (instruction.node == Op::kVariable)
+        {
+          for (int set = 0; set < num_sets; set++)
+          {
+            x_derivative.col(set * num_x_features + instruction.param1) +=
+                reverse_eval[adjoint].col(set);
+          }
+        }
+        else if (instruction.node == Op::kConstant)
+        {
+          for (int set = 0; set < num_sets; set++)
+          {
+            constant_derivative.col(set * num_constant_features +
+                                    instruction.param1) +=
+                reverse_eval[adjoint].col(set);
+          }
+        }
+        else if (instruction.node > Op::kConstant)
+        {
+          // the shape-specialized kernels expect one set of constants
+          ReverseKernel reverse = num_sets == 1
+                                      ? instruction.reverse
+                                      : GetReverseKernel(instruction.node);
+          reverse(adjoint, adjoints[instruction.adjoint1],
+                  adjoints[instruction.adjoint2],
+                  forward_eval[instruction.result],
+                  forward_eval[instruction.param1],
+                  forward_eval[instruction.param2],
+                  reverse_eval);
+        }
+      }
+
+      // Splits the instructions into segments, picking the segment length
+      // that needs the fewest buffers at once.  Recomputation does not
+      // depend on the length: every instruction is evaluated twice.
+      CheckpointSchedule checkpoint_schedule(const EvaluationPlan &plan)
+      {
+        CheckpointSchedule schedule;
+        schedule.instructions = plan.GetInstructions(true);
+        int num_instructions = schedule.instructions.size();
+        schedule.last_use.assign(num_instructions, num_instructions);
+        // values alive after each instruction, as a difference array
+        std::vector<int> live_changes(num_instructions + 1, 0);
+        for (int i = 0; i < num_instructions; ++i)
+        {
+          Instruction &instruction = schedule.instructions[i];
+          instruction.result = i;
+          if (instruction.node > Op::kConstant)
+          {
+            instruction.param1 = instruction.adjoint1;
+            instruction.param2 = instruction.adjoint2;
+            schedule.last_use[instruction.adjoint1] = i;
+            schedule.last_use[instruction.adjoint2] = i;
+          }
+        }
+        for (int i = 0; i < num_instructions; ++i)
+        {
+          ++live_changes[i];
+          --live_changes[std::min(schedule.last_use[i], num_instructions)];
+        }
+        // adjoints alive at once are bounded by the values alive at once
+        int max_live = 0;
+        for (int i = 0, live = 0; i < num_instructions; ++i)
+        {
+          live += live_changes[i];
+          max_live = std::max(max_live, live);
+        }
+
+        schedule.peak_buffers = -1;
+        for (int length = 1; ; length *= 2)
+        {
+          int segment_length = std::min(length, num_instructions);
+          int num_checkpoints = 0;
+          for (int i = 0; i < num_instructions; ++i)
+          {
+            if (schedule.last_use[i] / segment_length > i / segment_length)
+            {
+              ++num_checkpoints;
+            }
+          }
+          // checkpoints, one segment, live adjoints and the discarded ones
+          int peak = num_checkpoints + segment_length + max_live + 1;
+          if (schedule.peak_buffers < 0 || peak < schedule.peak_buffers)
+          {
+            schedule.peak_buffers = peak;
+            schedule.segment_length = segment_length;
+          }
+          if (segment_length == num_instructions)
+          {
+            break;
+          }
+        }
+        schedule.checkpoint.resize(num_instructions);
+        for (int i = 0; i < num_instructions; ++i)
+        {
+          schedule.checkpoint[i] = schedule.last_use[i] / schedule.segment_length >
+                                   i / schedule.segment_length;
+        }
+        return schedule;
+      }
+
+      // The forward sweep keeps only the checkpoints.  The reverse sweep
+      // then goes through the segments from the last, recomputing the
+      // values of each from the checkpoints before its reverse pass.  A
+      // buffer is empty when its value or adjoint is not alive; the
+      // adjoint of an operand becomes alive at its first contribution,
+      // from its last reader.
+      void checkpointed_eval(const ValueShape targets,
+                             const int num_sets,
+                             const EvaluationPlan &plan,
+                             const CheckpointSchedule &schedule,
+                             const Eigen::Ref<const Eigen::ArrayXXd> &x,
+                             const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+                             EvaluationWorkspace &workspace,
+                             Eigen::Ref<Eigen::ArrayXXd> x_derivative,
+                             Eigen::Ref<Eigen::ArrayXXd> constant_derivative)
+      {
+        const std::vector<Instruction> &instructions = schedule.instructions;
+        int num_instructions = instructions.size();
+        const std::vector<int> &adjoints = plan.GetAdjoints(targets);
+        int num_adjoints = plan.GetNumAdjoints(targets);
+        workspace.Reserve(num_instructions, num_adjoints + 1);
+        std::vector<Eigen::ArrayXXd> &values = workspace.forward_eval;
+        std::vector<Eigen::ArrayXXd> &reverse_eval = workspace.reverse_eval;
+        for (Eigen::ArrayXXd &buffer : values)
+        {
+          release_buffer(buffer, workspace);
+        }
+        for (Eigen::ArrayXXd &buffer : reverse_eval)
+        {
+          release_buffer(buffer, workspace);
+        }
+        if (workspace.spare_buffers.size() >
+            static_cast<std::size_t>(schedule.peak_buffers))
+        {
+          workspace.spare_buffers.resize(schedule.peak_buffers);
+        }
+
+        auto evaluate_value = [&](int i) {
+          const Instruction &instruction = instructions[i];
+          acquire_buffer(values[i], workspace);
+          instruction.forward(instruction.param1, instruction.param2, x,
+                              constants, values, values[i]);
+        };
+        for (int i = 0; i < num_instructions; ++i)
+        {
+          evaluate_value(i);
+          const Instruction &instruction = instructions[i];
+          if (instruction.node <= Op::kConstant)
+          {
+            continue;
+          }
+          for (int operand : {instruction.adjoint1, instruction.adjoint2})
+          {
+            if (schedule.last_use[operand] == i &&
+                !schedule.checkpoint[operand])
+            {
+              release_buffer(values[operand], workspace);
+            }
+          }
+        }
+
+        x_derivative.setZero();
+        constant_derivative.setZero();
+        int result = num_instructions - 1;
+        if (adjoints[result] == num_adjoints)
+        {
+          // the result does not depend on the targets
+          return;
+        }
+        int num_samples = x.rows();
+        acquire_buffer(reverse_eval[num_adjoints], workspace);
+        reverse_eval[num_adjoints].setZero(num_samples, num_sets);
+        acquire_buffer(reverse_eval[adjoints[result]], workspace);
+        reverse_eval[adjoints[result]].setOnes(num_samples, num_sets);
+
+        int segment_length = schedule.segment_length;
+        for (int begin = (result / segment_length) * segment_length;
+             begin >= 0; begin -= segment_length)
+        {
+          int end = std::min(begin + segment_length, num_instructions);
+          for (int i = begin; i < end; ++i)
+          {
+            if (values[i].size() == 0)
+            {
+              evaluate_value(i);
+            }
+          }
+          for (int i = end - 1; i >= begin; --i)
+          {
+            const Instruction &instruction = instructions[i];
+            int adjoint = adjoints[i];
+            if (adjoint == num_adjoints)
+            {
+              continue;
+            }
+            if (instruction.node > Op::kConstant)
+            {
+              for (int operand : {instruction.adjoint1, instruction.adjoint2})
+              {
+                Eigen::ArrayXXd &operand_adjoint =
+                    reverse_eval[adjoints[operand]];
+                if (operand_adjoint.size() == 0)
+                {
+                  acquire_buffer(operand_adjoint, workspace);
+                  operand_adjoint.setZero(num_samples, num_sets);
+                }
+              }
+            }
+            reverse_step(instruction, adjoint, num_sets, adjoints, values,
+                         reverse_eval, x_derivative, constant_derivative);
+            release_buffer(reverse_eval[adjoint], workspace);
+          }
+          // the segment is done, and so are its checkpoints; the result is
+          // kept for the evaluation
+          for (int i = begin; i < end; ++i)
+          {
+            if (i != result)
+            {
+              release_buffer(values[i], workspace);
+            }
+          }
+        }
+        release_buffer(reverse_eval[num_adjoints], workspace);
+      }
 
-        for (int i = 0; i < stack.rows(); ++i)
+      void acquire_buffer(Eigen::ArrayXXd &buffer,
+                          EvaluationWorkspace &workspace)
+      {
+        if (buffer.size() == 0 && !workspace.spare_buffers.empty())
         {
-          int node = stack(i, kOpIdx);
-          int op1 = stack(i, kParam1Idx);
-          int op2 = stack(i, kParam2Idx);
-          // std::cout<< i << ": ["<<node << " " <<op1 << " " <<op2 <<"]";
-          _forward_eval[i] = ForwardEvalFunction(
-              node, op1, op2, x, constants, _forward_eval);
-            // std::cout<<"  (" << _forward_eval[i].rows() << ", " << _forward_eval[i].cols() << "): " << _forward_eval[i] << "\n";
+          buffer.swap(workspace.spare_buffers.back());
+          workspace.spare_buffers.pop_back();
         }
+      }
 
-        Eigen::ArrayXXd tmp;
-        if (_forward_eval.back().rows() == 1 && x.rows() > 1) {
-          tmp = _forward_eval.back().replicate(x.rows(), 1);
-          _forward_eval.back() = tmp;
+      void release_buffer(Eigen::ArrayXXd &buffer,
+                          EvaluationWorkspace &workspace)
+      {
+        if (buffer.size() == 0)
+        {
+          return;
         }
-        if (_forward_eval.back().cols() == 1 && constants.cols() > 1) {
-          tmp = _forward_eval.back().replicate(1, constants.cols());
-          _forward_eval.back() = tmp;
+        workspace.spare_buffers.emplace_back();
+        workspace.spare_buffers.back().swap(buffer);
+      }
+
+      void forward_eval(const std::vector<Instruction> &instructions,
+                        int num_slots,
+                        const Eigen::Ref<const Eigen::ArrayXXd> &x,
+                        const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+                        const CachedRows &cached_rows,
+                        EvaluationWorkspace &workspace)
+      {
+        workspace.Reserve(num_slots);
+        std::vector<Eigen::ArrayXXd> &_forward_eval = workspace.forward_eval;
+        EvaluationCache *cache = cached_rows.cache;
+        bool use_cache = cached_rows.IsFilled();
+        int num_rows = x.rows();
+
+        for (std::size_t i = 0; i < instructions.size(); ++i)
+        {
+          const Instruction &instruction = instructions[i];
+          Eigen::ArrayXXd &result = _forward_eval[instruction.result];
+          if (use_cache && instruction.shape == kColumnShape &&
+              instruction.node > Op::kConstant)
+          {
+            // the other constant-free values are only read by these
+            if (instruction.cached)
+            {
+              result = cache->values[i].middleRows(cached_rows.first_row,
+                                                   num_rows);
+            }
+            continue;
+          }
+          instruction.forward(instruction.param1, instruction.param2, x,
+                              constants, _forward_eval, result);
+          if (cache != nullptr && instruction.cached)
+          {
+            cache->values[i].middleRows(cached_rows.first_row, num_rows) =
+                result;
+          }
         }
+      }
+
+      // Evaluates the instructions and their tangents in one sweep.  The
+      // tangent of each value shares the slot of the value, since the
+      // kernels read the operands and their tangents at the same time.
+      void forward_tangent_eval(const std::vector<Instruction> &instructions,
+                                int num_slots,
+                                const Eigen::Ref<const Eigen::ArrayXXd> &x,
+                                const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+                                const Eigen::Ref<const Eigen::ArrayXXd> &direction,
+                                EvaluationWorkspace &workspace)
+      {
+        workspace.Reserve(num_slots, 0, num_slots);
+        std::vector<Eigen::ArrayXXd> &_forward_eval = workspace.forward_eval;
+        std::vector<Eigen::ArrayXXd> &tangent_eval = workspace.tangent_eval;
+        int num_rows = x.rows();
+        int num_sets = evaluation_columns(constants);
 
-        return _forward_eval;
+        for (const Instruction &instruction : instructions)
+        {
+          Eigen::ArrayXXd &result = _forward_eval[instruction.result];
+          instruction.forward(instruction.param1, instruction.param2, x,
+                              constants, _forward_eval, result);
+          Eigen::ArrayXXd &tangent = tangent_eval[instruction.result];
+          if (!(instruction.shape & kColumnShape))
+          {
+            // values that do not vary with x
+            tangent.setZero(num_rows, num_sets);
+          }
+          else if (instruction.node == Op::kVariable)
+          {
+            tangent.resize(num_rows, num_sets);
+            tangent.colwise() = direction.col(instruction.param1);
+          }
+          else
+          {
+            instruction.tangent(instruction.result, instruction.param1,
+                                instruction.param2, result,
+                                _forward_eval[instruction.param1],
+                                _forward_eval[instruction.param2],
+                                tangent_eval);
+          }
+        }
       }
 
-      EvalAndDerivative evaluate_with_derivative(
-          const Eigen::ArrayX3i &stack,
-          const Eigen::ArrayXXd &x,
-          const Eigen::ArrayXXd &constants,
-          const bool param_x_or_c)
+      void store_evaluation(const int result_slot,
+                            const Eigen::Ref<const Eigen::ArrayXXd> &x,
+                            const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+                            EvaluationWorkspace &workspace)
       {
-        std::vector<Eigen::ArrayXXd> _forward_eval = forward_eval(
-            stack, x, constants);
+        // the result buffer is swapped rather than copied out, so the old
+        // evaluation storage is recycled as a slot buffer on the next call
+        Eigen::ArrayXXd &result = workspace.forward_eval[result_slot];
+        int row_factor = (result.rows() == 1 && x.rows() > 1) ? x.rows() : 1;
+        int col_factor = (result.cols() == 1 && constants.cols() > 1) ? constants.cols() : 1;
+        if (row_factor == 1 && col_factor == 1)
+        {
+          workspace.evaluation.swap(result);
+        }
+        else
+        {
+          workspace.evaluation = result.replicate(row_factor, col_factor);
+        }
+      }
 
-        std::pair<int, int> deriv_shape;
-        int deriv_wrt_node;
-        if (param_x_or_c)
-        { // true = x
-          deriv_shape = std::make_pair(x.rows(), x.cols());
-          deriv_wrt_node = Op::kVariable;
+      void store_tile_evaluation(const Eigen::ArrayXXd &result,
+                                 const int first_row, const int num_rows,
+                                 const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+                                 Eigen::ArrayXXd &evaluation)
+      {
+        int row_factor = (result.rows() == 1) ? num_rows : 1;
+        int col_factor = (result.cols() == 1 && constants.cols() > 1) ? constants.cols() : 1;
+        if (row_factor == 1 && col_factor == 1)
+        {
+          evaluation.middleRows(first_row, num_rows) = result;
         }
         else
-        { // false = c
-          deriv_shape = std::make_pair(x.rows(), constants.size());
-          deriv_wrt_node = Op::kConstant;
+        {
+          evaluation.middleRows(first_row, num_rows) =
+              result.replicate(row_factor, col_factor);
         }
+      }
+
+      // Every evaluation is broadcast to one column per set of constants
+      int evaluation_columns(const Eigen::Ref<const Eigen::ArrayXXd> &constants)
+      {
+        return std::max(static_cast<int>(constants.cols()), 1);
+      }
 
-        Eigen::ArrayXXd derivative = reverse_eval(
-            deriv_shape, deriv_wrt_node, _forward_eval, stack);
-        return std::make_pair(_forward_eval.back(), derivative);
+      // Runs evaluate_tile(first_row, tile_size, tile_workspace) for each
+      // tile of rows.  Large data sets are split across the threads of the
+      // shared pool, each thread using its own workspace for the buffers of
+      // its tiles; the results are written to disjoint rows.
+      template <typename TileFunction>
+      void for_each_tile(const int num_rows, const int tile,
+                         EvaluationWorkspace &workspace,
+                         const TileFunction &evaluate_tile)
+      {
+        int num_tiles = (num_rows + tile - 1) / tile;
+        if (num_rows < kMinParallelRows)
+        {
+          for (int i = 0; i < num_tiles; ++i)
+          {
+            int first_row = i * tile;
+            evaluate_tile(first_row, std::min(tile, num_rows - first_row),
+                          workspace);
+          }
+          return;
+        }
+        GetThreadPool()->ParallelFor(num_tiles, [&](int i) {
+          int first_row = i * tile;
+          evaluate_tile(first_row, std::min(tile, num_rows - first_row),
+                        thread_workspace());
+        });
+      }
+
+      int tile_rows(const EvaluationPlan &plan, const bool with_derivative,
+                    const int num_derivative_columns,
+                    const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+                    const EvaluationWorkspace &workspace)
+      {
+        if (workspace.tile_rows > 0)
+        {
+          return workspace.tile_rows;
+        }
+        // size the tile so that all of its buffers stay in cache
+        int columns = evaluation_columns(constants);
+        int row_doubles = plan.GetNumSlots(with_derivative) * columns;
+        if (with_derivative)
+        {
+          row_doubles += plan.GetInstructions(true).size() * columns +
+                         num_derivative_columns;
+        }
+        int rows = kTileCacheBytes / (sizeof(double) * std::max(row_doubles, 1));
+        return std::max(rows, kMinTileRows);
+      }
+
+      void check_plan(const EvaluationPlan &plan)
+      {
+        if (plan.IsEmpty())
+        {
+          throw std::invalid_argument("Cannot evaluate an empty command stack");
+        }
+      }
+
+      void check_all_rows(const EvaluationOptions &options)
+      {
+        if (options.rows != nullptr)
+        {
+          throw std::invalid_argument(
+              "Only evaluations without derivatives take rows of x");
+        }
+      }
+
+      EvaluationWorkspace &options_workspace(const EvaluationOptions &options)
+      {
+        return options.workspace != nullptr ? *options.workspace
+                                            : thread_workspace();
+      }
+
+      EvaluationWorkspace &thread_workspace()
+      {
+        thread_local EvaluationWorkspace workspace;
+        return workspace;
+      }
+
+      // Plans of stacks passed in directly are compiled into a thread-local
+      // plan, so its storage is reused as well
+      const EvaluationPlan &thread_plan(
+          const Eigen::Ref<const Eigen::ArrayX3i> &stack)
+      {
+        thread_local EvaluationPlan plan;
+        plan.Compile(stack);
+        return plan;
       }
 
     } // namespace (anonymous)
@@ -0,0 +1,301 @@
+#include <stdexcept>
+#include <vector>
+
+#include <bingocpp/agraph/evaluation_backend/evaluation_plan.h>
+#include <bingocpp/agraph/constants.h>
+#include <bingocpp/agraph/operator_definitions.h>
+
+namespace bingo
+{
+  namespace evaluation_backend
+  {
+    namespace
+    {
+      bool is_terminal(int node)
+      {
+        return node <= Op::kConstant;
+      }
+
+      bool is_arity_2(int node)
+      {
+        auto arity_2 = kIsArity2Map.find(node);
+        if (arity_2 == kIsArity2Map.end())
+        {
+          throw std::runtime_error("Unknown Operator In Forward Evaluation");
+        }
+        return arity_2->second;
+      }
+
+      ValueShape terminal_shape(int node)
+      {
+        switch (node)
+        {
+        case Op::kVariable:
+          return kColumnShape;
+        case Op::kConstant:
+          return kRowShape;
+        }
+        return kScalarShape;
+      }
+
+      // Whether the reverse pass reads the value of the node itself
+      bool reverse_reads_result(int node)
+      {
+        switch (node)
+        {
+        case Op::kDivision:
+        case Op::kExponential:
+        case Op::kPower:
+        case Op::kSafePower:
+        case Op::kSqrt:
+          return true;
+        }
+        return false;
+      }
+
+      // Whether the reverse pass reads the values of the operands
+      bool reverse_reads_operands(int node)
+      {
+        return !is_terminal(node) && node != Op::kAddition &&
+               node != Op::kSubtraction && node != Op::kExponential;
+      }
+
+      // Numbers the instructions whose shape varies with the target shape,
+      // giving the others the number after them, and returns their count
+      int assign_adjoints(const std::vector<Instruction> &instructions,
+                          ValueShape target_shape, std::vector<int> &adjoints)
+      {
+        adjoints.resize(instructions.size());
+        int num_adjoints = 0;
+        for (std::size_t i = 0; i < instructions.size(); ++i)
+        {
+          if (instructions[i].shape & target_shape)
+          {
+            adjoints[i] = num_adjoints++;
+          }
+        }
+        for (std::size_t i = 0; i < instructions.size(); ++i)
+        {
+          if (!(instructions[i].shape & target_shape))
+          {
+            adjoints[i] = num_adjoints;
+          }
+        }
+        return num_adjoints;
+      }
+
+      // Assigns a slot to each instruction, reusing the slot of a value
+      // after its last use unless the value is pinned
+      int assign_slots(const std::vector<int> &last_use,
+                       const std::vector<bool> &pinned,
+                       std::vector<Instruction> &instructions)
+      {
+        std::vector<int> slot_of(instructions.size());
+        std::vector<int> free_slots;
+        int num_slots = 0;
+        for (std::size_t i = 0; i < instructions.size(); ++i)
+        {
+          Instruction &instruction = instructions[i];
+          // the result gets a slot before the operands are released, so a
+          // kernel never writes over one of its own operands
+          if (free_slots.empty())
+          {
+            slot_of[i] = num_slots++;
+          }
+          else
+          {
+            slot_of[i] = free_slots.back();
+            free_slots.pop_back();
+          }
+          instruction.result = slot_of[i];
+
+          if (is_terminal(instruction.node))
+          {
+            continue;
+          }
+          instruction.param1 = slot_of[instruction.adjoint1];
+          instruction.param2 = slot_of[instruction.adjoint2];
+          int operands[2] = {instruction.adjoint1, instruction.adjoint2};
+          int num_operands = (operands[0] == operands[1]) ? 1 : 2;
+          for (int j = 0; j < num_operands; ++j)
+          {
+            int operand = operands[j];
+            if (last_use[operand] == static_cast<int>(i) && !pinned[operand])
+            {
+              free_slots.push_back(slot_of[operand]);
+            }
+          }
+        }
+        return num_slots;
+      }
+    } // namespace
+
+    EvaluationPlan::EvaluationPlan(const Eigen::Ref<const Eigen::ArrayX3i> &stack)
+    {
+      Compile(stack);
+    }
+
+    void EvaluationPlan::Compile(const Eigen::Ref<const Eigen::ArrayX3i> &stack)
+    {
+      forward_instructions_.clear();
+      derivative_instructions_.clear();
+      num_forward_slots_ = 0;
+      num_derivative_slots_ = 0;
+      num_cached_values_ = 0;
+      for (int targets = kScalarShape; targets <= kFullShape; ++targets)
+      {
+        adjoints_[targets].clear();
+        num_adjoints_[targets] = 0;
+      }
+      int stack_size = stack.rows();
+      if (stack_size == 0)
+      {
+        return;
+      }
+
+      // commands the last command depends on
+      std::vector<bool> utilized(stack_size, false);
+      utilized[stack_size - 1] = true;
+      for (int row = stack_size - 1; row >= 0; --row)
+      {
+        int node = stack(row, kOpIdx);
+        if (utilized[row] && !is_terminal(node))
+        {
+          utilized[stack(row, kParam1Idx)] = true;
+          if (is_arity_2(node))
+          {
+            utilized[stack(row, kParam2Idx)] = true;
+          }
+        }
+      }
+
+      // decode the utilized commands, referring to operands by instruction
+      std::vector<int> instruction_of(stack_size, -1);
+      for (int row = 0; row < stack_size; ++row)
+      {
+        if (!utilized[row])
+        {
+          continue;
+        }
+        Instruction instruction;
+        instruction.node = stack(row, kOpIdx);
+        instruction.forward = GetForwardKernel(instruction.node);
+        instruction.reverse = GetReverseKernel(instruction.node);
+        instruction.tangent = GetTangentKernel(instruction.node);
+        instruction.param1 = stack(row, kParam1Idx);
+        instruction.param2 = stack(row, kParam2Idx);
+        instruction.result = -1;
+        instruction.cached = false;
+        if (is_terminal(instruction.node))
+        {
+          instruction.shape = terminal_shape(instruction.node);
+          instruction.adjoint1 = -1;
+          instruction.adjoint2 = -1;
+        }
+        else
+        {
+          instruction.adjoint1 = instruction_of[instruction.param1];
+          instruction.adjoint2 = is_arity_2(instruction.node)
+                                     ? instruction_of[instruction.param2]
+                                     : instruction.adjoint1;
+          instruction.shape = static_cast<ValueShape>(
+              forward_instructions_[instruction.adjoint1].shape |
+              forward_instructions_[instruction.adjoint2].shape);
+          instruction.reverse = GetReverseKernel(instruction.node,
+                                                 instruction.shape);
+        }
+        instruction_of[row] = forward_instructions_.size();
+        forward_instructions_.push_back(instruction);
+      }
+
+      // constant-free values read by constant-dependent instructions
+      for (Instruction &instruction : forward_instructions_)
+      {
+        if (is_terminal(instruction.node) ||
+            !(instruction.shape & kRowShape))
+        {
+          continue;
+        }
+        for (int operand : {instruction.adjoint1, instruction.adjoint2})
+        {
+          Instruction &operand_instruction = forward_instructions_[operand];
+          if (!is_terminal(operand_instruction.node) &&
+              operand_instruction.shape == kColumnShape &&
+              !operand_instruction.cached)
+          {
+            operand_instruction.cached = true;
+            ++num_cached_values_;
+          }
+        }
+      }
+
+      for (ValueShape targets : {kRowShape, kColumnShape, kFullShape})
+      {
+        num_adjoints_[targets] = assign_adjoints(forward_instructions_,
+                                                 targets, adjoints_[targets]);
+      }
+
+      // liveness: the last instruction reading each value
+      int num_instructions = forward_instructions_.size();
+      std::vector<int> last_use(num_instructions, num_instructions);
+      std::vector<bool> no_pins(num_instructions, false);
+      std::vector<bool> reverse_pins(num_instructions, false);
+      for (int i = 0; i < num_instructions; ++i)
+      {
+        const Instruction &instruction = forward_instructions_[i];
+        if (is_terminal(instruction.node))
+        {
+          continue;
+        }
+        last_use[instruction.adjoint1] = i;
+        last_use[instruction.adjoint2] = i;
+        if (reverse_reads_operands(instruction.node))
+        {
+          reverse_pins[instruction.adjoint1] = true;
+          reverse_pins[instruction.adjoint2] = true;
+        }
+        if (reverse_reads_result(instruction.node))
+        {
+          reverse_pins[i] = true;
+        }
+      }
+
+      derivative_instructions_ = forward_instructions_;
+      num_forward_slots_ = assign_slots(last_use, no_pins,
+                                        forward_instructions_);
+      num_derivative_slots_ = assign_slots(last_use, reverse_pins,
+                                           derivative_instructions_);
+    }
+
+    const std::vector<Instruction> &EvaluationPlan::GetInstructions(
+        bool with_derivative) const
+    {
+      return with_derivative ? derivative_instructions_ : forward_instructions_;
+    }
+
+    int EvaluationPlan::GetNumSlots(bool with_derivative) const
+    {
+      return with_derivative ? num_derivative_slots_ : num_forward_slots_;
+    }
+
+    const std::vector<int> &EvaluationPlan::GetAdjoints(ValueShape targets) const
+    {
+      return adjoints_[targets];
+    }
+
+    int EvaluationPlan::GetNumAdjoints(ValueShape targets) const
+    {
+      return num_adjoints_[targets];
+    }
+
+    int EvaluationPlan::GetNumCachedValues() const
+    {
+      return num_cached_values_;
+    }
+
+    bool EvaluationPlan::IsEmpty() const
+    {
+      return forward_instructions_.empty();
+    }
+  } // namespace evaluation_backend
+} // namespace bingo
@@ -1,7 +1,10 @@
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
 #include <iostream>
 
 #include <bingocpp/agraph/evaluation_backend/operator_eval.h>
+#include <bingocpp/agraph/evaluation_backend/simd_math.h>
 #include <bingocpp/agraph/operator_definitions.h>
 
 namespace bingo
@@ -10,107 +13,309 @@ namespace bingo
   {
     namespace
     {
-      //reshaping utility
-      std::vector<Eigen::ArrayXXd> do_reshape(Eigen::ArrayXXd &buffer0, Eigen::ArrayXXd &buffer1)
-      {
-        Eigen::ArrayXXd tmp;
-        std::vector<Eigen::ArrayXXd> reshaped_buffers(2);
-        reshaped_buffers[0] = buffer0;
-        reshaped_buffers[1] = buffer1;
-        if (reshaped_buffers[0].rows() == reshaped_buffers[1].rows() 
-            && reshaped_buffers[0].cols() == reshaped_buffers[1].cols()) {
-          return reshaped_buffers;
+      // Buffers for rows or columns broadcast by nested calls of broadcast
+      const int kMaxBroadcastDepth = 4;
+      thread_local Eigen::ArrayXXd broadcast_buffers[kMaxBroadcastDepth];
+      thread_local int broadcast_depth = 0;
+
+      // Calls function with array broadcast to the shape of like.  Scalars
+      // are broadcast by a lazy expression.  A row or column, as with
+      // several sets of constants, is copied into a buffer instead: the copy
+      // is vectorized, while a replicate expression takes indices modulo
+      // the size of array for every element.
+      template <typename Function>
+      void broadcast(const Eigen::ArrayXXd &array, const Eigen::ArrayXXd &like,
+                     Function function)
+      {
+        if (array.rows() == like.rows() && array.cols() == like.cols())
+        {
+          function(array);
+        }
+        else if (array.size() == 1)
+        {
+          function(Eigen::ArrayXXd::Constant(like.rows(), like.cols(), array(0, 0)));
+        }
+        else if (broadcast_depth < kMaxBroadcastDepth &&
+                 (array.rows() == like.rows() || array.cols() == like.cols()))
+        {
+          Eigen::ArrayXXd &buffer = broadcast_buffers[broadcast_depth++];
+          buffer.resize(like.rows(), like.cols());
+          if (array.rows() == like.rows())
+          {
+            buffer.colwise() = array.col(0);
+          }
+          else
+          {
+            buffer.rowwise() = array.row(0);
+          }
+          function(static_cast<const Eigen::ArrayXXd &>(buffer));
+          --broadcast_depth;
+        }
+        else
+        {
+          function(array.replicate(like.rows() / array.rows(),
+                                   like.cols() / array.cols()));
+        }
+      }
+
+      // Calls function with a column of array broadcast to num_rows rows
+      template <typename Function>
+      void broadcast_column(const Eigen::ArrayXXd &array, const int num_rows,
+                            const int col, Function function)
+      {
+        int array_col = array.cols() == 1 ? 0 : col;
+        if (array.rows() == num_rows)
+        {
+          function(array.col(array_col));
         }
+        else
+        {
+          function(Eigen::ArrayXd::Constant(num_rows, array(0, array_col)));
+        }
+      }
 
-        if (reshaped_buffers[0].rows() == 1 && reshaped_buffers[1].rows() > 1) {
-          tmp = reshaped_buffers[0].replicate(reshaped_buffers[1].rows(), 1);
-          reshaped_buffers[0] = tmp;
-        } else if (reshaped_buffers[1].rows() == 1 && reshaped_buffers[0].rows() > 1) {
-          tmp = reshaped_buffers[1].replicate(reshaped_buffers[0].rows(), 1);
-          reshaped_buffers[1] = tmp;
-        } 
+      // Evaluates function on two buffers broadcast to a common shape,
+      // writing into result without temporaries.
+      template <typename Function>
+      void broadcast_binary(const Eigen::ArrayXXd &buffer0,
+                            const Eigen::ArrayXXd &buffer1,
+                            Eigen::ArrayXXd &result, Function function)
+      {
+        if (buffer0.rows() == buffer1.rows() && buffer0.cols() == buffer1.cols())
+        {
+          result = function(buffer0, buffer1);
+          return;
+        }
+        result.resize(std::max(buffer0.rows(), buffer1.rows()),
+                      std::max(buffer0.cols(), buffer1.cols()));
+        if (result.cols() > 1 && result.rows() > 1)
+        {
+          // several sets of constants: column by column, so that values
+          // of the constants are broadcast as scalars
+          for (int col = 0; col < result.cols(); ++col)
+          {
+            broadcast_column(buffer0, result.rows(), col, [&](const auto &b0) {
+              broadcast_column(buffer1, result.rows(), col, [&](const auto &b1) {
+                result.col(col) = function(b0, b1);
+              });
+            });
+          }
+          return;
+        }
+        broadcast(buffer0, result, [&](const auto &b0) {
+          broadcast(buffer1, result, [&](const auto &b1) {
+            result = function(b0, b1);
+          });
+        });
+      }
 
-        if (reshaped_buffers[0].cols() == 1 && reshaped_buffers[1].cols() > 1) {
-          tmp = reshaped_buffers[0].replicate(1, reshaped_buffers[1].cols());
-          reshaped_buffers[0] = tmp;
-        } else if (reshaped_buffers[1].cols() == 1 && reshaped_buffers[0].cols() > 1) {
-          tmp = reshaped_buffers[1].replicate(1, reshaped_buffers[0].cols());
-          reshaped_buffers[1] = tmp;
-        } 
+      bool same_shape(const Eigen::ArrayXXd &array, const Eigen::ArrayXXd &like)
+      {
+        return array.rows() == like.rows() && array.cols() == like.cols();
+      }
 
-        return reshaped_buffers;
+      // Calls function(adjoint, fe1, fe2, fer, adjoint1, adjoint2) with the
+      // forward evaluations of the operands and the result broadcast to the
+      // shape of the adjoint of the result, adjoint1 and adjoint2 being the
+      // adjoints of the operands.  With several sets of constants, function
+      // is called once per column, so values of the constants are broadcast
+      // as scalars.
+      template <typename Function>
+      void broadcast_reverse(int reverse_index, int param1, int param2,
+                             const Eigen::ArrayXXd &forward_result,
+                             const Eigen::ArrayXXd &forward_param1,
+                             const Eigen::ArrayXXd &forward_param2,
+                             std::vector<Eigen::ArrayXXd> &reverse_eval,
+                             Function function)
+      {
+        const Eigen::ArrayXXd &adjoint = reverse_eval[reverse_index];
+        Eigen::ArrayXXd &adjoint1 = reverse_eval[param1];
+        Eigen::ArrayXXd &adjoint2 = reverse_eval[param2];
+        if (adjoint.cols() > 1 && !(same_shape(forward_param1, adjoint) &&
+                                    same_shape(forward_param2, adjoint) &&
+                                    same_shape(forward_result, adjoint)))
+        {
+          int rows = adjoint.rows();
+          for (int col = 0; col < adjoint.cols(); ++col)
+          {
+            auto column1 = adjoint1.col(col);
+            auto column2 = adjoint2.col(col);
+            broadcast_column(forward_param1, rows, col, [&](const auto &fe1) {
+              broadcast_column(forward_param2, rows, col, [&](const auto &fe2) {
+                broadcast_column(forward_result, rows, col, [&](const auto &fer) {
+                  function(adjoint.col(col), fe1, fe2, fer, column1, column2);
+                });
+              });
+            });
+          }
+          return;
+        }
+        broadcast(forward_param1, adjoint, [&](const auto &fe1) {
+          broadcast(forward_param2, adjoint, [&](const auto &fe2) {
+            broadcast(forward_result, adjoint, [&](const auto &fer) {
+              function(adjoint, fe1, fe2, fer, adjoint1, adjoint2);
+            });
+          });
+        });
       }
 
-      Eigen::ArrayXXd broadcast(const Eigen::ArrayXXd &array, int rows, int cols)
+      // Calls function(tangent, fe1, fe2, fer, tangent1, tangent2) with the
+      // forward evaluations of the operands and the result broadcast to the
+      // shape of the tangents, tangent being the tangent of the result and
+      // tangent1 and tangent2 those of the operands.  With several sets of
+      // constants, function is called once per column, as by
+      // broadcast_reverse.
+      template <typename Function>
+      void broadcast_tangent(int tangent_index, int param1, int param2,
+                             const Eigen::ArrayXXd &forward_result,
+                             const Eigen::ArrayXXd &forward_param1,
+                             const Eigen::ArrayXXd &forward_param2,
+                             std::vector<Eigen::ArrayXXd> &tangent_eval,
+                             Function function)
       {
-          return array.replicate(rows / array.rows(), cols / array.cols());
+        const Eigen::ArrayXXd &tangent1 = tangent_eval[param1];
+        const Eigen::ArrayXXd &tangent2 = tangent_eval[param2];
+        Eigen::ArrayXXd &tangent = tangent_eval[tangent_index];
+        tangent.resize(tangent1.rows(), tangent1.cols());
+        if (tangent.cols() > 1 && !(same_shape(forward_param1, tangent) &&
+                                    same_shape(forward_param2, tangent) &&
+                                    same_shape(forward_result, tangent)))
+        {
+          int rows = tangent.rows();
+          for (int col = 0; col < tangent.cols(); ++col)
+          {
+            auto column = tangent.col(col);
+            broadcast_column(forward_param1, rows, col, [&](const auto &fe1) {
+              broadcast_column(forward_param2, rows, col, [&](const auto &fe2) {
+                broadcast_column(forward_result, rows, col, [&](const auto &fer) {
+                  function(column, fe1, fe2, fer, tangent1.col(col),
+                           tangent2.col(col));
+                });
+              });
+            });
+          }
+          return;
+        }
+        broadcast(forward_param1, tangent, [&](const auto &fe1) {
+          broadcast(forward_param2, tangent, [&](const auto &fe2) {
+            broadcast(forward_result, tangent, [&](const auto &fer) {
+              function(tangent, fe1, fe2, fer, tangent1, tangent2);
+            });
+          });
+        });
       }
 
+      // Evaluates a vectorized function of operand into result
+      void simd_forward_eval(SimdFunction function,
+                             const Eigen::ArrayXXd &operand,
+                             Eigen::ArrayXXd &result)
+      {
+        result.resize(operand.rows(), operand.cols());
+        ApplySimdFunction(function, operand.data(), result.data(),
+                          operand.size());
+      }
+
+      // Accumulates scale * adjoint * function(operand) into the adjoint of
+      // the operand, using the vectorized function when no broadcast is
+      // needed
+      void simd_reverse_eval(SimdFunction function, double scale,
+                             const Eigen::ArrayXXd &adjoint,
+                             const Eigen::ArrayXXd &operand,
+                             Eigen::ArrayXXd &operand_adjoint)
+      {
+        if (operand.rows() == adjoint.rows() &&
+            operand.cols() == adjoint.cols() &&
+            operand_adjoint.rows() == adjoint.rows() &&
+            operand_adjoint.cols() == adjoint.cols())
+        {
+          AccumulateSimdProduct(function, operand.data(), adjoint.data(),
+                                scale, operand_adjoint.data(), adjoint.size());
+          return;
+        }
+        // the function is evaluated once per distinct value of operand
+        Eigen::ArrayXXd values(operand.rows(), operand.cols());
+        ApplySimdFunction(function, operand.data(), values.data(),
+                          values.size());
+        for (int col = 0; col < adjoint.cols(); ++col)
+        {
+          broadcast_column(values, adjoint.rows(), col, [&](const auto &value) {
+            operand_adjoint.col(col) += scale * adjoint.col(col) * value;
+          });
+        }
+      }
 
       // Integer
-      Eigen::ArrayXXd integer_forward_eval(int param1, int,
-                                           const Eigen::ArrayXXd &x,
-                                           const Eigen::ArrayXXd &,
-                                           std::vector<Eigen::ArrayXXd> &)
+      void integer_forward_eval(int param1, int,
+                                const Eigen::Ref<const Eigen::ArrayXXd> &,
+                                const Eigen::Ref<const Eigen::ArrayXXd> &,
+                                const std::vector<Eigen::ArrayXXd> &,
+                                Eigen::ArrayXXd &result)
       {
-        return Eigen::ArrayXXd::Constant(1, 1, param1);
+        result.setConstant(1, 1, param1);
       }
 
       void integer_reverse_eval(int, int, int,
-                                const std::vector<Eigen::ArrayXXd> &,
+                                const Eigen::ArrayXXd &,
+                                const Eigen::ArrayXXd &,
+                                const Eigen::ArrayXXd &,
                                 std::vector<Eigen::ArrayXXd> &)
       {
         return;
       }
 
       // Load x
-      Eigen::ArrayXXd loadx_forward_eval(int param1, int,
-                                         const Eigen::ArrayXXd &x,
-                                         const Eigen::ArrayXXd &constants,
-                                         std::vector<Eigen::ArrayXXd> &)
+      void loadx_forward_eval(int param1, int,
+                              const Eigen::Ref<const Eigen::ArrayXXd> &x,
+                              const Eigen::Ref<const Eigen::ArrayXXd> &,
+                              const std::vector<Eigen::ArrayXXd> &,
+                              Eigen::ArrayXXd &result)
       {
-        return x.col(param1);
-        // int num_cols = (constants.cols() == 0) ? 1 : constants.cols();
-        // return x.col(param1).replicate(1, num_cols);
+        result = x.col(param1);
       }
 
       void loadx_reverse_eval(int, int, int,
-                              const std::vector<Eigen::ArrayXXd> &,
+                              const Eigen::ArrayXXd &,
+                              const Eigen::ArrayXXd &,
+                              const Eigen::ArrayXXd &,
                               std::vector<Eigen::ArrayXXd> &)
       {
         return;
       }
 
       // Load c
-      Eigen::ArrayXXd loadc_forward_eval(int param1, int,
-                                         const Eigen::ArrayXXd &x,
-                                         const Eigen::ArrayXXd &constants,
-                                         std::vector<Eigen::ArrayXXd> &)
+      void loadc_forward_eval(int param1, int,
+                              const Eigen::Ref<const Eigen::ArrayXXd> &,
+                              const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+                              const std::vector<Eigen::ArrayXXd> &,
+                              Eigen::ArrayXXd &result)
       {
-        // return Eigen::ArrayXXd::Constant(x.rows(), constants.columns(), constants(param1, 0));
-        // return constants.row(param1).replicate(x.rows(), 1);
-        return constants.row(param1);
+        result = constants.row(param1);
       }
 
       void loadc_reverse_eval(int, int, int,
-                              const std::vector<Eigen::ArrayXXd> &,
+                              const Eigen::ArrayXXd &,
+                              const Eigen::ArrayXXd &,
+                              const Eigen::ArrayXXd &,
                               std::vector<Eigen::ArrayXXd> &)
       {
         return;
       }
 
       // Addition
-      Eigen::ArrayXXd add_forward_eval(int param1, int param2,
-                                       const Eigen::ArrayXXd &,
-                                       const Eigen::ArrayXXd &,
-                                       std::vector<Eigen::ArrayXXd> &forward_eval)
+      void add_forward_eval(int param1, int param2,
+                            const Eigen::Ref<const Eigen::ArrayXXd> &,
+                            const Eigen::Ref<const Eigen::ArrayXXd> &,
+                            const std::vector<Eigen::ArrayXXd> &forward_eval,
+                            Eigen::ArrayXXd &result)
       {
-        std::vector<Eigen::ArrayXXd> reshaped_buffers = do_reshape(forward_eval[param1], forward_eval[param2]);
-        return reshaped_buffers[0] + reshaped_buffers[1];
+        broadcast_binary(forward_eval[param1], forward_eval[param2], result,
+                         [](const auto &b0, const auto &b1) { return b0 + b1; });
       }
 
       void add_reverse_eval(int reverse_index, int param1, int param2,
-                            const std::vector<Eigen::ArrayXXd> &,
+                            const Eigen::ArrayXXd &,
+                            const Eigen::ArrayXXd &,
+                            const Eigen::ArrayXXd &,
                             std::vector<Eigen::ArrayXXd> &reverse_eval)
       {
         reverse_eval[param1] += reverse_eval[reverse_index];
@@ -118,17 +323,20 @@ namespace bingo
       }
 
       // Subtraction
-      Eigen::ArrayXXd subtract_forward_eval(int param1, int param2,
-                                            const Eigen::ArrayXXd &,
-                                            const Eigen::ArrayXXd &,
-                                            std::vector<Eigen::ArrayXXd> &forward_eval)
+      void subtract_forward_eval(int param1, int param2,
+                                 const Eigen::Ref<const Eigen::ArrayXXd> &,
+                                 const Eigen::Ref<const Eigen::ArrayXXd> &,
+                                 const std::vector<Eigen::ArrayXXd> &forward_eval,
+                                 Eigen::ArrayXXd &result)
       {
-        std::vector<Eigen::ArrayXXd> reshaped_buffers = do_reshape(forward_eval[param1], forward_eval[param2]);
-        return reshaped_buffers[0] - reshaped_buffers[1];
+        broadcast_binary(forward_eval[param1], forward_eval[param2], result,
+                         [](const auto &b0, const auto &b1) { return b0 - b1; });
       }
 
       void subtract_reverse_eval(int reverse_index, int param1, int param2,
-                                 const std::vector<Eigen::ArrayXXd> &,
+                                 const Eigen::ArrayXXd &,
+                                 const Eigen::ArrayXXd &,
+                                 const Eigen::ArrayXXd &,
                                  std::vector<Eigen::ArrayXXd> &reverse_eval)
       {
         reverse_eval[param1] += reverse_eval[reverse_index];
@@ -136,368 +344,698 @@ namespace bingo
       }
 
       // Multiplication
-      Eigen::ArrayXXd multiply_forward_eval(int param1, int param2,
-                                            const Eigen::ArrayXXd &,
-                                            const Eigen::ArrayXXd &,
-                                            std::vector<Eigen::ArrayXXd> &forward_eval)
+      void multiply_forward_eval(int param1, int param2,
+                                 const Eigen::Ref<const Eigen::ArrayXXd> &,
+                                 const Eigen::Ref<const Eigen::ArrayXXd> &,
+                                 const std::vector<Eigen::ArrayXXd> &forward_eval,
+                                 Eigen::ArrayXXd &result)
       {
-        std::vector<Eigen::ArrayXXd> reshaped_buffers = do_reshape(forward_eval[param1], forward_eval[param2]);
-        return reshaped_buffers[0] * reshaped_buffers[1];
+        broadcast_binary(forward_eval[param1], forward_eval[param2], result,
+                         [](const auto &b0, const auto &b1) { return b0 * b1; });
       }
 
       void multiply_reverse_eval(int reverse_index, int param1, int param2,
-                                 const std::vector<Eigen::ArrayXXd> &forward_eval,
+                                 const Eigen::ArrayXXd &,
+                                 const Eigen::ArrayXXd &forward_param1,
+                                 const Eigen::ArrayXXd &forward_param2,
                                  std::vector<Eigen::ArrayXXd> &reverse_eval)
       {
-        Eigen::ArrayXXd fe1 = broadcast(forward_eval[param1], 
-                                        reverse_eval[reverse_index].rows(),
-                                        reverse_eval[reverse_index].cols());
-        Eigen::ArrayXXd fe2 = broadcast(forward_eval[param2], 
-                                        reverse_eval[reverse_index].rows(),
-                                        reverse_eval[reverse_index].cols());
-        reverse_eval[param1] += reverse_eval[reverse_index] * fe2;
-        reverse_eval[param2] += reverse_eval[reverse_index] * fe1;
+        broadcast_reverse(reverse_index, param1, param2, forward_param1,
+                          forward_param1, forward_param2, reverse_eval,
+                          [](const auto &adjoint, const auto &fe1,
+                             const auto &fe2, const auto &,
+                             auto &adjoint1, auto &adjoint2) {
+          adjoint1 += adjoint * fe2;
+          adjoint2 += adjoint * fe1;
+        });
       }
 
       // Division
-      Eigen::ArrayXXd divide_forward_eval(int param1, int param2,
-                                          const Eigen::ArrayXXd &,
-                                          const Eigen::ArrayXXd &,
-                                          std::vector<Eigen::ArrayXXd> &forward_eval)
+      void divide_forward_eval(int param1, int param2,
+                               const Eigen::Ref<const Eigen::ArrayXXd> &,
+                               const Eigen::Ref<const Eigen::ArrayXXd> &,
+                               const std::vector<Eigen::ArrayXXd> &forward_eval,
+                               Eigen::ArrayXXd &result)
       {
-        std::vector<Eigen::ArrayXXd> reshaped_buffers = do_reshape(forward_eval[param1], forward_eval[param2]);
-        return reshaped_buffers[0] / reshaped_buffers[1];
+        broadcast_binary(forward_eval[param1], forward_eval[param2], result,
+                         [](const auto &b0, const auto &b1) { return b0 / b1; });
       }
 
       void divide_reverse_eval(int reverse_index, int param1, int param2,
-                               const std::vector<Eigen::ArrayXXd> &forward_eval,
+                               const Eigen::ArrayXXd &forward_result,
+                               const Eigen::ArrayXXd &,
+                               const Eigen::ArrayXXd &forward_param2,
                                std::vector<Eigen::ArrayXXd> &reverse_eval)
       {
-        Eigen::ArrayXXd fe2 = broadcast(forward_eval[param2], 
-                                        reverse_eval[reverse_index].rows(),
-                                        reverse_eval[reverse_index].cols());
-        Eigen::ArrayXXd fer = broadcast(forward_eval[reverse_index], 
-                                        reverse_eval[reverse_index].rows(),
-                                        reverse_eval[reverse_index].cols());
-        reverse_eval[param1] += reverse_eval[reverse_index] / fe2;
-        reverse_eval[param2] -= reverse_eval[reverse_index] * fer / fe2;
+        broadcast_reverse(reverse_index, param1, param2, forward_result,
+                          forward_param2, forward_param2, reverse_eval,
+                          [](const auto &adjoint, const auto &,
+                             const auto &fe2, const auto &fer,
+                             auto &adjoint1, auto &adjoint2) {
+          adjoint1 += adjoint / fe2;
+          adjoint2 -= adjoint * fer / fe2;
+        });
       }
 
       // Sine
-      Eigen::ArrayXXd sin_forward_eval(int param1, int,
-                                       const Eigen::ArrayXXd &,
-                                       const Eigen::ArrayXXd &,
-                                       std::vector<Eigen::ArrayXXd> &forward_eval)
+      void sin_forward_eval(int param1, int,
+                            const Eigen::Ref<const Eigen::ArrayXXd> &,
+                            const Eigen::Ref<const Eigen::ArrayXXd> &,
+                            const std::vector<Eigen::ArrayXXd> &forward_eval,
+                            Eigen::ArrayXXd &result)
       {
-        return forward_eval.at(param1).sin();
+        simd_forward_eval(kSinFunction, forward_eval.at(param1), result);
       }
 
       void sin_reverse_eval(int reverse_index, int param1, int,
-                            const std::vector<Eigen::ArrayXXd> &forward_eval,
+                            const Eigen::ArrayXXd &,
+                            const Eigen::ArrayXXd &forward_param1,
+                            const Eigen::ArrayXXd &,
                             std::vector<Eigen::ArrayXXd> &reverse_eval)
       {
-        Eigen::ArrayXXd fe1 = broadcast(forward_eval[param1], 
-                                        reverse_eval[reverse_index].rows(),
-                                        reverse_eval[reverse_index].cols());
-        reverse_eval[param1] += reverse_eval[reverse_index] * fe1.cos();
+        const Eigen::ArrayXXd &adjoint = reverse_eval[reverse_index];
+        simd_reverse_eval(kCosFunction, 1.0, adjoint, forward_param1,
+                          reverse_eval[param1]);
       }
 
       // Cosine
-      Eigen::ArrayXXd cos_forward_eval(int param1, int,
-                                       const Eigen::ArrayXXd &,
-                                       const Eigen::ArrayXXd &,
-                                       std::vector<Eigen::ArrayXXd> &forward_eval)
+      void cos_forward_eval(int param1, int,
+                            const Eigen::Ref<const Eigen::ArrayXXd> &,
+                            const Eigen::Ref<const Eigen::ArrayXXd> &,
+                            const std::vector<Eigen::ArrayXXd> &forward_eval,
+                            Eigen::ArrayXXd &result)
       {
-        return forward_eval[param1].cos();
+        simd_forward_eval(kCosFunction, forward_eval[param1], result);
       }
 
       void cos_reverse_eval(int reverse_index, int param1, int,
-                            const std::vector<Eigen::ArrayXXd> &forward_eval,
+                            const Eigen::ArrayXXd &,
+                            const Eigen::ArrayXXd &forward_param1,
+                            const Eigen::ArrayXXd &,
                             std::vector<Eigen::ArrayXXd> &reverse_eval)
       {
-        Eigen::ArrayXXd fe1 = broadcast(forward_eval[param1], 
-                                        reverse_eval[reverse_index].rows(),
-                                        reverse_eval[reverse_index].cols());
-        reverse_eval[param1] -= reverse_eval[reverse_index] * fe1.sin();
+        const Eigen::ArrayXXd &adjoint = reverse_eval[reverse_index];
+        simd_reverse_eval(kSinFunction, -1.0, adjoint, forward_param1,
+                          reverse_eval[param1]);
       }
 
       // Exponential
-      Eigen::ArrayXXd exp_forward_eval(int param1, int,
-                                       const Eigen::ArrayXXd &,
-                                       const Eigen::ArrayXXd &,
-                                       std::vector<Eigen::ArrayXXd> &forward_eval)
+      void exp_forward_eval(int param1, int,
+                            const Eigen::Ref<const Eigen::ArrayXXd> &,
+                            const Eigen::Ref<const Eigen::ArrayXXd> &,
+                            const std::vector<Eigen::ArrayXXd> &forward_eval,
+                            Eigen::ArrayXXd &result)
       {
-        return forward_eval[param1].exp();
+        simd_forward_eval(kExpFunction, forward_eval[param1], result);
       }
 
       void exp_reverse_eval(int reverse_index, int param1, int,
-                            const std::vector<Eigen::ArrayXXd> &forward_eval,
+                            const Eigen::ArrayXXd &forward_result,
+                            const Eigen::ArrayXXd &,
+                            const Eigen::ArrayXXd &,
                             std::vector<Eigen::ArrayXXd> &reverse_eval)
       {
-        Eigen::ArrayXXd fer = broadcast(forward_eval[reverse_index], 
-                                        reverse_eval[reverse_index].rows(),
-                                        reverse_eval[reverse_index].cols());
-        reverse_eval[param1] += reverse_eval[reverse_index] * fer;
+        broadcast_reverse(reverse_index, param1, param1, forward_result,
+                          forward_result, forward_result, reverse_eval,
+                          [](const auto &adjoint, const auto &,
+                             const auto &, const auto &fer,
+                             auto &adjoint1, auto &) {
+          adjoint1 += adjoint * fer;
+        });
       }
 
       // Logarithm
-      Eigen::ArrayXXd log_forward_eval(int param1, int,
-                                       const Eigen::ArrayXXd &,
-                                       const Eigen::ArrayXXd &,
-                                       std::vector<Eigen::ArrayXXd> &forward_eval)
+      void log_forward_eval(int param1, int,
+                            const Eigen::Ref<const Eigen::ArrayXXd> &,
+                            const Eigen::Ref<const Eigen::ArrayXXd> &,
+                            const std::vector<Eigen::ArrayXXd> &forward_eval,
+                            Eigen::ArrayXXd &result)
       {
-        return forward_eval[param1].abs().log();
+        simd_forward_eval(kLogAbsFunction, forward_eval[param1], result);
       }
 
       void log_reverse_eval(int reverse_index, int param1, int,
-                            const std::vector<Eigen::ArrayXXd> &forward_eval,
+                            const Eigen::ArrayXXd &,
+                            const Eigen::ArrayXXd &forward_param1,
+                            const Eigen::ArrayXXd &,
                             std::vector<Eigen::ArrayXXd> &reverse_eval)
       {
-        Eigen::ArrayXXd fe1 = broadcast(forward_eval[param1], 
-                                        reverse_eval[reverse_index].rows(),
-                                        reverse_eval[reverse_index].cols());
-        reverse_eval[param1] += reverse_eval[reverse_index] / fe1;
+        broadcast_reverse(reverse_index, param1, param1, forward_param1,
+                          forward_param1, forward_param1, reverse_eval,
+                          [](const auto &adjoint, const auto &fe1,
+                             const auto &, const auto &,
+                             auto &adjoint1, auto &) {
+          adjoint1 += adjoint / fe1;
+        });
       }
 
       // Power
-      Eigen::ArrayXXd pow_forward_eval(int param1, int param2,
-                                       const Eigen::ArrayXXd &,
-                                       const Eigen::ArrayXXd &,
-                                       std::vector<Eigen::ArrayXXd> &forward_eval)
+      void pow_forward_eval(int param1, int param2,
+                            const Eigen::Ref<const Eigen::ArrayXXd> &,
+                            const Eigen::Ref<const Eigen::ArrayXXd> &,
+                            const std::vector<Eigen::ArrayXXd> &forward_eval,
+                            Eigen::ArrayXXd &result)
       {
-        std::vector<Eigen::ArrayXXd> reshaped_buffers = do_reshape(forward_eval[param1], forward_eval[param2]);
-        return reshaped_buffers[0].pow(reshaped_buffers[1]);
+        broadcast_binary(forward_eval[param1], forward_eval[param2], result,
+                         [](const auto &b0, const auto &b1) { return b0.pow(b1); });
       }
 
       void pow_reverse_eval(int reverse_index, int param1, int param2,
-                            const std::vector<Eigen::ArrayXXd> &forward_eval,
+                            const Eigen::ArrayXXd &forward_result,
+                            const Eigen::ArrayXXd &forward_param1,
+                            const Eigen::ArrayXXd &forward_param2,
                             std::vector<Eigen::ArrayXXd> &reverse_eval)
       {
-        Eigen::ArrayXXd fe1 = broadcast(forward_eval[param1], 
-                                        reverse_eval[reverse_index].rows(),
-                                        reverse_eval[reverse_index].cols());
-        Eigen::ArrayXXd fe2 = broadcast(forward_eval[param2], 
-                                        reverse_eval[reverse_index].rows(),
-                                        reverse_eval[reverse_index].cols());
-        Eigen::ArrayXXd fer = broadcast(forward_eval[reverse_index], 
-                                        reverse_eval[reverse_index].rows(),
-                                        reverse_eval[reverse_index].cols());
-        reverse_eval[param1] += reverse_eval[reverse_index] * fer * fe2 / fe1;
-        reverse_eval[param2] += reverse_eval[reverse_index] * fer * (fe1.log());
+        broadcast_reverse(reverse_index, param1, param2, forward_result,
+                          forward_param1, forward_param2, reverse_eval,
+                          [](const auto &adjoint, const auto &fe1,
+                             const auto &fe2, const auto &fer,
+                             auto &adjoint1, auto &adjoint2) {
+          adjoint1 += adjoint * fer * fe2 / fe1;
+          adjoint2 += adjoint * fer * (fe1.log());
+        });
       }
 
       // Safe Power
-      Eigen::ArrayXXd safepow_forward_eval(int param1, int param2,
-                                           const Eigen::ArrayXXd &,
-                                           const Eigen::ArrayXXd &,
-                                           std::vector<Eigen::ArrayXXd> &forward_eval)
+      void safepow_forward_eval(int param1, int param2,
+                                const Eigen::Ref<const Eigen::ArrayXXd> &,
+                                const Eigen::Ref<const Eigen::ArrayXXd> &,
+                                const std::vector<Eigen::ArrayXXd> &forward_eval,
+                                Eigen::ArrayXXd &result)
       {
-        std::vector<Eigen::ArrayXXd> reshaped_buffers = do_reshape(forward_eval[param1], forward_eval[param2]);
-        return reshaped_buffers[0].abs().pow(reshaped_buffers[1]);
+        broadcast_binary(forward_eval[param1], forward_eval[param2], result,
+                         [](const auto &b0, const auto &b1) { return b0.abs().pow(b1); });
       }
 
       void safepow_reverse_eval(int reverse_index, int param1, int param2,
-                                const std::vector<Eigen::ArrayXXd> &forward_eval,
+                                const Eigen::ArrayXXd &forward_result,
+                                const Eigen::ArrayXXd &forward_param1,
+                                const Eigen::ArrayXXd &forward_param2,
                                 std::vector<Eigen::ArrayXXd> &reverse_eval)
       {
-        Eigen::ArrayXXd fe1 = broadcast(forward_eval[param1], 
-                                        reverse_eval[reverse_index].rows(),
-                                        reverse_eval[reverse_index].cols());
-        Eigen::ArrayXXd fe2 = broadcast(forward_eval[param2], 
-                                        reverse_eval[reverse_index].rows(),
-                                        reverse_eval[reverse_index].cols());
-        Eigen::ArrayXXd fer = broadcast(forward_eval[reverse_index], 
-                                        reverse_eval[reverse_index].rows(),
-                                        reverse_eval[reverse_index].cols());
-        reverse_eval[param1] += reverse_eval[reverse_index] * fer * fe2 / fe1;
-        reverse_eval[param2] += reverse_eval[reverse_index] * fer * (fe1.abs().log());
+        broadcast_reverse(reverse_index, param1, param2, forward_result,
+                          forward_param1, forward_param2, reverse_eval,
+                          [](const auto &adjoint, const auto &fe1,
+                             const auto &fe2, const auto &fer,
+                             auto &adjoint1, auto &adjoint2) {
+          adjoint1 += adjoint * fer * fe2 / fe1;
+          adjoint2 += adjoint * fer * (fe1.abs().log());
+        });
       }
 
       // Absolute Value
-      Eigen::ArrayXXd abs_forward_eval(int param1, int,
-                                       const Eigen::ArrayXXd &,
-                                       const Eigen::ArrayXXd &,
-                                       std::vector<Eigen::ArrayXXd> &forward_eval)
+      void abs_forward_eval(int param1, int,
+                            const Eigen::Ref<const Eigen::ArrayXXd> &,
+                            const Eigen::Ref<const Eigen::ArrayXXd> &,
+                            const std::vector<Eigen::ArrayXXd> &forward_eval,
+                            Eigen::ArrayXXd &result)
       {
-        return forward_eval[param1].abs();
+        result = forward_eval[param1].abs();
       }
 
       void abs_reverse_eval(int reverse_index, int param1, int,
-                            const std::vector<Eigen::ArrayXXd> &forward_eval,
+                            const Eigen::ArrayXXd &,
+                            const Eigen::ArrayXXd &forward_param1,
+                            const Eigen::ArrayXXd &,
                             std::vector<Eigen::ArrayXXd> &reverse_eval)
       {
-        Eigen::ArrayXXd fe1 = broadcast(forward_eval[param1], 
-                                        reverse_eval[reverse_index].rows(),
-                                        reverse_eval[reverse_index].cols());
-        reverse_eval[param1] += reverse_eval[reverse_index] * fe1.sign();
+        broadcast_reverse(reverse_index, param1, param1, forward_param1,
+                          forward_param1, forward_param1, reverse_eval,
+                          [](const auto &adjoint, const auto &fe1,
+                             const auto &, const auto &,
+                             auto &adjoint1, auto &) {
+          adjoint1 += adjoint * fe1.sign();
+        });
       }
 
       // Sqruare root
-      Eigen::ArrayXXd sqrt_forward_eval(int param1, int,
-                                        const Eigen::ArrayXXd &,
-                                        const Eigen::ArrayXXd &,
-                                        std::vector<Eigen::ArrayXXd> &forward_eval)
+      void sqrt_forward_eval(int param1, int,
+                             const Eigen::Ref<const Eigen::ArrayXXd> &,
+                             const Eigen::Ref<const Eigen::ArrayXXd> &,
+                             const std::vector<Eigen::ArrayXXd> &forward_eval,
+                             Eigen::ArrayXXd &result)
       {
-        return forward_eval[param1].abs().sqrt();
+        result = forward_eval[param1].abs().sqrt();
       }
 
       void sqrt_reverse_eval(int reverse_index, int param1, int,
-                             const std::vector<Eigen::ArrayXXd> &forward_eval,
+                             const Eigen::ArrayXXd &forward_result,
+                             const Eigen::ArrayXXd &forward_param1,
+                             const Eigen::ArrayXXd &,
                              std::vector<Eigen::ArrayXXd> &reverse_eval)
       {
-        Eigen::ArrayXXd fe1 = broadcast(forward_eval[param1], 
-                                        reverse_eval[reverse_index].rows(),
-                                        reverse_eval[reverse_index].cols());
-        Eigen::ArrayXXd fer = broadcast(forward_eval[reverse_index], 
-                                        reverse_eval[reverse_index].rows(),
-                                        reverse_eval[reverse_index].cols());
-        reverse_eval[param1] += 0.5 * reverse_eval[reverse_index] / fer * fe1.sign();
+        broadcast_reverse(reverse_index, param1, param1, forward_result,
+                          forward_param1, forward_param1, reverse_eval,
+                          [](const auto &adjoint, const auto &fe1,
+                             const auto &, const auto &fer,
+                             auto &adjoint1, auto &) {
+          adjoint1 += 0.5 * adjoint / fer * fe1.sign();
+        });
       }
 
       // Sinh
-      Eigen::ArrayXXd sinh_forward_eval(int param1, int,
-                                        const Eigen::ArrayXXd &,
-                                        const Eigen::ArrayXXd &,
-                                        std::vector<Eigen::ArrayXXd> &forward_eval)
+      void sinh_forward_eval(int param1, int,
+                             const Eigen::Ref<const Eigen::ArrayXXd> &,
+                             const Eigen::Ref<const Eigen::ArrayXXd> &,
+                             const std::vector<Eigen::ArrayXXd> &forward_eval,
+                             Eigen::ArrayXXd &result)
       {
-        return forward_eval.at(param1).sinh();
+        simd_forward_eval(kSinhFunction, forward_eval.at(param1), result);
       }
 
       void sinh_reverse_eval(int reverse_index, int param1, int,
-                             const std::vector<Eigen::ArrayXXd> &forward_eval,
+                             const Eigen::ArrayXXd &,
+                             const Eigen::ArrayXXd &forward_param1,
+                             const Eigen::ArrayXXd &,
                              std::vector<Eigen::ArrayXXd> &reverse_eval)
       {
-        Eigen::ArrayXXd fe1 = broadcast(forward_eval[param1], 
-                                        reverse_eval[reverse_index].rows(),
-                                        reverse_eval[reverse_index].cols());
-        reverse_eval[param1] += reverse_eval[reverse_index] * fe1.cosh();
+        const Eigen::ArrayXXd &adjoint = reverse_eval[reverse_index];
+        simd_reverse_eval(kCoshFunction, 1.0, adjoint, forward_param1,
+                          reverse_eval[param1]);
       }
 
       // Cosh
-      Eigen::ArrayXXd cosh_forward_eval(int param1, int,
-                                        const Eigen::ArrayXXd &,
-                                        const Eigen::ArrayXXd &,
-                                        std::vector<Eigen::ArrayXXd> &forward_eval)
+      void cosh_forward_eval(int param1, int,
+                             const Eigen::Ref<const Eigen::ArrayXXd> &,
+                             const Eigen::Ref<const Eigen::ArrayXXd> &,
+                             const std::vector<Eigen::ArrayXXd> &forward_eval,
+                             Eigen::ArrayXXd &result)
       {
-        return forward_eval[param1].cosh();
+        simd_forward_eval(kCoshFunction, forward_eval[param1], result);
       }
 
       void cosh_reverse_eval(int reverse_index, int param1, int,
-                             const std::vector<Eigen::ArrayXXd> &forward_eval,
+                             const Eigen::ArrayXXd &,
+                             const Eigen::ArrayXXd &forward_param1,
+                             const Eigen::ArrayXXd &,
                              std::vector<Eigen::ArrayXXd> &reverse_eval)
       {
-        Eigen::ArrayXXd fe1 = broadcast(forward_eval[param1], 
-                                        reverse_eval[reverse_index].rows(),
-                                        reverse_eval[reverse_index].cols());
-        reverse_eval[param1] += reverse_eval[reverse_index] * fe1.sinh();
+        const Eigen::ArrayXXd &adjoint = reverse_eval[reverse_index];
+        simd_reverse_eval(kSinhFunction, 1.0, adjoint, forward_param1,
+                          reverse_eval[param1]);
+      }
+
+      // Tangent kernels, propagating the derivative along a direction from
+      // the operands to the result.  An operand that does not depend on the
+      // direction has a zero tangent; the power kernels skip its term, whose
+      // local derivative may not be finite.
+      void terminal_tangent_eval(int, int, int,
+                                 const Eigen::ArrayXXd &,
+                                 const Eigen::ArrayXXd &,
+                                 const Eigen::ArrayXXd &,
+                                 std::vector<Eigen::ArrayXXd> &)
+      {
+        return;
+      }
+
+      void add_tangent_eval(int tangent_index, int param1, int param2,
+                            const Eigen::ArrayXXd &,
+                            const Eigen::ArrayXXd &,
+                            const Eigen::ArrayXXd &,
+                            std::vector<Eigen::ArrayXXd> &tangent_eval)
+      {
+        tangent_eval[tangent_index] = tangent_eval[param1] + tangent_eval[param2];
+      }
+
+      void subtract_tangent_eval(int tangent_index, int param1, int param2,
+                                 const Eigen::ArrayXXd &,
+                                 const Eigen::ArrayXXd &,
+                                 const Eigen::ArrayXXd &,
+                                 std::vector<Eigen::ArrayXXd> &tangent_eval)
+      {
+        tangent_eval[tangent_index] = tangent_eval[param1] - tangent_eval[param2];
+      }
+
+      void multiply_tangent_eval(int tangent_index, int param1, int param2,
+                                 const Eigen::ArrayXXd &forward_result,
+                                 const Eigen::ArrayXXd &forward_param1,
+                                 const Eigen::ArrayXXd &forward_param2,
+                                 std::vector<Eigen::ArrayXXd> &tangent_eval)
+      {
+        broadcast_tangent(tangent_index, param1, param2, forward_result,
+                          forward_param1, forward_param2, tangent_eval,
+                          [](auto &tangent, const auto &fe1, const auto &fe2,
+                             const auto &, const auto &tangent1,
+                             const auto &tangent2) {
+          tangent = tangent1 * fe2 + fe1 * tangent2;
+        });
+      }
+
+      void divide_tangent_eval(int tangent_index, int param1, int param2,
+                               const Eigen::ArrayXXd &forward_result,
+                               const Eigen::ArrayXXd &forward_param1,
+                               const Eigen::ArrayXXd &forward_param2,
+                               std::vector<Eigen::ArrayXXd> &tangent_eval)
+      {
+        broadcast_tangent(tangent_index, param1, param2, forward_result,
+                          forward_param1, forward_param2, tangent_eval,
+                          [](auto &tangent, const auto &, const auto &fe2,
+                             const auto &fer, const auto &tangent1,
+                             const auto &tangent2) {
+          tangent = (tangent1 - fer * tangent2) / fe2;
+        });
+      }
+
+      void sin_tangent_eval(int tangent_index, int param1, int,
+                            const Eigen::ArrayXXd &forward_result,
+                            const Eigen::ArrayXXd &forward_param1,
+                            const Eigen::ArrayXXd &,
+                            std::vector<Eigen::ArrayXXd> &tangent_eval)
+      {
+        broadcast_tangent(tangent_index, param1, param1, forward_result,
+                          forward_param1, forward_param1, tangent_eval,
+                          [](auto &tangent, const auto &fe1, const auto &,
+                             const auto &, const auto &tangent1,
+                             const auto &) {
+          tangent = tangent1 * fe1.cos();
+        });
+      }
+
+      void cos_tangent_eval(int tangent_index, int param1, int,
+                            const Eigen::ArrayXXd &forward_result,
+                            const Eigen::ArrayXXd &forward_param1,
+                            const Eigen::ArrayXXd &,
+                            std::vector<Eigen::ArrayXXd> &tangent_eval)
+      {
+        broadcast_tangent(tangent_index, param1, param1, forward_result,
+                          forward_param1, forward_param1, tangent_eval,
+                          [](auto &tangent, const auto &fe1, const auto &,
+                             const auto &, const auto &tangent1,
+                             const auto &) {
+          tangent = -tangent1 * fe1.sin();
+        });
+      }
+
+      void exp_tangent_eval(int tangent_index, int param1, int,
+                            const Eigen::ArrayXXd &forward_result,
+                            const Eigen::ArrayXXd &forward_param1,
+                            const Eigen::ArrayXXd &,
+                            std::vector<Eigen::ArrayXXd> &tangent_eval)
+      {
+        broadcast_tangent(tangent_index, param1, param1, forward_result,
+                          forward_param1, forward_param1, tangent_eval,
+                          [](auto &tangent, const auto &, const auto &,
+                             const auto &fer, const auto &tangent1,
+                             const auto &) {
+          tangent = tangent1 * fer;
+        });
+      }
+
+      void log_tangent_eval(int tangent_index, int param1, int,
+                            const Eigen::ArrayXXd &forward_result,
+                            const Eigen::ArrayXXd &forward_param1,
+                            const Eigen::ArrayXXd &,
+                            std::vector<Eigen::ArrayXXd> &tangent_eval)
+      {
+        broadcast_tangent(tangent_index, param1, param1, forward_result,
+                          forward_param1, forward_param1, tangent_eval,
+                          [](auto &tangent, const auto &fe1, const auto &,
+                             const auto &, const auto &tangent1,
+                             const auto &) {
+          tangent = tangent1 / fe1;
+        });
+      }
+
+      void pow_tangent_eval(int tangent_index, int param1, int param2,
+                            const Eigen::ArrayXXd &forward_result,
+                            const Eigen::ArrayXXd &forward_param1,
+                            const Eigen::ArrayXXd &forward_param2,
+                            std::vector<Eigen::ArrayXXd> &tangent_eval)
+      {
+        broadcast_tangent(tangent_index, param1, param2, forward_result,
+                          forward_param1, forward_param2, tangent_eval,
+                          [](auto &tangent, const auto &fe1, const auto &fe2,
+                             const auto &fer, const auto &tangent1,
+                             const auto &tangent2) {
+          tangent = fer * ((tangent1 != 0.0).select(fe2 / fe1 * tangent1, 0.0) +
+                           (tangent2 != 0.0).select(fe1.log() * tangent2, 0.0));
+        });
+      }
+
+      void safepow_tangent_eval(int tangent_index, int param1, int param2,
+                                const Eigen::ArrayXXd &forward_result,
+                                const Eigen::ArrayXXd &forward_param1,
+                                const Eigen::ArrayXXd &forward_param2,
+                                std::vector<Eigen::ArrayXXd> &tangent_eval)
+      {
+        broadcast_tangent(tangent_index, param1, param2, forward_result,
+                          forward_param1, forward_param2, tangent_eval,
+                          [](auto &tangent, const auto &fe1, const auto &fe2,
+                             const auto &fer, const auto &tangent1,
+                             const auto &tangent2) {
+          tangent = fer * ((tangent1 != 0.0).select(fe2 / fe1 * tangent1, 0.0) +
+                           (tangent2 != 0.0).select(fe1.abs().log() * tangent2, 0.0));
+        });
+      }
+
+      void abs_tangent_eval(int tangent_index, int param1, int,
+                            const Eigen::ArrayXXd &forward_result,
+                            const Eigen::ArrayXXd &forward_param1,
+                            const Eigen::ArrayXXd &,
+                            std::vector<Eigen::ArrayXXd> &tangent_eval)
+      {
+        broadcast_tangent(tangent_index, param1, param1, forward_result,
+                          forward_param1, forward_param1, tangent_eval,
+                          [](auto &tangent, const auto &fe1, const auto &,
+                             const auto &, const auto &tangent1,
+                             const auto &) {
+          tangent = tangent1 * fe1.sign();
+        });
+      }
+
+      void sqrt_tangent_eval(int tangent_index, int param1, int,
+                             const Eigen::ArrayXXd &forward_result,
+                             const Eigen::ArrayXXd &forward_param1,
+                             const Eigen::ArrayXXd &,
+                             std::vector<Eigen::ArrayXXd> &tangent_eval)
+      {
+        broadcast_tangent(tangent_index, param1, param1, forward_result,
+                          forward_param1, forward_param1, tangent_eval,
+                          [](auto &tangent, const auto &fe1, const auto &,
+                             const auto &fer, const auto &tangent1,
+                             const auto &) {
+          tangent = 0.5 * tangent1 / fer * fe1.sign();
+        });
+      }
+
+      void sinh_tangent_eval(int tangent_index, int param1, int,
+                             const Eigen::ArrayXXd &forward_result,
+                             const Eigen::ArrayXXd &forward_param1,
+                             const Eigen::ArrayXXd &,
+                             std::vector<Eigen::ArrayXXd> &tangent_eval)
+      {
+        broadcast_tangent(tangent_index, param1, param1, forward_result,
+                          forward_param1, forward_param1, tangent_eval,
+                          [](auto &tangent, const auto &fe1, const auto &,
+                             const auto &, const auto &tangent1,
+                             const auto &) {
+          tangent = tangent1 * fe1.cosh();
+        });
+      }
+
+      void cosh_tangent_eval(int tangent_index, int param1, int,
+                             const Eigen::ArrayXXd &forward_result,
+                             const Eigen::ArrayXXd &forward_param1,
+                             const Eigen::ArrayXXd &,
+                             std::vector<Eigen::ArrayXXd> &tangent_eval)
+      {
+        broadcast_tangent(tangent_index, param1, param1, forward_result,
+                          forward_param1, forward_param1, tangent_eval,
+                          [](auto &tangent, const auto &fe1, const auto &,
+                             const auto &, const auto &tangent1,
+                             const auto &) {
+          tangent = tangent1 * fe1.sinh();
+        });
+      }
+
+      // Reverse kernels for operands that do not vary between samples.  The
+      // local derivative is then a single value, computed once instead of
+      // once per sample.
+      double sign(double value)
+      {
+        return (value > 0) - (value < 0);
+      }
+
+      double sin_derivative(double operand, double)
+      {
+        return std::cos(operand);
+      }
+
+      double cos_derivative(double operand, double)
+      {
+        return -std::sin(operand);
+      }
+
+      double exp_derivative(double, double result)
+      {
+        return result;
+      }
+
+      double log_derivative(double operand, double)
+      {
+        return 1.0 / operand;
+      }
+
+      double abs_derivative(double operand, double)
+      {
+        return sign(operand);
+      }
+
+      double sqrt_derivative(double operand, double result)
+      {
+        return 0.5 / result * sign(operand);
+      }
+
+      double sinh_derivative(double operand, double)
+      {
+        return std::cosh(operand);
+      }
+
+      double cosh_derivative(double operand, double)
+      {
+        return std::sinh(operand);
+      }
+
+      template <double (*Derivative)(double, double)>
+      void scalar_unary_reverse_eval(int reverse_index, int param1, int,
+                                     const Eigen::ArrayXXd &forward_result,
+                                     const Eigen::ArrayXXd &forward_param1,
+                                     const Eigen::ArrayXXd &,
+                                     std::vector<Eigen::ArrayXXd> &reverse_eval)
+      {
+        reverse_eval[param1] += reverse_eval[reverse_index] *
+                                Derivative(forward_param1(0, 0),
+                                           forward_result(0, 0));
+      }
+
+      template <bool kSafe>
+      void scalar_pow_reverse_eval(int reverse_index, int param1, int param2,
+                                   const Eigen::ArrayXXd &forward_result,
+                                   const Eigen::ArrayXXd &forward_param1,
+                                   const Eigen::ArrayXXd &forward_param2,
+                                   std::vector<Eigen::ArrayXXd> &reverse_eval)
+      {
+        const Eigen::ArrayXXd &adjoint = reverse_eval[reverse_index];
+        double base = forward_param1(0, 0);
+        double result = forward_result(0, 0);
+        double log_base = kSafe ? std::log(std::abs(base)) : std::log(base);
+        reverse_eval[param1] += adjoint * (result * forward_param2(0, 0) / base);
+        reverse_eval[param2] += adjoint * (result * log_base);
       }
 
     } // namespace
 
-    Eigen::ArrayXXd ForwardEvalFunction(int node, int param1, int param2,
-                                        const Eigen::ArrayXXd &x,
-                                        const Eigen::ArrayXXd &constants,
-                                        std::vector<Eigen::ArrayXXd> &forward_eval)
+    namespace
     {
-      switch (node)
+      // Kernels in the order of the operators, starting from Op::kInteger
+      const ForwardKernel kForwardKernels[] = {
+          integer_forward_eval, loadx_forward_eval, loadc_forward_eval,
+          add_forward_eval, subtract_forward_eval, multiply_forward_eval,
+          divide_forward_eval, sin_forward_eval, cos_forward_eval,
+          exp_forward_eval, log_forward_eval, pow_forward_eval,
+          abs_forward_eval, sqrt_forward_eval, safepow_forward_eval,
+          sinh_forward_eval, cosh_forward_eval};
+
+      const ReverseKernel kReverseKernels[] = {
+          integer_reverse_eval, loadx_reverse_eval, loadc_reverse_eval,
+          add_reverse_eval, subtract_reverse_eval, multiply_reverse_eval,
+          divide_reverse_eval, sin_reverse_eval, cos_reverse_eval,
+          exp_reverse_eval, log_reverse_eval, pow_reverse_eval,
+          abs_reverse_eval, sqrt_reverse_eval, safepow_reverse_eval,
+          sinh_reverse_eval, cosh_reverse_eval};
+
+      const TangentKernel kTangentKernels[] = {
+          terminal_tangent_eval, terminal_tangent_eval, terminal_tangent_eval,
+          add_tangent_eval, subtract_tangent_eval, multiply_tangent_eval,
+          divide_tangent_eval, sin_tangent_eval, cos_tangent_eval,
+          exp_tangent_eval, log_tangent_eval, pow_tangent_eval,
+          abs_tangent_eval, sqrt_tangent_eval, safepow_tangent_eval,
+          sinh_tangent_eval, cosh_tangent_eval};
+
+      const int kNumKernels = sizeof(kForwardKernels) / sizeof(ForwardKernel);
+
+      bool has_kernel(int node)
       {
-      case Op::kInteger:
-        return integer_forward_eval(param1, param2, x, constants, forward_eval);
-      case Op::kVariable:
-        return loadx_forward_eval(param1, param2, x, constants, forward_eval);
-      case Op::kConstant:
-        return loadc_forward_eval(param1, param2, x, constants, forward_eval);
-      case Op::kAddition:
-        return add_forward_eval(param1, param2, x, constants, forward_eval);
-      case Op::kSubtraction:
-        return subtract_forward_eval(param1, param2, x, constants, forward_eval);
-      case Op::kMultiplication:
-        return multiply_forward_eval(param1, param2, x, constants, forward_eval);
-      case Op::kDivision:
-        return divide_forward_eval(param1, param2, x, constants, forward_eval);
-      case Op::kSin:
-        return sin_forward_eval(param1, param2, x, constants, forward_eval);
-      case Op::kCos:
-        return cos_forward_eval(param1, param2, x, constants, forward_eval);
-      case Op::kExponential:
-        return exp_forward_eval(param1, param2, x, constants, forward_eval);
-      case Op::kLogarithm:
-        return log_forward_eval(param1, param2, x, constants, forward_eval);
-      case Op::kPower:
-        return pow_forward_eval(param1, param2, x, constants, forward_eval);
-      case Op::kAbs:
-        return abs_forward_eval(param1, param2, x, constants, forward_eval);
-      case Op::kSqrt:
-        return sqrt_forward_eval(param1, param2, x, constants, forward_eval);
-      case Op::kSafePower:
-        return safepow_forward_eval(param1, param2, x, constants, forward_eval);
-      case Op::kSinh:
-        return sinh_forward_eval(param1, param2, x, constants, forward_eval);
-      case Op::kCosh:
-        return cosh_forward_eval(param1, param2, x, constants, forward_eval);
+        return node >= Op::kInteger && node < Op::kInteger + kNumKernels;
+      }
+    } // namespace
+
+    ForwardKernel GetForwardKernel(int node)
+    {
+      if (!has_kernel(node))
+      {
+        throw std::runtime_error("Unknown Operator In Forward Evaluation");
       }
-      throw std::runtime_error("Unknown Operator In Forward Evaluation");
+      return kForwardKernels[node - Op::kInteger];
     }
 
-    void ReverseEvalFunction(int node, int reverse_index, int param1, int param2,
-                             const std::vector<Eigen::ArrayXXd> &forward_eval,
-                             std::vector<Eigen::ArrayXXd> &reverse_eval)
+    ReverseKernel GetReverseKernel(int node)
+    {
+      if (!has_kernel(node))
+      {
+        throw std::runtime_error("Unknown Operator In Reverse Evaluation");
+      }
+      return kReverseKernels[node - Op::kInteger];
+    }
+
+    TangentKernel GetTangentKernel(int node)
+    {
+      if (!has_kernel(node))
+      {
+        throw std::runtime_error("Unknown Operator In Tangent Evaluation");
+      }
+      return kTangentKernels[node - Op::kInteger];
+    }
+
+    ReverseKernel GetReverseKernel(int node, ValueShape operand_shape)
     {
+      if (operand_shape & kColumnShape)
+      {
+        return GetReverseKernel(node);
+      }
       switch (node)
       {
-      case Op::kInteger:
-        return integer_reverse_eval(reverse_index, param1, param2, forward_eval,
-                                    reverse_eval);
-      case Op::kVariable:
-        return loadx_reverse_eval(reverse_index, param1, param2, forward_eval,
-                                  reverse_eval);
-      case Op::kConstant:
-        return loadc_reverse_eval(reverse_index, param1, param2, forward_eval,
-                                  reverse_eval);
-      case Op::kAddition:
-        return add_reverse_eval(reverse_index, param1, param2, forward_eval,
-                                reverse_eval);
-      case Op::kSubtraction:
-        return subtract_reverse_eval(reverse_index, param1, param2, forward_eval,
-                                     reverse_eval);
-      case Op::kMultiplication:
-        return multiply_reverse_eval(reverse_index, param1, param2, forward_eval,
-                                     reverse_eval);
-      case Op::kDivision:
-        return divide_reverse_eval(reverse_index, param1, param2, forward_eval,
-                                   reverse_eval);
       case Op::kSin:
-        return sin_reverse_eval(reverse_index, param1, param2, forward_eval,
-                                reverse_eval);
+        return scalar_unary_reverse_eval<sin_derivative>;
       case Op::kCos:
-        return cos_reverse_eval(reverse_index, param1, param2, forward_eval,
-                                reverse_eval);
+        return scalar_unary_reverse_eval<cos_derivative>;
       case Op::kExponential:
-        return exp_reverse_eval(reverse_index, param1, param2, forward_eval,
-                                reverse_eval);
+        return scalar_unary_reverse_eval<exp_derivative>;
       case Op::kLogarithm:
-        return log_reverse_eval(reverse_index, param1, param2, forward_eval,
-                                reverse_eval);
-      case Op::kPower:
-        return pow_reverse_eval(reverse_index, param1, param2, forward_eval,
-                                reverse_eval);
+        return scalar_unary_reverse_eval<log_derivative>;
       case Op::kAbs:
-        return abs_reverse_eval(reverse_index, param1, param2, forward_eval,
-                                reverse_eval);
+        return scalar_unary_reverse_eval<abs_derivative>;
       case Op::kSqrt:
-        return sqrt_reverse_eval(reverse_index, param1, param2, forward_eval,
-                                 reverse_eval);
-      case Op::kSafePower:
-        return safepow_reverse_eval(reverse_index, param1, param2, forward_eval,
-                                    reverse_eval);
+        return scalar_unary_reverse_eval<sqrt_derivative>;
       case Op::kSinh:
-        return sinh_reverse_eval(reverse_index, param1, param2, forward_eval,
-                                 reverse_eval);
+        return scalar_unary_reverse_eval<sinh_derivative>;
       case Op::kCosh:
-        return cosh_reverse_eval(reverse_index, param1, param2, forward_eval,
-                                 reverse_eval);
+        return scalar_unary_reverse_eval<cosh_derivative>;
+      case Op::kPower:
+        return scalar_pow_reverse_eval<false>;
+      case Op::kSafePower:
+        return scalar_pow_reverse_eval<true>;
       }
-      throw std::runtime_error("Unknown Operator In Reverse Evaluation");
+      return GetReverseKernel(node);
+    }
+
+    void ForwardEvalFunction(int node, int param1, int param2,
+                             const Eigen::Ref<const Eigen::ArrayXXd> &x,
+                             const Eigen::Ref<const Eigen::ArrayXXd> &constants,
+                             const std::vector<Eigen::ArrayXXd> &forward_eval,
+                             Eigen::ArrayXXd &result)
+    {
+      GetForwardKernel(node)(param1, param2, x, constants, forward_eval, result);
+    }
+
+    void ReverseEvalFunction(int node, int reverse_index, int param1, int param2,
+                             const Eigen::ArrayXXd &forward_result,
+                             const Eigen::ArrayXXd &forward_param1,
+                             const Eigen::ArrayXXd &forward_param2,
+                             std::vector<Eigen::ArrayXXd> &reverse_eval)
+    {
+      GetReverseKernel(node)(reverse_index, param1, param2, forward_result,
+                             forward_param1, forward_param2, reverse_eval);
     }
   } // namespace backend
 } // namespace bingo
\ No newline at end of file
@@ -0,0 +1,684 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include <Eigen/Dense>
+
+#include <bingocpp/agraph/evaluation_backend/simd_math.h>
+
+// The vectorized kernels are written with GCC vector extensions and compiled
+// once per instruction set through target attributes, so a single build runs
+// the widest kernels the processor supports.  Other compilers use Eigen.
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__)
+#define BINGO_SIMD_DISPATCH
+#endif
+
+namespace bingo
+{
+  namespace evaluation_backend
+  {
+    namespace
+    {
+      double log_abs(double x)
+      {
+        return std::log(std::abs(x));
+      }
+
+      // Standard library version of each function, used for the values the
+      // vectorized kernels do not cover
+      double scalar_function(SimdFunction function, double x)
+      {
+        switch (function)
+        {
+        case kSinFunction:
+          return std::sin(x);
+        case kCosFunction:
+          return std::cos(x);
+        case kExpFunction:
+          return std::exp(x);
+        case kLogAbsFunction:
+          return log_abs(x);
+        case kSinhFunction:
+          return std::sinh(x);
+        case kCoshFunction:
+          return std::cosh(x);
+        }
+        return std::numeric_limits<double>::quiet_NaN();
+      }
+
+      void apply_generic(SimdFunction function, const double *x,
+                         double *result, std::size_t n)
+      {
+        Eigen::Map<const Eigen::ArrayXd> in(x, n);
+        Eigen::Map<Eigen::ArrayXd> out(result, n);
+        switch (function)
+        {
+        case kSinFunction:
+          out = in.sin();
+          break;
+        case kCosFunction:
+          out = in.cos();
+          break;
+        case kExpFunction:
+          out = in.exp();
+          break;
+        case kLogAbsFunction:
+          out = in.abs().log();
+          break;
+        case kSinhFunction:
+          out = in.sinh();
+          break;
+        case kCoshFunction:
+          out = in.cosh();
+          break;
+        }
+      }
+
+      void accumulate_generic(SimdFunction function, const double *x,
+                              const double *adjoint, double scale,
+                              double *accumulator, std::size_t n)
+      {
+        // blocks keep the temporary on the stack
+        const std::size_t kBlock = 256;
+        double values[kBlock];
+        for (std::size_t i = 0; i < n; i += kBlock)
+        {
+          std::size_t block = std::min(kBlock, n - i);
+          apply_generic(function, x + i, values, block);
+          for (std::size_t j = 0; j < block; ++j)
+          {
+            accumulator[i + j] += scale * adjoint[i + j] * values[j];
+          }
+        }
+      }
+
+#ifdef BINGO_SIMD_DISPATCH
+// The vector helpers are always inlined into the per-instruction-set entry
+// points and never called across the ABI, so the warning about passing wide
+// vectors without the matching instruction set does not apply.  GCC reports
+// it at the end of the file, so it stays disabled from here on.
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+#define BINGO_SIMD_INLINE inline __attribute__((always_inline))
+
+      typedef double Double2 __attribute__((vector_size(16)));
+      typedef double Double4 __attribute__((vector_size(32)));
+      typedef double Double8 __attribute__((vector_size(64)));
+      typedef unsigned long long Bits2 __attribute__((vector_size(16)));
+      typedef unsigned long long Bits4 __attribute__((vector_size(32)));
+      typedef unsigned long long Bits8 __attribute__((vector_size(64)));
+
+      template <typename D>
+      struct BitsOf;
+      template <>
+      struct BitsOf<Double2>
+      {
+        typedef Bits2 type;
+      };
+      template <>
+      struct BitsOf<Double4>
+      {
+        typedef Bits4 type;
+      };
+      template <>
+      struct BitsOf<Double8>
+      {
+        typedef Bits8 type;
+      };
+
+      const double kTwo52 = 4503599627370496.0;
+      const double kRoundMagic = 6755399441055744.0; // 1.5 * 2^52
+      const unsigned long long kSignBit = 0x8000000000000000ULL;
+      const unsigned long long kMantissaBits = 0x000FFFFFFFFFFFFFULL;
+      const unsigned long long kHalfExponent = 0x3FE0000000000000ULL;
+
+      // Largest arguments handled by the vectorized kernels
+      const double kMaxExpArgument = 708.0;
+      const double kMaxTrigArgument = 1.0e8;
+
+      template <typename D>
+      BINGO_SIMD_INLINE D splat(double value)
+      {
+        return D{} + value;
+      }
+
+      template <typename D>
+      BINGO_SIMD_INLINE D load(const double *values)
+      {
+        D vector;
+        std::memcpy(&vector, values, sizeof(D));
+        return vector;
+      }
+
+      template <typename D>
+      BINGO_SIMD_INLINE void store(double *values, const D &vector)
+      {
+        std::memcpy(values, &vector, sizeof(D));
+      }
+
+      template <typename D>
+      BINGO_SIMD_INLINE D abs(const D &x)
+      {
+        typedef typename BitsOf<D>::type B;
+        return (D)((B)x & ~kSignBit);
+      }
+
+      // Round to nearest, valid for |x| < 2^51
+      template <typename D>
+      BINGO_SIMD_INLINE D round_nearest(const D &x)
+      {
+        return (x + kRoundMagic) - kRoundMagic;
+      }
+
+      // Integer value of a non-negative whole number below 2^52
+      template <typename D>
+      BINGO_SIMD_INLINE typename BitsOf<D>::type to_bits_integer(const D &x)
+      {
+        typedef typename BitsOf<D>::type B;
+        return (B)(x + kTwo52) - (B)splat<D>(kTwo52);
+      }
+
+      // e^x for |x| <= kMaxExpArgument, after Cephes: x = n ln2 + r, with
+      // e^r from a Pade approximation
+      template <typename D>
+      BINGO_SIMD_INLINE D exp_kernel(const D &x)
+      {
+        typedef typename BitsOf<D>::type B;
+        D n = round_nearest(x * 1.4426950408889634073599);
+        D r = x - n * 6.93145751953125E-1;
+        r = r - n * 1.42860682030941723212E-6;
+        D rr = r * r;
+        D p = r * ((1.26177193074810590878E-4 * rr +
+                    3.02994407707441961300E-2) * rr +
+                   9.99999999999999999910E-1);
+        D q = ((3.00198505138664455042E-6 * rr +
+                2.52448340349684104192E-3) * rr +
+               2.27265548208155028766E-1) * rr +
+              2.00000000000000000009E0;
+        D exp_r = 1.0 + 2.0 * (p / (q - p));
+        B two_to_n = to_bits_integer(n + 1023.0) << 52;
+        return exp_r * (D)two_to_n;
+      }
+
+      // log(a) for normal positive a, after Cephes: a = m 2^e, with
+      // log(m) from a rational approximation of log(1 + z)
+      template <typename D>
+      BINGO_SIMD_INLINE D log_kernel(const D &a)
+      {
+        typedef typename BitsOf<D>::type B;
+        B bits = (B)a;
+        D e = (D)((bits >> 52) | (B)splat<D>(kTwo52)) - (kTwo52 + 1022.0);
+        D m = (D)((bits & kMantissaBits) | kHalfExponent);
+        auto small = m < 0.70710678118654752440;
+        e = small ? e - 1.0 : e;
+        D z = small ? m + m - 1.0 : m - 1.0;
+        D zz = z * z;
+        D p = ((((1.01875663804580931796E-4 * z +
+                  4.97494994976747001425E-1) * z +
+                 4.70579119878881725854E0) * z +
+                1.44989225341610930846E1) * z +
+               1.79368678507819816313E1) * z +
+              7.70838733755885391666E0;
+        D q = ((((z + 1.12873587189167450590E1) * z +
+                 4.52279145837532221105E1) * z +
+                8.29875266912776603211E1) * z +
+               7.11544750618563894466E1) * z +
+              2.31251620126765340583E1;
+        D y = z * (zz * p / q);
+        y = y - e * 2.121944400546905827679e-4;
+        y = y - 0.5 * zz;
+        return (z + y) + e * 0.693359375;
+      }
+
+      // sin(x) or cos(x) for |x| <= kMaxTrigArgument, after Cephes: the
+      // argument is reduced to an octant and both polynomials are evaluated
+      template <typename D, bool kCosine>
+      BINGO_SIMD_INLINE D sin_cos_kernel(const D &x)
+      {
+        typedef typename BitsOf<D>::type B;
+        D a = abs(x);
+        D y = round_nearest(a * 1.27323954473516268615);
+        y = y > a * 1.27323954473516268615 ? y - 1.0 : y;
+        B octant = to_bits_integer(y);
+        // map zeros to the origin
+        auto odd = (octant & 1) != 0;
+        y = odd ? y + 1.0 : y;
+        octant = (octant + (octant & 1)) & 7;
+
+        D z = ((a - y * 7.85398125648498535156E-1) -
+               y * 3.77489470793079817668E-8) -
+              y * 2.69515142907905952645E-15;
+        D zz = z * z;
+        D sin_poly = z + z * zz * (((((1.58962301576546568060E-10 * zz -
+                                       2.50507477628578072866E-8) * zz +
+                                      2.75573136213857245213E-6) * zz -
+                                     1.98412698295895385996E-4) * zz +
+                                    8.33333333332211858878E-3) * zz -
+                                   1.66666666666666307295E-1);
+        D cos_poly = 1.0 - 0.5 * zz +
+                     zz * zz * (((((-1.13585365213876817300E-11 * zz +
+                                    2.08757008419747316778E-9) * zz -
+                                   2.75573141792967388112E-7) * zz +
+                                  2.48015872888517045348E-5) * zz -
+                                 1.38888888888730564116E-3) * zz +
+                                4.16666666666665929218E-2);
+        B sign;
+        D result;
+        if (kCosine)
+        {
+          result = (octant & 2) == 0 ? cos_poly : sin_poly;
+          sign = ((octant + 2) & 4) << 61;
+        }
+        else
+        {
+          result = (octant & 2) == 0 ? sin_poly : cos_poly;
+          sign = ((octant & 4) << 61) ^ ((B)x & kSignBit);
+        }
+        return (D)((B)result ^ sign);
+      }
+
+      // sinh(x) or cosh(x) for |x| <= kMaxExpArgument.  sinh of small
+      // arguments uses its Taylor series to avoid cancellation.
+      template <typename D, bool kCosh>
+      BINGO_SIMD_INLINE D sinh_cosh_kernel(const D &x)
+      {
+        typedef typename BitsOf<D>::type B;
+        D a = abs(x);
+        D half_exp = 0.5 * exp_kernel(a);
+        D half_inverse = 0.25 / half_exp;
+        if (kCosh)
+        {
+          return half_exp + half_inverse;
+        }
+        D aa = a * a;
+        D series = a + a * aa * (((((((1.0 / 355687428096000.0 * aa +
+                                       1.0 / 1307674368000.0) * aa +
+                                      1.0 / 6227020800.0) * aa +
+                                     1.0 / 39916800.0) * aa +
+                                    1.0 / 362880.0) * aa +
+                                   1.0 / 5040.0) * aa +
+                                  1.0 / 120.0) * aa +
+                                 1.0 / 6.0);
+        D result = a < 1.0 ? series : half_exp - half_inverse;
+        return (D)((B)result | ((B)x & kSignBit));
+      }
+
+      // Each operation pairs a vectorized kernel with the mask of lanes it
+      // does not cover.  NaN fails every comparison, so it is never covered.
+      struct SinOperation
+      {
+        template <typename D>
+        static BINGO_SIMD_INLINE D kernel(const D &x)
+        {
+          return sin_cos_kernel<D, false>(x);
+        }
+        template <typename D>
+        static BINGO_SIMD_INLINE auto uncovered(const D &x)
+        {
+          return ~(abs(x) <= kMaxTrigArgument);
+        }
+      };
+
+      struct CosOperation
+      {
+        template <typename D>
+        static BINGO_SIMD_INLINE D kernel(const D &x)
+        {
+          return sin_cos_kernel<D, true>(x);
+        }
+        template <typename D>
+        static BINGO_SIMD_INLINE auto uncovered(const D &x)
+        {
+          return ~(abs(x) <= kMaxTrigArgument);
+        }
+      };
+
+      struct ExpOperation
+      {
+        template <typename D>
+        static BINGO_SIMD_INLINE D kernel(const D &x)
+        {
+          return exp_kernel(x);
+        }
+        template <typename D>
+        static BINGO_SIMD_INLINE auto uncovered(const D &x)
+        {
+          return ~(abs(x) <= kMaxExpArgument);
+        }
+      };
+
+      struct LogAbsOperation
+      {
+        template <typename D>
+        static BINGO_SIMD_INLINE D kernel(const D &x)
+        {
+          return log_kernel(abs(x));
+        }
+        template <typename D>
+        static BINGO_SIMD_INLINE auto uncovered(const D &x)
+        {
+          D a = abs(x);
+          return ~((a >= std::numeric_limits<double>::min()) &
+                   (a <= std::numeric_limits<double>::max()));
+        }
+      };
+
+      struct SinhOperation
+      {
+        template <typename D>
+        static BINGO_SIMD_INLINE D kernel(const D &x)
+        {
+          return sinh_cosh_kernel<D, false>(x);
+        }
+        template <typename D>
+        static BINGO_SIMD_INLINE auto uncovered(const D &x)
+        {
+          return ~(abs(x) <= kMaxExpArgument);
+        }
+      };
+
+      struct CoshOperation
+      {
+        template <typename D>
+        static BINGO_SIMD_INLINE D kernel(const D &x)
+        {
+          return sinh_cosh_kernel<D, true>(x);
+        }
+        template <typename D>
+        static BINGO_SIMD_INLINE auto uncovered(const D &x)
+        {
+          return ~(abs(x) <= kMaxExpArgument);
+        }
+      };
+
+      template <typename D, typename Operation>
+      BINGO_SIMD_INLINE D evaluate_vector(SimdFunction function, const D &x)
+      {
+        const int kWidth = sizeof(D) / sizeof(double);
+        D result = Operation::kernel(x);
+        auto uncovered = Operation::uncovered(x);
+        for (int lane = 0; lane < kWidth; ++lane)
+        {
+          if (uncovered[lane])
+          {
+            result[lane] = scalar_function(function, x[lane]);
+          }
+        }
+        return result;
+      }
+
+      // Evaluates the n values a vector at a time.  The last, partial
+      // vector is padded with ones in a stack buffer.
+      template <typename D, typename Operation>
+      BINGO_SIMD_INLINE void apply_vectors(SimdFunction function,
+                                           const double *x, double *result,
+                                           std::size_t n)
+      {
+        const std::size_t kWidth = sizeof(D) / sizeof(double);
+        std::size_t i = 0;
+        for (; i + kWidth <= n; i += kWidth)
+        {
+          store(result + i,
+                evaluate_vector<D, Operation>(function, load<D>(x + i)));
+        }
+        if (i < n)
+        {
+          double padded[kWidth];
+          for (std::size_t lane = 0; lane < kWidth; ++lane)
+          {
+            padded[lane] = i + lane < n ? x[i + lane] : 1.0;
+          }
+          store(padded,
+                evaluate_vector<D, Operation>(function, load<D>(padded)));
+          std::memcpy(result + i, padded, (n - i) * sizeof(double));
+        }
+      }
+
+      template <typename D, typename Operation>
+      BINGO_SIMD_INLINE void accumulate_vectors(SimdFunction function,
+                                                const double *x,
+                                                const double *adjoint,
+                                                double scale,
+                                                double *accumulator,
+                                                std::size_t n)
+      {
+        const std::size_t kWidth = sizeof(D) / sizeof(double);
+        std::size_t i = 0;
+        for (; i + kWidth <= n; i += kWidth)
+        {
+          D values = evaluate_vector<D, Operation>(function, load<D>(x + i));
+          store(accumulator + i, load<D>(accumulator + i) +
+                                     scale * load<D>(adjoint + i) * values);
+        }
+        if (i < n)
+        {
+          double padded[kWidth];
+          for (std::size_t lane = 0; lane < kWidth; ++lane)
+          {
+            padded[lane] = i + lane < n ? x[i + lane] : 1.0;
+          }
+          store(padded,
+                evaluate_vector<D, Operation>(function, load<D>(padded)));
+          for (std::size_t lane = 0; i + lane < n; ++lane)
+          {
+            accumulator[i + lane] += scale * adjoint[i + lane] * padded[lane];
+          }
+        }
+      }
+
+      template <typename D>
+      BINGO_SIMD_INLINE void apply_function(SimdFunction function,
+                                            const double *x, double *result,
+                                            std::size_t n)
+      {
+        switch (function)
+        {
+        case kSinFunction:
+          apply_vectors<D, SinOperation>(function, x, result, n);
+          break;
+        case kCosFunction:
+          apply_vectors<D, CosOperation>(function, x, result, n);
+          break;
+        case kExpFunction:
+          apply_vectors<D, ExpOperation>(function, x, result, n);
+          break;
+        case kLogAbsFunction:
+          apply_vectors<D, LogAbsOperation>(function, x, result, n);
+          break;
+        case kSinhFunction:
+          apply_vectors<D, SinhOperation>(function, x, result, n);
+          break;
+        case kCoshFunction:
+          apply_vectors<D, CoshOperation>(function, x, result, n);
+          break;
+        }
+      }
+
+      template <typename D>
+      BINGO_SIMD_INLINE void accumulate_function(SimdFunction function,
+                                                 const double *x,
+                                                 const double *adjoint,
+                                                 double scale,
+                                                 double *accumulator,
+                                                 std::size_t n)
+      {
+        switch (function)
+        {
+        case kSinFunction:
+          accumulate_vectors<D, SinOperation>(function, x, adjoint, scale,
+                                              accumulator, n);
+          break;
+        case kCosFunction:
+          accumulate_vectors<D, CosOperation>(function, x, adjoint, scale,
+                                              accumulator, n);
+          break;
+        case kExpFunction:
+          accumulate_vectors<D, ExpOperation>(function, x, adjoint, scale,
+                                              accumulator, n);
+          break;
+        case kLogAbsFunction:
+          accumulate_vectors<D, LogAbsOperation>(function, x, adjoint, scale,
+                                                 accumulator, n);
+          break;
+        case kSinhFunction:
+          accumulate_vectors<D, SinhOperation>(function, x, adjoint, scale,
+                                               accumulator, n);
+          break;
+        case kCoshFunction:
+          accumulate_vectors<D, CoshOperation>(function, x, adjoint, scale,
+                                               accumulator, n);
+          break;
+        }
+      }
+
+      // Entry points of each instruction set.  SSE2 is part of x86-64, so
+      // its kernels need no target attribute.
+      void apply_sse2(SimdFunction function, const double *x, double *result,
+                      std::size_t n)
+      {
+        apply_function<Double2>(function, x, result, n);
+      }
+
+      void accumulate_sse2(SimdFunction function, const double *x,
+                           const double *adjoint, double scale,
+                           double *accumulator, std::size_t n)
+      {
+        accumulate_function<Double2>(function, x, adjoint, scale, accumulator,
+                                     n);
+      }
+
+      __attribute__((target("avx2,fma")))
+      void apply_avx2(SimdFunction function, const double *x, double *result,
+                      std::size_t n)
+      {
+        apply_function<Double4>(function, x, result, n);
+      }
+
+      __attribute__((target("avx2,fma")))
+      void accumulate_avx2(SimdFunction function, const double *x,
+                           const double *adjoint, double scale,
+                           double *accumulator, std::size_t n)
+      {
+        accumulate_function<Double4>(function, x, adjoint, scale, accumulator,
+                                     n);
+      }
+
+      __attribute__((target("avx512f")))
+      void apply_avx512(SimdFunction function, const double *x,
+                        double *result, std::size_t n)
+      {
+        apply_function<Double8>(function, x, result, n);
+      }
+
+      __attribute__((target("avx512f")))
+      void accumulate_avx512(SimdFunction function, const double *x,
+                             const double *adjoint, double scale,
+                             double *accumulator, std::size_t n)
+      {
+        accumulate_function<Double8>(function, x, adjoint, scale, accumulator,
+                                     n);
+      }
+
+#endif // BINGO_SIMD_DISPATCH
+
+      struct SimdKernels
+      {
+        void (*apply)(SimdFunction, const double *, double *, std::size_t);
+        void (*accumulate)(SimdFunction, const double *, const double *,
+                           double, double *, std::size_t);
+      };
+
+      SimdKernels kernels_for(InstructionSet instruction_set)
+      {
+        switch (instruction_set)
+        {
+#ifdef BINGO_SIMD_DISPATCH
+        case kSse2Instructions:
+          return {apply_sse2, accumulate_sse2};
+        case kAvx2Instructions:
+          return {apply_avx2, accumulate_avx2};
+        case kAvx512Instructions:
+          return {apply_avx512, accumulate_avx512};
+#endif
+        default:
+          return {apply_generic, accumulate_generic};
+        }
+      }
+
+      bool instruction_set_supported(InstructionSet instruction_set)
+      {
+#ifdef BINGO_SIMD_DISPATCH
+        // may run before the constructors that initialize the cpu model
+        __builtin_cpu_init();
+        switch (instruction_set)
+        {
+        case kGenericInstructions:
+        case kSse2Instructions:
+          return true;
+        case kAvx2Instructions:
+          return __builtin_cpu_supports("avx2") &&
+                 __builtin_cpu_supports("fma");
+        case kAvx512Instructions:
+          return __builtin_cpu_supports("avx512f");
+        }
+        return false;
+#else
+        return instruction_set == kGenericInstructions;
+#endif
+      }
+
+      InstructionSet widest_instruction_set()
+      {
+        for (InstructionSet instruction_set :
+             {kAvx512Instructions, kAvx2Instructions, kSse2Instructions})
+        {
+          if (instruction_set_supported(instruction_set))
+          {
+            return instruction_set;
+          }
+        }
+        return kGenericInstructions;
+      }
+
+      // Selected when the library is loaded
+      InstructionSet active_instruction_set = widest_instruction_set();
+      SimdKernels active_kernels = kernels_for(active_instruction_set);
+    } // namespace
+
+    void ApplySimdFunction(SimdFunction function, const double *x,
+                           double *result, std::size_t n)
+    {
+      active_kernels.apply(function, x, result, n);
+    }
+
+    void AccumulateSimdProduct(SimdFunction function, const double *x,
+                               const double *adjoint, double scale,
+                               double *accumulator, std::size_t n)
+    {
+      active_kernels.accumulate(function, x, adjoint, scale, accumulator, n);
+    }
+
+    InstructionSet GetInstructionSet()
+    {
+      return active_instruction_set;
+    }
+
+    bool IsInstructionSetSupported(InstructionSet instruction_set)
+    {
+      return instruction_set_supported(instruction_set);
+    }
+
+    void SetInstructionSet(InstructionSet instruction_set)
+    {
+      if (!instruction_set_supported(instruction_set))
+      {
+        throw std::invalid_argument(
+            "Instruction set not supported by this processor");
+      }
+      active_instruction_set = instruction_set;
+      active_kernels = kernels_for(instruction_set);
+    }
+  }   // namespace evaluation_backend
+} // namespace bingo
@@ -0,0 +1,500 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <unordered_map>
+
+#include <bingocpp/agraph/simplification_backend/automatic_simplification.h>
+#include <bingocpp/agraph/simplification_backend/constant_expressions.h>
+
+namespace bingo {
+namespace simplification_backend {
+
+namespace {
+
+int get_operand(const ExpressionPtr &expression) {
+  return std::static_pointer_cast<const TermExpression>(expression)
+      ->GetOperand();
+}
+
+const ExpressionList &get_operands(const ExpressionPtr &expression) {
+  return std::static_pointer_cast<const OpExpression>(expression)
+      ->GetOperands();
+}
+
+bool is_integer(const ExpressionPtr &expression) {
+  return expression->GetOperator() == kInteger;
+}
+
+bool is_number(const ExpressionPtr &expression) {
+  return expression->GetOperator() == kInteger ||
+         expression->GetOperator() == kConstant;
+}
+
+bool is_function(const ExpressionPtr &expression) {
+  Op operatr = expression->GetOperator();
+  return !kIsTerminalMap.at(operatr) && operatr != kAddition &&
+         operatr != kMultiplication && operatr != kPower;
+}
+
+ExpressionList rest(const ExpressionList &list) {
+  return ExpressionList(list.begin() + 1, list.end());
+}
+
+ExpressionList adjoin(const ExpressionPtr &first, const ExpressionList &list) {
+  ExpressionList result(1, first);
+  result.insert(result.end(), list.begin(), list.end());
+  return result;
+}
+
+// Operand lists are compared as ranges, so that single expressions can be
+// compared with sums and products without allocating
+struct OperandRange {
+  const ExpressionPtr *begin;
+  std::size_t size;
+};
+
+OperandRange operand_range(const ExpressionPtr &expression) {
+  const ExpressionList &operands = get_operands(expression);
+  return {operands.data(), operands.size()};
+}
+
+OperandRange single_operand_range(const ExpressionPtr &expression) {
+  return {&expression, 1};
+}
+
+bool operands_less(OperandRange u, OperandRange v, bool from_last) {
+  std::size_t num_compared = std::min(u.size, v.size);
+  for (std::size_t i = 0; i < num_compared; ++i) {
+    const ExpressionPtr &u_i = from_last ? u.begin[u.size - 1 - i] : u.begin[i];
+    const ExpressionPtr &v_i = from_last ? v.begin[v.size - 1 - i] : v.begin[i];
+    if (*u_i != *v_i) {
+      return ExpressionLess(u_i, v_i);
+    }
+  }
+  return u.size < v.size;
+}
+
+// The factors of a term other than its coefficient (see GetTerm)
+OperandRange term_factors(const ExpressionPtr &expression) {
+  if (expression->GetOperator() == kMultiplication) {
+    OperandRange factors = operand_range(expression);
+    if (is_number(factors.begin[0])) {
+      return {factors.begin + 1, factors.size - 1};
+    }
+    return factors;
+  }
+  return single_operand_range(expression);
+}
+
+bool same_term(const ExpressionPtr &u, const ExpressionPtr &v) {
+  OperandRange u_factors = term_factors(u);
+  OperandRange v_factors = term_factors(v);
+  return u_factors.size == v_factors.size &&
+         std::equal(u_factors.begin, u_factors.begin + u_factors.size,
+                    v_factors.begin,
+                    [](const ExpressionPtr &a, const ExpressionPtr &b) {
+                      return *a == *b;
+                    });
+}
+
+// Integer arithmetic is only folded when the result fits in a command
+bool integer_power(int base, int exponent, int *result) {
+  if (base == 1 || base == -1) {
+    *result = (base == -1 && exponent % 2 != 0) ? -1 : 1;
+    return true;
+  }
+  if (exponent < 0) {
+    return false;
+  }
+  int power = 1;
+  for (int i = 0; i < exponent; ++i) {
+    if (__builtin_mul_overflow(power, base, &power)) {
+      return false;
+    }
+  }
+  *result = power;
+  return true;
+}
+
+class AutomaticSimplifier {
+ public:
+  explicit AutomaticSimplifier(ExpressionArena &arena)
+      : arena_(arena), one_(arena.MakeInteger(1)) {}
+
+  ExpressionPtr Simplify(const ExpressionPtr &expression) {
+    if (kIsTerminalMap.at(expression->GetOperator())) {
+      return expression;
+    }
+    auto found = simplified_.find(expression.get());
+    if (found != simplified_.end()) {
+      return found->second;
+    }
+
+    ExpressionList operands;
+    for (const ExpressionPtr &operand : get_operands(expression)) {
+      operands.push_back(Simplify(operand));
+    }
+    ExpressionPtr simplified;
+    switch (expression->GetOperator()) {
+      case kAddition:
+        simplified = simplify_sum(operands);
+        break;
+      case kMultiplication:
+        simplified = simplify_product(operands);
+        break;
+      case kPower:
+        simplified = simplify_power(operands[0], operands[1]);
+        break;
+      default:
+        simplified = simplify_function(expression->GetOperator(), operands);
+    }
+    simplified_[expression.get()] = simplified;
+    return simplified;
+  }
+
+ private:
+  ExpressionArena &arena_;
+  ExpressionPtr one_;
+  std::unordered_map<const Expression *, ExpressionPtr> simplified_;
+
+  ExpressionPtr coefficient_of(const ExpressionPtr &expression) {
+    if (expression->GetOperator() == kMultiplication &&
+        is_number(get_operands(expression)[0])) {
+      return get_operands(expression)[0];
+    }
+    return one_;
+  }
+
+  ExpressionPtr exponent_of(const ExpressionPtr &expression) {
+    if (expression->GetOperator() == kPower) {
+      return get_operands(expression)[1];
+    }
+    return one_;
+  }
+
+  ExpressionPtr simplify_power(const ExpressionPtr &base,
+                               const ExpressionPtr &exponent) {
+    if (base->IsZero()) {
+      if (is_integer(exponent) && get_operand(exponent) > 0) {
+        return base;
+      }
+      return arena_.MakeOp(kPower, {base, exponent});
+    }
+    if (base->IsOne()) {
+      return base;
+    }
+    if (is_integer(exponent)) {
+      return simplify_integer_power(base, get_operand(exponent));
+    }
+    return arena_.MakeOp(kPower, {base, exponent});
+  }
+
+  ExpressionPtr simplify_integer_power(const ExpressionPtr &base,
+                                       int exponent) {
+    if (is_integer(base)) {
+      int power;
+      if (integer_power(get_operand(base), exponent, &power)) {
+        return arena_.MakeInteger(power);
+      }
+      return arena_.MakeOp(kPower, {base, arena_.MakeInteger(exponent)});
+    }
+    if (exponent == 0) {
+      return one_;
+    }
+    if (exponent == 1) {
+      return base;
+    }
+    if (base->GetOperator() == kPower) {
+      const ExpressionList &base_operands = get_operands(base);
+      ExpressionPtr new_exponent =
+          simplify_product({base_operands[1], arena_.MakeInteger(exponent)});
+      if (is_integer(new_exponent)) {
+        return simplify_integer_power(base_operands[0],
+                                      get_operand(new_exponent));
+      }
+      return arena_.MakeOp(kPower, {base_operands[0], new_exponent});
+    }
+    if (base->GetOperator() == kMultiplication) {
+      ExpressionList factors;
+      for (const ExpressionPtr &factor : get_operands(base)) {
+        factors.push_back(simplify_integer_power(factor, exponent));
+      }
+      return simplify_product(factors);
+    }
+    return arena_.MakeOp(kPower, {base, arena_.MakeInteger(exponent)});
+  }
+
+  ExpressionPtr simplify_product(const ExpressionList &factors) {
+    for (const ExpressionPtr &factor : factors) {
+      if (factor->IsZero()) {
+        return factor;
+      }
+    }
+    if (factors.size() == 1) {
+      return factors[0];
+    }
+    ExpressionList simplified = simplify_product_rec(factors);
+    if (simplified.empty()) {
+      return one_;
+    }
+    if (simplified.size() == 1) {
+      return simplified[0];
+    }
+    return arena_.MakeOp(kMultiplication, simplified);
+  }
+
+  ExpressionList simplify_product_rec(const ExpressionList &factors) {
+    const ExpressionPtr &u_1 = factors[0];
+    if (factors.size() > 2) {
+      ExpressionList w = simplify_product_rec(rest(factors));
+      if (u_1->GetOperator() == kMultiplication) {
+        return merge_products(get_operands(u_1), w);
+      }
+      return merge_products({u_1}, w);
+    }
+
+    const ExpressionPtr &u_2 = factors[1];
+    bool u_1_is_product = u_1->GetOperator() == kMultiplication;
+    bool u_2_is_product = u_2->GetOperator() == kMultiplication;
+    if (u_1_is_product || u_2_is_product) {
+      return merge_products(u_1_is_product ? get_operands(u_1) : ExpressionList{u_1},
+                            u_2_is_product ? get_operands(u_2) : ExpressionList{u_2});
+    }
+    int product;
+    if (is_integer(u_1) && is_integer(u_2) &&
+        !__builtin_mul_overflow(get_operand(u_1), get_operand(u_2), &product)) {
+      if (product == 1) {
+        return {};
+      }
+      return {arena_.MakeInteger(product)};
+    }
+    if (u_1->IsOne()) {
+      return {u_2};
+    }
+    if (u_2->IsOne()) {
+      return {u_1};
+    }
+    if (*u_1->GetBase() == *u_2->GetBase()) {
+      ExpressionPtr power = simplify_power(
+          u_1->GetBase(), simplify_sum({exponent_of(u_1), exponent_of(u_2)}));
+      if (power->IsOne()) {
+        return {};
+      }
+      return {power};
+    }
+    if (ExpressionLess(u_2, u_1)) {
+      return {u_2, u_1};
+    }
+    return {u_1, u_2};
+  }
+
+  ExpressionList merge_products(const ExpressionList &p,
+                                const ExpressionList &q) {
+    if (q.empty()) {
+      return p;
+    }
+    if (p.empty()) {
+      return q;
+    }
+    ExpressionList h = simplify_product_rec({p[0], q[0]});
+    if (h.empty()) {
+      return merge_products(rest(p), rest(q));
+    }
+    if (h.size() == 2 && h[0] == p[0] && h[1] == q[0]) {
+      return adjoin(p[0], merge_products(rest(p), q));
+    }
+    if (h.size() == 2 && h[0] == q[0] && h[1] == p[0]) {
+      return adjoin(q[0], merge_products(p, rest(q)));
+    }
+    return adjoin(h[0], merge_products(rest(p), rest(q)));
+  }
+
+  ExpressionPtr simplify_sum(const ExpressionList &terms) {
+    if (terms.size() == 1) {
+      return terms[0];
+    }
+    ExpressionList simplified = simplify_sum_rec(terms);
+    if (simplified.empty()) {
+      return arena_.MakeInteger(0);
+    }
+    if (simplified.size() == 1) {
+      return simplified[0];
+    }
+    return arena_.MakeOp(kAddition, simplified);
+  }
+
+  ExpressionList simplify_sum_rec(const ExpressionList &terms) {
+    const ExpressionPtr &u_1 = terms[0];
+    if (terms.size() > 2) {
+      ExpressionList w = simplify_sum_rec(rest(terms));
+      if (u_1->GetOperator() == kAddition) {
+        return merge_sums(get_operands(u_1), w);
+      }
+      return merge_sums({u_1}, w);
+    }
+
+    const ExpressionPtr &u_2 = terms[1];
+    bool u_1_is_sum = u_1->GetOperator() == kAddition;
+    bool u_2_is_sum = u_2->GetOperator() == kAddition;
+    if (u_1_is_sum || u_2_is_sum) {
+      return merge_sums(u_1_is_sum ? get_operands(u_1) : ExpressionList{u_1},
+                        u_2_is_sum ? get_operands(u_2) : ExpressionList{u_2});
+    }
+    int sum;
+    if (is_integer(u_1) && is_integer(u_2) &&
+        !__builtin_add_overflow(get_operand(u_1), get_operand(u_2), &sum)) {
+      if (sum == 0) {
+        return {};
+      }
+      return {arena_.MakeInteger(sum)};
+    }
+    if (u_1->IsZero()) {
+      return {u_2};
+    }
+    if (u_2->IsZero()) {
+      return {u_1};
+    }
+    if (!is_integer(u_1) && !is_integer(u_2) && same_term(u_1, u_2)) {
+      OperandRange term = term_factors(u_1);
+      ExpressionList factors(1, simplify_sum({coefficient_of(u_1),
+                                              coefficient_of(u_2)}));
+      factors.insert(factors.end(), term.begin, term.begin + term.size);
+      ExpressionPtr product = simplify_product(factors);
+      if (product->IsZero()) {
+        return {};
+      }
+      return {product};
+    }
+    if (ExpressionLess(u_2, u_1)) {
+      return {u_2, u_1};
+    }
+    return {u_1, u_2};
+  }
+
+  ExpressionList merge_sums(const ExpressionList &p, const ExpressionList &q) {
+    if (q.empty()) {
+      return p;
+    }
+    if (p.empty()) {
+      return q;
+    }
+    ExpressionList h = simplify_sum_rec({p[0], q[0]});
+    if (h.empty()) {
+      return merge_sums(rest(p), rest(q));
+    }
+    if (h.size() == 2 && h[0] == p[0] && h[1] == q[0]) {
+      return adjoin(p[0], merge_sums(rest(p), q));
+    }
+    if (h.size() == 2 && h[0] == q[0] && h[1] == p[0]) {
+      return adjoin(q[0], merge_sums(p, rest(q)));
+    }
+    return adjoin(h[0], merge_sums(rest(p), rest(q)));
+  }
+
+  ExpressionPtr simplify_function(Op operatr, const ExpressionList &operands) {
+    if (is_integer(operands[0])) {
+      int argument = get_operand(operands[0]);
+      switch (operatr) {
+        case kSin:
+        case kSinh:
+          if (argument == 0) {
+            return operands[0];
+          }
+          break;
+        case kCos:
+        case kCosh:
+        case kExponential:
+          if (argument == 0) {
+            return one_;
+          }
+          break;
+        case kLogarithm:
+          if (argument == 1 || argument == -1) {
+            return arena_.MakeInteger(0);
+          }
+          break;
+        case kAbs:
+          if (argument != std::numeric_limits<int>::min()) {
+            return arena_.MakeInteger(std::abs(argument));
+          }
+          break;
+        case kSqrt: {
+          int root = static_cast<int>(std::lround(
+              std::sqrt(std::fabs(static_cast<double>(argument)))));
+          if (static_cast<long long>(root) * root ==
+              std::llabs(static_cast<long long>(argument))) {
+            return arena_.MakeInteger(root);
+          }
+          break;
+        }
+        default:
+          break;
+      }
+    }
+    return arena_.MakeOp(operatr, operands);
+  }
+};
+} // namespace
+
+ExpressionPtr AutomaticSimplify(const ExpressionPtr &expression,
+                                ExpressionArena &arena) {
+  return AutomaticSimplifier(arena).Simplify(expression);
+}
+
+bool ExpressionLess(const ExpressionPtr &u, const ExpressionPtr &v) {
+  Op u_op = u->GetOperator();
+  Op v_op = v->GetOperator();
+  if (is_number(u) && is_number(v)) {
+    if (u_op != v_op) {
+      return u_op == kInteger;
+    }
+    return get_operand(u) < get_operand(v);
+  }
+  if (is_number(u)) {
+    return true;
+  }
+  if (is_number(v)) {
+    return false;
+  }
+  if (u_op == kVariable && v_op == kVariable) {
+    return get_operand(u) < get_operand(v);
+  }
+  if (u_op == v_op && (u_op == kAddition || u_op == kMultiplication)) {
+    return operands_less(operand_range(u), operand_range(v), true);
+  }
+  if (u_op == kPower && v_op == kPower) {
+    ExpressionPtr u_base = u->GetBase();
+    ExpressionPtr v_base = v->GetBase();
+    if (*u_base != *v_base) {
+      return ExpressionLess(u_base, v_base);
+    }
+    return ExpressionLess(u->GetExponent(), v->GetExponent());
+  }
+  if (is_function(u) && is_function(v)) {
+    if (u_op != v_op) {
+      return u_op < v_op;
+    }
+    return operands_less(operand_range(u), operand_range(v), false);
+  }
+  if (u_op == kMultiplication) {
+    return operands_less(operand_range(u), single_operand_range(v), true);
+  }
+  if (u_op == kPower && v_op != kMultiplication) {
+    // compared as v^1
+    ExpressionPtr u_base = u->GetBase();
+    if (*u_base != *v) {
+      return ExpressionLess(u_base, v);
+    }
+    return ExpressionLess(u->GetExponent(), kOne);
+  }
+  if (u_op == kAddition && (is_function(v) || v_op == kVariable)) {
+    return operands_less(operand_range(u), single_operand_range(v), true);
+  }
+  if (is_function(u) && v_op == kVariable) {
+    return false;
+  }
+  return !ExpressionLess(v, u);
+}
+} // namespace simplification_backend
+} // namespace bingo
@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <bingocpp/agraph/simplification_backend/constant_folding.h>
+
+namespace bingo {
+namespace simplification_backend {
+
+namespace {
+
+const ExpressionList &get_operands(const ExpressionPtr &expression) {
+  return std::static_pointer_cast<const OpExpression>(expression)
+      ->GetOperands();
+}
+
+bool is_terminal(const ExpressionPtr &expression) {
+  return kIsTerminalMap.at(expression->GetOperator());
+}
+
+// shared subexpressions are only visited once
+int get_max_constant(const ExpressionPtr &expression,
+                     std::unordered_set<const Expression *> *visited) {
+  if (is_terminal(expression)) {
+    if (expression->GetOperator() != kConstant) {
+      return -1;
+    }
+    return std::static_pointer_cast<const TermExpression>(expression)
+        ->GetOperand();
+  }
+  if (!visited->insert(expression.get()).second) {
+    return -1;
+  }
+  int max_constant = -1;
+  for (const ExpressionPtr &operand : get_operands(expression)) {
+    max_constant = std::max(max_constant, get_max_constant(operand, visited));
+  }
+  return max_constant;
+}
+
+class ConstantFolder {
+ public:
+  ConstantFolder(ExpressionArena &arena, int next_constant)
+      : arena_(arena), next_constant_(next_constant) {}
+
+  ExpressionPtr Fold(const ExpressionPtr &expression) {
+    if (is_terminal(expression)) {
+      return expression;
+    }
+    auto found = folded_.find(expression.get());
+    if (found != folded_.end()) {
+      return found->second;
+    }
+
+    ExpressionPtr folded;
+    if (!expression->IsConstantValued()) {
+      folded = fold_operands(expression);
+    } else if (contains_constant(expression)) {
+      folded = new_constant();
+    } else {
+      folded = expression;
+    }
+    folded_[expression.get()] = folded;
+    return folded;
+  }
+
+ private:
+  ExpressionArena &arena_;
+  int next_constant_;
+  std::unordered_map<const Expression *, ExpressionPtr> folded_;
+  std::unordered_map<const Expression *, bool> contains_constant_;
+
+  bool contains_constant(const ExpressionPtr &expression) {
+    if (is_terminal(expression)) {
+      return expression->GetOperator() == kConstant;
+    }
+    auto found = contains_constant_.find(expression.get());
+    if (found != contains_constant_.end()) {
+      return found->second;
+    }
+    bool contains = false;
+    for (const ExpressionPtr &operand : get_operands(expression)) {
+      if (contains_constant(operand)) {
+        contains = true;
+        break;
+      }
+    }
+    contains_constant_[expression.get()] = contains;
+    return contains;
+  }
+
+  ExpressionPtr new_constant() {
+    return arena_.MakeTerm(kConstant, next_constant_++);
+  }
+
+  ExpressionPtr fold_operands(const ExpressionPtr &expression) {
+    Op operatr = expression->GetOperator();
+    bool is_associative = operatr == kAddition || operatr == kMultiplication;
+    ExpressionList operands;
+    ExpressionList constant_operands;
+    for (const ExpressionPtr &operand : get_operands(expression)) {
+      if (is_associative && operand->IsConstantValued()) {
+        constant_operands.push_back(operand);
+      } else {
+        operands.push_back(Fold(operand));
+      }
+    }
+
+    // the constant-valued operands of sums and products are combined
+    bool has_constant = std::any_of(
+        constant_operands.begin(), constant_operands.end(),
+        [this](const ExpressionPtr &operand) {
+          return contains_constant(operand);
+        });
+    if (has_constant && (constant_operands.size() > 1 ||
+                         !is_terminal(constant_operands[0]))) {
+      constant_operands = {new_constant()};
+    }
+    operands.insert(operands.begin(), constant_operands.begin(),
+                    constant_operands.end());
+    return arena_.MakeOp(operatr, operands);
+  }
+};
+} // namespace
+
+ExpressionPtr FoldConstants(const ExpressionPtr &expression,
+                            ExpressionArena &arena) {
+  std::unordered_set<const Expression *> visited;
+  return ConstantFolder(arena, get_max_constant(expression, &visited) + 1)
+      .Fold(expression);
+}
+} // namespace simplification_backend
+} // namespace bingo
@@ -5,8 +5,31 @@
 namespace bingo {
 namespace simplification_backend {
 
+namespace {
+
+std::uint64_t hash_combine(std::uint64_t seed, std::uint64_t value) {
+  // splitmix64 finalizer, so that hashes do not depend on the platform
+  std::uint64_t z = seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) +
+                            (seed >> 2));
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+std::uint64_t hash_int(int value) {
+  return static_cast<std::uint64_t>(static_cast<std::int64_t>(value));
+}
+} // namespace
+
 TermExpression::TermExpression(const Op operatr, const int operand):
-  operand_(operand){ operator_ = operatr; }
+  operand_(operand){
+  operator_ = operatr;
+  hash_ = Hash(operatr, operand);
+}
+
+std::uint64_t TermExpression::Hash(const Op operatr, const int operand) {
+  return hash_combine(hash_combine(0, hash_int(operatr)), hash_int(operand));
+}
 
 
 
@@ -25,7 +48,7 @@ bool TermExpression::equal(const Expression& other) const {
   return operand_ == cast_other.operand_;
 }
 
-inline std::shared_ptr<const Expression> TermExpression::GetExponent() const
+std::shared_ptr<const Expression> TermExpression::GetExponent() const
   { return kOne; }
 
 
@@ -35,7 +58,7 @@ std::shared_ptr<const Expression> TermExpression::GetTerm() const {
 }
 
 
-inline std::shared_ptr<const Expression> TermExpression::GetCoefficient() const
+std::shared_ptr<const Expression> TermExpression::GetCoefficient() const
   { return kOne; }
 
 
@@ -44,14 +67,25 @@ inline std::shared_ptr<const Expression> TermExpression::GetCoefficient() const
 
 OpExpression::OpExpression(const Op operatr,
                            const std::vector<std::shared_ptr<const Expression>> operands):
-  operands_(operands){ operator_ = operatr; }
+  operands_(operands){
+  operator_ = operatr;
+  hash_ = Hash(operatr, operands);
+  is_constant_valued_ = true;
+  for (const auto &i : operands_) {
+    if (!(i->IsConstantValued())) { is_constant_valued_ = false; }
+  }
+}
 
-bool OpExpression::IsConstantValued() const  {
-  for (auto i : operands_ ) {
-    if ( !(i->IsConstantValued()) ) { return false; };
+std::uint64_t OpExpression::Hash(
+    const Op operatr,
+    const std::vector<std::shared_ptr<const Expression>> &operands) {
+  std::uint64_t hash = hash_combine(0, hash_int(operatr));
+  for (const auto &i : operands) {
+    hash = hash_combine(hash, i->GetHash());
   }
-  return true;
-};
+  return hash;
+}
+
 
 
 bool OpExpression::equal(const Expression& other) const {
@@ -0,0 +1,137 @@
+#include <algorithm>
+
+#include <bingocpp/agraph/simplification_backend/expression_arena.h>
+
+namespace bingo {
+namespace simplification_backend {
+
+namespace {
+
+const std::size_t kBlockSize = 1 << 12;
+const std::size_t kInitialTableSize = 64;
+} // namespace
+
+// Hands out arena memory to std::allocate_shared; memory is only released
+// with the arena
+template <typename T>
+class ExpressionArena::Allocator {
+ public:
+  typedef T value_type;
+
+  explicit Allocator(ExpressionArena *arena) : arena_(arena) {}
+  template <typename U>
+  Allocator(const Allocator<U> &other) : arena_(other.arena_) {}
+
+  T *allocate(std::size_t n) {
+    return static_cast<T *>(arena_->allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T *, std::size_t) {}
+
+  template <typename U>
+  bool operator==(const Allocator<U> &other) const {
+    return arena_ == other.arena_;
+  }
+  template <typename U>
+  bool operator!=(const Allocator<U> &other) const {
+    return arena_ != other.arena_;
+  }
+
+ private:
+  template <typename U>
+  friend class Allocator;
+  ExpressionArena *arena_;
+};
+
+ExpressionArena::ExpressionArena()
+    : block_capacity_(0), block_used_(0),
+      expressions_(kInitialTableSize), num_expressions_(0) {}
+
+ExpressionArena::~ExpressionArena() {
+  // the expressions are destroyed before the memory holding them
+  expressions_.clear();
+}
+
+void *ExpressionArena::allocate(std::size_t size, std::size_t alignment) {
+  if (!blocks_.empty()) {
+    std::uintptr_t next =
+        reinterpret_cast<std::uintptr_t>(blocks_.back().get()) + block_used_;
+    std::size_t padding = (alignment - next % alignment) % alignment;
+    if (block_used_ + padding + size <= block_capacity_) {
+      block_used_ += padding + size;
+      return reinterpret_cast<void *>(next + padding);
+    }
+  }
+  block_capacity_ = std::max(kBlockSize, size + alignment);
+  blocks_.emplace_back(new char[block_capacity_]);
+  block_used_ = 0;
+  return allocate(size, alignment);
+}
+
+ExpressionPtr ExpressionArena::insert(std::size_t slot,
+                                      ExpressionPtr expression) {
+  expressions_[slot] = expression;
+  if (2 * ++num_expressions_ > expressions_.size()) {
+    std::vector<ExpressionPtr> old_expressions(2 * expressions_.size());
+    old_expressions.swap(expressions_);
+    for (ExpressionPtr &old_expression : old_expressions) {
+      if (!old_expression) {
+        continue;
+      }
+      std::size_t mask = expressions_.size() - 1;
+      std::size_t new_slot = old_expression->GetHash() & mask;
+      while (expressions_[new_slot]) {
+        new_slot = (new_slot + 1) & mask;
+      }
+      expressions_[new_slot] = std::move(old_expression);
+    }
+  }
+  return expression;
+}
+
+ExpressionPtr ExpressionArena::MakeTerm(Op operatr, int operand) {
+  std::uint64_t hash = TermExpression::Hash(operatr, operand);
+  std::size_t mask = expressions_.size() - 1;
+  for (std::size_t slot = hash & mask; ; slot = (slot + 1) & mask) {
+    if (!expressions_[slot]) {
+      return insert(slot, std::allocate_shared<TermExpression>(
+          Allocator<TermExpression>(this), operatr, operand));
+    }
+    const ExpressionPtr &expression = expressions_[slot];
+    if (expression->GetHash() == hash &&
+        expression->GetOperator() == operatr &&
+        std::static_pointer_cast<const TermExpression>(expression)
+            ->GetOperand() == operand) {
+      return expression;
+    }
+  }
+}
+
+ExpressionPtr ExpressionArena::MakeOp(Op operatr,
+                                      const ExpressionList &operands) {
+  std::uint64_t hash = OpExpression::Hash(operatr, operands);
+  std::size_t mask = expressions_.size() - 1;
+  for (std::size_t slot = hash & mask; ; slot = (slot + 1) & mask) {
+    if (!expressions_[slot]) {
+      return insert(slot, std::allocate_shared<OpExpression>(
+          Allocator<OpExpression>(this), operatr, operands));
+    }
+    const ExpressionPtr &expression = expressions_[slot];
+    if (expression->GetHash() != hash ||
+        expression->GetOperator() != operatr) {
+      continue;
+    }
+    const ExpressionList &interned_operands =
+        std::static_pointer_cast<const OpExpression>(expression)
+            ->GetOperands();
+    if (interned_operands.size() == operands.size() &&
+        std::equal(operands.begin(), operands.end(),
+                   interned_operands.begin(),
+                   [](const ExpressionPtr &a, const ExpressionPtr &b) {
+                     return *a == *b;
+                   })) {
+      return expression;
+    }
+  }
+}
+} // namespace simplification_backend
+} // namespace bingo
@@ -0,0 +1,125 @@
+#include <map>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include <bingocpp/agraph/constants.h>
+#include <bingocpp/agraph/operator_definitions.h>
+#include <bingocpp/agraph/simplification_backend/interpreter.h>
+
+namespace bingo {
+namespace simplification_backend {
+
+namespace {
+
+class StackBuilder {
+ public:
+  Eigen::ArrayX3i Build(const ExpressionPtr &expression) {
+    add(expression);
+    Eigen::ArrayX3i stack(commands_.size(), 3);
+    for (std::size_t i = 0; i < commands_.size(); ++i) {
+      stack.row(i) = commands_[i];
+    }
+    return stack;
+  }
+
+ private:
+  std::vector<Eigen::Array<int, 1, 3>> commands_;
+  // commands of equal subexpressions have equal parameters
+  std::map<std::tuple<int, int, int>, int> command_index_;
+  // shared subexpressions are only visited once
+  std::unordered_map<const Expression *, int> expression_index_;
+
+  int add_command(int node, int param1, int param2) {
+    auto key = std::make_tuple(node, param1, param2);
+    auto found = command_index_.find(key);
+    if (found != command_index_.end()) {
+      return found->second;
+    }
+    Eigen::Array<int, 1, 3> command;
+    command << node, param1, param2;
+    commands_.push_back(command);
+    command_index_[key] = commands_.size() - 1;
+    return commands_.size() - 1;
+  }
+
+  int add(const ExpressionPtr &expression) {
+    auto found = expression_index_.find(expression.get());
+    if (found != expression_index_.end()) {
+      return found->second;
+    }
+    int index = add_new(expression);
+    expression_index_[expression.get()] = index;
+    return index;
+  }
+
+  int add_new(const ExpressionPtr &expression) {
+    Op operatr = expression->GetOperator();
+    if (kIsTerminalMap.at(operatr)) {
+      int operand =
+          std::static_pointer_cast<const TermExpression>(expression)->GetOperand();
+      return add_command(operatr, operand, operand);
+    }
+
+    const ExpressionList &operands =
+        std::static_pointer_cast<const OpExpression>(expression)->GetOperands();
+    std::vector<int> params;
+    for (const ExpressionPtr &operand : operands) {
+      params.push_back(add(operand));
+    }
+    if (!kIsArity2Map.at(operatr)) {
+      return add_command(operatr, params[0], params[0]);
+    }
+    // sums and products may have any number of operands
+    int result = params[0];
+    for (std::size_t i = 1; i < params.size(); ++i) {
+      result = add_command(operatr, result, params[i]);
+    }
+    return result;
+  }
+};
+} // namespace
+
+ExpressionPtr BuildExpression(const Eigen::ArrayX3i &stack,
+                              ExpressionArena &arena) {
+  std::vector<ExpressionPtr> expressions(stack.rows());
+  for (int row = 0; row < stack.rows(); ++row) {
+    Op node = static_cast<Op>(stack(row, kOpIdx));
+    int param1 = stack(row, kParam1Idx);
+    int param2 = stack(row, kParam2Idx);
+    if (kIsTerminalMap.at(node)) {
+      expressions[row] = arena.MakeTerm(node, param1);
+      continue;
+    }
+
+    const ExpressionPtr &operand1 = expressions[param1];
+    const ExpressionPtr &operand2 = expressions[param2];
+    switch (node) {
+      case kSubtraction:
+        expressions[row] = arena.MakeOp(
+            kAddition, {operand1, arena.MakeOp(kMultiplication,
+                                               {arena.MakeInteger(-1),
+                                                operand2})});
+        break;
+      case kDivision:
+        expressions[row] = arena.MakeOp(
+            kMultiplication, {operand1, arena.MakeOp(kPower,
+                                                     {operand2,
+                                                      arena.MakeInteger(-1)})});
+        break;
+      default:
+        if (kIsArity2Map.at(node)) {
+          expressions[row] = arena.MakeOp(node, {operand1, operand2});
+        } else {
+          expressions[row] = arena.MakeOp(node, {operand1});
+        }
+    }
+  }
+  return expressions.back();
+}
+
+Eigen::ArrayX3i BuildStack(const ExpressionPtr &expression) {
+  return StackBuilder().Build(expression);
+}
+} // namespace simplification_backend
+} // namespace bingo
@@ -0,0 +1,144 @@
+#include <limits>
+#include <unordered_map>
+
+#include <bingocpp/agraph/simplification_backend/optional_expression_modification.h>
+
+namespace bingo {
+namespace simplification_backend {
+
+namespace {
+
+ExpressionPtr make_op(ExpressionArena &arena, Op operatr,
+                      const ExpressionList &operands) {
+  if (operands.size() == 1 &&
+      (operatr == kAddition || operatr == kMultiplication)) {
+    return operands[0];
+  }
+  return arena.MakeOp(operatr, operands);
+}
+
+int get_operand(const ExpressionPtr &expression) {
+  return std::static_pointer_cast<const TermExpression>(expression)
+      ->GetOperand();
+}
+
+const ExpressionList &get_operands(const ExpressionPtr &expression) {
+  return std::static_pointer_cast<const OpExpression>(expression)
+      ->GetOperands();
+}
+
+bool is_negative_integer(const ExpressionPtr &expression) {
+  return expression->GetOperator() == kInteger &&
+         get_operand(expression) < 0 &&
+         get_operand(expression) != std::numeric_limits<int>::min();
+}
+
+// -k * x_1 * ... * x_n  ->  k * x_1 * ... * x_n
+ExpressionPtr negate_term(ExpressionArena &arena, const ExpressionPtr &term) {
+  ExpressionList factors = get_operands(term);
+  int coefficient = -get_operand(factors[0]);
+  if (coefficient == 1) {
+    factors.erase(factors.begin());
+  } else {
+    factors[0] = arena.MakeInteger(coefficient);
+  }
+  return make_op(arena, kMultiplication, factors);
+}
+
+// x^-k  ->  x^k
+ExpressionPtr invert_factor(ExpressionArena &arena,
+                            const ExpressionPtr &factor) {
+  const ExpressionList &operands = get_operands(factor);
+  int exponent = -get_operand(operands[1]);
+  if (exponent == 1) {
+    return operands[0];
+  }
+  return arena.MakeOp(kPower, {operands[0], arena.MakeInteger(exponent)});
+}
+
+class ExpressionModifier {
+ public:
+  ExpressionModifier(ExpressionArena &arena, Op operatr)
+      : arena_(arena), operator_(operatr) {}
+
+  ExpressionPtr Modify(const ExpressionPtr &expression) {
+    if (kIsTerminalMap.at(expression->GetOperator())) {
+      return expression;
+    }
+    auto found = modified_.find(expression.get());
+    if (found != modified_.end()) {
+      return found->second;
+    }
+
+    ExpressionList operands;
+    for (const ExpressionPtr &operand : get_operands(expression)) {
+      operands.push_back(Modify(operand));
+    }
+    ExpressionPtr modified;
+    if (operator_ == kSubtraction &&
+        expression->GetOperator() == kAddition) {
+      modified = insert_subtraction(operands);
+    } else if (operator_ == kDivision &&
+               expression->GetOperator() == kMultiplication) {
+      modified = insert_division(operands);
+    } else {
+      modified = make_op(arena_, expression->GetOperator(), operands);
+    }
+    modified_[expression.get()] = modified;
+    return modified;
+  }
+
+ private:
+  ExpressionArena &arena_;
+  Op operator_;
+  std::unordered_map<const Expression *, ExpressionPtr> modified_;
+
+  ExpressionPtr insert_subtraction(const ExpressionList &terms) {
+    ExpressionList positive_terms;
+    ExpressionList negative_terms;
+    for (const ExpressionPtr &term : terms) {
+      if (term->GetOperator() == kMultiplication &&
+          is_negative_integer(get_operands(term)[0])) {
+        negative_terms.push_back(negate_term(arena_, term));
+      } else {
+        positive_terms.push_back(term);
+      }
+    }
+    if (positive_terms.empty() || negative_terms.empty()) {
+      return make_op(arena_, kAddition, terms);
+    }
+    return arena_.MakeOp(kSubtraction,
+                         {make_op(arena_, kAddition, positive_terms),
+                          make_op(arena_, kAddition, negative_terms)});
+  }
+
+  ExpressionPtr insert_division(const ExpressionList &factors) {
+    ExpressionList numerator_factors;
+    ExpressionList denominator_factors;
+    for (const ExpressionPtr &factor : factors) {
+      if (factor->GetOperator() == kPower &&
+          is_negative_integer(get_operands(factor)[1])) {
+        denominator_factors.push_back(invert_factor(arena_, factor));
+      } else {
+        numerator_factors.push_back(factor);
+      }
+    }
+    if (numerator_factors.empty() || denominator_factors.empty()) {
+      return make_op(arena_, kMultiplication, factors);
+    }
+    return arena_.MakeOp(
+        kDivision, {make_op(arena_, kMultiplication, numerator_factors),
+                    make_op(arena_, kMultiplication, denominator_factors)});
+  }
+};
+} // namespace
+
+ExpressionPtr InsertSubtractionAndDivision(const ExpressionPtr &expression,
+                                           ExpressionArena &arena) {
+  // subtraction goes first so that negated terms can still become quotients
+  ExpressionPtr with_subtraction =
+      ExpressionModifier(arena, kSubtraction).Modify(expression);
+  return ExpressionModifier(arena, kDivision).Modify(with_subtraction);
+}
+} // namespace simplification_backend
+} // namespace bingo
@@ -1,9 +1,16 @@
+#include <algorithm>
+#include <atomic>
 #include <map>
 #include <numeric>
+#include <set>
 
 #include <Eigen/Dense>
 
 #include <bingocpp/agraph/simplification_backend/simplification_backend.h>
+#include <bingocpp/agraph/simplification_backend/automatic_simplification.h>
+#include <bingocpp/agraph/simplification_backend/constant_folding.h>
+#include <bingocpp/agraph/simplification_backend/interpreter.h>
+#include <bingocpp/agraph/simplification_backend/optional_expression_modification.h>
 #include <bingocpp/agraph/constants.h>
 #include <bingocpp/agraph/operator_definitions.h>
 
@@ -17,6 +24,70 @@ namespace py = pybind11;
 namespace bingo {
 namespace simplification_backend {
 
+namespace {
+
+// Finds the linear constants each utilized command depends on.  At the
+// first command that is not affine in them, the constants entering it
+// nonlinearly are marked as not linear and true is returned
+bool remove_nonlinear_constants(const Eigen::ArrayX3i &stack,
+                                const std::vector<bool> &utilized,
+                                std::vector<bool> &linear) {
+  std::vector<std::set<int>> dependencies(stack.rows());
+  for (int row = 0; row < stack.rows(); ++row) {
+    int node = stack(row, kOpIdx);
+    int param1 = stack(row, kParam1Idx);
+    int param2 = stack(row, kParam2Idx);
+    if (!utilized[row]) {
+      continue;
+    }
+    if (node == Op::kConstant && linear[param1]) {
+      dependencies[row].insert(param1);
+    }
+    if (kIsTerminalMap.at(node)) {
+      continue;
+    }
+
+    const std::set<int> &operand1 = dependencies[param1];
+    const std::set<int> &operand2 = dependencies[param2];
+    const std::set<int> *nonlinear = nullptr;
+    switch (node) {
+      case Op::kAddition:
+      case Op::kSubtraction:
+        break;
+      case Op::kMultiplication:
+        if (!operand1.empty() && !operand2.empty()) {
+          nonlinear = operand1.size() <= operand2.size() ?
+                      &operand1 : &operand2;
+        }
+        break;
+      case Op::kDivision:
+        if (!operand2.empty()) {
+          nonlinear = &operand2;
+        }
+        break;
+      default:
+        if (!operand1.empty()) {
+          nonlinear = &operand1;
+        } else if (kIsArity2Map.at(node) && !operand2.empty()) {
+          nonlinear = &operand2;
+        }
+    }
+    if (nonlinear != nullptr) {
+      for (int constant : *nonlinear) {
+        linear[constant] = false;
+      }
+      return true;
+    }
+    dependencies[row] = operand1;
+    dependencies[row].insert(operand2.begin(), operand2.end());
+  }
+  return false;
+}
+
+// whether AlgebraicSimplifyStack uses CppSimplifyStack
+std::atomic<bool> use_native_simplification(false);
+} // namespace
+
 std::vector<bool> GetUtilizedCommands(const Eigen::ArrayX3i &stack) {
   std::vector<bool> used_commands(stack.rows());
   used_commands.back() = true;
@@ -36,6 +107,22 @@ std::vector<bool> GetUtilizedCommands(const Eigen::ArrayX3i &stack) {
   return used_commands;
 }
 
+std::vector<bool> FindLinearConstants(const Eigen::ArrayX3i &stack) {
+  int num_constants = 0;
+  for (int row = 0; row < stack.rows(); ++row) {
+    if (stack(row, kOpIdx) == Op::kConstant) {
+      num_constants = std::max(num_constants, stack(row, kParam1Idx) + 1);
+    }
+  }
+  std::vector<bool> linear(num_constants, true);
+  if (stack.rows() == 0) {
+    return linear;
+  }
+  std::vector<bool> utilized = GetUtilizedCommands(stack);
+  while (remove_nonlinear_constants(stack, utilized, linear)) {}
+  return linear;
+}
+
 Eigen::ArrayX3i SimplifyStack(const Eigen::ArrayX3i &stack) {
   std::vector<bool> used_command = GetUtilizedCommands(stack);
   std::map<int, int> reduced_param_map;
@@ -65,11 +152,38 @@ Eigen::ArrayX3i SimplifyStack(const Eigen::ArrayX3i &stack) {
 }
 
 Eigen::ArrayX3i PythonSimplifyStack(const Eigen::ArrayX3i &stack) {
+  // population evaluations release the GIL before simplifying
+  py::gil_scoped_acquire gil;
   py::object python_simp_module = py::module::import("bingo.symbolic_regression.agraph.simplification_backend.simplification_backend");
   py::object python_simp = python_simp_module.attr("simplify_stack");
   Eigen::ArrayX3i result = python_simp(stack).cast<Eigen::ArrayX3i>();
   return result;
 }
 
+Eigen::ArrayX3i CppSimplifyStack(const Eigen::ArrayX3i &stack) {
+  // all expressions of the simplification are freed with the arena
+  ExpressionArena arena;
+  ExpressionPtr expression =
+      AutomaticSimplify(BuildExpression(stack, arena), arena);
+  expression = FoldConstants(expression, arena);
+  expression = InsertSubtractionAndDivision(expression, arena);
+  return BuildStack(expression);
+}
+
+Eigen::ArrayX3i AlgebraicSimplifyStack(const Eigen::ArrayX3i &stack) {
+  if (use_native_simplification) {
+    return CppSimplifyStack(stack);
+  }
+  return PythonSimplifyStack(stack);
+}
+
+void SetUseNativeSimplification(bool use_native) {
+  use_native_simplification = use_native;
+}
+
+bool GetUseNativeSimplification() {
+  return use_native_simplification;
+}
+
 } // namespace simplification_backend
 } // namespace bingo 
@@ -0,0 +1,963 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+#include "bingocpp/continuous_local_optimizer.h"
+#include "bingocpp/thread_pool.h"
+
+namespace bingo {
+
+namespace {
+
+// The residuals of the fitness vector and their derivatives at params
+struct LeastSquaresPoint {
+  Eigen::VectorXd params;
+  // all constants of the individual, which include the linear constants
+  // solved for at params under variable projection
+  Eigen::VectorXd constants;
+  Eigen::VectorXd residual;
+  Eigen::MatrixXd jacobian;
+  double cost;
+  Eigen::VectorXd gradient;
+  Eigen::MatrixXd jacobian_squared;
+};
+
+class LeastSquaresProblem {
+ public:
+  // The constants flagged in linear_params, if any, are projected out of
+  // the problem: params holds only the other constants, and the linear ones
+  // are solved for at each evaluation
+  LeastSquaresProblem(const VectorGradientMixin &fitness_function,
+                      AGraph &individual,
+                      const std::vector<bool> &linear_params = {})
+      : fitness_function_(fitness_function), individual_(individual),
+        num_evaluations_(0) {
+    for (std::size_t i = 0; i < linear_params.size(); ++i) {
+      if (linear_params[i]) {
+        linear_indices_.push_back(i);
+      } else {
+        nonlinear_indices_.push_back(i);
+      }
+    }
+  }
+
+  // Evaluates each column of params as a set of constants, all in one pass
+  // over the individual, or two under variable projection.  Non-finite
+  // residuals or derivatives give an infinite cost
+  void Evaluate(const Eigen::MatrixXd &params,
+                std::vector<LeastSquaresPoint> &points) {
+    if (linear_indices_.empty()) {
+      evaluate_normal_equations(params, points);
+      return;
+    }
+    evaluate_projected(params, points);
+    for (LeastSquaresPoint &point : points) {
+      if (std::isfinite(point.cost)) {
+        point.gradient = point.jacobian.transpose() * point.residual;
+        point.jacobian_squared = point.jacobian.transpose() * point.jacobian;
+      }
+    }
+  }
+
+  // The params of the problem among all constants
+  Eigen::MatrixXd GetParams(const Eigen::MatrixXd &constants) const {
+    if (linear_indices_.empty()) {
+      return constants;
+    }
+    return constants(nonlinear_indices_, Eigen::all);
+  }
+
+  int GetNumEvaluations() const { return num_evaluations_; }
+
+ private:
+  const VectorGradientMixin &fitness_function_;
+  AGraph &individual_;
+  int num_evaluations_;
+  Eigen::ArrayXXd params_array_;
+  std::vector<int> linear_indices_;
+  std::vector<int> nonlinear_indices_;
+
+  // Without projection only JᵀJ and Jᵀr are needed, which the fitness
+  // function may accumulate without forming the residuals and jacobian
+  void evaluate_normal_equations(const Eigen::MatrixXd &constants,
+                                 std::vector<LeastSquaresPoint> &points) {
+    ++num_evaluations_;
+    params_array_ = constants;
+    individual_.SetLocalOptimizationParams(params_array_);
+    std::vector<NormalEquations> normal_equations =
+        fitness_function_.GetNormalEquations(individual_);
+
+    int num_sets = constants.cols();
+    bool evaluated_all_sets =
+        static_cast<int>(normal_equations.size()) == num_sets;
+    if (!evaluated_all_sets) {
+      for (const NormalEquations &equations : normal_equations) {
+        if (std::isfinite(equations.squared_residual)) {
+          throw std::invalid_argument(
+              "Fitness function does not evaluate several sets of constants");
+        }
+      }
+    }
+    points.resize(num_sets);
+    for (int i = 0; i < num_sets; ++i) {
+      LeastSquaresPoint &point = points[i];
+      point.params = constants.col(i);
+      point.constants = point.params;
+      if (!evaluated_all_sets || !normal_equations[i].AllFinite()) {
+        point.cost = std::numeric_limits<double>::infinity();
+        continue;
+      }
+      point.cost = 0.5 * normal_equations[i].squared_residual;
+      point.gradient = std::move(normal_equations[i].gradient);
+      point.jacobian_squared =
+          std::move(normal_equations[i].jacobian_squared);
+    }
+  }
+
+  void evaluate_constants(const Eigen::MatrixXd &constants,
+                          std::vector<LeastSquaresPoint> &points) {
+    ++num_evaluations_;
+    params_array_ = constants;
+    individual_.SetLocalOptimizationParams(params_array_);
+    Eigen::ArrayXXd fitness_vectors;
+    Eigen::ArrayXXd jacobians;
+    std::tie(fitness_vectors, jacobians) =
+        fitness_function_.GetFitnessVectorsAndJacobians(individual_);
+
+    int num_constants = constants.rows();
+    int num_sets = constants.cols();
+    bool evaluated_all_sets = fitness_vectors.cols() == num_sets &&
+                              jacobians.cols() == num_constants * num_sets;
+    if (!evaluated_all_sets && fitness_vectors.allFinite()) {
+      throw std::invalid_argument(
+          "Fitness function does not evaluate several sets of constants");
+    }
+    points.resize(num_sets);
+    for (int i = 0; i < num_sets; ++i) {
+      LeastSquaresPoint &point = points[i];
+      point.params = constants.col(i);
+      point.constants = point.params;
+      if (!evaluated_all_sets) {
+        point.cost = std::numeric_limits<double>::infinity();
+        continue;
+      }
+      point.residual = fitness_vectors.col(i).matrix();
+      point.jacobian =
+          jacobians.middleCols(i * num_constants, num_constants).matrix();
+      point.cost = 0.5 * point.residual.squaredNorm();
+      if (!std::isfinite(point.cost) || !point.jacobian.allFinite()) {
+        point.cost = std::numeric_limits<double>::infinity();
+      }
+    }
+  }
+
+  // The fitness vector is affine in the linear constants, so their columns
+  // of the jacobian, the basis of the projection, do not depend on them.
+  // One pass with the linear constants at zero gives the basis and the
+  // residual they are solved from; a second pass at the solution gives the
+  // jacobian of the other constants, projected as by Kaufman
+  void evaluate_projected(const Eigen::MatrixXd &params,
+                          std::vector<LeastSquaresPoint> &points) {
+    int num_sets = params.cols();
+    Eigen::MatrixXd constants = Eigen::MatrixXd::Zero(
+        linear_indices_.size() + nonlinear_indices_.size(), num_sets);
+    constants(nonlinear_indices_, Eigen::all) = params;
+    evaluate_constants(constants, points);
+
+    std::vector<bool> solved(num_sets);
+    for (int i = 0; i < num_sets; ++i) {
+      LeastSquaresPoint &point = points[i];
+      solved[i] = std::isfinite(point.cost);
+      if (!solved[i]) {
+        continue;
+      }
+      Eigen::MatrixXd basis = point.jacobian(Eigen::all, linear_indices_);
+      Eigen::VectorXd linear_params =
+          basis.colPivHouseholderQr().solve(-point.residual);
+      constants(linear_indices_, i) = linear_params;
+      point.residual += basis * linear_params;
+      point.cost = 0.5 * point.residual.squaredNorm();
+    }
+    if (!nonlinear_indices_.empty()) {
+      evaluate_constants(constants, points);
+    }
+
+    for (int i = 0; i < num_sets; ++i) {
+      LeastSquaresPoint &point = points[i];
+      point.params = params.col(i);
+      point.constants = constants.col(i);
+      if (!solved[i] || !std::isfinite(point.cost)) {
+        point.cost = std::numeric_limits<double>::infinity();
+        continue;
+      }
+      Eigen::MatrixXd basis = point.jacobian(Eigen::all, linear_indices_);
+      Eigen::MatrixXd nonlinear = point.jacobian(Eigen::all,
+                                                 nonlinear_indices_);
+      point.jacobian =
+          nonlinear - basis * basis.colPivHouseholderQr().solve(nonlinear);
+    }
+  }
+};
+
+// One start of Levenberg-Marquardt or dogleg
+struct LeastSquaresStart {
+  LeastSquaresPoint point;
+  Eigen::VectorXd step;
+  // damping of Levenberg-Marquardt
+  double damping;
+  double damping_growth;
+  // radius of the trust region of dogleg
+  double radius;
+  bool running;
+  bool converged;
+};
+
+// The fitness and its gradient at params
+class ScalarProblem {
+ public:
+  ScalarProblem(const GradientMixin &fitness_function, AGraph &individual)
+      : fitness_function_(fitness_function), individual_(individual),
+        num_evaluations_(0) {}
+
+  // Writes the gradient into a buffer of the caller; a non-finite fitness
+  // or gradient gives an infinite fitness
+  double Evaluate(const Eigen::VectorXd &params, Eigen::VectorXd &gradient) {
+    ++num_evaluations_;
+    params_array_ = params;
+    individual_.SetLocalOptimizationParams(params_array_);
+    const FitnessAndGradient evaluation =
+        fitness_function_.GetIndividualFitnessAndGradient(individual_);
+    gradient = std::get<1>(evaluation).matrix();
+    double fitness = std::get<0>(evaluation);
+    if (!std::isfinite(fitness) || !gradient.allFinite()) {
+      return std::numeric_limits<double>::infinity();
+    }
+    return fitness;
+  }
+
+  int GetNumEvaluations() const { return num_evaluations_; }
+
+ private:
+  const GradientMixin &fitness_function_;
+  AGraph &individual_;
+  int num_evaluations_;
+  Eigen::ArrayXXd params_array_;
+};
+
+// Buffers of L-BFGS, allocated once per optimization and reused by every
+// iteration and line search step
+struct LbfgsWorkspace {
+  LbfgsWorkspace(int num_params, int memory)
+      : params(num_params), gradient(num_params),
+        trial_params(num_params), trial_gradient(num_params),
+        lowest_params(num_params), lowest_gradient(num_params),
+        direction(num_params), steps(num_params, memory),
+        gradient_changes(num_params, memory), curvatures(memory),
+        coefficients(memory), num_corrections(0), newest(0) {}
+
+  Eigen::VectorXd params;
+  Eigen::VectorXd gradient;
+  double fitness;
+  Eigen::VectorXd trial_params;
+  Eigen::VectorXd trial_gradient;
+  double trial_fitness;
+  Eigen::VectorXd lowest_params;
+  Eigen::VectorXd lowest_gradient;
+  Eigen::VectorXd direction;
+  // circular history of the corrections s = dx, y = dg and 1 / (y . s)
+  Eigen::MatrixXd steps;
+  Eigen::MatrixXd gradient_changes;
+  Eigen::VectorXd curvatures;
+  Eigen::VectorXd coefficients;
+  int num_corrections;
+  int newest;
+};
+
+bool is_small_step(const Eigen::VectorXd &step, const Eigen::VectorXd &params,
+                   const LocalOptimizationOptions &options) {
+  return step.norm() <= options.parameter_tolerance *
+                        (params.norm() + options.parameter_tolerance);
+}
+
+bool is_small_gradient(const LeastSquaresPoint &point,
+                       const LocalOptimizationOptions &options) {
+  return point.gradient.size() == 0 ||
+         point.gradient.lpNorm<Eigen::Infinity>() <=
+             options.gradient_tolerance;
+}
+
+bool is_small_reduction(double reduction, double cost,
+                        const LocalOptimizationOptions &options) {
+  return reduction <= options.function_tolerance * cost;
+}
+
+// Levenberg-Marquardt with the damping update of Nielsen
+void start_levenberg_marquardt(LeastSquaresStart &start) {
+  const Eigen::MatrixXd &jacobian_squared = start.point.jacobian_squared;
+  start.damping = 1e-3 * std::max(jacobian_squared.size() > 0 ?
+                                  jacobian_squared.diagonal().maxCoeff() : 0.0,
+                                  1.0);
+  start.damping_growth = 2.0;
+}
+
+// Computes the next step of a start, returning false if it has converged
+bool levenberg_marquardt_step(LeastSquaresStart &start,
+                              const LocalOptimizationOptions &options) {
+  const LeastSquaresPoint &point = start.point;
+  if (is_small_gradient(point, options)) {
+    return false;
+  }
+  Eigen::MatrixXd damped = point.jacobian_squared;
+  damped.diagonal().array() += start.damping;
+  start.step = damped.ldlt().solve(-point.gradient);
+  return !is_small_step(start.step, point.params, options);
+}
+
+// Accepts or rejects the trial point of a step, returning true if the
+// start has converged
+bool levenberg_marquardt_update(LeastSquaresStart &start,
+                                LeastSquaresPoint &trial,
+                                const LocalOptimizationOptions &options) {
+  const Eigen::VectorXd &step = start.step;
+  double reduction = start.point.cost - trial.cost;
+  double predicted_reduction =
+      0.5 * step.dot(start.damping * step - start.point.gradient);
+  if (reduction > 0.0 && predicted_reduction > 0.0) {
+    double ratio = reduction / predicted_reduction;
+    start.damping *= std::max(1.0 / 3.0,
+                              1.0 - std::pow(2.0 * ratio - 1.0, 3));
+    start.damping_growth = 2.0;
+    bool converged = is_small_reduction(reduction, start.point.cost, options);
+    start.point = std::move(trial);
+    return converged;
+  }
+  start.damping *= start.damping_growth;
+  start.damping_growth *= 2.0;
+  return false;
+}
+
+// The step minimizing the Gauss-Newton model along the dogleg path within
+// the trust region
+Eigen::VectorXd dogleg_path_step(const LeastSquaresPoint &point,
+                                 double radius) {
+  const Eigen::VectorXd &gradient = point.gradient;
+  Eigen::VectorXd gauss_newton =
+      point.jacobian_squared.ldlt().solve(-gradient);
+  if (gauss_newton.allFinite() && gauss_newton.norm() <= radius) {
+    return gauss_newton;
+  }
+
+  double curvature = gradient.dot(point.jacobian_squared * gradient);
+  double gradient_norm = gradient.norm();
+  if (curvature <= 0.0 ||
+      std::pow(gradient_norm, 3) / curvature >= radius ||
+      !gauss_newton.allFinite()) {
+    return -radius / gradient_norm * gradient;
+  }
+  Eigen::VectorXd cauchy = -gradient.squaredNorm() / curvature * gradient;
+  // ||cauchy + t (gauss_newton - cauchy)|| = radius for t in [0, 1]
+  Eigen::VectorXd difference = gauss_newton - cauchy;
+  double a = difference.squaredNorm();
+  double b = 2.0 * cauchy.dot(difference);
+  double c = cauchy.squaredNorm() - radius * radius;
+  double t = (-b + std::sqrt(b * b - 4.0 * a * c)) / (2.0 * a);
+  return cauchy + t * difference;
+}
+
+void start_dogleg(LeastSquaresStart &start) {
+  start.radius = std::max(start.point.params.norm(), 1.0);
+}
+
+bool dogleg_step(LeastSquaresStart &start,
+                 const LocalOptimizationOptions &options) {
+  if (is_small_gradient(start.point, options)) {
+    return false;
+  }
+  start.step = dogleg_path_step(start.point, start.radius);
+  return !is_small_step(start.step, start.point.params, options);
+}
+
+bool dogleg_update(LeastSquaresStart &start, LeastSquaresPoint &trial,
+                   const LocalOptimizationOptions &options) {
+  const Eigen::VectorXd &step = start.step;
+  const LeastSquaresPoint &point = start.point;
+  double reduction = point.cost - trial.cost;
+  double predicted_reduction = -point.gradient.dot(step) -
+      0.5 * step.dot(point.jacobian_squared * step);
+  double ratio = predicted_reduction > 0.0 ?
+                 reduction / predicted_reduction : -1.0;
+  if (ratio < 0.25) {
+    start.radius = 0.25 * step.norm();
+  } else if (ratio > 0.75 && step.norm() >= 0.99 * start.radius) {
+    start.radius *= 2.0;
+  }
+  if (reduction > 0.0 && ratio > 0.0) {
+    bool converged = is_small_reduction(reduction, point.cost, options);
+    start.point = std::move(trial);
+    return converged;
+  }
+  return false;
+}
+
+// Advances all starts in lockstep: each evaluation of the individual takes
+// one step of every start still running, their trial points being the
+// columns of one set of multi-column constants
+void least_squares(LeastSquaresProblem &problem,
+                   LocalOptimizationAlgorithm algorithm,
+                   std::vector<LeastSquaresStart> &starts,
+                   const LocalOptimizationOptions &options) {
+  for (LeastSquaresStart &start : starts) {
+    if (start.running && algorithm == kLevenbergMarquardt) {
+      start_levenberg_marquardt(start);
+    } else if (start.running) {
+      start_dogleg(start);
+    }
+  }
+
+  std::vector<int> stepping;
+  Eigen::MatrixXd trial_params;
+  std::vector<LeastSquaresPoint> trials;
+  while (problem.GetNumEvaluations() < options.max_iterations) {
+    stepping.clear();
+    for (std::size_t i = 0; i < starts.size(); ++i) {
+      LeastSquaresStart &start = starts[i];
+      if (!start.running) {
+        continue;
+      }
+      bool has_step = algorithm == kLevenbergMarquardt ?
+                      levenberg_marquardt_step(start, options) :
+                      dogleg_step(start, options);
+      if (has_step) {
+        stepping.push_back(i);
+      } else {
+        start.running = false;
+        start.converged = true;
+      }
+    }
+    if (stepping.empty()) {
+      return;
+    }
+
+    trial_params.resize(starts[stepping[0]].step.size(), stepping.size());
+    for (std::size_t j = 0; j < stepping.size(); ++j) {
+      const LeastSquaresStart &start = starts[stepping[j]];
+      trial_params.col(j) = start.point.params + start.step;
+    }
+    problem.Evaluate(trial_params, trials);
+    for (std::size_t j = 0; j < stepping.size(); ++j) {
+      LeastSquaresStart &start = starts[stepping[j]];
+      bool converged = algorithm == kLevenbergMarquardt ?
+                       levenberg_marquardt_update(start, trials[j], options) :
+                       dogleg_update(start, trials[j], options);
+      if (converged) {
+        start.running = false;
+        start.converged = true;
+      }
+    }
+  }
+}
+
+// One safeguarded step of Moré and Thuente: updates the interval
+// [best_step, other_step] around a minimizer along the search direction
+// and returns the next trial step, interpolating the fitness and slope at
+// best_step and step by cubics and quadratics
+double more_thuente_step(double &best_step, double &best_fitness,
+                         double &best_slope, double &other_step,
+                         double &other_fitness, double &other_slope,
+                         double step, double fitness, double slope,
+                         bool &bracketed, double min_step, double max_step) {
+  double sign = slope * (best_slope / std::abs(best_slope));
+  double next_step;
+  if (fitness > best_fitness) {
+    // higher fitness: the minimizer is bracketed
+    double theta = 3.0 * (best_fitness - fitness) / (step - best_step) +
+                   best_slope + slope;
+    double s = std::max({std::abs(theta), std::abs(best_slope),
+                         std::abs(slope)});
+    double gamma = s * std::sqrt(std::max(
+        0.0, (theta / s) * (theta / s) - (best_slope / s) * (slope / s)));
+    if (step < best_step) {
+      gamma = -gamma;
+    }
+    double p = (gamma - best_slope) + theta;
+    double q = ((gamma - best_slope) + gamma) + slope;
+    double cubic = best_step + p / q * (step - best_step);
+    double quadratic = best_step +
+        best_slope / ((best_fitness - fitness) / (step - best_step) +
+                      best_slope) / 2.0 * (step - best_step);
+    if (std::abs(cubic - best_step) < std::abs(quadratic - best_step)) {
+      next_step = cubic;
+    } else {
+      next_step = cubic + (quadratic - cubic) / 2.0;
+    }
+    bracketed = true;
+  } else if (sign < 0.0) {
+    // the slope changed sign: the minimizer is bracketed
+    double theta = 3.0 * (best_fitness - fitness) / (step - best_step) +
+                   best_slope + slope;
+    double s = std::max({std::abs(theta), std::abs(best_slope),
+                         std::abs(slope)});
+    double gamma = s * std::sqrt(std::max(
+        0.0, (theta / s) * (theta / s) - (best_slope / s) * (slope / s)));
+    if (step > best_step) {
+      gamma = -gamma;
+    }
+    double p = (gamma - slope) + theta;
+    double q = ((gamma - slope) + gamma) + best_slope;
+    double cubic = step + p / q * (best_step - step);
+    double secant = step + slope / (slope - best_slope) * (best_step - step);
+    if (std::abs(cubic - step) > std::abs(secant - step)) {
+      next_step = cubic;
+    } else {
+      next_step = secant;
+    }
+    bracketed = true;
+  } else if (std::abs(slope) < std::abs(best_slope)) {
+    // lower fitness and a decreasing slope of the same sign
+    double theta = 3.0 * (best_fitness - fitness) / (step - best_step) +
+                   best_slope + slope;
+    double s = std::max({std::abs(theta), std::abs(best_slope),
+                         std::abs(slope)});
+    double gamma = s * std::sqrt(std::max(
+        0.0, (theta / s) * (theta / s) - (best_slope / s) * (slope / s)));
+    if (step > best_step) {
+      gamma = -gamma;
+    }
+    double p = (gamma - slope) + theta;
+    double q = (gamma + (best_slope - slope)) + gamma;
+    double r = p / q;
+    double cubic;
+    if (r < 0.0 && gamma != 0.0) {
+      cubic = step + r * (best_step - step);
+    } else if (step > best_step) {
+      cubic = max_step;
+    } else {
+      cubic = min_step;
+    }
+    double secant = step + slope / (slope - best_slope) * (best_step - step);
+    if (bracketed) {
+      next_step = std::abs(cubic - step) < std::abs(secant - step) ?
+                  cubic : secant;
+      if (step > best_step) {
+        next_step = std::min(step + 0.66 * (other_step - step), next_step);
+      } else {
+        next_step = std::max(step + 0.66 * (other_step - step), next_step);
+      }
+    } else {
+      next_step = std::abs(cubic - step) > std::abs(secant - step) ?
+                  cubic : secant;
+      next_step = std::min(max_step, std::max(min_step, next_step));
+    }
+  } else {
+    // lower fitness and a slope that does not decrease
+    if (bracketed) {
+      double theta = 3.0 * (fitness - other_fitness) / (other_step - step) +
+                     other_slope + slope;
+      double s = std::max({std::abs(theta), std::abs(other_slope),
+                           std::abs(slope)});
+      double gamma = s * std::sqrt(std::max(
+          0.0, (theta / s) * (theta / s) - (other_slope / s) * (slope / s)));
+      if (step > other_step) {
+        gamma = -gamma;
+      }
+      double p = (gamma - slope) + theta;
+      double q = ((gamma - slope) + gamma) + other_slope;
+      next_step = step + p / q * (other_step - step);
+    } else if (step > best_step) {
+      next_step = max_step;
+    } else {
+      next_step = min_step;
+    }
+  }
+
+  if (fitness > best_fitness) {
+    other_step = step;
+    other_fitness = fitness;
+    other_slope = slope;
+  } else {
+    if (sign < 0.0) {
+      other_step = best_step;
+      other_fitness = best_fitness;
+      other_slope = best_slope;
+    }
+    best_step = step;
+    best_fitness = fitness;
+    best_slope = slope;
+  }
+  return next_step;
+}
+
+// The line search of Moré and Thuente for a step along the direction of
+// the workspace satisfying the strong Wolfe conditions.  The accepted point
+// is left in the trial buffers; if none is found before the evaluations run
+// out, they hold the lowest point seen, which may be the starting point.
+bool more_thuente_search(ScalarProblem &problem, LbfgsWorkspace &workspace,
+                         double step, int max_evaluations) {
+  const double kSufficientDecrease = 1e-4;
+  const double kCurvature = 0.9;
+  const double kStepTolerance = 0.1;
+  const double kExtrapolation = 4.0;
+  double min_step = 0.0;
+  double max_step = 1e20;
+
+  double initial_slope = workspace.gradient.dot(workspace.direction);
+  double decrease_slope = kSufficientDecrease * initial_slope;
+  bool bracketed = false;
+  bool first_stage = true;
+  double width = max_step - min_step;
+  double previous_width = 2.0 * width;
+  double best_step = 0.0;
+  double best_fitness = workspace.fitness;
+  double best_slope = initial_slope;
+  double other_step = 0.0;
+  double other_fitness = workspace.fitness;
+  double other_slope = initial_slope;
+  double lower = 0.0;
+  double upper = step + kExtrapolation * step;
+  double lowest_fitness = workspace.fitness;
+
+  bool found = false;
+  while (problem.GetNumEvaluations() < max_evaluations) {
+    workspace.trial_params = workspace.params + step * workspace.direction;
+    workspace.trial_fitness = problem.Evaluate(workspace.trial_params,
+                                               workspace.trial_gradient);
+    if (!std::isfinite(workspace.trial_fitness)) {
+      // back off towards the best step without widening the search again
+      max_step = step;
+      upper = std::min(upper, step);
+      step = best_step + 0.5 * (step - best_step);
+      continue;
+    }
+    if (workspace.trial_fitness < lowest_fitness) {
+      lowest_fitness = workspace.trial_fitness;
+      workspace.lowest_params = workspace.trial_params;
+      workspace.lowest_gradient = workspace.trial_gradient;
+    }
+
+    double fitness = workspace.trial_fitness;
+    double slope = workspace.trial_gradient.dot(workspace.direction);
+    double sufficient_fitness = workspace.fitness + step * decrease_slope;
+    if (fitness <= sufficient_fitness &&
+        std::abs(slope) <= -kCurvature * initial_slope) {
+      found = true;
+      break;
+    }
+    if ((bracketed && (step <= lower || step >= upper)) ||
+        (bracketed && upper - lower <= kStepTolerance * upper) ||
+        (step == max_step && fitness <= sufficient_fitness &&
+         slope <= decrease_slope) ||
+        (step == min_step && (fitness > sufficient_fitness ||
+                              slope >= decrease_slope))) {
+      break;
+    }
+    if (first_stage && fitness <= sufficient_fitness &&
+        slope >= std::min(kSufficientDecrease, kCurvature) * initial_slope) {
+      first_stage = false;
+    }
+
+    if (first_stage && fitness <= best_fitness &&
+        fitness > sufficient_fitness) {
+      // the modified function, fitness less the sufficient decrease
+      double modified_best_fitness = best_fitness - best_step * decrease_slope;
+      double modified_best_slope = best_slope - decrease_slope;
+      double modified_other_fitness =
+          other_fitness - other_step * decrease_slope;
+      double modified_other_slope = other_slope - decrease_slope;
+      step = more_thuente_step(best_step, modified_best_fitness,
+                               modified_best_slope, other_step,
+                               modified_other_fitness, modified_other_slope,
+                               step, fitness - step * decrease_slope,
+                               slope - decrease_slope, bracketed,
+                               lower, upper);
+      best_fitness = modified_best_fitness + best_step * decrease_slope;
+      best_slope = modified_best_slope + decrease_slope;
+      other_fitness = modified_other_fitness + other_step * decrease_slope;
+      other_slope = modified_other_slope + decrease_slope;
+    } else {
+      step = more_thuente_step(best_step, best_fitness, best_slope,
+                               other_step, other_fitness, other_slope,
+                               step, fitness, slope, bracketed,
+                               lower, upper);
+    }
+
+    if (bracketed) {
+      if (std::abs(other_step - best_step) >= 0.66 * previous_width) {
+        step = best_step + 0.5 * (other_step - best_step);
+      }
+      previous_width = width;
+      width = std::abs(other_step - best_step);
+      lower = std::min(best_step, other_step);
+      upper = std::max(best_step, other_step);
+    } else {
+      lower = step + 1.1 * (step - best_step);
+      upper = step + kExtrapolation * (step - best_step);
+    }
+    step = std::min(max_step, std::max(min_step, step));
+    if (bracketed && (step <= lower || step >= upper ||
+                      upper - lower <= kStepTolerance * upper)) {
+      step = best_step;
+    }
+  }
+
+  if (!found && lowest_fitness < workspace.fitness) {
+    workspace.trial_params = workspace.lowest_params;
+    workspace.trial_gradient = workspace.lowest_gradient;
+    workspace.trial_fitness = lowest_fitness;
+  } else if (!found) {
+    workspace.trial_fitness = workspace.fitness;
+  }
+  return found;
+}
+
+// The two loop recursion for the L-BFGS direction -H g
+void lbfgs_direction(LbfgsWorkspace &workspace) {
+  int memory = workspace.steps.cols();
+  workspace.direction = -workspace.gradient;
+  for (int k = 0; k < workspace.num_corrections; ++k) {
+    int i = (workspace.newest - k + memory) % memory;
+    workspace.coefficients(i) = workspace.curvatures(i) *
+        workspace.steps.col(i).dot(workspace.direction);
+    workspace.direction -= workspace.coefficients(i) *
+                           workspace.gradient_changes.col(i);
+  }
+  if (workspace.num_corrections > 0) {
+    int i = workspace.newest;
+    workspace.direction /= workspace.curvatures(i) *
+                           workspace.gradient_changes.col(i).squaredNorm();
+  }
+  for (int k = workspace.num_corrections - 1; k >= 0; --k) {
+    int i = (workspace.newest - k + memory) % memory;
+    double correction = workspace.curvatures(i) *
+        workspace.gradient_changes.col(i).dot(workspace.direction);
+    workspace.direction += (workspace.coefficients(i) - correction) *
+                           workspace.steps.col(i);
+  }
+}
+
+bool lbfgs(ScalarProblem &problem, LbfgsWorkspace &workspace,
+           const LocalOptimizationOptions &options) {
+  int memory = workspace.steps.cols();
+  while (problem.GetNumEvaluations() < options.max_iterations) {
+    if (workspace.gradient.size() == 0 ||
+        workspace.gradient.lpNorm<Eigen::Infinity>() <=
+            options.gradient_tolerance) {
+      return true;
+    }
+    lbfgs_direction(workspace);
+    if (workspace.num_corrections > 0 &&
+        workspace.gradient.dot(workspace.direction) >= 0.0) {
+      workspace.num_corrections = 0;
+      workspace.direction = -workspace.gradient;
+    }
+    double step = workspace.num_corrections > 0 ?
+                  1.0 : std::min(1.0, 1.0 / workspace.direction.norm());
+
+    more_thuente_search(problem, workspace, step, options.max_iterations);
+    if (!(workspace.trial_fitness < workspace.fitness)) {
+      // retry once along the gradient before giving up
+      if (workspace.num_corrections == 0) {
+        return false;
+      }
+      workspace.num_corrections = 0;
+      continue;
+    }
+
+    int next = (workspace.newest + 1) % memory;
+    workspace.steps.col(next) = workspace.trial_params - workspace.params;
+    workspace.gradient_changes.col(next) =
+        workspace.trial_gradient - workspace.gradient;
+    double curvature =
+        workspace.steps.col(next).dot(workspace.gradient_changes.col(next));
+    if (curvature > std::numeric_limits<double>::epsilon() *
+                    workspace.gradient_changes.col(next).squaredNorm()) {
+      workspace.curvatures(next) = 1.0 / curvature;
+      workspace.newest = next;
+      workspace.num_corrections =
+          std::min(workspace.num_corrections + 1, memory);
+    }
+
+    double reduction = workspace.fitness - workspace.trial_fitness;
+    bool converged =
+        is_small_reduction(reduction, workspace.fitness, options) ||
+        is_small_step(workspace.trial_params - workspace.params,
+                      workspace.params, options);
+    workspace.params.swap(workspace.trial_params);
+    workspace.gradient.swap(workspace.trial_gradient);
+    workspace.fitness = workspace.trial_fitness;
+    if (converged) {
+      return true;
+    }
+  }
+  return false;
+}
+
+LocalOptimizationResult minimize_fitness(
+    const GradientMixin &fitness_function, AGraph &individual,
+    const Eigen::VectorXd &initial_params,
+    const LocalOptimizationOptions &options) {
+  ScalarProblem problem(fitness_function, individual);
+  LbfgsWorkspace workspace(initial_params.size(),
+                           std::max(options.lbfgs_memory, 1));
+  workspace.params = initial_params;
+  workspace.fitness = problem.Evaluate(workspace.params, workspace.gradient);
+  bool converged = std::isfinite(workspace.fitness) &&
+                   lbfgs(problem, workspace, options);
+  return LocalOptimizationResult{workspace.params, workspace.fitness,
+                                 problem.GetNumEvaluations(), converged};
+}
+} // namespace
+
+// Keeps the values of the constant-free parts of an individual while its
+// constants are optimized, dropping them afterwards.  x is the training
+// data of the fitness function, which is not modified in the meantime.
+class ContinuousLocalOptimizer::EvaluationCaching {
+ public:
+  explicit EvaluationCaching(AGraph &individual) : individual_(individual) {
+    individual_.SetEvaluationCaching(true);
+  }
+
+  ~EvaluationCaching() { individual_.SetEvaluationCaching(false); }
+
+ private:
+  AGraph &individual_;
+};
+
+ContinuousLocalOptimizer::ContinuousLocalOptimizer(
+    const VectorGradientMixin *fitness_function,
+    const std::string &algorithm,
+    double param_init_min, double param_init_max,
+    const LocalOptimizationOptions &options,
+    unsigned int seed) :
+    fitness_function_(fitness_function),
+    evaluation_function_(
+        dynamic_cast<const FitnessFunction *>(fitness_function)),
+    options_(options),
+    param_distribution_(param_init_min, param_init_max),
+    generator_(seed) {
+  if (algorithm == "lm") {
+    algorithm_ = kLevenbergMarquardt;
+  } else if (algorithm == "dogleg") {
+    algorithm_ = kDogleg;
+  } else if (algorithm == "lbfgs") {
+    algorithm_ = kLbfgs;
+  } else {
+    throw std::invalid_argument("Invalid algorithm for local optimization");
+  }
+  if (evaluation_function_ == nullptr) {
+    throw std::invalid_argument(
+        "Fitness function for local optimization must be a FitnessFunction");
+  }
+}
+
+LocalOptimizationResult ContinuousLocalOptimizer::OptimizeParams(
+    AGraph &individual, const Eigen::VectorXd &initial_params) const {
+  return OptimizeParamsMultiStart(individual, initial_params);
+}
+
+LocalOptimizationResult ContinuousLocalOptimizer::OptimizeParamsMultiStart(
+    AGraph &individual, const Eigen::MatrixXd &initial_params) const {
+  if (initial_params.cols() == 0) {
+    throw std::invalid_argument(
+        "Local optimization needs at least one set of initial constants");
+  }
+  EvaluationCaching caching(individual);
+  LocalOptimizationResult best;
+  if (algorithm_ == kLbfgs) {
+    // line searches take varying numbers of evaluations, so the starts of
+    // L-BFGS are run one after another
+    int num_evaluations = 0;
+    for (int i = 0; i < initial_params.cols(); ++i) {
+      LocalOptimizationResult result = minimize_fitness(
+          *fitness_function_, individual, initial_params.col(i), options_);
+      num_evaluations += result.num_evaluations;
+      if (i == 0 || result.cost < best.cost) {
+        best = std::move(result);
+      }
+    }
+    best.num_evaluations = num_evaluations;
+  } else {
+    std::vector<bool> linear_params;
+    if (options_.variable_projection) {
+      linear_params = individual.GetLinearLocalOptimizationParams();
+    }
+    LeastSquaresProblem problem(*fitness_function_, individual,
+                                linear_params);
+    std::vector<LeastSquaresPoint> points;
+    problem.Evaluate(problem.GetParams(initial_params), points);
+    std::vector<LeastSquaresStart> starts(points.size());
+    for (std::size_t i = 0; i < points.size(); ++i) {
+      starts[i].point = std::move(points[i]);
+      starts[i].running = std::isfinite(starts[i].point.cost);
+      starts[i].converged = false;
+    }
+    least_squares(problem, algorithm_, starts, options_);
+
+    const LeastSquaresStart &best_start = *std::min_element(
+        starts.begin(), starts.end(),
+        [](const LeastSquaresStart &a, const LeastSquaresStart &b) {
+          return a.point.cost < b.point.cost;
+        });
+    best = LocalOptimizationResult{best_start.point.constants,
+                                   best_start.point.cost,
+                                   problem.GetNumEvaluations(),
+                                   best_start.converged};
+  }
+
+  Eigen::ArrayXXd params = best.params;
+  individual.SetLocalOptimizationParams(params);
+  return best;
+}
+
+double ContinuousLocalOptimizer::EvaluateIndividualFitness(
+    AGraph &individual) {
+  if (individual.NeedsLocalOptimization()) {
+    OptimizeParamsMultiStart(individual, draw_initial_params(
+        individual.GetNumberLocalOptimizationParams()));
+  }
+  return evaluation_function_->EvaluateIndividualFitness(individual);
+}
+
+Eigen::ArrayXd ContinuousLocalOptimizer::EvaluatePopulationFitness(
+    const std::vector<AGraph *> &individuals) {
+  std::vector<Eigen::MatrixXd> initial_params(individuals.size());
+  for (std::size_t i = 0; i < individuals.size(); ++i) {
+    if (individuals[i]->NeedsLocalOptimization()) {
+      initial_params[i] = draw_initial_params(
+          individuals[i]->GetNumberLocalOptimizationParams());
+    }
+  }
+
+  Eigen::ArrayXd fitness(individuals.size());
+  auto evaluate_individual = [&](int i) {
+    if (initial_params[i].size() > 0) {
+      OptimizeParamsMultiStart(*individuals[i], initial_params[i]);
+    }
+    fitness(i) = evaluation_function_->EvaluateIndividualFitness(
+        *individuals[i]);
+  };
+  TrainingData *training_data = evaluation_function_->GetTrainingData();
+  int num_rows = training_data != nullptr ? training_data->Size() : 0;
+  if (UseRowParallelism(individuals.size(), num_rows)) {
+    for (std::size_t i = 0; i < individuals.size(); ++i) {
+      evaluate_individual(i);
+    }
+  } else {
+    GetThreadPool()->ParallelFor(individuals.size(), evaluate_individual);
+  }
+  return fitness;
+}
+
+Eigen::MatrixXd ContinuousLocalOptimizer::draw_initial_params(
+    int num_params) {
+  Eigen::MatrixXd params(num_params, std::max(options_.num_starts, 1));
+  for (int start = 0; start < params.cols(); ++start) {
+    for (int i = 0; i < num_params; ++i) {
+      params(i, start) = param_distribution_(generator_);
+    }
+  }
+  return params;
+}
+} // namespace bingo
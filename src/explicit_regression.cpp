@@ -1,16 +1,30 @@
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <limits>
+#include <memory>
 #include <tuple>
 
 #include "bingocpp/explicit_regression.h"
 
 namespace bingo {
+namespace {
+
+// Racing evaluates the rows in about this many chunks, of at least
+// kMinRacingRows rows each
+const int kRacingChunks = 32;
+const int kMinRacingRows = 1024;
+} // namespace
 
 ExplicitTrainingData *ExplicitTrainingData::GetItem(int item) {
-  return new ExplicitTrainingData(x.row(item), y.row(item));
+  return GetRange(item, item + 1);
 }
 
 ExplicitTrainingData *ExplicitTrainingData::GetItem(
     const std::vector<int> &items) {
+  if (IsRange(items)) {
+    return GetRange(items.front(), items.back() + 1);
+  }
   Eigen::ArrayXXd temp_in(items.size(), x.cols());
   Eigen::ArrayXXd temp_out(items.size(), y.cols());
 
@@ -22,33 +36,175 @@ ExplicitTrainingData *ExplicitTrainingData::GetItem(
   return new ExplicitTrainingData(temp_in, temp_out);
 }
 
+ExplicitTrainingData *ExplicitTrainingData::GetRange(int begin, int end) {
+  return new ExplicitTrainingData(RowsOf(x, begin, end), RowsOf(y, begin, end),
+                                  owner_);
+}
+
 Eigen::ArrayXd ExplicitRegression::EvaluateFitnessVector(
     Equation &individual) const {
   ++ eval_count_;
-  const Eigen::ArrayXXd x = ((ExplicitTrainingData*)training_data_)->x;
-  Eigen::ArrayXXd f_of_x = individual.EvaluateEquationAt(x);
-  Eigen::ArrayXXd error = f_of_x - ((ExplicitTrainingData*)training_data_)->y;
-  if (relative_)
-    error /= ((ExplicitTrainingData*)training_data_)->y;
+  auto view = dynamic_cast<ExplicitTrainingDataView*>(training_data_);
+  if (view != nullptr) {
+    return fitness_vector_at_rows(individual, view->data, *view->rows);
+  }
+  const ExplicitTrainingData &data = *(ExplicitTrainingData*)training_data_;
+  return fitness_vector_of(individual, data.x, data.y);
+}
+
+BoundedFitness ExplicitRegression::EvaluateIndividualFitnessWithin(
+    Equation &individual, double bound) const {
+  ++ eval_count_;
+  // the rows evaluated: all rows of data, or those listed in rows
+  auto view = dynamic_cast<ExplicitTrainingDataView*>(training_data_);
+  const ExplicitTrainingData &data =
+      view != nullptr ? view->data : *(ExplicitTrainingData*)training_data_;
+  const Eigen::ArrayXi *rows = view != nullptr ? view->rows.get() : nullptr;
+  Eigen::ArrayXi minibatch_rows;
+  if (GetMinibatchSize() > 0) {
+    minibatch_rows = rows != nullptr ? (*rows)(GetMinibatchRows())
+                                     : GetMinibatchRows();
+    rows = &minibatch_rows;
+  }
+  int num_rows = rows != nullptr ? rows->size() : data.x.rows();
+
+  // chunks large enough to be split over threads, if the rows are
+  int min_chunk = num_rows < kMinParallelRows ? kMinRacingRows
+                                              : kMinParallelRows;
+  int chunk = std::max((num_rows + kRacingChunks - 1) / kRacingChunks,
+                       min_chunk);
+  Eigen::ArrayXd fitness_vector(num_rows);
+  double metric_sum = 0.0;
+  for (int begin = 0; begin < num_rows; begin += chunk) {
+    int end = std::min(begin + chunk, num_rows);
+    auto chunk_fitness = fitness_vector.segment(begin, end - begin);
+    if (rows != nullptr) {
+      chunk_fitness = fitness_vector_at_rows(individual, data,
+                                             rows->segment(begin, end - begin));
+    } else {
+      chunk_fitness = fitness_vector_of(individual, RowsOf(data.x, begin, end),
+                                        RowsOf(data.y, begin, end));
+    }
+    metric_sum += MetricSum(chunk_fitness);
+    // a NaN row makes the fitness NaN, whatever the other rows
+    if (std::isnan(metric_sum)) {
+      return BoundedFitness{std::numeric_limits<double>::quiet_NaN(), false};
+    }
+    double lower_bound = MetricOfSum(metric_sum, num_rows);
+    if (end < num_rows && lower_bound > bound) {
+      return BoundedFitness{lower_bound, true};
+    }
+  }
+  return BoundedFitness{MetricOf(fitness_vector), false};
+}
+
+Eigen::ArrayXd ExplicitRegression::fitness_vector_of(
+    Equation &individual, const TrainingArray &x,
+    const TrainingArray &y) const {
+  Eigen::ArrayXXd error = individual.EvaluateEquationAt(x);
+  // the evaluation itself is split by rows for large data, so is the error
+  GetThreadPool()->ParallelForBlocks(error.rows(), kMinParallelRows,
+                                    [&](int begin, int end) {
+    auto error_rows = error.middleRows(begin, end - begin);
+    error_rows -= y.middleRows(begin, end - begin);
+    if (relative_)
+      error_rows /= y.middleRows(begin, end - begin);
+  });
+  return error;
+}
+
+Eigen::ArrayXd ExplicitRegression::EvaluateFitnessVectorAtRows(
+    Equation &individual, const Eigen::ArrayXi &rows) const {
+  ++ eval_count_;
+  auto view = dynamic_cast<ExplicitTrainingDataView*>(training_data_);
+  if (view != nullptr) {
+    Eigen::ArrayXi view_rows = (*view->rows)(rows);
+    return fitness_vector_at_rows(individual, view->data, view_rows);
+  }
+  return fitness_vector_at_rows(
+      individual, *(ExplicitTrainingData*)training_data_, rows);
+}
+
+Eigen::ArrayXd ExplicitRegression::fitness_vector_at_rows(
+    Equation &individual, const ExplicitTrainingData &data,
+    const Eigen::Ref<const Eigen::ArrayXi> &rows) const {
+  // the rows of y are gathered a block at a time, as those of x are
+  const TrainingArray &y = data.y;
+  Eigen::ArrayXXd error = individual.EvaluateEquationAtRows(data.x, rows);
+  GetThreadPool()->ParallelForBlocks(error.rows(), kMinParallelRows,
+                                    [&](int begin, int end) {
+    auto error_rows = error.middleRows(begin, end - begin);
+    auto y_rows = y(rows.segment(begin, end - begin), Eigen::all);
+    error_rows -= y_rows;
+    if (relative_)
+      error_rows /= y_rows;
+  });
   return error;
 }
 
 FitnessVectorAndJacobian ExplicitRegression::GetFitnessVectorAndJacobian(
     Equation &individual) const {
+  Eigen::ArrayXXd error, df_dc;
+  std::tie(error, df_dc) = GetFitnessVectorsAndJacobians(individual);
+  return FitnessVectorAndJacobian{error, df_dc};
+}
+
+// the derivatives of the rows of a view are taken on a copy of the rows
+FitnessVectorsAndJacobians ExplicitRegression::GetFitnessVectorsAndJacobians(
+    Equation &individual) const {
   ++ eval_count_;
-  Eigen::ArrayXXd f_of_x, df_dc;
-  const Eigen::ArrayXXd x = ((ExplicitTrainingData*)training_data_)->x;
-  std::tie(f_of_x, df_dc) = individual.EvaluateEquationWithLocalOptGradientAt(x);
+  auto view = dynamic_cast<ExplicitTrainingDataView*>(training_data_);
+  if (view != nullptr) {
+    std::unique_ptr<ExplicitTrainingData> data(view->Gather());
+    return fitness_vectors_and_jacobians(individual, data->x, data->y);
+  }
+  const ExplicitTrainingData &data = *(ExplicitTrainingData*)training_data_;
+  return fitness_vectors_and_jacobians(individual, data.x, data.y);
+}
 
-  Eigen::ArrayXXd error = f_of_x - ((ExplicitTrainingData*)training_data_)->y;
+std::vector<NormalEquations> ExplicitRegression::GetNormalEquations(
+    Equation &individual) const {
+  ++ eval_count_;
+  auto view = dynamic_cast<ExplicitTrainingDataView*>(training_data_);
+  if (view != nullptr) {
+    std::unique_ptr<ExplicitTrainingData> data(view->Gather());
+    return normal_equations(individual, data->x, data->y);
+  }
+  const ExplicitTrainingData &data = *(ExplicitTrainingData*)training_data_;
+  return normal_equations(individual, data.x, data.y);
+}
+
+FitnessVectorsAndJacobians ExplicitRegression::fitness_vectors_and_jacobians(
+    Equation &individual, const TrainingArray &x,
+    const TrainingArray &y) const {
+  Eigen::ArrayXXd error, df_dc;
+  std::tie(error, df_dc) = individual.EvaluateEquationWithLocalOptGradientAt(x);
+
+  // one column of error per set of constants
+  error.colwise() -= y.col(0);
   if (relative_) {
-    error /= ((ExplicitTrainingData*)training_data_)->y;
-    df_dc.colwise() /= ((ExplicitTrainingData*)training_data_)->y(Eigen::all, 0);
+    error.colwise() /= y.col(0);
+    df_dc.colwise() /= y.col(0);
   }
-  return FitnessVectorAndJacobian{error, df_dc};
+  return FitnessVectorsAndJacobians{error, df_dc};
+}
+
+std::vector<NormalEquations> ExplicitRegression::normal_equations(
+    Equation &individual, const TrainingArray &x,
+    const TrainingArray &y) const {
+  if (relative_) {
+    Eigen::ArrayXd weights = y.col(0).inverse();
+    return individual.EvaluateNormalEquationsAt(x, y.col(0), weights);
+  }
+  return individual.EvaluateNormalEquationsAt(x, y.col(0));
 }
 
 ExplicitRegressionState ExplicitRegression::DumpState() {
+  auto view = dynamic_cast<ExplicitTrainingDataView*>(training_data_);
+  if (view != nullptr) {
+    std::unique_ptr<ExplicitTrainingData> data(view->Gather());
+    return ExplicitRegressionState(data->DumpState(), metric_, eval_count_);
+  }
   return ExplicitRegressionState(
           ((ExplicitTrainingData*)training_data_)->DumpState(),
           metric_, eval_count_);
@@ -0,0 +1,93 @@
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <utility>
+
+#include <bingocpp/fitness_function.h>
+
+namespace bingo {
+
+namespace {
+
+// The raw output of std::mt19937 and std::seed_seq is the same with every
+// standard library, unlike the standard distributions, so a minibatch is
+// drawn from its seed the same way everywhere
+std::mt19937 minibatch_generator(unsigned int seed, int draw) {
+  std::seed_seq sequence{seed, static_cast<unsigned int>(draw)};
+  return std::mt19937(sequence);
+}
+
+// Lemire's multiply-shift: the high word of draw * n is uniform in
+// [0, n) once the low words below 2^32 mod n are rejected
+int uniform_below(std::mt19937 &generator, int n) {
+  std::uint32_t range = static_cast<std::uint32_t>(n);
+  std::uint64_t product =
+      static_cast<std::uint64_t>(static_cast<std::uint32_t>(generator())) *
+      range;
+  if (static_cast<std::uint32_t>(product) < range) {
+    std::uint32_t threshold = -range % range;
+    while (static_cast<std::uint32_t>(product) < threshold) {
+      product = static_cast<std::uint64_t>(
+          static_cast<std::uint32_t>(generator())) * range;
+    }
+  }
+  return static_cast<int>(product >> 32);
+}
+} // namespace
+
+void VectorBasedFunction::SetMinibatch(int size, MinibatchSampling sampling,
+                                       unsigned int seed) {
+  if (size < 0) {
+    throw std::invalid_argument("Minibatch size must not be negative");
+  }
+  minibatch_size_ = size;
+  minibatch_sampling_ = sampling;
+  minibatch_seed_ = seed;
+  SetMinibatchIndex(0);
+}
+
+void VectorBasedFunction::SetMinibatchIndex(int index) {
+  if (index < 0) {
+    throw std::invalid_argument("Minibatch index must not be negative");
+  }
+  minibatch_index_ = index;
+  int num_rows = training_data_ != nullptr ? training_data_->Size() : 0;
+  int size = std::min(minibatch_size_, num_rows);
+  minibatch_rows_.resize(size);
+  if (size == 0) {
+    return;
+  }
+
+  if (minibatch_sampling_ == kStratifiedMinibatch) {
+    std::mt19937 generator = minibatch_generator(minibatch_seed_, index);
+    for (int i = 0; i < size; ++i) {
+      int begin = static_cast<long>(num_rows) * i / size;
+      int end = static_cast<long>(num_rows) * (i + 1) / size;
+      minibatch_rows_(i) = begin + uniform_below(generator, end - begin);
+    }
+    return;
+  }
+
+  // every row is in one slice of the permutation of each epoch, except
+  // for the remainder of the rows not filling a whole slice
+  int slices_per_epoch = num_rows / size;
+  int epoch = index / slices_per_epoch;
+  int slice = index % slices_per_epoch;
+  // the permutation is shuffled once per epoch, not once per minibatch
+  if (epoch != permutation_epoch_ || minibatch_seed_ != permutation_seed_ ||
+      num_rows != permutation_.size()) {
+    std::mt19937 generator = minibatch_generator(minibatch_seed_, epoch);
+    permutation_ = Eigen::ArrayXi::LinSpaced(num_rows, 0, num_rows - 1);
+    for (int i = num_rows - 1; i > 0; --i) {
+      std::swap(permutation_(i), permutation_(uniform_below(generator, i + 1)));
+    }
+    permutation_epoch_ = epoch;
+    permutation_seed_ = minibatch_seed_;
+  }
+  // in order, so that the rows are gathered front to back
+  minibatch_rows_ = permutation_.segment(slice * size, size);
+  std::sort(minibatch_rows_.data(), minibatch_rows_.data() + size);
+}
+
+} // namespace bingo
@@ -2,6 +2,7 @@
 #include <bingocpp/gradient_mixin.h>
 
 #include <tuple>
+#include <vector>
 
 namespace bingo {
 
@@ -28,4 +29,26 @@ FitnessAndGradient VectorGradientMixin::GetIndividualFitnessAndGradient(Equation
   return FitnessAndGradient{fitness, metric_derivative_(fitness_vector, jacobian.transpose())};
 }
 
+FitnessVectorsAndJacobians VectorGradientMixin::GetFitnessVectorsAndJacobians(Equation &individual) const {
+  Eigen::ArrayXd fitness_vector;
+  Eigen::ArrayXXd jacobian;
+  std::tie(fitness_vector, jacobian) = this->GetFitnessVectorAndJacobian(individual);
+  return FitnessVectorsAndJacobians{fitness_vector, jacobian};
+}
+
+std::vector<NormalEquations> VectorGradientMixin::GetNormalEquations(Equation &individual) const {
+  Eigen::ArrayXXd fitness_vectors, jacobians;
+  std::tie(fitness_vectors, jacobians) = this->GetFitnessVectorsAndJacobians(individual);
+  int num_sets = fitness_vectors.cols();
+  int num_params = num_sets > 0 ? jacobians.cols() / num_sets : 0;
+  std::vector<NormalEquations> normal_equations;
+  for (int set = 0; set < num_sets; ++set) {
+    normal_equations.emplace_back(num_params);
+    normal_equations.back().Accumulate(
+        jacobians.middleCols(set * num_params, num_params).matrix(),
+        fitness_vectors.col(set).matrix());
+  }
+  return normal_equations;
+}
+
 } // namespace bingo
@@ -1,3 +1,5 @@
+#include <memory>
+
 #include <Eigen/Dense>
 #include <Eigen/Core>
 
@@ -6,11 +8,14 @@
 namespace bingo {
 
 ImplicitTrainingData *ImplicitTrainingData::GetItem(int item) {
-  return new ImplicitTrainingData(x.row(item), dx_dt.row(item));
+  return GetRange(item, item + 1);
 }
 
 ImplicitTrainingData *ImplicitTrainingData::GetItem(
     const std::vector<int> &items) {
+  if (IsRange(items)) {
+    return GetRange(items.front(), items.back() + 1);
+  }
   Eigen::ArrayXXd temp_in(items.size(), x.cols());
   Eigen::ArrayXXd temp_out(items.size(), dx_dt.cols());
 
@@ -21,31 +26,65 @@ ImplicitTrainingData *ImplicitTrainingData::GetItem(
   return new ImplicitTrainingData(temp_in, temp_out);
 }
 
+ImplicitTrainingData *ImplicitTrainingData::GetRange(int begin, int end) {
+  return new ImplicitTrainingData(RowsOf(x, begin, end),
+                                  RowsOf(dx_dt, begin, end), owner_);
+}
+
 ImplicitRegressionState ImplicitRegression::DumpState() {
+  auto view = dynamic_cast<ImplicitTrainingDataView*>(training_data_);
+  if (view != nullptr) {
+    std::unique_ptr<ImplicitTrainingData> data(view->Gather());
+    return ImplicitRegressionState(data->DumpState(), metric_,
+                                   required_params_, eval_count_);
+  }
   return ImplicitRegressionState(
             ((ImplicitTrainingData*)training_data_)->DumpState(),
                       metric_, required_params_, eval_count_);
 }
 
-Eigen::ArrayXXd dfdx_dot_dfdt(const Eigen::ArrayXXd &dx_dt,
+Eigen::ArrayXXd dfdx_dot_dfdt(const Eigen::Ref<const Eigen::ArrayXXd> &dx_dt,
                               const Eigen::ArrayXXd &grad);
 bool not_enough_parameters_used(int required_params, 
                                 const Eigen::ArrayXXd &dot_product);
 
 Eigen::ArrayXd ImplicitRegression::EvaluateFitnessVector(
     Equation &individual) const {
+  auto view = dynamic_cast<ImplicitTrainingDataView*>(training_data_);
+  if (view != nullptr) {
+    std::unique_ptr<ImplicitTrainingData> data(view->Gather());
+    return fitness_vector(individual, data->x, data->dx_dt);
+  }
+  return fitness_vector(individual,
+                        ((ImplicitTrainingData*)training_data_)->x,
+                        ((ImplicitTrainingData*)training_data_)->dx_dt);
+}
+
+Eigen::ArrayXd ImplicitRegression::EvaluateFitnessVectorAtRows(
+    Equation &individual, const Eigen::ArrayXi &rows) const {
+  std::vector<int> items(rows.data(), rows.data() + rows.size());
+  auto view = dynamic_cast<ImplicitTrainingDataView*>(training_data_);
+  if (view != nullptr) {
+    std::unique_ptr<ImplicitTrainingDataView> rows_view(view->GetItem(items));
+    std::unique_ptr<ImplicitTrainingData> data(rows_view->Gather());
+    return fitness_vector(individual, data->x, data->dx_dt);
+  }
+  std::unique_ptr<ImplicitTrainingData> data(
+      ((ImplicitTrainingData*)training_data_)->GetItem(items));
+  return fitness_vector(individual, data->x, data->dx_dt);
+}
+
+Eigen::ArrayXd ImplicitRegression::fitness_vector(
+    Equation &individual, const TrainingArray &x,
+    const TrainingArray &dx_dt) const {
   EvalAndDerivative eval_and_grad 
-      = individual.EvaluateEquationWithXGradientAt(
-      ((ImplicitTrainingData*)training_data_)->x);
-  Eigen::ArrayXXd dot_product = dfdx_dot_dfdt(
-      ((ImplicitTrainingData*)training_data_)->dx_dt,
-      eval_and_grad.second);
+      = individual.EvaluateEquationWithXGradientAt(x);
+  Eigen::ArrayXXd dot_product = dfdx_dot_dfdt(dx_dt, eval_and_grad.second);
 
   if (required_params_ != kNoneRequired
       && not_enough_parameters_used(required_params_, dot_product)) {
     return Eigen::ArrayXd::Constant(
-        ((ImplicitTrainingData*)training_data_)->x.rows(),
-         std::numeric_limits<double>::infinity());
+        x.rows(), std::numeric_limits<double>::infinity());
   }
   // NOTE tylertownsend: may need to verify eigen NaN conditions
   Eigen::ArrayXXd denominator = dot_product.abs().rowwise().sum();
@@ -56,11 +95,9 @@ Eigen::ArrayXd ImplicitRegression::EvaluateFitnessVector(
   });
 }
 
-Eigen::ArrayXXd dfdx_dot_dfdt(const Eigen::ArrayXXd &dx_dt,
+Eigen::ArrayXXd dfdx_dot_dfdt(const Eigen::Ref<const Eigen::ArrayXXd> &dx_dt,
                               const Eigen::ArrayXXd &grad) {
-  Eigen::ArrayXXd left_dot = grad;
-  Eigen::ArrayXXd right_dot = dx_dt;
-  return left_dot * right_dot;
+  return grad * dx_dt;
 }
 
 bool not_enough_parameters_used(int required_params, 
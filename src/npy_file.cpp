@@ -0,0 +1,220 @@
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <Eigen/Dense>
+
+#include "bingocpp/npy_file.h"
+
+namespace bingo {
+
+namespace {
+
+// A read-only mapping of a whole file
+class FileMapping {
+ public:
+  explicit FileMapping(const std::string &path) {
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+      throw std::runtime_error("Cannot open " + path);
+    }
+    struct stat status;
+    if (fstat(file, &status) != 0) {
+      close(file);
+      throw std::runtime_error("Cannot read the size of " + path);
+    }
+    size_ = status.st_size;
+    if (size_ > 0) {
+      data_ = mmap(nullptr, size_, PROT_READ, MAP_SHARED, file, 0);
+    }
+    // the mapping keeps the file itself open
+    close(file);
+    if (data_ == MAP_FAILED) {
+      throw std::runtime_error("Cannot map " + path);
+    }
+  }
+
+  FileMapping(const FileMapping &) = delete;
+  FileMapping &operator=(const FileMapping &) = delete;
+
+  ~FileMapping() {
+    if (data_ != nullptr) {
+      munmap(data_, size_);
+    }
+  }
+
+  const char *Data() const { return static_cast<const char *>(data_); }
+
+  std::size_t Size() const { return size_; }
+
+ private:
+  void *data_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+struct NpyHeader {
+  std::string descr;
+  bool fortran_order;
+  std::vector<Eigen::Index> shape;
+  std::size_t data_offset;
+};
+
+// The text following "'key':" in the header dictionary
+std::string header_value(const std::string &header, const std::string &key,
+                         const std::string &path) {
+  std::size_t key_start = header.find("'" + key + "'");
+  std::size_t colon = header.find(':', key_start);
+  if (key_start == std::string::npos || colon == std::string::npos) {
+    throw std::invalid_argument(path + " has no " + key + " in its header");
+  }
+  std::size_t value_start = header.find_first_not_of(' ', colon + 1);
+  if (value_start == std::string::npos) {
+    throw std::invalid_argument(path + " has no value for " + key +
+                                " in its header");
+  }
+  return header.substr(value_start);
+}
+
+NpyHeader read_npy_header(const FileMapping &file, const std::string &path) {
+  const char *data = file.Data();
+  const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+  if (file.Size() < 10 || std::memcmp(data, "\x93NUMPY", 6) != 0) {
+    throw std::invalid_argument(path + " is not a .npy file");
+  }
+  if (bytes[6] < 1 || bytes[6] > 3) {
+    throw std::invalid_argument(path + " has an unknown .npy version");
+  }
+  // version 1 has a 2 byte header length, later versions 4 bytes
+  std::size_t header_start = bytes[6] == 1 ? 10 : 12;
+  if (file.Size() < header_start) {
+    throw std::invalid_argument(path + " has a truncated header");
+  }
+  std::size_t header_length = 0;
+  for (std::size_t i = header_start - 1; i >= 8; --i) {
+    header_length = header_length << 8 | bytes[i];
+  }
+  if (header_start + header_length > file.Size()) {
+    throw std::invalid_argument(path + " has a truncated header");
+  }
+  std::string header(data + header_start, header_length);
+
+  NpyHeader npy_header;
+  npy_header.data_offset = header_start + header_length;
+  // the type is quoted, as '<f8'
+  std::string descr = header_value(header, "descr", path);
+  npy_header.descr =
+      descr.empty() ? "" : descr.substr(1, descr.find(descr[0], 1) - 1);
+  npy_header.fortran_order =
+      header_value(header, "fortran_order", path).compare(0, 4, "True") == 0;
+  std::string shape = header_value(header, "shape", path);
+  std::size_t shape_end = shape.find(')');
+  if (shape[0] != '(' || shape_end == std::string::npos) {
+    throw std::invalid_argument(path + " has a malformed shape");
+  }
+  std::string dimensions = shape.substr(1, shape_end - 1);
+  for (char &c : dimensions) {
+    if (c == ',') {
+      c = ' ';
+    }
+  }
+  std::istringstream dimension_stream(dimensions);
+  Eigen::Index dimension;
+  while (dimension_stream >> dimension) {
+    npy_header.shape.push_back(dimension);
+  }
+  if (!dimension_stream.eof()) {
+    throw std::invalid_argument(path + " has a malformed shape");
+  }
+  return npy_header;
+}
+
+bool is_little_endian() {
+  const std::uint16_t one = 1;
+  return *reinterpret_cast<const unsigned char *>(&one) == 1;
+}
+
+std::shared_ptr<const void> owner_of_both(std::shared_ptr<const void> first,
+                                          std::shared_ptr<const void> second) {
+  typedef std::pair<std::shared_ptr<const void>, std::shared_ptr<const void>>
+      Owners;
+  return std::make_shared<const Owners>(std::move(first), std::move(second));
+}
+
+void check_same_rows(const LoadedArray &first, const LoadedArray &second,
+                     const std::string &second_path) {
+  if (first.values.rows() != second.values.rows()) {
+    throw std::invalid_argument(second_path +
+                                " does not have the rows of x");
+  }
+}
+} // namespace
+
+LoadedArray MapNpyFile(const std::string &path) {
+  auto file = std::make_shared<const FileMapping>(path);
+  NpyHeader header = read_npy_header(*file, path);
+  if (header.descr != "<f8" || !is_little_endian()) {
+    throw std::invalid_argument(path + " must hold little-endian float64");
+  }
+  if (header.shape.size() > 2) {
+    throw std::invalid_argument(path + " must have one or two dimensions");
+  }
+  Eigen::Index rows = header.shape.size() > 0 ? header.shape[0] : 1;
+  Eigen::Index cols = header.shape.size() > 1 ? header.shape[1] : 1;
+  if (rows < 0 || cols < 0) {
+    throw std::invalid_argument(path + " has a negative dimension");
+  }
+  // compared by division, since rows * cols can overflow
+  std::size_t num_doubles =
+      (file->Size() - header.data_offset) / sizeof(double);
+  if (cols != 0 && static_cast<std::size_t>(rows) > num_doubles / cols) {
+    throw std::invalid_argument(path + " is shorter than its shape");
+  }
+
+  const double *values =
+      reinterpret_cast<const double *>(file->Data() + header.data_offset);
+  bool aligned = header.data_offset % sizeof(double) == 0;
+  if (aligned && (header.fortran_order || rows == 1 || cols == 1)) {
+    return LoadedArray{
+        TrainingArray(values, rows, cols, Eigen::OuterStride<>(rows)), file};
+  }
+  typedef Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+      RowMajorArray;
+  auto copy = std::make_shared<Eigen::ArrayXXd>(rows, cols);
+  if (header.fortran_order) {
+    *copy = Eigen::Map<const Eigen::ArrayXXd>(values, rows, cols);
+  } else {
+    *copy = Eigen::Map<const RowMajorArray>(values, rows, cols);
+  }
+  return LoadedArray{ViewOf(*copy), copy};
+}
+
+ExplicitTrainingData *LoadExplicitTrainingData(const std::string &x_path,
+                                               const std::string &y_path) {
+  LoadedArray x = MapNpyFile(x_path);
+  LoadedArray y = MapNpyFile(y_path);
+  check_same_rows(x, y, y_path);
+  return new ExplicitTrainingData(x.values, y.values,
+                                  owner_of_both(x.owner, y.owner));
+}
+
+ImplicitTrainingData *LoadImplicitTrainingData(const std::string &x_path,
+                                               const std::string &dx_dt_path) {
+  LoadedArray x = MapNpyFile(x_path);
+  LoadedArray dx_dt = MapNpyFile(dx_dt_path);
+  check_same_rows(x, dx_dt, dx_dt_path);
+  if (x.values.cols() != dx_dt.values.cols()) {
+    throw std::invalid_argument(dx_dt_path + " does not have the shape of x");
+  }
+  return new ImplicitTrainingData(x.values, dx_dt.values,
+                                  owner_of_both(x.owner, dx_dt.owner));
+}
+
+} // namespace bingo
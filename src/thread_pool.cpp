@@ -0,0 +1,193 @@
+#include <algorithm>
+
+#include "bingocpp/thread_pool.h"
+
+namespace bingo {
+
+namespace {
+
+// Loops started from a worker are run serially, since the pool is busy
+thread_local bool in_pool_worker = false;
+
+std::mutex shared_pool_mutex;
+std::shared_ptr<ThreadPool> shared_pool;
+
+int hardware_threads() {
+  return std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+}
+} // namespace
+
+ThreadPool::ThreadPool(int num_threads) :
+    task_(nullptr), generation_(0), busy_workers_(0), stop_(false) {
+  if (num_threads <= 0) {
+    num_threads = hardware_threads();
+  }
+  ranges_.reset(new TaskRange[num_threads]);
+  for (int id = 1; id < num_threads; ++id) {
+    workers_.emplace_back(&ThreadPool::worker_loop, this, id);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  wake_.notify_all();
+  for (std::thread &worker : workers_) {
+    worker.join();
+  }
+}
+
+int ThreadPool::GetNumThreads() const {
+  return workers_.size() + 1;
+}
+
+void ThreadPool::ParallelFor(int num_tasks,
+                             const std::function<void(int)> &task) {
+  if (workers_.empty() || in_pool_worker || num_tasks <= 1) {
+    for (int i = 0; i < num_tasks; ++i) {
+      task(i);
+    }
+    return;
+  }
+
+  std::lock_guard<std::mutex> loop_lock(loop_mutex_);
+  int num_threads = GetNumThreads();
+  for (int id = 0; id < num_threads; ++id) {
+    ranges_[id].begin = static_cast<long>(num_tasks) * id / num_threads;
+    ranges_[id].end = static_cast<long>(num_tasks) * (id + 1) / num_threads;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    task_ = &task;
+    error_ = nullptr;
+    busy_workers_ = workers_.size();
+    ++generation_;
+  }
+  wake_.notify_all();
+
+  in_pool_worker = true;
+  run_tasks(0);
+  in_pool_worker = false;
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_.wait(lock, [this] { return busy_workers_ == 0; });
+  task_ = nullptr;
+  if (error_) {
+    std::exception_ptr error = error_;
+    error_ = nullptr;
+    std::rethrow_exception(error);
+  }
+}
+
+void ThreadPool::ParallelForBlocks(int num_items, int block_size,
+                                   const std::function<void(int, int)> &task) {
+  if (num_items <= 0) {
+    return;
+  }
+  int num_blocks = std::max(num_items / std::max(block_size, 1), 1);
+  ParallelFor(num_blocks, [&](int block) {
+    int begin = static_cast<long>(num_items) * block / num_blocks;
+    int end = static_cast<long>(num_items) * (block + 1) / num_blocks;
+    task(begin, end);
+  });
+}
+
+void ThreadPool::worker_loop(int id) {
+  in_pool_worker = true;
+  unsigned long seen_generation = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_.wait(lock, [&] {
+        return stop_ || generation_ != seen_generation;
+      });
+      if (stop_) {
+        return;
+      }
+      seen_generation = generation_;
+    }
+    run_tasks(id);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (--busy_workers_ == 0) {
+        done_.notify_one();
+      }
+    }
+  }
+}
+
+void ThreadPool::run_tasks(int id) {
+  int task;
+  while (next_task(id, task)) {
+    try {
+      (*task_)(task);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!error_) {
+        error_ = std::current_exception();
+      }
+    }
+  }
+}
+
+bool ThreadPool::next_task(int id, int &task) {
+  {
+    std::lock_guard<std::mutex> lock(ranges_[id].mutex);
+    if (ranges_[id].begin < ranges_[id].end) {
+      task = ranges_[id].begin++;
+      return true;
+    }
+  }
+
+  // steal the back half of the first thread with work left
+  int num_threads = GetNumThreads();
+  for (int offset = 1; offset < num_threads; ++offset) {
+    TaskRange &victim = ranges_[(id + offset) % num_threads];
+    int stolen_begin;
+    int stolen_end;
+    {
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      int remaining = victim.end - victim.begin;
+      if (remaining <= 0) {
+        continue;
+      }
+      stolen_end = victim.end;
+      stolen_begin = victim.end - (remaining + 1) / 2;
+      victim.end = stolen_begin;
+    }
+    std::lock_guard<std::mutex> lock(ranges_[id].mutex);
+    ranges_[id].begin = stolen_begin + 1;
+    ranges_[id].end = stolen_end;
+    task = stolen_begin;
+    return true;
+  }
+  return false;
+}
+
+std::shared_ptr<ThreadPool> GetThreadPool() {
+  std::lock_guard<std::mutex> lock(shared_pool_mutex);
+  if (!shared_pool) {
+    shared_pool = std::make_shared<ThreadPool>();
+  }
+  return shared_pool;
+}
+
+void SetNumThreads(int num_threads) {
+  std::shared_ptr<ThreadPool> pool = std::make_shared<ThreadPool>(num_threads);
+  {
+    std::lock_guard<std::mutex> lock(shared_pool_mutex);
+    shared_pool.swap(pool);
+  }
+  // the old pool is joined here unless a loop still holds it
+}
+
+int GetNumThreads() {
+  return GetThreadPool()->GetNumThreads();
+}
+
+bool UseRowParallelism(int num_individuals, int num_rows) {
+  return num_rows >= kMinParallelRows && num_individuals < GetNumThreads();
+}
+} // namespace bingo
@@ -5,7 +5,9 @@
 #include <gtest/gtest.h>
 
 #include <bingocpp/agraph/evaluation_backend/evaluation_backend.h>
+#include <bingocpp/agraph/operator_definitions.h>
 #include <bingocpp/agraph/simplification_backend/simplification_backend.h>
+#include <bingocpp/thread_pool.h>
 
 #include "testing_utils.h"
 #include "test_fixtures.h"
@@ -18,6 +20,14 @@ namespace {
 
 const int N_OPS = 13;
 
+EvaluationOptions with_workspace(EvaluationWorkspace &workspace,
+                                 EvaluationCache *cache = nullptr) {
+  EvaluationOptions options;
+  options.workspace = &workspace;
+  options.cache = cache;
+  return options;
+}
+
 struct AGraphValues {
 Eigen::ArrayXXd x_vals;
 Eigen::ArrayXXd constants;
@@ -178,6 +188,550 @@ TEST_F(AGraphBackend, evaluate_and_derivative) {
   ASSERT_TRUE(testutils::almost_equal(y_and_dy.second, dy_true));
 }
 
+TEST_F(AGraphBackend, evaluate_with_workspace) {
+  EvaluationWorkspace workspace;
+  EvaluationPlan plan(simple_stack);
+  Eigen::ArrayXXd y_true = Evaluate(simple_stack, x, constants);
+  Eigen::ArrayXXd y = Evaluate(plan, x, constants, with_workspace(workspace));
+  ASSERT_TRUE(testutils::almost_equal(y, y_true));
+
+  const double *first_buffer = workspace.forward_eval[0].data();
+  Evaluate(EvaluationPlan(simple_stack2), x, constants,
+           with_workspace(workspace));
+  y = Evaluate(plan, x, constants, with_workspace(workspace));
+  ASSERT_TRUE(testutils::almost_equal(y, y_true));
+  ASSERT_EQ(first_buffer, workspace.forward_eval[0].data());
+}
+
+TEST_F(AGraphBackend, evaluate_and_derivative_with_workspace) {
+  EvaluationWorkspace workspace;
+  EvaluationPlan plan(simple_stack);
+  std::pair<Eigen::ArrayXXd, Eigen::ArrayXXd> y_and_dy =
+    EvaluateWithDerivative(simple_stack, x, constants, false);
+  for (int i = 0; i < 2; ++i) {
+    EvaluateWithDerivative(plan, x, constants, false,
+                           with_workspace(workspace));
+    ASSERT_TRUE(testutils::almost_equal(workspace.evaluation, y_and_dy.first));
+    ASSERT_TRUE(testutils::almost_equal(workspace.derivative, y_and_dy.second));
+  }
+}
+
+TEST_F(AGraphBackend, evaluation_plan_drops_unused_commands) {
+  EvaluationPlan plan(simple_stack);
+  ASSERT_EQ(plan.GetInstructions(false).size(), 8u);
+  ASSERT_EQ(plan.GetInstructions(true).size(), 8u);
+  ASSERT_FALSE(plan.IsEmpty());
+  ASSERT_TRUE(EvaluationPlan(Eigen::ArrayX3i(0, 3)).IsEmpty());
+}
+
+TEST_F(AGraphBackend, evaluation_plan_reuses_slots) {
+  EvaluationPlan plan(simple_stack);
+  ASSERT_LT(plan.GetNumSlots(false), 8);
+  ASSERT_LE(plan.GetNumSlots(false), plan.GetNumSlots(true));
+  for (const Instruction &instruction : plan.GetInstructions(false)) {
+    if (instruction.node > Op::kConstant) {
+      ASSERT_NE(instruction.result, instruction.param1);
+      ASSERT_NE(instruction.result, instruction.param2);
+    }
+  }
+}
+
+TEST_F(AGraphBackend, evaluate_with_plan) {
+  EvaluationPlan plan(simple_stack);
+  ASSERT_TRUE(testutils::almost_equal(Evaluate(plan, x, constants),
+                                      Evaluate(simple_stack, x, constants)));
+  ASSERT_TRUE(testutils::almost_equal(Evaluate(plan, x, constants_2d),
+                                      Evaluate(simple_stack, x, constants_2d)));
+}
+
+TEST_F(AGraphBackend, evaluate_and_derivative_with_plan) {
+  EvaluationPlan plan(simple_stack);
+  for (bool param_x_or_c : {true, false}) {
+    std::pair<Eigen::ArrayXXd, Eigen::ArrayXXd> expected =
+      EvaluateWithDerivative(simple_stack, x, constants, param_x_or_c);
+    std::pair<Eigen::ArrayXXd, Eigen::ArrayXXd> y_and_dy =
+      EvaluateWithDerivative(plan, x, constants, param_x_or_c);
+    ASSERT_TRUE(testutils::almost_equal(y_and_dy.first, expected.first));
+    ASSERT_TRUE(testutils::almost_equal(y_and_dy.second, expected.second));
+  }
+}
+
+TEST_F(AGraphBackend, evaluation_plan_resolves_kernels) {
+  EvaluationPlan plan(simple_stack);
+  for (const Instruction &instruction : plan.GetInstructions(true)) {
+    ASSERT_EQ(instruction.forward, GetForwardKernel(instruction.node));
+    ASSERT_EQ(instruction.reverse, GetReverseKernel(instruction.node));
+  }
+}
+
+TEST_F(AGraphBackend, evaluation_plan_unknown_operator_throws) {
+  Eigen::ArrayX3i stack(2, 3);
+  stack << 0, 0, 0,
+           100, 0, 0;
+  ASSERT_THROW(EvaluationPlan plan(stack), std::runtime_error);
+}
+
+TEST_F(AGraphBackend, evaluation_plan_shapes) {
+  Eigen::ArrayX3i stack(5, 3);
+  stack << -1, 2, 2,
+            1, 0, 0,
+            4, 0, 1,
+            0, 0, 0,
+            2, 2, 3;
+  EvaluationPlan plan(stack);
+  const std::vector<Instruction> &instructions = plan.GetInstructions(false);
+  ASSERT_EQ(instructions[0].shape, kScalarShape);
+  ASSERT_EQ(instructions[1].shape, kRowShape);
+  ASSERT_EQ(instructions[2].shape, kRowShape);
+  ASSERT_EQ(instructions[3].shape, kColumnShape);
+  ASSERT_EQ(instructions[4].shape, kFullShape);
+}
+
+TEST_F(AGraphBackend, evaluation_plan_activity) {
+  // c0 * sin(x0) + x1
+  Eigen::ArrayX3i stack(6, 3);
+  stack << 0, 0, 0,
+           6, 0, 0,
+           1, 0, 0,
+           4, 2, 1,
+           0, 1, 1,
+           2, 3, 4;
+  EvaluationPlan plan(stack);
+  ASSERT_EQ(plan.GetNumAdjoints(kRowShape), 3);
+  ASSERT_EQ(plan.GetAdjoints(kRowShape), std::vector<int>({3, 3, 0, 1, 3, 2}));
+  ASSERT_EQ(plan.GetNumAdjoints(kColumnShape), 5);
+  ASSERT_EQ(plan.GetAdjoints(kColumnShape), std::vector<int>({0, 1, 5, 2, 3, 4}));
+  ASSERT_EQ(plan.GetNumAdjoints(kFullShape), 6);
+
+  Eigen::ArrayXXd c = Eigen::ArrayXXd::Constant(1, 1, 2.0);
+  EvaluationWorkspace workspace;
+  EvaluateWithDerivative(plan, x, c, false, with_workspace(workspace));
+  ASSERT_TRUE(testutils::almost_equal(workspace.derivative,
+                                      x.col(0).sin()));
+  EvaluateWithDerivative(plan, x, c, true, with_workspace(workspace));
+  ASSERT_TRUE(testutils::almost_equal(workspace.derivative.col(0),
+                                      2.0 * x.col(0).cos()));
+  ASSERT_TRUE(testutils::almost_equal(workspace.derivative.col(1),
+                                      Eigen::ArrayXd::Ones(x.rows())));
+
+  // a result without the targets has no active instructions
+  EvaluationPlan constant_plan(testutils::stack_unary_operator(6, 1));
+  ASSERT_EQ(constant_plan.GetNumAdjoints(kColumnShape), 0);
+  EvaluateWithDerivative(constant_plan, x, c, true,
+                         with_workspace(workspace));
+  ASSERT_TRUE(workspace.derivative.isZero());
+}
+
+TEST_F(AGraphBackend, evaluation_cache_keeps_constant_free_values) {
+  // c0 * sin(x0 * x1) + exp(x1) - c1
+  Eigen::ArrayX3i stack(10, 3);
+  stack << 0, 0, 0,
+           0, 1, 1,
+           4, 0, 1,
+           6, 2, 2,
+           1, 0, 0,
+           4, 4, 3,
+           8, 1, 1,
+           2, 5, 6,
+           1, 1, 1,
+           3, 7, 8;
+  EvaluationPlan plan(stack);
+  ASSERT_EQ(plan.GetNumCachedValues(), 2);
+  ASSERT_TRUE(plan.GetInstructions(false)[3].cached);
+  ASSERT_TRUE(plan.GetInstructions(false)[6].cached);
+
+  Eigen::ArrayXXd large_x = Eigen::ArrayXXd::Random(1000, 2);
+  EvaluationCache cache;
+  for (int tile_rows : {1000, 64}) {
+    cache.Clear();
+    EvaluationWorkspace cached;
+    cached.tile_rows = tile_rows;
+    EvaluationWorkspace uncached;
+    for (int i = 0; i < 3; ++i) {
+      Eigen::ArrayXXd c = Eigen::ArrayXXd::Random(2, i + 1);
+      ASSERT_TRUE(testutils::almost_equal(
+        Evaluate(plan, large_x, c, with_workspace(cached, &cache)),
+        Evaluate(plan, large_x, c, with_workspace(uncached))));
+      ASSERT_TRUE(cache.IsFilledFor(large_x));
+      EvaluateWithDerivative(plan, large_x, c, false,
+                             with_workspace(cached, &cache));
+      EvaluateWithDerivative(plan, large_x, c, false,
+                             with_workspace(uncached));
+      ASSERT_TRUE(testutils::almost_equal(cached.evaluation,
+                                          uncached.evaluation));
+      ASSERT_TRUE(testutils::almost_equal(cached.derivative,
+                                          uncached.derivative));
+    }
+  }
+
+  // other x is evaluated anew
+  Eigen::ArrayXXd other_x = large_x + 1.0;
+  ASSERT_FALSE(cache.IsFilledFor(other_x));
+  EvaluationOptions cached_options;
+  cached_options.cache = &cache;
+  ASSERT_TRUE(testutils::almost_equal(
+    Evaluate(plan, other_x, constants_2d, cached_options),
+    Evaluate(plan, other_x, constants_2d)));
+}
+
+TEST_F(AGraphBackend, scalar_operand_derivatives) {
+  Eigen::ArrayXXd c(2, 1);
+  c << 0.5, 1.5;
+  for (int op : {6, 7, 8, 9, 10, 11, 12, 13, 14, 15}) {
+    // op applied to constants, and to the same values offset by x_0 - x_0
+    Eigen::ArrayX3i scalar_stack(5, 3);
+    scalar_stack << 1, 0, 0,
+                    1, 1, 1,
+                    op, 0, 1,
+                    0, 0, 0,
+                    4, 2, 3;
+    Eigen::ArrayX3i column_stack(8, 3);
+    column_stack << 1, 0, 0,
+                    1, 1, 1,
+                    0, 0, 0,
+                    3, 2, 2,
+                    2, 0, 3,
+                    2, 1, 3,
+                    op, 4, 5,
+                    4, 6, 2;
+    EvaluationPlan scalar_plan(scalar_stack);
+    const std::vector<Instruction> &instructions =
+      scalar_plan.GetInstructions(true);
+    ASSERT_EQ(instructions[instructions.size() - 3].shape, kRowShape);
+    std::pair<Eigen::ArrayXXd, Eigen::ArrayXXd> expected =
+      EvaluateWithDerivative(column_stack, x, c, false);
+    std::pair<Eigen::ArrayXXd, Eigen::ArrayXXd> y_and_dy =
+      EvaluateWithDerivative(scalar_plan, x, c, false);
+    ASSERT_TRUE(testutils::almost_equal(y_and_dy.first, expected.first));
+    ASSERT_TRUE(testutils::almost_equal(y_and_dy.second, expected.second));
+  }
+}
+
+TEST_F(AGraphBackend, derivative_of_several_constant_sets) {
+  EvaluationWorkspace workspace;
+  EvaluationPlan plan(simple_stack);
+  for (bool param_x_or_c : {true, false}) {
+    EvaluateWithDerivative(plan, x, constants_2d, param_x_or_c,
+                           with_workspace(workspace));
+    int num_features = param_x_or_c ? x.cols() : constants_2d.rows();
+    ASSERT_EQ(workspace.evaluation.cols(), 2);
+    ASSERT_EQ(workspace.derivative.cols(), 2 * num_features);
+    for (int set = 0; set < 2; ++set) {
+      std::pair<Eigen::ArrayXXd, Eigen::ArrayXXd> expected =
+        EvaluateWithDerivative(simple_stack, x, constants_2d.col(set),
+                               param_x_or_c);
+      ASSERT_TRUE(testutils::almost_equal(workspace.evaluation.col(set),
+                                          expected.first));
+      ASSERT_TRUE(testutils::almost_equal(
+        workspace.derivative.middleCols(set * num_features, num_features),
+        expected.second));
+    }
+  }
+}
+
+TEST_F(AGraphBackend, gradients_match_separate_derivatives) {
+  Eigen::ArrayXXd large_x = Eigen::ArrayXXd::Random(1000, 3) + 2.0;
+  for (const Eigen::ArrayXXd &c : {constants, constants_2d}) {
+    EvaluationPlan plan(simple_stack);
+    std::pair<Eigen::ArrayXXd, Eigen::ArrayXXd> x_gradient =
+      EvaluateWithDerivative(plan, large_x, c, true);
+    std::pair<Eigen::ArrayXXd, Eigen::ArrayXXd> c_gradient =
+      EvaluateWithDerivative(plan, large_x, c, false);
+    for (int tile_rows : {1000, 64}) {
+      EvaluationWorkspace workspace;
+      workspace.tile_rows = tile_rows;
+      EvaluateWithGradients(plan, large_x, c, with_workspace(workspace));
+      ASSERT_TRUE(testutils::almost_equal(workspace.evaluation,
+                                          x_gradient.first));
+      ASSERT_TRUE(testutils::almost_equal(workspace.derivative,
+                                          x_gradient.second));
+      ASSERT_TRUE(testutils::almost_equal(workspace.constant_derivative,
+                                          c_gradient.second));
+    }
+  }
+
+  EvalAndGradients y_and_gradients = EvaluateWithGradients(simple_stack, x,
+                                                           constants);
+  ASSERT_EQ(std::get<1>(y_and_gradients).cols(), x.cols());
+  ASSERT_EQ(std::get<2>(y_and_gradients).cols(), constants.rows());
+}
+
+TEST_F(AGraphBackend, evaluation_at_rows_matches_gathered_rows) {
+  EvaluationPlan plan(simple_stack);
+  SetNumThreads(4);
+  int num_rows = 2 * kMinParallelRows + 100;
+  Eigen::ArrayXXd large_x = Eigen::ArrayXXd::Random(num_rows, 3);
+  Eigen::ArrayXi rows = (Eigen::ArrayXd::Random(num_rows / 2).abs() *
+                         (num_rows - 1)).cast<int>();
+  Eigen::Ref<const Eigen::ArrayXi> rows_ref(rows);
+  EvaluationOptions options;
+  options.rows = &rows_ref;
+  for (const Eigen::ArrayXXd &c : {constants, constants_2d}) {
+    Eigen::ArrayXXd gathered_x = large_x(rows, Eigen::all);
+    Eigen::ArrayXXd expected = Evaluate(plan, gathered_x, c);
+    ASSERT_TRUE(testutils::almost_equal(expected,
+                                        Evaluate(plan, large_x, c, options)));
+  }
+  SetNumThreads(0);
+  ASSERT_THROW(EvaluateWithDerivative(plan, large_x, constants, true, options),
+               std::invalid_argument);
+
+  Eigen::ArrayXi no_rows;
+  Eigen::Ref<const Eigen::ArrayXi> no_rows_ref(no_rows);
+  options.rows = &no_rows_ref;
+  ASSERT_EQ(Evaluate(plan, x, constants, options).rows(), 0);
+  Eigen::ArrayXi past_end = Eigen::ArrayXi::Constant(1, x.rows());
+  Eigen::Ref<const Eigen::ArrayXi> past_end_ref(past_end);
+  options.rows = &past_end_ref;
+  ASSERT_THROW(Evaluate(plan, x, constants, options), std::out_of_range);
+}
+
+TEST_F(AGraphBackend, normal_equations_match_jacobian_products) {
+  EvaluationPlan plan(simple_stack);
+  SetNumThreads(4);
+  for (int num_rows : {1000, 2 * kMinParallelRows + 100}) {
+    Eigen::ArrayXXd large_x = Eigen::ArrayXXd::Random(num_rows, 3) + 2.0;
+    Eigen::ArrayXd y = Eigen::ArrayXd::Random(num_rows);
+    Eigen::ArrayXd random_weights = Eigen::ArrayXd::Random(num_rows) + 2.0;
+    for (const Eigen::ArrayXXd &c : {constants, constants_2d}) {
+      std::pair<Eigen::ArrayXXd, Eigen::ArrayXXd> df_dc =
+        EvaluateWithDerivative(plan, large_x, c, false);
+      for (const Eigen::ArrayXd &weights :
+           {Eigen::ArrayXd(), random_weights}) {
+        std::vector<NormalEquations> normal_equations =
+          EvaluateNormalEquations(plan, large_x, c, y, weights);
+        ASSERT_EQ(normal_equations.size(), c.cols());
+        for (int set = 0; set < c.cols(); ++set) {
+          Eigen::ArrayXd residual = df_dc.first.col(set) - y;
+          Eigen::ArrayXXd jacobian =
+            df_dc.second.middleCols(set * c.rows(), c.rows());
+          if (weights.size() != 0) {
+            residual *= weights;
+            jacobian.colwise() *= weights;
+          }
+          const NormalEquations &equations = normal_equations[set];
+          ASSERT_TRUE(equations.jacobian_squared.isApprox(
+            jacobian.matrix().transpose() * jacobian.matrix()));
+          ASSERT_TRUE(equations.gradient.isApprox(
+            jacobian.matrix().transpose() * residual.matrix()));
+          ASSERT_NEAR(equations.squared_residual,
+                      residual.square().sum(),
+                      1e-10 * equations.squared_residual);
+        }
+      }
+    }
+  }
+  SetNumThreads(0);
+
+  Eigen::ArrayXd short_y = Eigen::ArrayXd::Zero(x.rows() - 1);
+  ASSERT_THROW(EvaluateNormalEquations(plan, x, constants, short_y,
+                                       Eigen::ArrayXd()),
+               std::invalid_argument);
+}
+
+TEST_F(AGraphBackend, checkpointed_derivative_matches_taped_derivative) {
+  // a deep chain that keeps reading x1 and c1 from its first commands
+  int depth = 200;
+  Eigen::ArrayX3i stack(4 + 3 * depth, 3);
+  stack.topRows(4) << 0, 0, 0,
+                      0, 1, 1,
+                      1, 0, 0,
+                      1, 1, 1;
+  int previous = 0;
+  for (int i = 0; i < depth; ++i) {
+    int row = 4 + 3 * i;
+    stack.row(row) << 6, previous, previous;
+    stack.row(row + 1) << 4, row, 2 + (i % 2);
+    stack.row(row + 2) << 2, row + 1, 1;
+    previous = row + 2;
+  }
+  EvaluationPlan plan(stack);
+  Eigen::ArrayXXd large_x = Eigen::ArrayXXd::Random(1000, 2);
+  Eigen::ArrayXXd c = Eigen::ArrayXXd::Random(2, 3);
+
+  for (bool param_x_or_c : {true, false}) {
+    EvaluationWorkspace taped;
+    EvaluateWithDerivative(plan, large_x, c, param_x_or_c,
+                           with_workspace(taped));
+    for (std::size_t memory_budget : {1 << 20, 1 << 14}) {
+      EvaluationWorkspace checkpointed;
+      EvaluationOptions options = with_workspace(checkpointed);
+      options.memory_budget = memory_budget;
+      EvaluateWithDerivative(plan, large_x, c, param_x_or_c, options);
+      ASSERT_TRUE(testutils::almost_equal(checkpointed.evaluation,
+                                          taped.evaluation));
+      ASSERT_TRUE(testutils::almost_equal(checkpointed.derivative,
+                                          taped.derivative));
+
+      std::size_t buffer_bytes = 0;
+      for (const std::vector<Eigen::ArrayXXd> *buffers :
+           {&checkpointed.forward_eval, &checkpointed.reverse_eval,
+            &checkpointed.spare_buffers}) {
+        for (const Eigen::ArrayXXd &buffer : *buffers) {
+          buffer_bytes += buffer.size() * sizeof(double);
+        }
+      }
+      ASSERT_LE(buffer_bytes, memory_budget);
+    }
+  }
+}
+
+TEST_F(AGraphBackend, directional_derivative_matches_gradient) {
+  Eigen::ArrayXXd large_x = Eigen::ArrayXXd::Random(1000, 3) + 2.0;
+  Eigen::ArrayXXd direction = Eigen::ArrayXXd::Random(1000, 3);
+  Eigen::ArrayXXd c(2, 1);
+  c << 0.5, 1.5;
+  for (int op = 2; op <= 15; ++op) {
+    // op(x0, c0 * x1) + op(c1, x2)
+    Eigen::ArrayX3i stack(9, 3);
+    stack << 0, 0, 0,
+             0, 1, 1,
+             1, 0, 0,
+             4, 1, 2,
+             op, 0, 3,
+             1, 1, 1,
+             0, 2, 2,
+             op, 5, 6,
+             2, 4, 7;
+    EvaluationPlan plan(stack);
+    std::pair<Eigen::ArrayXXd, Eigen::ArrayXXd> gradient =
+      EvaluateWithDerivative(plan, large_x, c, true);
+    Eigen::ArrayXXd expected = (gradient.second * direction).rowwise().sum();
+    for (int tile_rows : {1000, 64}) {
+      EvaluationWorkspace workspace;
+      workspace.tile_rows = tile_rows;
+      EvaluateWithDirectionalDerivative(plan, large_x, c, direction,
+                                        with_workspace(workspace));
+      ASSERT_TRUE(testutils::almost_equal(workspace.evaluation,
+                                          gradient.first));
+      ASSERT_TRUE(testutils::almost_equal(workspace.derivative, expected));
+    }
+  }
+}
+
+TEST_F(AGraphBackend, directional_derivative_of_several_constant_sets) {
+  Eigen::ArrayXXd direction = x.reverse();
+  std::pair<Eigen::ArrayXXd, Eigen::ArrayXXd> y_and_dy =
+    EvaluateWithDirectionalDerivative(simple_stack, x, constants_2d,
+                                      direction);
+  ASSERT_EQ(y_and_dy.second.cols(), 2);
+  for (int set = 0; set < 2; ++set) {
+    std::pair<Eigen::ArrayXXd, Eigen::ArrayXXd> expected =
+      EvaluateWithDerivative(simple_stack, x, constants_2d.col(set), true);
+    ASSERT_TRUE(testutils::almost_equal(y_and_dy.first.col(set),
+                                        expected.first));
+    ASSERT_TRUE(testutils::almost_equal(
+      y_and_dy.second.col(set),
+      (expected.second * direction).rowwise().sum()));
+  }
+  ASSERT_THROW(EvaluateWithDirectionalDerivative(simple_stack, x, constants,
+                                                 direction.leftCols(2)),
+               std::invalid_argument);
+}
+
+TEST_F(AGraphBackend, tiled_evaluation_matches_whole_evaluation) {
+  Eigen::ArrayXXd large_x = Eigen::ArrayXXd::Random(1000, 3) + 2.0;
+  EvaluationPlan plan(simple_stack);
+  EvaluationWorkspace whole;
+  whole.tile_rows = 1000;
+  EvaluationWorkspace tiled;
+  tiled.tile_rows = 64;
+
+  ASSERT_TRUE(testutils::almost_equal(
+    Evaluate(plan, large_x, constants, with_workspace(tiled)),
+    Evaluate(plan, large_x, constants, with_workspace(whole))));
+  ASSERT_TRUE(testutils::almost_equal(
+    Evaluate(plan, large_x, constants_2d, with_workspace(tiled)),
+    Evaluate(plan, large_x, constants_2d, with_workspace(whole))));
+  for (bool param_x_or_c : {true, false}) {
+    EvaluateWithDerivative(plan, large_x, constants, param_x_or_c,
+                           with_workspace(whole));
+    EvaluateWithDerivative(plan, large_x, constants, param_x_or_c,
+                           with_workspace(tiled));
+    ASSERT_TRUE(testutils::almost_equal(tiled.evaluation, whole.evaluation));
+    ASSERT_TRUE(testutils::almost_equal(tiled.derivative, whole.derivative));
+  }
+}
+
+TEST_F(AGraphBackend, tiles_without_constants_are_sized_as_one_set) {
+  // sums of sines and cosines of x0, x1 and x2, all live at once
+  Eigen::ArrayX3i stack(14, 3);
+  stack << kVariable, 0, 0,
+           kVariable, 1, 1,
+           kVariable, 2, 2,
+           kSin, 0, 0,
+           kSin, 1, 1,
+           kSin, 2, 2,
+           kCos, 0, 0,
+           kCos, 1, 1,
+           kCos, 2, 2,
+           kAddition, 3, 4,
+           kAddition, 5, 6,
+           kAddition, 7, 8,
+           kAddition, 9, 10,
+           kAddition, 12, 11;
+  EvaluationPlan plan(stack);
+  Eigen::ArrayXXd large_x = Eigen::ArrayXXd::Random(10000, 3);
+  EvaluationWorkspace no_sets;
+  EvaluationWorkspace one_set;
+  Eigen::ArrayXXd f_of_x =
+      Evaluate(plan, large_x, Eigen::ArrayXXd(0, 0), with_workspace(no_sets));
+  ASSERT_TRUE(testutils::almost_equal(
+      f_of_x, Evaluate(plan, large_x, Eigen::ArrayXXd(0, 1),
+                       with_workspace(one_set))));
+  ASSERT_EQ(no_sets.forward_eval[0].rows(), one_set.forward_eval[0].rows());
+  ASSERT_LT(no_sets.forward_eval[0].rows(), large_x.rows());
+}
+
+TEST_F(AGraphBackend, tiled_evaluation_of_constant_stack) {
+  Eigen::ArrayXXd large_x = Eigen::ArrayXXd::Random(1000, 3);
+  EvaluationPlan plan(testutils::stack_unary_operator(6, 1));
+  EvaluationWorkspace tiled;
+  tiled.tile_rows = 300;
+  Eigen::ArrayXXd y = Evaluate(plan, large_x, constants, with_workspace(tiled));
+  ASSERT_EQ(y.rows(), 1000);
+  ASSERT_TRUE((y == std::sin(constants(0, 0))).all());
+}
+
+TEST_F(AGraphBackend, row_parallel_evaluation_matches_serial_evaluation) {
+  Eigen::ArrayXXd large_x =
+    Eigen::ArrayXXd::Random(2 * kMinParallelRows + 100, 3) + 2.0;
+  EvaluationPlan plan(simple_stack);
+  EvaluationWorkspace whole;
+  whole.tile_rows = large_x.rows();
+  EvaluationWorkspace tiled;
+  tiled.tile_rows = 1000;
+
+  SetNumThreads(4);
+  ASSERT_TRUE(testutils::almost_equal(
+    Evaluate(plan, large_x, constants, with_workspace(tiled)),
+    Evaluate(plan, large_x, constants, with_workspace(whole))));
+  for (bool param_x_or_c : {true, false}) {
+    EvaluateWithDerivative(plan, large_x, constants, param_x_or_c,
+                           with_workspace(whole));
+    EvaluateWithDerivative(plan, large_x, constants, param_x_or_c,
+                           with_workspace(tiled));
+    ASSERT_TRUE(testutils::almost_equal(tiled.evaluation, whole.evaluation));
+    ASSERT_TRUE(testutils::almost_equal(tiled.derivative, whole.derivative));
+  }
+  SetNumThreads(0);
+}
+
+TEST_F(AGraphBackend, tune_tile_rows) {
+  Eigen::ArrayXXd large_x = Eigen::ArrayXXd::Random(1000, 3) + 2.0;
+  EvaluationPlan plan(simple_stack);
+  EvaluationWorkspace workspace;
+  int tile_rows = TuneTileRows(plan, large_x, constants, true, workspace);
+  ASSERT_GE(tile_rows, 256);
+  ASSERT_LE(tile_rows, 1000);
+  ASSERT_EQ(tile_rows, workspace.tile_rows);
+}
+
+TEST_F(AGraphBackend, evaluate_empty_plan_throws) {
+  EvaluationPlan plan(Eigen::ArrayX3i(0, 3));
+  ASSERT_THROW(Evaluate(plan, x, constants), std::invalid_argument);
+}
+
 TEST_F(AGraphBackend, get_utilized_commands) {
   std::vector<bool> used_commands = GetUtilizedCommands(simple_stack);
   int num_used_commands = 0;
@@ -6,6 +6,7 @@
 #include <Eigen/Dense>
 
 #include <bingocpp/agraph/agraph.h>
+#include <bingocpp/agraph/evaluation_backend/evaluation_backend.h>
 
 #include "test_fixtures.h"
 #include "testing_utils.h"
@@ -210,6 +211,65 @@ namespace
     ASSERT_TRUE(testutils::almost_equal(sample_agraph_1_values.grad_x, df_dx));
   }
 
+  TEST_F(AGraphTest, evaluateWithGradients)
+  {
+    Eigen::ArrayXXd x = sample_agraph_1_values.x;
+    EvalAndGradients result = sample_agraph_1.EvaluateEquationWithGradientsAt(x);
+    ASSERT_TRUE(testutils::almost_equal(sample_agraph_1_values.f_of_x,
+                                        std::get<0>(result)));
+    ASSERT_TRUE(testutils::almost_equal(sample_agraph_1_values.grad_x,
+                                        std::get<1>(result)));
+    ASSERT_TRUE(testutils::almost_equal(sample_agraph_1_values.grad_c,
+                                        std::get<2>(result)));
+  }
+
+  TEST_F(AGraphTest, evaluateNormalEquations)
+  {
+    Eigen::ArrayXXd x = sample_agraph_1_values.x;
+    Eigen::ArrayXd y = x.col(0);
+    Eigen::ArrayXd weights = x.col(0).abs() + 1.0;
+    std::vector<NormalEquations> result =
+        sample_agraph_1.EvaluateNormalEquationsAt(x, y, weights);
+    // the default of Equation forms the jacobian
+    std::vector<NormalEquations> expected =
+        sample_agraph_1.Equation::EvaluateNormalEquationsAt(x, y, weights);
+    ASSERT_EQ(result.size(), 1);
+    ASSERT_EQ(expected.size(), 1);
+    ASSERT_TRUE(testutils::almost_equal(expected[0].jacobian_squared,
+                                        result[0].jacobian_squared));
+    ASSERT_TRUE(testutils::almost_equal(expected[0].gradient,
+                                        result[0].gradient));
+    ASSERT_NEAR(expected[0].squared_residual, result[0].squared_residual,
+                1e-8 * expected[0].squared_residual);
+  }
+
+  TEST_F(AGraphTest, evaluateAtRows)
+  {
+    Eigen::ArrayXXd x = sample_agraph_1_values.x;
+    Eigen::ArrayXi rows(4);
+    rows << 3, 0, 3, x.rows() - 1;
+    Eigen::ArrayXXd result = sample_agraph_1.EvaluateEquationAtRows(x, rows);
+    // the default of Equation copies the rows first
+    Eigen::ArrayXXd expected =
+        sample_agraph_1.Equation::EvaluateEquationAtRows(x, rows);
+    ASSERT_TRUE(testutils::almost_equal(expected, result));
+  }
+
+  TEST_F(AGraphTest, evaluateWithXDirectionalDerivative)
+  {
+    Eigen::ArrayXXd x = sample_agraph_1_values.x;
+    Eigen::ArrayXXd direction = x.reverse();
+    EvalAndDerivative result =
+        sample_agraph_1.EvaluateEquationWithXDirectionalDerivativeAt(x, direction);
+    // the default of Equation goes through the gradient
+    EvalAndDerivative expected =
+        sample_agraph_1.Equation::EvaluateEquationWithXDirectionalDerivativeAt(
+            x, direction);
+    ASSERT_TRUE(testutils::almost_equal(sample_agraph_1_values.f_of_x,
+                                        result.first));
+    ASSERT_TRUE(testutils::almost_equal(expected.second, result.second));
+  }
+
   TEST_F(AGraphTest, evaluatWithCDerivative)
   {
     Eigen::ArrayXXd x = sample_agraph_1_values.x;
@@ -220,6 +280,42 @@ namespace
     ASSERT_TRUE(testutils::almost_equal(sample_agraph_1_values.grad_c, df_dc));
   }
 
+  TEST_F(AGraphTest, evaluate_copied_and_loaded_agraph)
+  {
+    Eigen::ArrayXXd x = sample_agraph_1_values.x;
+    sample_agraph_1.EvaluateEquationAt(x);
+    AGraph agraph_copy = sample_agraph_1.Copy();
+    AGraph agraph_loaded = AGraph(sample_agraph_1.DumpState());
+    ASSERT_TRUE(testutils::almost_equal(sample_agraph_1_values.f_of_x,
+                                        agraph_copy.EvaluateEquationAt(x)));
+    ASSERT_TRUE(testutils::almost_equal(sample_agraph_1_values.f_of_x,
+                                        agraph_loaded.EvaluateEquationAt(x)));
+  }
+
+  TEST_F(AGraphTest, evaluate_population)
+  {
+    Eigen::ArrayXXd x = sample_agraph_1_values.x;
+    std::vector<AGraph> population(20, sample_agraph_1);
+    for (std::size_t i = 0; i < population.size(); i += 2)
+    {
+      population[i] = all_funcs_graph.Copy();
+    }
+    std::vector<AGraph *> individuals;
+    for (AGraph &individual : population)
+    {
+      individuals.push_back(&individual);
+    }
+
+    std::vector<Eigen::ArrayXXd> evaluations =
+        evaluation_backend::EvaluatePopulation(individuals, x);
+    ASSERT_EQ(evaluations.size(), population.size());
+    for (std::size_t i = 0; i < population.size(); ++i)
+    {
+      ASSERT_TRUE(testutils::almost_equal(
+          population[i].EvaluateEquationAt(x), evaluations[i]));
+    }
+  }
+
   TEST_F(AGraphTest, setting_fitness_updates_fit_set)
   {
     AGraph new_graph = AGraph(false);
@@ -0,0 +1,279 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <Eigen/Dense>
+
+#include <bingocpp/agraph/agraph.h>
+#include <bingocpp/continuous_local_optimizer.h>
+#include <bingocpp/explicit_regression.h>
+#include <bingocpp/thread_pool.h>
+
+using namespace bingo;
+
+namespace {
+
+class TestContinuousLocalOptimizer : public testing::TestWithParam<std::string> {
+ public:
+  ExplicitTrainingData *training_data_;
+  AGraph exponential_ = AGraph(false);
+
+  void SetUp() {
+    // c0 * exp(c1 * x0) + c2
+    Eigen::ArrayX3i command_array(8, 3);
+    command_array << 0, 0, 0,
+                     1, 0, 0,
+                     1, 1, 1,
+                     1, 2, 2,
+                     4, 2, 0,
+                     8, 4, 4,
+                     4, 1, 5,
+                     2, 6, 3;
+    exponential_.SetCommandArray(command_array);
+
+    Eigen::ArrayXXd x(25, 1);
+    x.col(0) = Eigen::ArrayXd::LinSpaced(25, -1.0, 1.0);
+    Eigen::ArrayXXd y = 2.0 * (1.5 * x).exp() + 0.5;
+    training_data_ = new ExplicitTrainingData(x, y);
+  }
+
+  void TearDown() {
+    delete training_data_;
+  }
+};
+
+TEST_P(TestContinuousLocalOptimizer, OptimizeParamsFitsConstants) {
+  ExplicitRegression regressor(training_data_, "mse");
+  ContinuousLocalOptimizer optimizer(&regressor, GetParam());
+  Eigen::VectorXd initial_params(3);
+  initial_params << 1.0, 1.0, 0.0;
+  LocalOptimizationResult result =
+      optimizer.OptimizeParams(exponential_, initial_params);
+
+  ASSERT_TRUE(result.converged);
+  ASSERT_NEAR(result.cost, 0.0, 1e-12);
+  ASSERT_LE(result.num_evaluations, optimizer.GetOptions().max_iterations);
+  Eigen::Vector3d expected_params(2.0, 1.5, 0.5);
+  ASSERT_TRUE(result.params.isApprox(expected_params, 1e-6));
+  ASSERT_TRUE(exponential_.GetLocalOptimizationParams().matrix()
+              .isApprox(result.params));
+  ASSERT_FALSE(exponential_.NeedsLocalOptimization());
+}
+
+TEST_P(TestContinuousLocalOptimizer, StopsAfterMaxIterations) {
+  ExplicitRegression regressor(training_data_);
+  LocalOptimizationOptions options;
+  options.max_iterations = 3;
+  ContinuousLocalOptimizer optimizer(&regressor, GetParam(), -10.0, 10.0,
+                                     options);
+  Eigen::VectorXd initial_params(3);
+  initial_params << 1.0, 1.0, 0.0;
+  LocalOptimizationResult result =
+      optimizer.OptimizeParams(exponential_, initial_params);
+  ASSERT_FALSE(result.converged);
+  ASSERT_EQ(result.num_evaluations, 3);
+}
+
+TEST_P(TestContinuousLocalOptimizer, EvaluateIndividualFitness) {
+  ExplicitRegression regressor(training_data_);
+  ContinuousLocalOptimizer optimizer(&regressor, GetParam(), 0.5, 2.5);
+  ASSERT_TRUE(exponential_.NeedsLocalOptimization());
+  double fitness = optimizer.EvaluateIndividualFitness(exponential_);
+  ASSERT_FALSE(exponential_.NeedsLocalOptimization());
+  ASSERT_NEAR(fitness, 0.0, 1e-6);
+}
+
+TEST_P(TestContinuousLocalOptimizer, EvaluatePopulationFitness) {
+  ExplicitRegression regressor(training_data_);
+  std::vector<AGraph> population(6, exponential_);
+  std::vector<AGraph *> individuals;
+  for (AGraph &individual : population) {
+    individuals.push_back(&individual);
+  }
+
+  SetNumThreads(3);
+  ContinuousLocalOptimizer parallel_optimizer(&regressor, GetParam(),
+                                              0.5, 2.5);
+  Eigen::ArrayXd fitness =
+      parallel_optimizer.EvaluatePopulationFitness(individuals);
+  SetNumThreads(0);
+
+  ContinuousLocalOptimizer serial_optimizer(&regressor, GetParam(),
+                                            0.5, 2.5);
+  for (std::size_t i = 0; i < population.size(); ++i) {
+    AGraph individual = exponential_;
+    ASSERT_EQ(serial_optimizer.EvaluateIndividualFitness(individual),
+              fitness(i));
+    ASSERT_FALSE(population[i].NeedsLocalOptimization());
+    ASSERT_NEAR(fitness(i), 0.0, 1e-6);
+  }
+}
+
+TEST_P(TestContinuousLocalOptimizer, MultiStartKeepsBestStart) {
+  ExplicitRegression regressor(training_data_);
+  ContinuousLocalOptimizer optimizer(&regressor, GetParam());
+  Eigen::MatrixXd initial_params(3, 4);
+  initial_params << 1.0, -3.0, 1.0, 8.0,
+                    1.0, 2.0, -4.0, -6.0,
+                    0.0, 5.0, 1.0, 9.0;
+
+  double best_cost = std::numeric_limits<double>::infinity();
+  for (int start = 0; start < initial_params.cols(); ++start) {
+    AGraph individual = exponential_;
+    best_cost = std::min(best_cost, optimizer.OptimizeParams(
+        individual, initial_params.col(start)).cost);
+  }
+  LocalOptimizationResult result =
+      optimizer.OptimizeParamsMultiStart(exponential_, initial_params);
+  ASSERT_NEAR(result.cost, best_cost, 1e-12);
+  ASSERT_TRUE(exponential_.GetLocalOptimizationParams().matrix()
+              .isApprox(result.params));
+  ASSERT_EQ(exponential_.GetLocalOptimizationParams().cols(), 1);
+}
+
+TEST_P(TestContinuousLocalOptimizer, CachesOnlyWhileOptimizing) {
+  ExplicitRegression regressor(training_data_);
+  ContinuousLocalOptimizer optimizer(&regressor, GetParam());
+  optimizer.OptimizeParams(exponential_, Eigen::Vector3d(1.0, 1.0, 0.0));
+  Eigen::ArrayXd params = exponential_.GetLocalOptimizationParams().col(0);
+
+  // x modified in place, then the command array changed
+  Eigen::ArrayXXd x = training_data_->x;
+  exponential_.EvaluateEquationAt(x);
+  x *= 2.0;
+  ASSERT_TRUE(exponential_.EvaluateEquationAt(x).isApprox(
+      params(0) * (params(1) * x).exp() + params(2)));
+  exponential_.GetCommandArrayModifiable()(5, 0) = 6;
+  exponential_.SetLocalOptimizationParamsV(params.matrix());
+  ASSERT_TRUE(exponential_.EvaluateEquationAt(x).isApprox(
+      params(0) * (params(1) * x).sin() + params(2)));
+}
+
+TEST_P(TestContinuousLocalOptimizer, VariableProjectionSolvesLinearParams) {
+  if (GetParam() == "lbfgs") {
+    GTEST_SKIP() << "variable projection is only used by least squares";
+  }
+  ExplicitRegression regressor(training_data_);
+  LocalOptimizationOptions options;
+  options.variable_projection = true;
+  ContinuousLocalOptimizer optimizer(&regressor, GetParam(), -10.0, 10.0,
+                                     options);
+  // a start that fails when c0 and c2 are iterated on as well
+  Eigen::VectorXd initial_params(3);
+  initial_params << 9.0, -1.0, 9.0;
+  LocalOptimizationResult result =
+      optimizer.OptimizeParams(exponential_, initial_params);
+
+  ASSERT_TRUE(result.converged);
+  ASSERT_NEAR(result.cost, 0.0, 1e-12);
+  Eigen::Vector3d expected_params(2.0, 1.5, 0.5);
+  ASSERT_TRUE(result.params.isApprox(expected_params, 1e-6));
+  ASSERT_TRUE(exponential_.GetLocalOptimizationParams().matrix()
+              .isApprox(result.params));
+}
+
+INSTANTIATE_TEST_SUITE_P(, TestContinuousLocalOptimizer,
+                         ::testing::Values("lm", "dogleg", "lbfgs"));
+
+TEST(ContinuousLocalOptimizerTest, LbfgsMinimizesMeanAbsoluteError) {
+  // c0 * x0 + c1
+  AGraph linear(false);
+  Eigen::ArrayX3i command_array(5, 3);
+  command_array << 0, 0, 0,
+                   1, 0, 0,
+                   4, 1, 0,
+                   1, 1, 1,
+                   2, 2, 3;
+  linear.SetCommandArray(command_array);
+
+  Eigen::ArrayXXd x(21, 1);
+  x.col(0) = Eigen::ArrayXd::LinSpaced(21, -1.0, 1.0);
+  Eigen::ArrayXXd y = 2.0 * x + 0.5;
+  y(3, 0) += 10.0;
+  y(11, 0) += 10.0;
+  y(17, 0) -= 10.0;
+  ExplicitTrainingData training_data(x, y);
+  ExplicitRegression regressor(&training_data, "mae");
+  Eigen::VectorXd initial_params(2);
+  initial_params << -1.0, 3.0;
+
+  ContinuousLocalOptimizer lbfgs(&regressor, "lbfgs");
+  LocalOptimizationResult result = lbfgs.OptimizeParams(linear,
+                                                        initial_params);
+  ASSERT_LE(result.num_evaluations, lbfgs.GetOptions().max_iterations);
+  ASSERT_EQ(result.cost, regressor.EvaluateIndividualFitness(linear));
+  Eigen::Vector2d expected_params(2.0, 0.5);
+  ASSERT_TRUE(result.params.isApprox(expected_params, 1e-2));
+
+  // least squares is pulled away from the line by the outliers
+  AGraph least_squares_fit = linear;
+  ContinuousLocalOptimizer(&regressor, "lm").OptimizeParams(
+      least_squares_fit, initial_params);
+  ASSERT_LT(result.cost,
+            regressor.EvaluateIndividualFitness(least_squares_fit));
+}
+
+TEST(ContinuousLocalOptimizerTest, MultiStartEscapesLocalMinima) {
+  // sin(c0 * x0), which has many local minima in c0
+  AGraph wave(false);
+  Eigen::ArrayX3i command_array(4, 3);
+  command_array << 0, 0, 0,
+                   1, 0, 0,
+                   4, 1, 0,
+                   6, 2, 2;
+  wave.SetCommandArray(command_array);
+  Eigen::ArrayXXd x = Eigen::ArrayXd::LinSpaced(50, -2.0, 2.0);
+  Eigen::ArrayXXd y = (2.0 * x).sin();
+  ExplicitTrainingData training_data(x, y);
+  ExplicitRegression regressor(&training_data, "mse");
+
+  LocalOptimizationOptions options;
+  options.num_starts = 16;
+  ContinuousLocalOptimizer optimizer(&regressor, "lm", -10.0, 10.0, options);
+  double fitness = optimizer.EvaluateIndividualFitness(wave);
+  ASSERT_NEAR(fitness, 0.0, 1e-10);
+  ASSERT_NEAR(std::abs(wave.GetLocalOptimizationParams()(0, 0)), 2.0, 1e-6);
+}
+
+TEST(ContinuousLocalOptimizerTest, VariableProjectionOfLinearEquation) {
+  // c0 * x0 + c1 * x1 + c2
+  AGraph plane(false);
+  Eigen::ArrayX3i command_array(9, 3);
+  command_array << 0, 0, 0,
+                   0, 1, 1,
+                   1, 0, 0,
+                   1, 1, 1,
+                   1, 2, 2,
+                   4, 2, 0,
+                   4, 3, 1,
+                   2, 5, 6,
+                   2, 7, 4;
+  plane.SetCommandArray(command_array);
+  Eigen::ArrayXXd x(20, 2);
+  x.col(0) = Eigen::ArrayXd::LinSpaced(20, -1.0, 1.0);
+  x.col(1) = x.col(0).square();
+  Eigen::ArrayXXd y = 3.0 * x.col(0) - 2.0 * x.col(1) + 1.0;
+  ExplicitTrainingData training_data(x, y);
+  ExplicitRegression regressor(&training_data);
+
+  LocalOptimizationOptions options;
+  options.variable_projection = true;
+  ContinuousLocalOptimizer optimizer(&regressor, "lm", -10.0, 10.0, options);
+  LocalOptimizationResult result =
+      optimizer.OptimizeParams(plane, Eigen::Vector3d(5.0, 5.0, 5.0));
+  ASSERT_EQ(result.num_evaluations, 1);
+  ASSERT_TRUE(result.converged);
+  ASSERT_TRUE(result.params.isApprox(Eigen::Vector3d(3.0, -2.0, 1.0), 1e-10));
+}
+
+TEST(ContinuousLocalOptimizerTest, InvalidAlgorithm) {
+  Eigen::ArrayXXd x = Eigen::ArrayXXd::Ones(5, 1);
+  ExplicitTrainingData training_data(x, x);
+  ExplicitRegression regressor(&training_data);
+  ASSERT_THROW(ContinuousLocalOptimizer(&regressor, "newton"),
+               std::invalid_argument);
+}
+} // namespace
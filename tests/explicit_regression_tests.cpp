@@ -1,9 +1,16 @@
 #include <cmath>
+#include <limits>
+#include <memory>
+#include <string>
+#include <thread>
 #include <tuple>
+#include <utility>
+#include <vector>
 
 #include <gtest/gtest.h>
 #include <Eigen/Dense>
 
+#include <bingocpp/agraph/agraph.h>
 #include <bingocpp/explicit_regression.h>
 
 #include "test_fixtures.h"
@@ -52,14 +59,86 @@ TEST_F(TestExplicitRegression, EvaluateIndividualFitnessRelative) {
 }
 
 TEST_F(TestExplicitRegression, EvaluateIndividualFitnessWithNaN) {
-  training_data_->x(0, 0) = std::numeric_limits<double>::quiet_NaN();
-  ExplicitRegression regressor(training_data_);
+  Eigen::ArrayXXd x = training_data_->x;
+  x(0, 0) = std::numeric_limits<double>::quiet_NaN();
+  ExplicitTrainingData nan_training_data(x, training_data_->y);
+  ExplicitRegression regressor(&nan_training_data);
   ASSERT_EQ(regressor.GetEvalCount(), 0);
   double fitness = regressor.EvaluateIndividualFitness(sum_equation_);
   ASSERT_TRUE(std::isnan(fitness));
   ASSERT_EQ(regressor.GetEvalCount(), 1);
 }
 
+TEST_F(TestExplicitRegression, TrainingDataIsSharedNotCopied) {
+  ExplicitTrainingData copy(*training_data_);
+  ASSERT_EQ(copy.x.data(), training_data_->x.data());
+  ASSERT_EQ(copy.y.data(), training_data_->y.data());
+
+  ExplicitRegression regressor(training_data_);
+  ExplicitTrainingData *regressor_data =
+      static_cast<ExplicitTrainingData *>(regressor.GetTrainingData());
+  ASSERT_EQ(regressor_data->x.data(), training_data_->x.data());
+}
+
+TEST_F(TestExplicitRegression, TrainingDataViewsCallerArrays) {
+  auto x = std::make_shared<Eigen::ArrayXXd>(
+      Eigen::ArrayXXd::Constant(10, 5, 1.0));
+  auto y = std::make_shared<Eigen::ArrayXXd>(
+      Eigen::ArrayXXd::Constant(10, 1, 2.5));
+  std::shared_ptr<const void> owner = std::make_shared<
+      std::pair<std::shared_ptr<Eigen::ArrayXXd>,
+                std::shared_ptr<Eigen::ArrayXXd>>>(x, y);
+  ExplicitTrainingData view(ViewOf(*x), ViewOf(*y), owner);
+  owner.reset();
+  x.reset();
+  y.reset();
+
+  ExplicitRegression regressor(&view);
+  ASSERT_NEAR(regressor.EvaluateIndividualFitness(sum_equation_), 2.5, 1e-10);
+}
+
+TEST_F(TestExplicitRegression, EvaluatePopulationFitness) {
+  ExplicitRegression regressor(training_data_);
+  std::vector<Equation *> population(10, &sum_equation_);
+  Eigen::ArrayXd fitness = regressor.EvaluatePopulationFitness(population);
+  ASSERT_EQ(fitness.size(), 10);
+  ASSERT_TRUE((fitness - 2.5).abs().maxCoeff() < 1e-10);
+  ASSERT_EQ(regressor.GetEvalCount(), 10);
+}
+
+TEST_F(TestExplicitRegression, SetNumThreadsDuringPopulationFitness) {
+  ExplicitRegression regressor(training_data_);
+  std::vector<Equation *> population(64, &sum_equation_);
+  SetNumThreads(4);
+  bool all_correct = true;
+  std::thread evaluation([&] {
+    for (int i = 0; i < 200; ++i) {
+      Eigen::ArrayXd fitness = regressor.EvaluatePopulationFitness(population);
+      all_correct = all_correct && (fitness - 2.5).abs().maxCoeff() < 1e-10;
+    }
+  });
+  for (int i = 0; i < 50; ++i) {
+    SetNumThreads(2 + i % 3);
+  }
+  evaluation.join();
+  SetNumThreads(0);
+  ASSERT_TRUE(all_correct);
+  ASSERT_EQ(regressor.GetEvalCount(), 200 * 64);
+}
+
+TEST_F(TestExplicitRegression, EvaluateFitnessVectorOfLargeData) {
+  int num_rows = 3 * kMinParallelRows + 5;
+  Eigen::ArrayXXd x = Eigen::ArrayXXd::Constant(num_rows, 5, 1.0);
+  Eigen::ArrayXXd y = Eigen::ArrayXXd::Constant(num_rows, 1, 2.5);
+  ExplicitTrainingData large_data(x, y);
+  ExplicitRegression regressor(&large_data, "mae", true);
+  SetNumThreads(4);
+  Eigen::ArrayXd fitness_vector = regressor.EvaluateFitnessVector(sum_equation_);
+  SetNumThreads(0);
+  ASSERT_EQ(fitness_vector.size(), num_rows);
+  ASSERT_TRUE((fitness_vector - 1.0).abs().maxCoeff() < 1e-10);
+}
+
 TEST_F(TestExplicitRegression, GetIndividualFitnessAndGradient) {
   ExplicitRegression regressor(training_data_);
   ASSERT_EQ(regressor.GetEvalCount(), 0);
@@ -118,6 +197,45 @@ TEST_F(TestExplicitRegression, GetFitnessVectorAndJacobianRelative) {
   ASSERT_EQ(regressor.GetEvalCount(), 1);
 }
 
+TEST_F(TestExplicitRegression, GetFitnessVectorsAndJacobiansOfConstantSets) {
+  // c0 * x0 + c1
+  AGraph linear(false);
+  Eigen::ArrayX3i command_array(5, 3);
+  command_array << 0, 0, 0,
+                   1, 0, 0,
+                   4, 1, 0,
+                   1, 1, 1,
+                   2, 2, 3;
+  linear.SetCommandArray(command_array);
+  Eigen::ArrayXXd x = Eigen::ArrayXd::LinSpaced(6, 0.0, 1.0);
+  Eigen::ArrayXXd y = 2.0 * x + 1.0;
+  ExplicitTrainingData training_data(x, y);
+  ExplicitRegression regressor(&training_data);
+
+  Eigen::ArrayXXd constant_sets(2, 3);
+  constant_sets << 2.0, 1.0, 0.0,
+                   1.0, 0.0, 0.5;
+  linear.SetLocalOptimizationParams(constant_sets);
+  Eigen::ArrayXXd fitness_vectors;
+  Eigen::ArrayXXd jacobians;
+  std::tie(fitness_vectors, jacobians) =
+      regressor.GetFitnessVectorsAndJacobians(linear);
+  ASSERT_EQ(regressor.GetEvalCount(), 1);
+  ASSERT_EQ(fitness_vectors.cols(), 3);
+  ASSERT_EQ(jacobians.cols(), 6);
+
+  for (int set = 0; set < 3; ++set) {
+    Eigen::ArrayXXd constants = constant_sets.col(set);
+    linear.SetLocalOptimizationParams(constants);
+    Eigen::ArrayXd fitness_vector;
+    Eigen::ArrayXXd jacobian;
+    std::tie(fitness_vector, jacobian) =
+        regressor.GetFitnessVectorAndJacobian(linear);
+    ASSERT_TRUE(fitness_vectors.col(set).isApprox(fitness_vector));
+    ASSERT_TRUE(jacobians.middleCols(2 * set, 2).isApprox(jacobian));
+  }
+}
+
 TEST_F(TestExplicitRegression, GetSubsetOfTrainingData) {
   Eigen::ArrayXXd data_input = Eigen::ArrayXd::LinSpaced(5, 0, 4);
   ExplicitTrainingData* training_data = new ExplicitTrainingData(data_input, data_input);
@@ -131,6 +249,128 @@ TEST_F(TestExplicitRegression, GetSubsetOfTrainingData) {
   delete subset_training_data;
 }
 
+TEST_F(TestExplicitRegression, RangesOfTrainingDataShareIt) {
+  Eigen::ArrayXXd data_input = Eigen::ArrayXd::LinSpaced(5, 0, 4);
+  ExplicitTrainingData training_data(data_input, data_input);
+  std::unique_ptr<ExplicitTrainingData> range(training_data.GetRange(1, 4));
+  std::unique_ptr<ExplicitTrainingData> consecutive(
+      training_data.GetItem(std::vector<int>{1, 2, 3}));
+
+  Eigen::ArrayXXd expected_subset(3, 1);
+  expected_subset << 1, 2, 3;
+  for (ExplicitTrainingData *subset : {range.get(), consecutive.get()}) {
+    ASSERT_EQ(subset->x.data(), training_data.x.data() + 1);
+    ASSERT_TRUE(subset->x.isApprox(expected_subset));
+    ASSERT_TRUE(subset->y.isApprox(expected_subset));
+  }
+}
+
+TEST_F(TestExplicitRegression, ViewFitnessMatchesGatheredSubset) {
+  int num_rows = 2 * kMinParallelRows + 5;
+  Eigen::ArrayXXd x = Eigen::ArrayXXd::Random(num_rows, 5);
+  Eigen::ArrayXXd y = Eigen::ArrayXXd::Random(num_rows, 1) + 2.0;
+  ExplicitTrainingData data(x, y);
+  std::vector<int> items;
+  for (int row = num_rows - 1; row >= 0; row -= 3) {
+    items.push_back(row);
+  }
+  ExplicitTrainingDataView view(data, items);
+  ASSERT_EQ(view.Size(), items.size());
+  ASSERT_EQ(view.data.x.data(), data.x.data());
+  std::unique_ptr<ExplicitTrainingData> subset(data.GetItem(items));
+
+  for (bool relative : {false, true}) {
+    ExplicitRegression view_regressor(&view, "mse", relative);
+    ExplicitRegression subset_regressor(subset.get(), "mse", relative);
+    SetNumThreads(4);
+    Eigen::ArrayXd view_fitness =
+        view_regressor.EvaluateFitnessVector(sum_equation_);
+    SetNumThreads(0);
+    ASSERT_TRUE(view_fitness.isApprox(
+        subset_regressor.EvaluateFitnessVector(sum_equation_)));
+    ASSERT_NEAR(
+        std::get<0>(view_regressor.GetIndividualFitnessAndGradient(sum_equation_)),
+        std::get<0>(subset_regressor.GetIndividualFitnessAndGradient(sum_equation_)),
+        1e-10);
+  }
+
+  // a view of a view selects from the same arrays
+  std::unique_ptr<ExplicitTrainingDataView> inner(
+      view.GetItem(std::vector<int>{2, 0}));
+  ASSERT_EQ(inner->data.x.data(), data.x.data());
+  ASSERT_EQ((*inner->rows)(0), items[2]);
+  ASSERT_EQ((*inner->rows)(1), items[0]);
+}
+
+TEST_F(TestExplicitRegression, MinibatchFitnessGathersItsRows) {
+  int num_rows = 2 * kMinParallelRows + 5;
+  Eigen::ArrayXXd x = Eigen::ArrayXXd::Random(num_rows, 5);
+  Eigen::ArrayXXd y = Eigen::ArrayXXd::Random(num_rows, 1) + 2.0;
+  ExplicitTrainingData data(x, y);
+  std::vector<int> items;
+  for (int row = 0; row < num_rows; row += 2) {
+    items.push_back(row);
+  }
+  ExplicitTrainingDataView view(data, items);
+
+  ExplicitRegression data_regressor(&data);
+  ExplicitRegression view_regressor(&view);
+  for (ExplicitRegression *regressor : {&data_regressor, &view_regressor}) {
+    regressor->SetMinibatch(kMinParallelRows / 2, kStratifiedMinibatch, 5);
+    const Eigen::ArrayXi &rows = regressor->GetMinibatchRows();
+    // the default evaluates all rows and keeps those of the minibatch
+    ASSERT_TRUE(regressor->EvaluateFitnessVectorAtRows(sum_equation_, rows)
+                .isApprox(regressor->VectorBasedFunction::EvaluateFitnessVectorAtRows(
+                    sum_equation_, rows)));
+  }
+}
+
+// counts the rows it is evaluated at
+class RowCountingEquation : public testutils::SumEquation {
+ public:
+  int rows_evaluated = 0;
+
+  Eigen::ArrayXXd EvaluateEquationAt(const Eigen::Ref<const Eigen::ArrayXXd> &x) {
+    rows_evaluated += x.rows();
+    return testutils::SumEquation::EvaluateEquationAt(x);
+  }
+};
+
+TEST_F(TestExplicitRegression, RacingStopsOnceFitnessExceedsBound) {
+  int num_rows = 4 * kMinParallelRows;
+  Eigen::ArrayXXd x = Eigen::ArrayXXd::Random(num_rows, 5);
+  Eigen::ArrayXXd y = Eigen::ArrayXXd::Random(num_rows, 1);
+  ExplicitTrainingData data(x, y);
+  double no_bound = std::numeric_limits<double>::infinity();
+  for (std::string metric : {"mae", "mse", "rmse"}) {
+    ExplicitRegression regressor(&data, metric);
+    RowCountingEquation equation;
+    double fitness = regressor.EvaluateIndividualFitness(equation);
+    BoundedFitness exact =
+        regressor.EvaluateIndividualFitnessWithin(equation, no_bound);
+    ASSERT_FALSE(exact.is_lower_bound);
+    ASSERT_EQ(exact.fitness, fitness);
+
+    equation.rows_evaluated = 0;
+    BoundedFitness raced =
+        regressor.EvaluateIndividualFitnessWithin(equation, fitness / 8);
+    ASSERT_TRUE(raced.is_lower_bound);
+    ASSERT_GT(raced.fitness, fitness / 8);
+    ASSERT_LE(raced.fitness, fitness);
+    ASSERT_LT(equation.rows_evaluated, num_rows);
+  }
+
+  // a minibatch is raced over its own rows
+  ExplicitRegression regressor(&data);
+  regressor.SetMinibatch(num_rows / 2, kRotatingMinibatch, 11);
+  RowCountingEquation equation;
+  double fitness = regressor.EvaluateIndividualFitness(equation);
+  ASSERT_NEAR(regressor.EvaluateIndividualFitnessWithin(equation, no_bound).fitness,
+              fitness, 1e-12);
+  ASSERT_TRUE(regressor.EvaluateIndividualFitnessWithin(equation, fitness / 8)
+              .is_lower_bound);
+}
+
 TEST_F(TestExplicitRegression, CorrectTrainingDataSize) {
   for (int size : std::vector<int> {2, 5, 50}) {
     Eigen::ArrayXXd data_input = Eigen::ArrayXd::LinSpaced(size, 0, 10);
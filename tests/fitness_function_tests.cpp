@@ -1,11 +1,15 @@
+#include <algorithm>
 #include <cmath>
+#include <set>
 #include <stdexcept>
 
 #include <gtest/gtest.h>
 #include <Eigen/Dense>
+#include <pybind11/embed.h>
 
 #include <bingocpp/equation.h>
 #include <bingocpp/fitness_function.h>
+#include <bingocpp/thread_pool.h>
 #include <bingocpp/training_data.h>
 
 #include "test_fixtures.h"
@@ -44,6 +48,16 @@ class SampleFitnessFunction : public bingo::VectorBasedFunction {
   }
 };
 
+// takes the GIL, as fitness functions implemented in Python do
+class GilAcquiringFitnessFunction : public SampleFitnessFunction {
+ public:
+  using SampleFitnessFunction::SampleFitnessFunction;
+  Eigen::ArrayXd EvaluateFitnessVector(bingo::Equation &individual) const {
+    pybind11::gil_scoped_acquire gil;
+    return SampleFitnessFunction::EvaluateFitnessVector(individual);
+  }
+};
+
 class TestFitnessFunction : public testing::Test {
  public:
   SampleTrainingData training_data_;
@@ -97,4 +111,101 @@ TEST_F(TestFitnessFunction, CorrectMetricSet) {
               rmse.EvaluateIndividualFitness(agraph),
               error_tol);
 }
+TEST_F(TestFitnessFunction, MetricsOfLargeFitnessVector) {
+  Eigen::ArrayXd fitness_vector =
+      Eigen::ArrayXd::LinSpaced(5 * bingo::kMinParallelRows + 7, -1., 2.);
+  double error_tol = 10e-10;
+  bingo::SetNumThreads(4);
+  ASSERT_NEAR(metric_functions::mean_absolute_error(fitness_vector),
+              fitness_vector.abs().mean(), error_tol);
+  ASSERT_NEAR(metric_functions::mean_squared_error(fitness_vector),
+              fitness_vector.square().mean(), error_tol);
+  ASSERT_NEAR(metric_functions::root_mean_squared_error(fitness_vector),
+              std::sqrt(fitness_vector.square().mean()), error_tol);
+  bingo::SetNumThreads(0);
+}
+
+TEST(TestMinibatchFitness, RotatingMinibatchesUseEachRowOncePerEpoch) {
+  Eigen::ArrayXXd x = Eigen::ArrayXXd::Random(10, 3);
+  Eigen::ArrayXXd y = Eigen::ArrayXXd::Random(10, 1);
+  SampleTrainingData training_data(x, y);
+  SampleFitnessFunction fitness_function(&training_data);
+  fitness_function.SetMinibatch(3, bingo::kRotatingMinibatch, 7);
+
+  std::vector<Eigen::ArrayXi> minibatches;
+  std::set<int> epoch_rows;
+  for (int index = 0; index < 3; ++index) {
+    ASSERT_EQ(fitness_function.GetMinibatchIndex(), index);
+    const Eigen::ArrayXi &rows = fitness_function.GetMinibatchRows();
+    ASSERT_EQ(rows.size(), 3);
+    ASSERT_TRUE(std::is_sorted(rows.data(), rows.data() + rows.size()));
+    epoch_rows.insert(rows.data(), rows.data() + rows.size());
+    minibatches.push_back(rows);
+    fitness_function.NextMinibatch();
+  }
+  ASSERT_EQ(epoch_rows.size(), 9);
+
+  // minibatches are drawn again from their seed and index
+  SampleFitnessFunction other_function(&training_data);
+  other_function.SetMinibatch(3, bingo::kRotatingMinibatch, 7);
+  other_function.SetMinibatchIndex(1);
+  ASSERT_TRUE((other_function.GetMinibatchRows() == minibatches[1]).all());
+}
+
+TEST(TestMinibatchFitness, StratifiedMinibatchesTakeOneRowPerStratum) {
+  Eigen::ArrayXXd x = Eigen::ArrayXXd::Random(10, 3);
+  Eigen::ArrayXXd y = Eigen::ArrayXXd::Random(10, 1);
+  SampleTrainingData training_data(x, y);
+  SampleFitnessFunction fitness_function(&training_data);
+  fitness_function.SetMinibatch(4, bingo::kStratifiedMinibatch, 3);
+  for (int index = 0; index < 5; ++index) {
+    const Eigen::ArrayXi &rows = fitness_function.GetMinibatchRows();
+    ASSERT_EQ(rows.size(), 4);
+    for (int i = 0; i < 4; ++i) {
+      ASSERT_GE(rows(i), 10 * i / 4);
+      ASSERT_LT(rows(i), 10 * (i + 1) / 4);
+    }
+    fitness_function.NextMinibatch();
+  }
+  ASSERT_THROW(fitness_function.SetMinibatch(-1), std::invalid_argument);
+}
+
+TEST_F(TestFitnessFunction, MinibatchFitnessIsFitnessOfItsRows) {
+  bingo::AGraph agraph = testutils::init_sample_agraph_1();
+  Eigen::ArrayXd fitness_vector =
+      sample_fitness_function_->EvaluateFitnessVector(agraph);
+  double full_fitness = fitness_vector.abs().mean();
+
+  sample_fitness_function_->SetMinibatch(2, bingo::kRotatingMinibatch, 1);
+  const Eigen::ArrayXi &rows = sample_fitness_function_->GetMinibatchRows();
+  ASSERT_EQ(rows.size(), 2);
+  ASSERT_NEAR(sample_fitness_function_->EvaluateIndividualFitness(agraph),
+              fitness_vector(rows).abs().mean(), 1e-10);
+  ASSERT_NEAR(sample_fitness_function_->EvaluateFullFitness(agraph),
+              full_fitness, 1e-10);
+
+  sample_fitness_function_->SetMinibatch(0);
+  ASSERT_NEAR(sample_fitness_function_->EvaluateIndividualFitness(agraph),
+              full_fitness, 1e-10);
+}
+
+TEST_F(TestFitnessFunction, PopulationFitnessTakesGilOnPoolThreads) {
+  pybind11::scoped_interpreter interpreter;
+  GilAcquiringFitnessFunction fitness_function(&training_data_);
+  testutils::SumEquation sum_equation = testutils::init_sum_equation();
+  std::vector<bingo::Equation *> population(8, &sum_equation);
+  double expected_fitness =
+      fitness_function.EvaluateIndividualFitness(sum_equation);
+
+  bingo::SetNumThreads(4);
+  Eigen::ArrayXd fitness;
+  {
+    // as the evaluate_population_fitness bindings do
+    pybind11::gil_scoped_release release;
+    fitness = fitness_function.EvaluatePopulationFitness(population);
+  }
+  bingo::SetNumThreads(0);
+  ASSERT_EQ(fitness.size(), 8);
+  ASSERT_TRUE((fitness - expected_fitness).abs().maxCoeff() < 1e-10);
+}
 } // namespace (anonymous)
\ No newline at end of file
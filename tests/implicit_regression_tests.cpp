@@ -1,4 +1,6 @@
 #include <cmath>
+#include <memory>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include <Eigen/Dense>
@@ -109,6 +111,18 @@ TEST_F(ImplicitRegressionTest, GetSubsetOfData) {
   delete subset_training_data;
 }
 
+TEST_F(ImplicitRegressionTest, ViewFitnessMatchesGatheredSubset) {
+  std::vector<int> items{5, 0, 3, 7};
+  ImplicitTrainingDataView view(*training_data_, items);
+  ASSERT_EQ(view.Size(), items.size());
+  std::unique_ptr<ImplicitTrainingData> subset(training_data_->GetItem(items));
+
+  ImplicitRegression view_regressor(&view);
+  ImplicitRegression subset_regressor(subset.get());
+  ASSERT_TRUE(view_regressor.EvaluateFitnessVector(sum_equation_).isApprox(
+      subset_regressor.EvaluateFitnessVector(sum_equation_)));
+}
+
 TEST_F(ImplicitRegressionTest, CorrectTrainingDataSize) {
   for (int size : std::vector<int> {2, 5, 50}) {
     Eigen::ArrayXXd data_input = Eigen::ArrayXd::LinSpaced(size, 0, 10);
@@ -0,0 +1,144 @@
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <gtest/gtest.h>
+#include <Eigen/Dense>
+
+#include <bingocpp/explicit_regression.h>
+#include <bingocpp/implicit_regression.h>
+#include <bingocpp/npy_file.h>
+
+#include "test_fixtures.h"
+
+using namespace bingo;
+
+namespace {
+
+typedef Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+    RowMajorArray;
+
+// Writes a version 1 .npy file with the header as given
+std::string write_npy_with_header(const std::string &name,
+                                  const std::string &header,
+                                  const double *values, int num_values) {
+  std::string path = testing::TempDir() + name;
+  std::ofstream file(path, std::ios::binary);
+  file.write("\x93NUMPY\x01\x00", 8);
+  char length[2] = {static_cast<char>(header.size() & 0xff),
+                    static_cast<char>(header.size() >> 8)};
+  file.write(length, 2);
+  file << header;
+  file.write(reinterpret_cast<const char *>(values),
+             sizeof(double) * num_values);
+  return path;
+}
+
+// Writes values as a version 1 .npy file, in the layout of its order
+std::string write_npy(const std::string &name, const double *values,
+                      const std::string &shape, bool fortran_order,
+                      int num_values, const std::string &descr = "<f8") {
+  std::string header = "{'descr': '" + descr + "', 'fortran_order': " +
+                       (fortran_order ? "True" : "False") +
+                       ", 'shape': " + shape + ", }";
+  // the data starts on a multiple of 64 bytes, after a newline
+  header.append(63 - (10 + header.size()) % 64, ' ');
+  header += '\n';
+  return write_npy_with_header(name, header, values, num_values);
+}
+
+class NpyFileTest : public testing::Test {
+ public:
+  Eigen::ArrayXXd x_;
+  Eigen::ArrayXXd y_;
+  std::string x_path_;
+  std::string y_path_;
+
+  void SetUp() {
+    x_ = Eigen::ArrayXXd::Random(20, 3);
+    y_ = Eigen::ArrayXXd::Random(20, 1);
+    x_path_ = write_npy("npy_x.npy", x_.data(), "(20, 3)", true, x_.size());
+    y_path_ = write_npy("npy_y.npy", y_.data(), "(20,)", false, y_.size());
+  }
+
+  void TearDown() {
+    std::remove(x_path_.c_str());
+    std::remove(y_path_.c_str());
+  }
+};
+
+TEST_F(NpyFileTest, MapsColumnMajorArrays) {
+  LoadedArray x = MapNpyFile(x_path_);
+  ASSERT_EQ(x.values.rows(), 20);
+  ASSERT_EQ(x.values.cols(), 3);
+  ASSERT_TRUE((x.values == x_).all());
+
+  LoadedArray y = MapNpyFile(y_path_);
+  ASSERT_EQ(y.values.cols(), 1);
+  ASSERT_TRUE((y.values == y_).all());
+}
+
+TEST_F(NpyFileTest, TransposesRowMajorArrays) {
+  RowMajorArray row_major = x_;
+  std::string path = write_npy("npy_row_major.npy", row_major.data(),
+                               "(20, 3)", false, row_major.size());
+  LoadedArray x = MapNpyFile(path);
+  std::remove(path.c_str());
+  ASSERT_TRUE((x.values == x_).all());
+}
+
+TEST_F(NpyFileTest, LoadsTrainingData) {
+  std::unique_ptr<ExplicitTrainingData> explicit_data(
+      LoadExplicitTrainingData(x_path_, y_path_));
+  ExplicitTrainingData in_memory(x_, y_);
+  testutils::SumEquation equation;
+  ExplicitRegression loaded_regression(explicit_data.get());
+  ExplicitRegression in_memory_regression(&in_memory);
+  ASSERT_EQ(loaded_regression.EvaluateIndividualFitness(equation),
+            in_memory_regression.EvaluateIndividualFitness(equation));
+
+  std::unique_ptr<ImplicitTrainingData> implicit_data(
+      LoadImplicitTrainingData(x_path_, x_path_));
+  ASSERT_TRUE((implicit_data->dx_dt == x_).all());
+  ASSERT_THROW(LoadImplicitTrainingData(x_path_, y_path_),
+               std::invalid_argument);
+}
+
+TEST_F(NpyFileTest, RejectsOtherFiles) {
+  ASSERT_THROW(MapNpyFile(testing::TempDir() + "npy_missing.npy"),
+               std::runtime_error);
+
+  Eigen::ArrayXd values = Eigen::ArrayXd::Zero(4);
+  std::string integers = write_npy("npy_integers.npy", values.data(), "(4,)",
+                                   false, 4, "<i8");
+  std::string truncated = write_npy("npy_truncated.npy", values.data(),
+                                    "(5,)", false, 4);
+  std::string three_d = write_npy("npy_3d.npy", values.data(), "(1, 2, 2)",
+                                  false, 4);
+  // rows * cols * 8 overflows to 0
+  std::string overflowing = write_npy(
+      "npy_overflowing.npy", values.data(), "(2305843009213693952, 1)", false,
+      0);
+  std::string negative = write_npy("npy_negative.npy", values.data(),
+                                   "(-1, -1)", false, 0);
+  std::string unshaped = write_npy("npy_unshaped.npy", values.data(), "4",
+                                   false, 4);
+  std::string no_value = write_npy_with_header(
+      "npy_no_value.npy", "{'descr':", values.data(), 0);
+  for (const std::string &path : {integers, truncated, three_d, overflowing,
+                                  negative, unshaped, no_value}) {
+    EXPECT_THROW(MapNpyFile(path), std::invalid_argument) << path;
+    std::remove(path.c_str());
+  }
+
+  Eigen::ArrayXXd short_y = Eigen::ArrayXXd::Zero(19, 1);
+  std::string path = write_npy("npy_short_y.npy", short_y.data(), "(19, 1)",
+                               true, 19);
+  ASSERT_THROW(LoadExplicitTrainingData(x_path_, path),
+               std::invalid_argument);
+  std::remove(path.c_str());
+}
+} // namespace
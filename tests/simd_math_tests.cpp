@@ -0,0 +1,114 @@
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <gtest/gtest.h>
+
+#include <bingocpp/agraph/evaluation_backend/simd_math.h>
+
+using namespace bingo;
+using namespace evaluation_backend;
+
+namespace {
+
+const double kInf = std::numeric_limits<double>::infinity();
+const double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+double log_abs(double x) {
+  return std::log(std::abs(x));
+}
+
+struct FunctionCase {
+  SimdFunction function;
+  double (*expected)(double);
+};
+
+class SimdMathTest : public ::testing::TestWithParam<InstructionSet> {
+ public:
+  std::vector<double> x;
+  InstructionSet default_instruction_set;
+
+  void SetUp() {
+    default_instruction_set = GetInstructionSet();
+    if (!IsInstructionSetSupported(GetParam())) {
+      GTEST_SKIP();
+    }
+    SetInstructionSet(GetParam());
+    Eigen::ArrayXd samples = Eigen::ArrayXd::LinSpaced(1001, -20, 20);
+    x.assign(samples.data(), samples.data() + samples.size());
+    // odd sizes leave a partial vector; special values take the fallback
+    for (double value : {0.0, -0.0, 1e-3, -1e-300, 700.0, -707.5,
+                         709.5, -746.0, 1e5, 1e9, -1e20, kInf, -kInf, kNaN}) {
+      x.push_back(value);
+    }
+    // Eigen's log flushes subnormals, the vectorized kernels fall back
+    if (GetParam() != kGenericInstructions) {
+      x.push_back(1e-310);
+    }
+  }
+
+  void TearDown() {
+    SetInstructionSet(default_instruction_set);
+  }
+};
+
+bool near_or_equal(double value, double expected) {
+  if (std::isnan(expected) || std::isinf(expected)) {
+    return std::isnan(expected) ? std::isnan(value) : value == expected;
+  }
+  return std::abs(value - expected) <= 1e-14 * std::max(std::abs(expected), 1.0);
+}
+
+const std::vector<FunctionCase> kFunctionCases = {
+  {kSinFunction, std::sin}, {kCosFunction, std::cos},
+  {kExpFunction, std::exp}, {kLogAbsFunction, log_abs},
+  {kSinhFunction, std::sinh}, {kCoshFunction, std::cosh}};
+
+TEST_P(SimdMathTest, apply_matches_standard_library) {
+  for (const FunctionCase &function_case : kFunctionCases) {
+    std::vector<double> result(x.size());
+    ApplySimdFunction(function_case.function, x.data(), result.data(),
+                      x.size());
+    for (std::size_t i = 0; i < x.size(); ++i) {
+      ASSERT_TRUE(near_or_equal(result[i], function_case.expected(x[i])))
+        << "function " << function_case.function << " at " << x[i]
+        << ": " << result[i];
+    }
+  }
+}
+
+TEST_P(SimdMathTest, apply_in_place) {
+  std::vector<double> result(x);
+  ApplySimdFunction(kSinFunction, result.data(), result.data(), result.size());
+  for (std::size_t i = 0; i < x.size(); ++i) {
+    ASSERT_TRUE(near_or_equal(result[i], std::sin(x[i])));
+  }
+}
+
+TEST_P(SimdMathTest, accumulate_product) {
+  for (const FunctionCase &function_case : kFunctionCases) {
+    std::vector<double> adjoint(x.size(), 0.5);
+    std::vector<double> accumulator(x.size(), 1.0);
+    AccumulateSimdProduct(function_case.function, x.data(), adjoint.data(),
+                          -2.0, accumulator.data(), x.size());
+    for (std::size_t i = 0; i < x.size(); ++i) {
+      ASSERT_TRUE(near_or_equal(accumulator[i],
+                                1.0 - function_case.expected(x[i])))
+        << "function " << function_case.function << " at " << x[i];
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(, SimdMathTest,
+                         ::testing::Values(kGenericInstructions,
+                                           kSse2Instructions,
+                                           kAvx2Instructions,
+                                           kAvx512Instructions));
+
+TEST(SimdMath, generic_instructions_are_always_supported) {
+  ASSERT_TRUE(IsInstructionSetSupported(kGenericInstructions));
+  ASSERT_TRUE(IsInstructionSetSupported(GetInstructionSet()));
+}
+} // namespace
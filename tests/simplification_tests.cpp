@@ -0,0 +1,287 @@
+#include <vector>
+
+#include <Eigen/Dense>
+#include <gtest/gtest.h>
+
+#include <bingocpp/agraph/constants.h>
+#include <bingocpp/agraph/evaluation_backend/evaluation_backend.h>
+#include <bingocpp/agraph/operator_definitions.h>
+#include <bingocpp/agraph/simplification_backend/automatic_simplification.h>
+#include <bingocpp/agraph/simplification_backend/expression_arena.h>
+#include <bingocpp/agraph/simplification_backend/interpreter.h>
+#include <bingocpp/agraph/simplification_backend/simplification_backend.h>
+
+using namespace bingo;
+using namespace simplification_backend;
+
+namespace {
+
+Eigen::ArrayX3i make_stack(const std::vector<std::vector<int>> &commands) {
+  Eigen::ArrayX3i stack(commands.size(), 3);
+  for (std::size_t i = 0; i < commands.size(); ++i) {
+    stack.row(i) << commands[i][0], commands[i][1], commands[i][2];
+  }
+  return stack;
+}
+
+Eigen::ArrayXXd sample_x() {
+  Eigen::ArrayXXd x(10, 2);
+  x.col(0) = Eigen::ArrayXd::LinSpaced(10, -2.5, 2.0);
+  x.col(1) = Eigen::ArrayXd::LinSpaced(10, 0.5, 3.0);
+  return x;
+}
+
+void expect_same_values(const Eigen::ArrayX3i &stack,
+                        const Eigen::ArrayX3i &simplified) {
+  Eigen::ArrayXXd x = sample_x();
+  Eigen::VectorXd constants(0);
+  Eigen::ArrayXXd expected = evaluation_backend::Evaluate(stack, x, constants);
+  Eigen::ArrayXXd result =
+      evaluation_backend::Evaluate(simplified, x, constants);
+  ASSERT_TRUE(expected.isApprox(result, 1e-12));
+}
+
+TEST(SimplificationTest, ArenaInternsEqualExpressions) {
+  ExpressionArena arena;
+  ExpressionPtr x0 = arena.MakeTerm(kVariable, 0);
+  ExpressionPtr sin_x0 = arena.MakeOp(kSin, {x0});
+  EXPECT_EQ(x0, arena.MakeTerm(kVariable, 0));
+  EXPECT_EQ(sin_x0, arena.MakeOp(kSin, {arena.MakeTerm(kVariable, 0)}));
+  EXPECT_NE(x0, arena.MakeTerm(kConstant, 0));
+  EXPECT_NE(sin_x0, arena.MakeOp(kCos, {x0}));
+  EXPECT_EQ(4, arena.GetNumExpressions());
+}
+
+TEST(SimplificationTest, EqualExpressionsHaveEqualHashes) {
+  ExpressionArena arena;
+  ExpressionPtr interned = arena.MakeOp(
+      kAddition, {arena.MakeTerm(kVariable, 0), arena.MakeInteger(2)});
+  ExpressionPtr allocated = std::make_shared<const OpExpression>(
+      kAddition, ExpressionList{
+          std::make_shared<const TermExpression>(kVariable, 0),
+          std::make_shared<const TermExpression>(kInteger, 2)});
+  EXPECT_EQ(interned->GetHash(), allocated->GetHash());
+  EXPECT_TRUE(*interned == *allocated);
+  ExpressionPtr reversed = arena.MakeOp(
+      kAddition, {arena.MakeInteger(2), arena.MakeTerm(kVariable, 0)});
+  EXPECT_NE(interned->GetHash(), reversed->GetHash());
+}
+
+TEST(SimplificationTest, InterpreterRoundTrip) {
+  Eigen::ArrayX3i stack = make_stack({{kVariable, 0, 0},
+                                      {kSin, 0, 0},
+                                      {kVariable, 1, 1},
+                                      {kMultiplication, 1, 2},
+                                      {kPower, 3, 0}});
+  ExpressionArena arena;
+  Eigen::ArrayX3i rebuilt = BuildStack(BuildExpression(stack, arena));
+  ASSERT_TRUE((stack == rebuilt).all());
+}
+
+TEST(SimplificationTest, InterpreterSharesEqualSubexpressions) {
+  Eigen::ArrayX3i stack = make_stack({{kVariable, 0, 0},
+                                      {kVariable, 0, 0},
+                                      {kSin, 0, 0},
+                                      {kSin, 1, 1},
+                                      {kAddition, 2, 3}});
+  Eigen::ArrayX3i expected = make_stack({{kVariable, 0, 0},
+                                         {kSin, 0, 0},
+                                         {kAddition, 1, 1}});
+  ExpressionArena arena;
+  ASSERT_TRUE((expected == BuildStack(BuildExpression(stack, arena))).all());
+}
+
+TEST(SimplificationTest, SubtractionOfEqualTermsIsZero) {
+  Eigen::ArrayX3i stack = make_stack({{kVariable, 0, 0},
+                                      {kSubtraction, 0, 0}});
+  Eigen::ArrayX3i expected = make_stack({{kInteger, 0, 0}});
+  ASSERT_TRUE((expected == CppSimplifyStack(stack)).all());
+}
+
+TEST(SimplificationTest, PowersOfEqualBasesAreMerged) {
+  Eigen::ArrayX3i stack = make_stack({{kVariable, 0, 0},
+                                      {kMultiplication, 0, 0},
+                                      {kMultiplication, 1, 0}});
+  Eigen::ArrayX3i expected = make_stack({{kVariable, 0, 0},
+                                         {kInteger, 3, 3},
+                                         {kPower, 0, 1}});
+  ASSERT_TRUE((expected == CppSimplifyStack(stack)).all());
+  expect_same_values(stack, CppSimplifyStack(stack));
+}
+
+TEST(SimplificationTest, QuotientOfEqualTermsIsOne) {
+  Eigen::ArrayX3i stack = make_stack({{kVariable, 0, 0},
+                                      {kSin, 0, 0},
+                                      {kDivision, 1, 1}});
+  Eigen::ArrayX3i expected = make_stack({{kInteger, 1, 1}});
+  ASSERT_TRUE((expected == CppSimplifyStack(stack)).all());
+}
+
+TEST(SimplificationTest, LikeTermsAreCollected) {
+  // x0 + x1 + x0 + x0 * x1 - x1 * x0
+  Eigen::ArrayX3i stack = make_stack({{kVariable, 0, 0},
+                                      {kVariable, 1, 1},
+                                      {kAddition, 0, 1},
+                                      {kAddition, 2, 0},
+                                      {kMultiplication, 0, 1},
+                                      {kMultiplication, 1, 0},
+                                      {kAddition, 3, 4},
+                                      {kSubtraction, 6, 5}});
+  Eigen::ArrayX3i expected = make_stack({{kInteger, 2, 2},
+                                         {kVariable, 0, 0},
+                                         {kMultiplication, 0, 1},
+                                         {kVariable, 1, 1},
+                                         {kAddition, 2, 3}});
+  ASSERT_TRUE((expected == CppSimplifyStack(stack)).all());
+  expect_same_values(stack, CppSimplifyStack(stack));
+}
+
+TEST(SimplificationTest, SubtractionAndDivisionAreReinserted) {
+  // x0 / x1 - x1
+  Eigen::ArrayX3i stack = make_stack({{kVariable, 0, 0},
+                                      {kVariable, 1, 1},
+                                      {kDivision, 0, 1},
+                                      {kSubtraction, 2, 1}});
+  ASSERT_TRUE((stack == CppSimplifyStack(stack)).all());
+}
+
+TEST(SimplificationTest, ConstantValuedTermsAreFolded) {
+  // (c0 + c1 * 2) * x0 * c2 + sin(c3)
+  Eigen::ArrayX3i stack = make_stack({{kConstant, 0, 0},
+                                      {kConstant, 1, 1},
+                                      {kInteger, 2, 2},
+                                      {kMultiplication, 1, 2},
+                                      {kAddition, 0, 3},
+                                      {kVariable, 0, 0},
+                                      {kMultiplication, 4, 5},
+                                      {kConstant, 2, 2},
+                                      {kMultiplication, 6, 7},
+                                      {kConstant, 3, 3},
+                                      {kSin, 9, 9},
+                                      {kAddition, 8, 10}});
+  Eigen::ArrayX3i simplified = CppSimplifyStack(stack);
+  ASSERT_EQ(5, simplified.rows());
+  ASSERT_EQ(kAddition, simplified(4, kOpIdx));
+  ASSERT_EQ(2, (simplified.col(kOpIdx) == kConstant).count());
+}
+
+TEST(SimplificationTest, IntegerArithmeticIsFolded) {
+  // (2 * 3 - 6) * sin(x0) + cos(0) + sqrt(-4)
+  Eigen::ArrayX3i stack = make_stack({{kInteger, 2, 2},
+                                      {kInteger, 3, 3},
+                                      {kMultiplication, 0, 1},
+                                      {kInteger, 6, 6},
+                                      {kSubtraction, 2, 3},
+                                      {kVariable, 0, 0},
+                                      {kSin, 5, 5},
+                                      {kMultiplication, 4, 6},
+                                      {kInteger, 0, 0},
+                                      {kCos, 8, 8},
+                                      {kInteger, -4, -4},
+                                      {kSqrt, 10, 10},
+                                      {kAddition, 7, 9},
+                                      {kAddition, 12, 11}});
+  Eigen::ArrayX3i expected = make_stack({{kInteger, 3, 3}});
+  ASSERT_TRUE((expected == CppSimplifyStack(stack)).all());
+}
+
+TEST(SimplificationTest, SimplifiedStacksEvaluateTheSame) {
+  // (x0 - x1)^2 / (x1 - x0) + exp(x0 * x0) * exp(x0)^-1 + log(x1) * 3 / x1
+  Eigen::ArrayX3i stack = make_stack({{kVariable, 0, 0},
+                                      {kVariable, 1, 1},
+                                      {kSubtraction, 0, 1},
+                                      {kInteger, 2, 2},
+                                      {kPower, 2, 3},
+                                      {kSubtraction, 1, 0},
+                                      {kDivision, 4, 5},
+                                      {kMultiplication, 0, 0},
+                                      {kExponential, 7, 7},
+                                      {kExponential, 0, 0},
+                                      {kDivision, 8, 9},
+                                      {kAddition, 6, 10},
+                                      {kLogarithm, 1, 1},
+                                      {kInteger, 3, 3},
+                                      {kMultiplication, 12, 13},
+                                      {kDivision, 14, 1},
+                                      {kAddition, 11, 15}});
+  Eigen::ArrayX3i simplified = CppSimplifyStack(stack);
+  expect_same_values(stack, simplified);
+  ASSERT_TRUE((simplified == CppSimplifyStack(simplified)).all());
+}
+
+TEST(SimplificationTest, NativeSimplificationIsChosenExplicitly) {
+  ASSERT_FALSE(GetUseNativeSimplification());
+  // x0 + x0 - x0
+  Eigen::ArrayX3i stack = make_stack({{kVariable, 0, 0},
+                                      {kAddition, 0, 0},
+                                      {kSubtraction, 1, 0}});
+  SetUseNativeSimplification(true);
+  Eigen::ArrayX3i simplified = AlgebraicSimplifyStack(stack);
+  SetUseNativeSimplification(false);
+  ASSERT_TRUE((simplified == CppSimplifyStack(stack)).all());
+}
+
+TEST(SimplificationTest, SharedSubexpressionsAreSimplifiedOnce) {
+  // x0 doubled 60 times; as a tree it would have 2^60 leaves
+  const int num_doublings = 60;
+  Eigen::ArrayX3i stack(num_doublings + 1, 3);
+  stack.row(0) << kVariable, 0, 0;
+  for (int i = 1; i <= num_doublings; ++i) {
+    stack.row(i) << kAddition, i - 1, i - 1;
+  }
+  Eigen::ArrayX3i simplified = CppSimplifyStack(stack);
+  ASSERT_GT(10, simplified.rows());
+  expect_same_values(stack, simplified);
+}
+
+TEST(SimplificationTest, FindsLinearConstants) {
+  // c0 * exp(c1 * x0) + c2 - x0 / c3
+  Eigen::ArrayX3i stack = make_stack({{kConstant, 0, 0},
+                                      {kConstant, 1, 1},
+                                      {kVariable, 0, 0},
+                                      {kMultiplication, 1, 2},
+                                      {kExponential, 3, 3},
+                                      {kMultiplication, 0, 4},
+                                      {kConstant, 2, 2},
+                                      {kAddition, 5, 6},
+                                      {kConstant, 3, 3},
+                                      {kDivision, 2, 8},
+                                      {kSubtraction, 7, 9}});
+  std::vector<bool> expected = {true, false, true, false};
+  ASSERT_EQ(expected, FindLinearConstants(stack));
+}
+
+TEST(SimplificationTest, ProductsOfLinearConstantsKeepTheLargerSide) {
+  // c0 * (c1 * x0 + c2) + sin(x0) * c0 * c3, with an unused sin(c2)
+  Eigen::ArrayX3i stack = make_stack({{kConstant, 0, 0},
+                                      {kConstant, 1, 1},
+                                      {kVariable, 0, 0},
+                                      {kMultiplication, 1, 2},
+                                      {kConstant, 2, 2},
+                                      {kSin, 4, 4},
+                                      {kAddition, 3, 4},
+                                      {kMultiplication, 0, 6},
+                                      {kSin, 2, 2},
+                                      {kMultiplication, 8, 0},
+                                      {kConstant, 3, 3},
+                                      {kMultiplication, 9, 10},
+                                      {kAddition, 7, 11}});
+  std::vector<bool> expected = {false, true, true, true};
+  ASSERT_EQ(expected, FindLinearConstants(stack));
+}
+
+TEST(SimplificationTest, NumbersAreOrderedBeforeVariables) {
+  ExpressionPtr two = std::make_shared<const TermExpression>(kInteger, 2);
+  ExpressionPtr c0 = std::make_shared<const TermExpression>(kConstant, 0);
+  ExpressionPtr x0 = std::make_shared<const TermExpression>(kVariable, 0);
+  ExpressionPtr x1 = std::make_shared<const TermExpression>(kVariable, 1);
+  ExpressionPtr sin_x0 = std::make_shared<const OpExpression>(
+      kSin, ExpressionList{x0});
+  EXPECT_TRUE(ExpressionLess(two, c0));
+  EXPECT_TRUE(ExpressionLess(c0, x0));
+  EXPECT_TRUE(ExpressionLess(x0, x1));
+  EXPECT_TRUE(ExpressionLess(x1, sin_x0));
+  EXPECT_FALSE(ExpressionLess(sin_x0, x0));
+  EXPECT_FALSE(ExpressionLess(x0, x0));
+}
+} // namespace
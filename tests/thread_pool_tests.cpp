@@ -0,0 +1,92 @@
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <bingocpp/thread_pool.h>
+
+using namespace bingo;
+
+namespace {
+
+TEST(ThreadPoolTest, runs_every_task_once) {
+  ThreadPool pool(4);
+  ASSERT_EQ(pool.GetNumThreads(), 4);
+  std::vector<std::atomic<int>> counts(1000);
+  for (auto &count : counts) {
+    count = 0;
+  }
+  pool.ParallelFor(counts.size(), [&](int i) { ++counts[i]; });
+  for (auto &count : counts) {
+    ASSERT_EQ(count.load(), 1);
+  }
+}
+
+TEST(ThreadPoolTest, balances_uneven_tasks) {
+  ThreadPool pool(3);
+  std::atomic<long> total(0);
+  pool.ParallelFor(100, [&](int i) {
+    long sum = 0;
+    for (int j = 0; j < (i < 10 ? 100000 : 10); ++j) {
+      sum += j % 7;
+    }
+    total += sum > 0 ? 1 : 0;
+  });
+  ASSERT_EQ(total.load(), 100);
+}
+
+TEST(ThreadPoolTest, rethrows_task_exception) {
+  ThreadPool pool(4);
+  std::atomic<int> num_run(0);
+  ASSERT_THROW(pool.ParallelFor(100, [&](int i) {
+    ++num_run;
+    if (i == 50) {
+      throw std::runtime_error("task failed");
+    }
+  }), std::runtime_error);
+  ASSERT_EQ(num_run.load(), 100);
+  pool.ParallelFor(10, [&](int) { ++num_run; });
+  ASSERT_EQ(num_run.load(), 110);
+}
+
+TEST(ThreadPoolTest, nested_loops_run_serially) {
+  ThreadPool pool(4);
+  std::atomic<int> total(0);
+  pool.ParallelFor(8, [&](int) {
+    pool.ParallelFor(8, [&](int) { ++total; });
+  });
+  ASSERT_EQ(total.load(), 64);
+}
+
+TEST(ThreadPoolTest, blocks_cover_every_item_once) {
+  ThreadPool pool(4);
+  std::vector<int> counts(1000, 0);
+  pool.ParallelForBlocks(counts.size(), 300, [&](int begin, int end) {
+    ASSERT_GE(end - begin, 300);
+    for (int i = begin; i < end; ++i) {
+      ++counts[i];
+    }
+  });
+  for (int count : counts) {
+    ASSERT_EQ(count, 1);
+  }
+}
+
+TEST(ThreadPoolTest, use_row_parallelism) {
+  SetNumThreads(4);
+  ASSERT_TRUE(UseRowParallelism(1, kMinParallelRows));
+  ASSERT_FALSE(UseRowParallelism(1, kMinParallelRows - 1));
+  ASSERT_FALSE(UseRowParallelism(4, kMinParallelRows));
+  SetNumThreads(1);
+  ASSERT_FALSE(UseRowParallelism(1, 100 * kMinParallelRows));
+  SetNumThreads(0);
+}
+
+TEST(ThreadPoolTest, set_num_threads) {
+  SetNumThreads(2);
+  ASSERT_EQ(GetNumThreads(), 2);
+  SetNumThreads(0);
+  ASSERT_GE(GetNumThreads(), 1);
+}
+} // namespace